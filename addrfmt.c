@@ -0,0 +1,100 @@
+/** @file:   addrfmt.c
+ *  @brief:  Binary to text address formatters (IPv4 dotted quad, RFC 5952 IPv6) without libc calls
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "addrfmt.h"
+
+static const char addr_hex[] = "0123456789abcdef";
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//decimal octet, no leading zeros
+static inline char *addr_put_u8(char *p, unsigned int v){
+    if (v >= 100){
+        *p++ = (char)('0' + v / 100);
+        v %= 100;
+        *p++ = (char)('0' + v / 10);
+    } else if (v >= 10){
+        *p++ = (char)('0' + v / 10);
+    }
+    *p++ = (char)('0' + v % 10);
+    return p;
+}
+
+//hexadecimal group, no leading zeros
+static inline char *addr_put_hex16(char *p, unsigned int v){
+    if (v >= 0x1000){
+        *p++ = addr_hex[v >> 12];
+    }
+    if (v >= 0x100){
+        *p++ = addr_hex[(v >> 8) & 0xf];
+    }
+    if (v >= 0x10){
+        *p++ = addr_hex[(v >> 4) & 0xf];
+    }
+    *p++ = addr_hex[v & 0xf];
+    return p;
+}
+
+/*************************************************
+ *                  FORMATTERS                   *
+*************************************************/
+size_t addr_format_ipv4(const unsigned char *addr, char *out){
+    char *p = addr_put_u8(out, addr[0]);
+    for (int i = 1; i < 4; i++){
+        *p++ = '.';
+        p = addr_put_u8(p, addr[i]);
+    }
+    *p = '\0';
+    return (size_t)(p - out);
+}
+
+size_t addr_format_ipv6(const unsigned char *addr, char *out){
+  //16 bit groups, longest (first if tied) run of zero groups
+    unsigned int w[8];
+    int best = -1, blen = 0, cur = -1, clen = 0;
+    for (int i = 0; i < 8; i++){
+        w[i] = ((unsigned int)addr[2 * i] << 8) | addr[2 * i + 1];
+        if (w[i] != 0){
+            cur = -1;
+            continue;
+        }
+        if (cur < 0){
+            cur = i;
+            clen = 0;
+        }
+        if (++clen > blen){
+            best = cur;
+            blen = clen;
+        }
+    }
+    if (blen < 2){ //single zero group isn't compressed
+        best = -1;
+        blen = 0;
+    }
+
+    char *p = out;
+    for (int i = 0; i < 8; i++){
+        if (best >= 0 && i >= best && i < best + blen){
+            if (i == best){
+                *p++ = ':';
+            }
+            continue;
+        }
+        if (i != 0){
+            *p++ = ':';
+        }
+        if (i == 6 && best == 0 && (blen == 6 || (blen == 5 && w[5] == 0xffff))){ //::a.b.c.d, ::ffff:a.b.c.d
+            return (size_t)(p - out) + addr_format_ipv4(addr + 12, p);
+        }
+        p = addr_put_hex16(p, w[i]);
+    }
+    if (best >= 0 && best + blen == 8){ //trailing "::"
+        *p++ = ':';
+    }
+    *p = '\0';
+    return (size_t)(p - out);
+}
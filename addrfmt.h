@@ -0,0 +1,36 @@
+/** @file:   addrfmt.h
+ *  @brief:  Binary to text address formatters (IPv4 dotted quad, RFC 5952 IPv6) without libc calls
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef ADDRFMT_H
+#define ADDRFMT_H
+
+#include "dns.h"
+
+#define ADDR_TEXT_MAX 46 //longest text form including the terminating zero (same as INET6_ADDRSTRLEN)
+
+/**
+ * @function: addr_format_ipv4
+ * @brief formats IPv4 address into dotted quad (10.0.0.1)
+ *
+ * @param[in] addr: 4 bytes, network order
+ * @param[in] out:  buffer (at least 16 chars) to write NUL terminated text into
+ * @return length of text, without the terminating zero
+*/
+size_t addr_format_ipv4(const unsigned char *addr, char *out);
+
+/**
+ * @function: addr_format_ipv6
+ * @brief formats IPv6 address in RFC 5952 form: lowercase, no leading zeros, first longest run of
+ *        two or more zero groups compressed to "::", IPv4-mapped and -compatible addresses with
+ *        dotted quad tail (same output as inet_ntop)
+ *
+ * @param[in] addr: 16 bytes, network order
+ * @param[in] out:  buffer (at least ADDR_TEXT_MAX chars) to write NUL terminated text into
+ * @return length of text, without the terminating zero
+*/
+size_t addr_format_ipv6(const unsigned char *addr, char *out);
+
+#endif
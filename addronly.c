@@ -0,0 +1,157 @@
+/** @file:   addronly.c
+ *  @brief:  Addresses-only reply fast path ('--addresses-only'): A/AAAA rdata pulled straight out of the wire reply
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "addronly.h"
+
+static const char *addr_only_rcodes[16] = {"NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED", "YXDOMAIN",
+                                           "YXRRSET", "NXRRSET", "NOTAUTH", "NOTZONE", "RCODE11", "RCODE12", "RCODE13",
+                                           "RCODE14", "RCODE15"};
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//ASCII lowercase (names compare case insensitively, locale plays no part)
+static inline unsigned char addr_only_lower(unsigned char c){
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + 32) : c;
+}
+
+//position right after name at 'pos' (its labels are walked, a pointer ends it), 0 if it runs out of the reply
+static size_t addr_only_skip_name(const unsigned char *buf, size_t len, size_t pos){
+    while (pos < len){
+        unsigned char l = buf[pos];
+        if (l == 0){
+            return pos + 1;
+        }
+        if ((l & 0xc0) == 0xc0){
+            return (pos + 2 <= len) ? pos + 2 : 0;
+        }
+        if ((l & 0xc0) != 0){ //extended label types
+            return 0;
+        }
+        pos += (size_t)l + 1;
+    }
+    return 0;
+}
+
+//follows compression pointers at 'pos' to the next real label, 0 on a bad pointer or too many of them
+static size_t addr_only_label(const unsigned char *buf, size_t len, size_t pos, int *hops){
+    while (pos + 1 < len && (buf[pos] & 0xc0) == 0xc0){
+        if (++(*hops) > ADDR_ONLY_HOPS){
+            return 0;
+        }
+        pos = ((size_t)(buf[pos] & 0x3f) << 8) | buf[pos + 1];
+    }
+    return (pos < len) ? pos : 0;
+}
+
+//names at 'a' and 'b' are equal; both are compared where they lie, the same position means the same rest
+//(owners written as a pointer to the question name, the usual case, match on the first check)
+static bool addr_only_name_eq(const unsigned char *buf, size_t len, size_t a, size_t b){
+    int hops = 0;
+    while (true){
+        if ((a = addr_only_label(buf, len, a, &hops)) == 0 || (b = addr_only_label(buf, len, b, &hops)) == 0){
+            return false;
+        }
+        if (a == b){
+            return true;
+        }
+        unsigned char l = buf[a];
+        if (l != buf[b] || (l & 0xc0) != 0 || a + 1 + l > len || b + 1 + l > len){
+            return false;
+        }
+        if (l == 0){
+            return true;
+        }
+        for (size_t i = 1; i <= l; i++){
+            if (addr_only_lower(buf[a + i]) != addr_only_lower(buf[b + i])){
+                return false;
+            }
+        }
+        a += (size_t)l + 1;
+        b += (size_t)l + 1;
+    }
+}
+
+/*************************************************
+ *                ADDRESSES ONLY                 *
+*************************************************/
+int addr_only_extract(const unsigned char *buf, size_t len, struct addr_only *out){
+    out->count = 0;
+    out->ttl = UINT32_MAX;
+    const struct dns_header_t *dns = (const struct dns_header_t *)buf;
+    if (len < sizeof(struct dns_header_t) || dns->qr != 1 || ntohs(dns->qdcount) != 1){
+        return 1;
+    }
+    out->rcode = dns->rcode;
+
+  //question (its name is where the chain starts)
+    size_t pos = addr_only_skip_name(buf, len, sizeof(struct dns_header_t));
+    if (pos == 0 || pos + 4 > len){
+        return 1;
+    }
+    uint16_t qtype = (uint16_t)(buf[pos] << 8 | buf[pos + 1]);
+    if (qtype != DNS_QTYPE_A && qtype != DNS_QTYPE_AAAA){
+        return 1;
+    }
+    out->qtype = qtype;
+    size_t alen = (qtype == DNS_QTYPE_A) ? 4 : 16;
+    pos += 4;
+
+  //answers: addresses owned by the current chain name, CNAMEs owned by it move the chain on
+    size_t target = sizeof(struct dns_header_t);
+    int cnames = 0;
+    for (uint16_t i = ntohs(dns->ancount); i > 0; i--){
+        size_t owner = pos;
+        if ((pos = addr_only_skip_name(buf, len, pos)) == 0 || pos + 10 > len){
+            return 1;
+        }
+        uint16_t type = (uint16_t)(buf[pos] << 8 | buf[pos + 1]);
+        uint16_t class = (uint16_t)(buf[pos + 2] << 8 | buf[pos + 3]);
+        uint32_t ttl = (uint32_t)buf[pos + 4] << 24 | (uint32_t)buf[pos + 5] << 16 | (uint32_t)buf[pos + 6] << 8 | buf[pos + 7];
+        size_t rdlen = (size_t)(buf[pos + 8] << 8 | buf[pos + 9]);
+        size_t rdata = pos + 10;
+        if (rdata + rdlen > len){
+            return 1;
+        }
+        pos = rdata + rdlen;
+        if (class != DNS_QCLASS_IN){
+            continue;
+        }
+        if (type == qtype && rdlen == alen){
+            if (out->count < ADDR_ONLY_MAX && addr_only_name_eq(buf, len, owner, target)){
+                memcpy(out->addrs[out->count++], &buf[rdata], alen);
+                out->ttl = (ttl < out->ttl) ? ttl : out->ttl;
+            }
+        } else if (type == DNS_QTYPE_CNAME && cnames < ADDR_ONLY_CNAMES && addr_only_name_eq(buf, len, owner, target)){
+            target = rdata;
+            cnames++;
+            out->ttl = (ttl < out->ttl) ? ttl : out->ttl;
+        }
+    }
+    return 0;
+}
+
+size_t addr_only_format(const struct addr_only *a, const unsigned char *host, char *out){
+    size_t hlen = strlen((const char *)host);
+    char *p = out;
+    for (uint16_t i = 0; i < a->count || (a->count == 0 && p == out); i++){
+        memcpy(p, host, hlen);
+        p += hlen;
+        *p++ = '.';
+        *p++ = ' ';
+        if (a->count == 0){ //no address, just how the server answered
+            size_t rlen = strlen(addr_only_rcodes[a->rcode & 0xf]);
+            memcpy(p, addr_only_rcodes[a->rcode & 0xf], rlen);
+            p += rlen;
+        } else {
+            p += (a->qtype == DNS_QTYPE_A) ? addr_format_ipv4(a->addrs[i], p) : addr_format_ipv6(a->addrs[i], p);
+        }
+        *p++ = '\n';
+        *p++ = '\r';
+    }
+    *p = '\0';
+    return (size_t)(p - out);
+}
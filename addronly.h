@@ -0,0 +1,59 @@
+/** @file:   addronly.h
+ *  @brief:  Addresses-only reply fast path ('--addresses-only'): A/AAAA rdata pulled straight out of the wire reply
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef ADDRONLY_H
+#define ADDRONLY_H
+
+#include "dns.h"
+#include "addrfmt.h"
+
+#define ADDR_ONLY_MAX    32 //addresses kept from one reply (further ones are left out)
+#define ADDR_ONLY_CNAMES 8  //CNAME hops followed from the question name
+#define ADDR_ONLY_HOPS   16 //compression pointers followed while comparing one name (loop guard)
+
+//longest text of one reply: a line per address ("name. address\n\r")
+#define ADDR_ONLY_TEXT_MAX (ADDR_ONLY_MAX * (255 + 2 + ADDR_TEXT_MAX + 2) + 1)
+
+/**
+ * @struct: addresses of one reply (fixed size, lives on the stack)
+*/
+struct addr_only{
+    uint16_t qtype;       /* DNS_QTYPE_A or DNS_QTYPE_AAAA */
+    uint8_t rcode;
+    uint16_t count;       /* addresses in @param addrs */
+    uint32_t ttl;         /* lowest TTL of the addresses and CNAMEs of the chain (UINT32_MAX when none) */
+    unsigned char addrs[ADDR_ONLY_MAX][16]; /* network order, 4 or 16 bytes used by qtype */
+};
+
+/**
+ * @function: addr_only_extract
+ * @brief checks header and question of reply and collects the A/AAAA rdata (of the question's type) of answer
+ *        records owned by the question name or by a CNAME target on its chain; names are compared in place
+ *        (compression pointers followed, nothing decompressed or allocated), authority and additional
+ *        sections aren't read at all
+ *
+ * The chain is followed in one pass, in the order the answer section lists it (the order servers send it in).
+ *
+ * @param[in] buf: reply
+ * @param[in] len: length of reply
+ * @param[in] out: addresses found
+ * @return 0 if successful, 1 if reply is malformed or not one to an A/AAAA question
+*/
+int addr_only_extract(const unsigned char *buf, size_t len, struct addr_only *out);
+
+/**
+ * @function: addr_only_format
+ * @brief formats addresses of reply into text, one "name. address" line per address,
+ *        "name. RCODE" when there's none (NXDOMAIN, or NOERROR without data)
+ *
+ * @param[in] a:    addresses of reply
+ * @param[in] host: question name (printable form)
+ * @param[in] out:  buffer (at least ADDR_ONLY_TEXT_MAX chars)
+ * @return length of text
+*/
+size_t addr_only_format(const struct addr_only *a, const unsigned char *host, char *out);
+
+#endif
@@ -0,0 +1,1157 @@
+/** @file:   batch.c
+ *  @brief:  Batch resolution of name lists with in-flight query coalescing
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "batch.h"
+#include "namenorm.h"
+#include "input.h"
+#include "uring.h"
+#include "trace.h"
+#include "columnar.h"
+#include "shmring.h"
+#include "spsc.h"
+#include "probes.h"
+#include "pool.h"
+#include "journal.h"
+#include "addronly.h"
+#include "zout.h"
+#include "metrics.h"
+
+#include <poll.h>
+#include <fcntl.h>
+#include <time.h>
+
+struct batch_stats bstats;
+
+static struct batch_slot *slots;  //in-flight query slots ('par.window' of them)
+static int32_t id_map[65536];     //transaction ID --> slot index (-1 = ID not in use)
+static int32_t *buckets;          //coalescing hash table (bucket --> first slot index)
+static uint32_t bucket_mask;
+static unsigned int inflight;     //amount of used slots
+static int32_t *free_slots;       //stack of unused slot indices ('par.window - inflight' of them)
+static int32_t *dl_heap;          //used slot indices, binary min-heap by deadline ('inflight' of them)
+static uint64_t waiting;          //amount of waiters of all used slots
+static struct pool pool;          //servers queries are spread over (each with its own send pacing)
+
+static int socks[BATCH_SOCKETS_MAX];        //socket pool, each on its own random source port
+static unsigned int nsocks;
+static uint16_t sock_ports[BATCH_SOCKETS_MAX];
+static uint32_t sock_drops[BATCH_SOCKETS_MAX]; //datagrams dropped by kernel (last SO_RXQ_OVFL seen)
+static struct uring ring;         //io_uring backend ('ring.fd' is -1 when plain sockets are used)
+static struct col_writer colw;    //columnar output ('-o'), 'colw.fd' is -1 when results are printed
+static struct shm_writer shmw;    //shared-memory result ring ('--shm'), 'shmw.hdr' is NULL when not used
+static struct zout zo;            //compressed output ('--compress'), 'stdout' feeds its writer thread while open
+static struct spsc_ring names;    //input thread --> I/O thread (struct batch_name)
+static struct spsc_ring results;  //I/O thread --> output thread (struct batch_result)
+static struct journal jr;         //checkpoint journal ('--journal'), 'jr.fd' is -1 when not used
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//monotonic clock in nanoseconds
+uint64_t batch_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//coalescing key hash (FNV-1a over lowercase DNSname and qtype)
+uint32_t batch_key_hash(const unsigned char *qname, uint16_t qtype){
+    uint32_t h = 2166136261u;
+    for (; *qname; qname++){
+        h = (h ^ (uint32_t)tolower(*qname)) * 16777619u;
+    }
+    h = (h ^ (qtype & 0xff)) * 16777619u;
+    h = (h ^ (qtype >> 8)) * 16777619u;
+    return h;
+}
+
+//case insensitive DNSname comparison
+bool dnsname_equal(const unsigned char *a, const unsigned char *b){
+    while (*a && *b){
+        if (tolower(*a) != tolower(*b)){
+            return false;
+        }
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+//input line --> lowercase DNSname (no libc pre-lookups, those would serialize the whole batch)
+size_t batch_qname_build(const char *name, size_t len, unsigned char *qname){
+    char addr[INET6_ADDRSTRLEN];
+    char host[128];
+
+    if (len >= sizeof(addr)){ //longer than any address, so a hostname
+        return par.reverse ? 0 : name_normalize(name, len, qname);
+    }
+    memcpy(addr, name, len); //input isn't NUL terminated
+    addr[len] = '\0';
+    if (par.reverse){
+        if (dns_reverse_name(addr, host) != 0){
+            return 0;
+        }
+        return name_normalize(host, strlen(host), qname);
+    }
+    if (is_it_IPv4(addr)){
+        return 0;
+    }
+    return name_normalize(name, len, qname);
+}
+
+//printable qname for probe arguments (only prepared while a tracer is attached)
+static const char *batch_probe_name(const unsigned char *qname, char *out){
+    strcpy(out, (const char *)qname);
+    DNSname_to_hostname((unsigned char *)out);
+    return out;
+}
+
+/*************************************************
+ *                    PACING                     *
+*************************************************/
+//tokens per nanosecond (window spread over one round trip)
+static double batch_pacer_rate(struct batch_pacer *p){
+    return p->cwnd * BATCH_PACING_GAIN / (double)p->srtt_ns;
+}
+
+//bucket depth, at least one millisecond worth of sends (poll can't wait any shorter)
+static double batch_pacer_depth(struct batch_pacer *p){
+    double per_ms = batch_pacer_rate(p) * 1000000.0;
+    return (per_ms > BATCH_BURST) ? per_ms : BATCH_BURST;
+}
+
+void batch_pacer_init(struct batch_pacer *p, uint64_t now){
+    memset(p, 0, sizeof(*p));
+    p->cwnd = BATCH_CWND_INIT;
+    p->cwnd_max = BATCH_CWND_INIT;
+    p->ssthresh = BATCH_WINDOW_MAX;
+    p->tokens = BATCH_BURST;
+    p->refilled = now;
+}
+
+unsigned int batch_pacer_window(struct batch_pacer *p){
+    return (p->cwnd < 1.0) ? 1 : (unsigned int)p->cwnd;
+}
+
+bool batch_pacer_ready(struct batch_pacer *p, uint64_t now){
+    if (p->srtt_ns == 0){ //nothing to pace by yet, the window alone limits the first round trip
+        p->tokens = BATCH_BURST;
+    } else {
+        p->tokens += (double)(now - p->refilled) * batch_pacer_rate(p);
+        double depth = batch_pacer_depth(p);
+        if (p->tokens > depth){
+            p->tokens = depth;
+        }
+    }
+    p->refilled = now;
+    return p->tokens >= 1.0;
+}
+
+void batch_pacer_sent(struct batch_pacer *p){
+    p->tokens -= 1.0; //retransmits may take the bucket below zero, delaying new queries
+}
+
+int batch_pacer_wait_ms(struct batch_pacer *p, uint64_t now){
+    if (!batch_pacer_ready(p, now)){
+        return (int)((1.0 - p->tokens) / batch_pacer_rate(p) / 1000000.0) + 1;
+    }
+    return 0;
+}
+
+uint64_t batch_pacer_rto(struct batch_pacer *p){
+    if (p->srtt_ns == 0){
+        return (uint64_t)BATCH_TIMEOUT_MS * 1000000ULL;
+    }
+    uint64_t rto = p->srtt_ns + 4 * p->rttvar_ns;
+    if (rto < (uint64_t)BATCH_RTO_MIN_MS * 1000000ULL){
+        return (uint64_t)BATCH_RTO_MIN_MS * 1000000ULL;
+    }
+    return (rto > (uint64_t)BATCH_TIMEOUT_MS * 1000000ULL) ? (uint64_t)BATCH_TIMEOUT_MS * 1000000ULL : rto;
+}
+
+//round trip time sample (RFC 6298 smoothing), 0 = none
+static void batch_pacer_sample(struct batch_pacer *p, uint64_t rtt_ns){
+    if (rtt_ns > 0){
+        if (p->srtt_ns == 0){
+            p->srtt_ns = rtt_ns;
+            p->rttvar_ns = rtt_ns / 2;
+        } else {
+            uint64_t diff = (rtt_ns > p->srtt_ns) ? rtt_ns - p->srtt_ns : p->srtt_ns - rtt_ns;
+            p->rttvar_ns = (p->rttvar_ns * 3 + diff) / 4;
+            p->srtt_ns = (p->srtt_ns * 7 + rtt_ns) / 8;
+        }
+    }
+}
+
+void batch_pacer_ack(struct batch_pacer *p, uint64_t rtt_ns, unsigned int limit){
+    batch_pacer_sample(p, rtt_ns);
+    p->cwnd += (p->cwnd < p->ssthresh) ? 1.0 : 1.0 / p->cwnd; //doubles per round trip, or one per round trip
+    if (p->cwnd > limit){
+        p->cwnd = limit;
+    }
+    if (p->cwnd > p->cwnd_max){
+        p->cwnd_max = p->cwnd;
+    }
+}
+
+void batch_pacer_loss(struct batch_pacer *p, uint64_t sent, uint64_t now){
+    if (sent < p->recovery || p->srtt_ns == 0){ //sent before the last cut (that one already reacted to it),
+        return;                                 //or nothing ever came back (server down, not overloaded)
+    }
+    p->ssthresh = (p->cwnd / 2.0 < 1.0) ? 1.0 : p->cwnd / 2.0;
+    p->cwnd = p->ssthresh;
+    p->recovery = now;
+    p->cuts++;
+}
+
+/*************************************************
+ *          INTERNAL BATCH FUNCTIONS             *
+*************************************************/
+//find in-flight query with the same (qname, qtype)
+static int32_t batch_lookup(const unsigned char *qname, uint16_t qtype, uint32_t hash){
+    for (int32_t i = buckets[hash & bucket_mask]; i != -1; i = slots[i].hnext){
+        if (slots[i].hash == hash && slots[i].qtype == qtype && dnsname_equal(slots[i].qname, qname)){
+            return i;
+        }
+    }
+    return -1;
+}
+
+//add waiter (input line of name) to in-flight query
+static void batch_waiter_add(struct batch_slot *s, const struct batch_name *n){
+    if (s->nwaiters == s->waiters_cap){
+        s->waiters_cap = (s->waiters_cap == 0) ? 4 : s->waiters_cap * 2;
+        s->waiters = realloc(s->waiters, s->waiters_cap * sizeof(struct batch_waiter));
+        if (s->waiters == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+    }
+    s->waiters[s->nwaiters].key = n->key;
+    s->waiters[s->nwaiters].seq = n->seq;
+    s->nwaiters++;
+    waiting++;
+}
+
+//hand waiters of finished query over with its result (the output thread journals them)
+static void batch_result_waiters(struct batch_result *r, struct batch_slot *s){
+    r->waiters = s->nwaiters;
+    if (jr.fd < 0){
+        r->done = NULL;
+        return;
+    }
+    r->done = r->inline_done;
+    if (s->nwaiters > BATCH_RESULT_WAITERS && (r->done = malloc(s->nwaiters * sizeof(struct batch_waiter))) == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        exit(1);
+    }
+    memcpy(r->done, s->waiters, s->nwaiters * sizeof(struct batch_waiter));
+}
+
+//server name for probe arguments ('-s' as given, "address#port" of pool server with more of them)
+static const char *batch_server_name(unsigned int server){
+    return (pool.nservers > 1) ? pool.servers[server].name : par.server;
+}
+
+//put slot at heap position 'pos' (keeps its back-reference in sync)
+static inline void batch_heap_place(uint32_t pos, int32_t idx){
+    dl_heap[pos] = idx;
+    slots[idx].heap_pos = pos;
+}
+
+//restore heap order around slot 'idx' whose deadline changed (or which was just placed at the end)
+static void batch_heap_fix(int32_t idx){
+    uint32_t pos = slots[idx].heap_pos;
+    uint64_t deadline = slots[idx].deadline;
+  //sift up
+    while (pos > 0 && slots[dl_heap[(pos - 1) / 2]].deadline > deadline){
+        batch_heap_place(pos, dl_heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+  //sift down
+    for (;;){
+        uint32_t child = 2 * pos + 1;
+        if (child >= inflight){
+            break;
+        }
+        if (child + 1 < inflight && slots[dl_heap[child + 1]].deadline < slots[dl_heap[child]].deadline){
+            child++;
+        }
+        if (slots[dl_heap[child]].deadline >= deadline){
+            break;
+        }
+        batch_heap_place(pos, dl_heap[child]);
+        pos = child;
+    }
+    batch_heap_place(pos, idx);
+}
+
+//send (or resend) query of slot to its pool server
+static void batch_send(struct batch_slot *s){
+    struct pool_server *srv = &pool.servers[s->server];
+    if (DNS_PROBE_ENABLED(query_send)){
+        char host[256];
+        DNS_PROBE6(query_send, batch_probe_name(s->qname, host), s->qtype, s->id, batch_server_name(s->server), s->query.len,
+                   s->tries + 1);
+    }
+    if (ring.fd >= 0){ //queued, goes out with the next wait
+        uring_send(&ring, s->query.pkt, s->query.len);
+    } else if (sendto(socks[s->sock], s->query.pkt, s->query.len, 0, (struct sockaddr *)&srv->addr, srv->addr_len) < 0){
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS){
+            perror("ERROR: sendto failure");
+            exit(1);
+        }
+        //socket buffer full, the timeout will retransmit it
+    }
+    metric_add(METRIC_QUERIES, 1);
+    metric_add(METRIC_BYTES_OUT, s->query.len);
+    batch_pacer_sent(&srv->pacer);
+    srv->queries++;
+    s->tried |= 1u << s->server;
+    s->tries++;
+    uint64_t rto = batch_pacer_rto(&srv->pacer);
+    if (srv->pacer.srtt_ns != 0){ //backs off on every retry once the timeout is tight
+        rto <<= (s->tries - 1);
+    }
+    s->last_sent = batch_now_ns();
+    s->deadline = s->last_sent + rto;
+    batch_heap_fix((int32_t)(s - slots));
+}
+
+//unlink slot from coalescing table and free its ID
+static void batch_release(int32_t idx){
+    struct batch_slot *s = &slots[idx];
+    int32_t *link = &buckets[s->hash & bucket_mask];
+    while (*link != idx){
+        link = &slots[*link].hnext;
+    }
+    *link = s->hnext;
+
+    id_map[s->id] = -1;
+    pool.servers[s->server].inflight--;
+    s->used = false;
+    waiting -= s->nwaiters;
+    s->nwaiters = 0; //waiters array is kept for reuse
+    inflight--;
+
+  //last heap entry takes its place, slot goes back on the free stack
+    int32_t last = dl_heap[inflight];
+    if (last != idx){
+        batch_heap_place(s->heap_pos, last);
+        batch_heap_fix(last);
+    }
+    free_slots[par.window - inflight - 1] = idx;
+}
+
+//create new in-flight query (or attach to an identical one), 'false' if it has to wait for a free slot
+//(duplicates attach even when windows are full, only a new query has to wait for room in the window of
+//its pool server and for that server's pacer - '*paced' is set to the server when it's the latter)
+static bool batch_submit(const struct batch_name *n, int *paced){
+    const unsigned char *qname = n->qname;
+    uint16_t qtype = n->qtype;
+    uint32_t hash = batch_key_hash(qname, qtype);
+    int32_t idx = batch_lookup(qname, qtype, hash);
+    if (idx != -1){ //already in flight, just wait for its reply
+        batch_waiter_add(&slots[idx], n);
+        bstats.names++;
+        bstats.coalesced++;
+        return true;
+    }
+    uint32_t key = pool_key(qname);
+    uint64_t now = batch_now_ns();
+    bool failover;
+    unsigned int server = pool_pick(&pool, key, now, &failover);
+    struct pool_server *srv = &pool.servers[server];
+    if (inflight >= par.window || srv->inflight >= batch_pacer_window(&srv->pacer)){
+        return false;
+    }
+    if (!batch_pacer_ready(&srv->pacer, now)){
+        *paced = (int)server;
+        return false;
+    }
+    bstats.names++;
+
+  //take free slot and find free transaction ID
+    idx = free_slots[par.window - inflight - 1];
+    struct batch_slot *s = &slots[idx];
+    uint16_t id;
+    do {
+        id = (uint16_t)random();
+    } while (id_map[id] != -1);
+
+  //build packet (retransmits send it unchanged, so late replies to earlier tries still match)
+    dns_query_build(&s->query, qname, n->qlen, qtype, par.recursion);
+    dns_query_patch(&s->query, id, par.recursion);
+    s->qname = &s->query.pkt[sizeof(struct dns_header_t)];
+    if (DNS_PROBE_ENABLED(query_build)){
+        char host[256];
+        DNS_PROBE4(query_build, batch_probe_name(s->qname, host), qtype, id, s->query.len);
+    }
+
+    s->used = true;
+    s->id = id;
+    s->qtype = qtype;
+    s->hash = hash;
+    s->sock = (unsigned int)random() % nsocks; //spread (and make the source port unpredictable)
+    s->server = server;
+    s->key = key;
+    s->tried = 0;
+    s->tries = 0;
+    s->sent = now;
+    TRACE_STAMP(s->trace_sent);
+    s->hnext = buckets[hash & bucket_mask];
+    buckets[hash & bucket_mask] = idx;
+    id_map[id] = idx;
+    batch_heap_place(inflight, idx); //queued at the heap end, batch_send() moves it into place
+    inflight++;
+    srv->inflight++;
+    if (failover){
+        srv->failovers++;
+    }
+    batch_waiter_add(s, n);
+
+    batch_send(s);
+    bstats.queries++;
+    return true;
+}
+
+//hand reply over to output thread (a result slot is known to be free)
+static void batch_complete(int32_t idx, unsigned char *buf, size_t len){
+    struct batch_slot *s = &slots[idx];
+    TRACE_END(TRACE_WIRE, s->trace_sent);
+    bstats.answered++;
+
+    struct batch_result *r = spsc_reserve(&results);
+    r->kind = BATCH_RESULT_REPLY;
+    batch_result_waiters(r, s);
+    r->tries = s->tries;
+    r->len = len;
+    r->data = r->inline_data;
+    if (len > BATCH_RESULT_INLINE && (r->data = malloc(len)) == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        exit(1);
+    }
+    memcpy(r->data, buf, len);
+    spsc_commit(&results);
+    batch_release(idx);
+}
+
+//process one datagram received on pool socket 'sock' ('from' is NULL on a connected socket,
+//the kernel filters the source then)
+static void batch_reply(unsigned char *buf, size_t len, struct sockaddr_storage *from, unsigned int sock){
+    struct dns_header_t *dns = (struct dns_header_t *)buf;
+    uint16_t id = (len >= 2) ? ntohs(dns->id) : 0;
+    int server = (from != NULL) ? pool_find(&pool, from) : 0;
+    const char *server_name = (server >= 0) ? batch_server_name((unsigned int)server) : par.server; //for probes
+    DNS_PROBE3(reply_receive, server_name, len, id);
+    metric_add(METRIC_BYTES_IN, len);
+
+  //check this is a reply to one of our in-flight queries (from a server it was sent to)
+    if (server < 0 ||
+        len < sizeof(struct dns_header_t) + 1 + sizeof(struct dns_question_t) ||
+        dns->qr != 1 || ntohs(dns->qdcount) != 1 ||
+        memchr(&buf[sizeof(struct dns_header_t)], 0, len - sizeof(struct dns_header_t)) == NULL){
+        DNS_PROBE3(reply_mismatch, server_name, len, id);
+        bstats.mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return;
+    }
+    int32_t idx = id_map[id];
+    if (idx == -1 || slots[idx].sock != sock || !(slots[idx].tried & (1u << server))){ //a spoofed reply has to guess source port as well as ID
+        DNS_PROBE3(reply_mismatch, server_name, len, id);
+        bstats.mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return;
+    }
+    struct batch_slot *s = &slots[idx];
+    unsigned char *qname = &buf[sizeof(struct dns_header_t)];
+    size_t qlen = strlen((const char *)qname) + 1;
+    struct dns_question_t *qinfo = (struct dns_question_t *)&buf[sizeof(struct dns_header_t) + qlen];
+    if (sizeof(struct dns_header_t) + qlen + sizeof(struct dns_question_t) > len ||
+        ntohs(qinfo->q_type) != s->qtype || !dnsname_equal(qname, s->qname)){
+        DNS_PROBE3(reply_mismatch, server_name, len, id);
+        bstats.mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return;
+    }
+
+  //SERVFAIL/REFUSED means the server is overloaded, back off; anything else lets the window grow
+    struct batch_pacer *pacer = &pool.servers[server].pacer;
+    uint64_t now = batch_now_ns();
+    uint64_t rtt = (s->tries == 1) ? now - s->sent : 0; //retransmitted ones are ambiguous
+    if (DNS_PROBE_ENABLED(reply_match)){
+        char host[256];
+        DNS_PROBE5(reply_match, batch_probe_name(s->qname, host), s->qtype, id, now - s->sent, dns->rcode);
+    }
+    metric_add(METRIC_RCODE + dns->rcode, 1);
+    if (dns->tc){
+        metric_add(METRIC_TRUNCATED, 1);
+    }
+    if (dns->rcode == 2 || dns->rcode == 5){
+        bstats.refused++;
+        batch_pacer_sample(pacer, rtt);
+        batch_pacer_loss(pacer, s->sent, now);
+    } else {
+        batch_pacer_ack(pacer, rtt, par.window);
+    }
+    pool_reply(&pool, (unsigned int)server, now);
+    batch_complete(idx, buf, len);
+}
+
+//receive every reply waiting in socket (kernel drop counter comes along with every datagram)
+static void batch_recv_sock(unsigned char *buf, unsigned int sock){
+    struct sockaddr_storage from;
+    struct iovec iov = {.iov_base = buf, .iov_len = 65536};
+    char control[CMSG_SPACE(sizeof(uint32_t))];
+    struct msghdr msg;
+    ssize_t len;
+
+    while (spsc_reserve(&results) != NULL){ //otherwise replies wait in socket buffer until output catches up
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &from;
+        msg.msg_namelen = sizeof(from);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        len = recvmsg(socks[sock], &msg, 0);
+        if (len < 0){
+            if (errno == EAGAIN || errno == EWOULDBLOCK){
+                return;
+            }
+            perror("ERROR: recvmsg failure");
+            exit(1);
+        }
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c != NULL; c = CMSG_NXTHDR(&msg, c)){
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL){
+                memcpy(&sock_drops[sock], CMSG_DATA(c), sizeof(uint32_t));
+            }
+        }
+        batch_reply(buf, (size_t)len, &from, sock);
+    }
+}
+
+//receive every reply waiting in io_uring buffers or in ready sockets
+static void batch_recv_all(unsigned char *buf, struct pollfd *pfds){
+    if (ring.fd >= 0){ //already received into provided buffers, no syscalls needed
+        unsigned char *data;
+        size_t dlen;
+        unsigned short bid;
+        while (spsc_reserve(&results) != NULL && uring_recv_next(&ring, &data, &dlen, &bid)){
+            batch_reply(data, dlen, NULL, 0);
+            uring_recv_done(&ring, bid);
+        }
+        return;
+    }
+
+    for (unsigned int i = 0; i < nsocks; i++){
+        if (pfds[i].revents & POLLIN){
+            batch_recv_sock(buf, i);
+        }
+    }
+}
+
+//set up pool socket: random source port, large kernel buffers, kernel drop counter
+static void batch_sock_setup(unsigned int i){
+    int fd = socks[i];
+    int one = 1;
+    struct sockaddr_storage local;
+    socklen_t local_len = pool.servers[0].addr_len;
+
+  //bind to random port (kernel picks one if all tries are taken)
+    for (int t = 0; t <= BATCH_PORT_TRIES; t++){
+        uint16_t port = (t == BATCH_PORT_TRIES) ? 0 : (uint16_t)(1024 + random() % (65536 - 1024));
+        memset(&local, 0, sizeof(local));
+        local.ss_family = pool.servers[0].addr.ss_family;
+        if (local.ss_family == AF_INET6){
+            ((struct sockaddr_in6 *)&local)->sin6_port = htons(port);
+        } else {
+            ((struct sockaddr_in *)&local)->sin_port = htons(port);
+        }
+        if (bind(fd, (struct sockaddr *)&local, local_len) == 0){
+            break;
+        }
+    }
+    local_len = sizeof(local);
+    getsockname(fd, (struct sockaddr *)&local, &local_len);
+    sock_ports[i] = ntohs((local.ss_family == AF_INET6) ? ((struct sockaddr_in6 *)&local)->sin6_port : ((struct sockaddr_in *)&local)->sin_port);
+
+  //buffers past rmem_max/wmem_max need CAP_NET_ADMIN (FORCE variants), otherwise the kernel caps them
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &par.rcvbuf, sizeof(par.rcvbuf)) != 0){
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &par.rcvbuf, sizeof(par.rcvbuf));
+    }
+    if (setsockopt(fd, SOL_SOCKET, SO_SNDBUFFORCE, &par.sndbuf, sizeof(par.sndbuf)) != 0){
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &par.sndbuf, sizeof(par.sndbuf));
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+//retransmit or give up on queries past their deadline (earliest deadline first)
+static void batch_check_timeouts(){
+    uint64_t now = batch_now_ns();
+    while (inflight > 0 && slots[dl_heap[0]].deadline <= now){
+        int32_t i = dl_heap[0];
+        struct batch_slot *s = &slots[i];
+        struct batch_result *r = NULL;
+        if (s->tries > BATCH_RETRIES && (r = spsc_reserve(&results)) == NULL){
+            break; //a failure is reported by output thread too, so it waits for a free result slot
+        }
+        if (DNS_PROBE_ENABLED(query_timeout)){
+            char host[256];
+            DNS_PROBE5(query_timeout, batch_probe_name(s->qname, host), s->qtype, s->id, s->tries, s->tries > BATCH_RETRIES);
+        }
+        metric_add(METRIC_TIMEOUTS, 1);
+        batch_pacer_loss(&pool.servers[s->server].pacer, s->sent, now);
+        pool_timeout(&pool, s->server, s->last_sent, now);
+        if (s->tries <= BATCH_RETRIES){
+            unsigned int next = pool_next(&pool, s->key, s->server, now); //fails over to the next server clockwise
+            if (next != s->server){
+                pool.servers[s->server].inflight--;
+                pool.servers[next].inflight++;
+                pool.servers[next].failovers++;
+                s->server = next;
+            }
+            batch_send(s); //new deadline is in the future, slot sinks in the heap
+            bstats.retransmits++;
+        } else {
+            r->kind = BATCH_RESULT_FAILED;
+            batch_result_waiters(r, s);
+            r->tries = s->tries;
+            r->len = strlen((const char *)s->qname) + 1;
+            r->data = r->inline_data;
+            memcpy(r->data, s->qname, r->len);
+            spsc_commit(&results);
+            bstats.failed++;
+            batch_release(i);
+        }
+    }
+}
+
+//milliseconds until nearest deadline
+static int batch_next_timeout(){
+    if (inflight == 0){
+        return -1;
+    }
+    uint64_t now = batch_now_ns();
+    uint64_t nearest = slots[dl_heap[0]].deadline;
+    return (nearest <= now) ? 0 : (int)((nearest - now) / 1000000ULL) + 1;
+}
+
+//coalescing summary
+static void batch_stats_print(){
+    double ratio = bstats.queries ? (double)bstats.names / (double)bstats.queries : 0.0;
+    double saved = bstats.names ? 100.0 * (double)bstats.coalesced / (double)bstats.names : 0.0;
+    fprintf(stderr, "Batch: %lu names, %lu queries sent, %lu coalesced (%.1f%% upstream load avoided, %.2f names/query)\r\n",
+            bstats.names, bstats.queries, bstats.coalesced, saved, ratio);
+    fprintf(stderr, "       %lu answered, %lu failed, %lu retransmits, %lu mismatched replies, %lu invalid names\r\n",
+            bstats.answered, bstats.failed, bstats.retransmits, bstats.mismatched, bstats.invalid);
+}
+
+//pacing summary (windows and cuts summed over pool servers, round trip averaged over the measured ones)
+static void batch_pacer_print(uint64_t elapsed_ns){
+    double secs = (double)elapsed_ns / 1e9;
+    unsigned int max = 0, final = 0, measured = 0;
+    unsigned long cuts = 0;
+    uint64_t srtt = 0;
+    for (unsigned int i = 0; i < pool.nservers; i++){
+        struct batch_pacer *p = &pool.servers[i].pacer;
+        max += (unsigned int)p->cwnd_max;
+        final += batch_pacer_window(p);
+        cuts += p->cuts;
+        if (p->srtt_ns != 0){
+            srtt += p->srtt_ns;
+            measured++;
+        }
+    }
+    fprintf(stderr, "Pacing: window %u --> %u max (%u final, limit %u), %lu cuts, %lu SERVFAIL/REFUSED, "
+                    "srtt %.2f ms, %.0f queries/s\r\n",
+            BATCH_CWND_INIT * pool.nservers, max, final, par.window, cuts, bstats.refused,
+            measured ? (double)srtt / measured / 1e6 : 0.0, secs > 0 ? (double)(bstats.queries + bstats.retransmits) / secs : 0.0);
+}
+
+//socket pool summary (buffer sizes as the kernel reports them, it doubles requested ones for bookkeeping)
+static void batch_socks_print(){
+    int rcvbuf = 0, sndbuf = 0;
+    socklen_t optlen = sizeof(int);
+    getsockopt(socks[0], SOL_SOCKET, SO_RCVBUF, &rcvbuf, &optlen);
+    optlen = sizeof(int);
+    getsockopt(socks[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, &optlen);
+    unsigned long drops = 0;
+    fprintf(stderr, "Sockets: %u on ports", nsocks);
+    for (unsigned int i = 0; i < nsocks; i++){
+        fprintf(stderr, " %u", sock_ports[i]);
+        drops += sock_drops[i];
+    }
+    fprintf(stderr, ", rcvbuf %d (requested %d), sndbuf %d (requested %d), %lu datagrams dropped by kernel%s\r\n",
+            rcvbuf, par.rcvbuf, sndbuf, par.sndbuf, drops, (drops > 0) ? " (receive queue overflow, raise --rcvbuf)" : "");
+}
+
+//io_uring summary
+static void batch_uring_print(){
+    unsigned long ops = ring.sends + ring.recvs;
+    fprintf(stderr, "io_uring: %lu sends, %lu receives in %lu syscalls (%.1f datagrams/syscall), %lu send errors\r\n",
+            ring.sends, ring.recvs, ring.enters, ring.enters ? (double)ops / (double)ring.enters : 0.0, ring.send_errors);
+}
+
+//pipeline summary (how full the rings ran, how long each side waited on the other)
+static void batch_pipeline_print(){
+    fprintf(stderr, "Pipeline: input --> I/O ring avg %.1f/%u max %u (input waited %.3f s, I/O found it empty %lu times), "
+                    "I/O --> output ring avg %.1f/%u max %u (output waited %.3f s, I/O paused %.3f s for output)\r\n",
+            names.commits ? (double)names.occupancy_sum / (double)names.commits : 0.0, names.size, names.occupancy_max,
+            (double)names.full_ns / 1e9, bstats.starved,
+            results.commits ? (double)results.occupancy_sum / (double)results.commits : 0.0, results.size,
+            results.occupancy_max, (double)results.empty_ns / 1e9, (double)bstats.held_ns / 1e9);
+}
+
+/*************************************************
+ *                PIPELINE STAGES                *
+*************************************************/
+//input thread: reads names, encodes them into DNSnames (one slot per query type asked, those a resumed
+//'--journal' run already did are left out)
+static void *batch_input_stage(void *arg){
+    struct input_reader *in = arg;
+    uint16_t qtypes[2] = {par.reverse ? DNS_QTYPE_PTR : par.Qtype}; //query types every name is asked for
+    int nqtypes = 1;
+    if (par.dual){ //A and AAAA back-to-back
+        qtypes[0] = DNS_QTYPE_A;
+        qtypes[1] = DNS_QTYPE_AAAA;
+        nqtypes = 2;
+    }
+
+    const char *name;
+    size_t len;
+    uint64_t offset, seq = 0;
+    while (input_next(in, &name, &len, &offset)){
+        bool todo[2] = {true, true};
+        if (jr.resumed){
+            int ntodo = 0;
+            for (int i = 0; i < nqtypes; i++){
+                todo[i] = !journal_skip(&jr, JOURNAL_KEY(offset, i));
+                ntodo += todo[i];
+            }
+            if (ntodo == 0){
+                continue;
+            }
+        }
+
+        struct batch_name *n = spsc_reserve_wait(&names);
+        TRACE_START(t_qname);
+        size_t qlen = batch_qname_build(name, len, n->qname);
+        TRACE_END(TRACE_QNAME, t_qname);
+        if (qlen == 0){
+            fprintf(stderr, "WARNING: skipping invalid name: %.*s\r\n", (int)(len > 255 ? 255 : len), name);
+            bstats.invalid++;
+            continue;
+        }
+        struct batch_name *first = NULL;
+        for (int i = 0; i < nqtypes; i++){
+            if (!todo[i]){
+                continue;
+            }
+            if (first != NULL){
+                n = spsc_reserve_wait(&names);
+                memcpy(n->qname, first->qname, qlen);
+            }
+            first = n;
+            n->end = false;
+            n->qtype = qtypes[i];
+            n->qlen = (uint16_t)qlen;
+            n->key = JOURNAL_KEY(offset, i);
+            n->seq = seq++;
+            spsc_commit(&names);
+        }
+    }
+    struct batch_name *n = spsc_reserve_wait(&names);
+    n->end = true;
+    spsc_commit(&names);
+    return NULL;
+}
+
+//decode reply and print it once for every waiter
+static void batch_output_reply(struct batch_result *r){
+    unsigned char *buf = r->data;
+    struct dns_header_t *dns = (struct dns_header_t *)buf;
+    unsigned char *qname = &buf[sizeof(struct dns_header_t)];
+    size_t qlen = strlen((const char *)qname) + 1;
+    struct dns_question_t *qinfo = (struct dns_question_t *)&buf[sizeof(struct dns_header_t) + qlen];
+
+    unsigned char host[256];
+    memcpy(host, qname, qlen);
+    DNSname_to_hostname(host);
+    uint16_t qtype = ntohs(qinfo->q_type), id = ntohs(dns->id);
+
+    if (par.addresses_only){ //addresses straight out of the reply, formatted once for every waiter
+        struct addr_only addrs;
+        char text[ADDR_ONLY_TEXT_MAX];
+        DNS_PROBE4(decode_start, host, qtype, id, r->len);
+        TRACE_START(t_decode);
+        int bad = addr_only_extract(buf, r->len, &addrs);
+        TRACE_END(TRACE_DECODE, t_decode);
+        if (bad){
+            metric_add(METRIC_DECODE_ERRORS, 1);
+            fprintf(stderr, "ERROR: reply for query #%u is malformed\r\n", id);
+            return;
+        }
+        DNS_PROBE4(decode_end, host, qtype, id, addrs.count);
+        TRACE_START(t_print);
+        size_t len = addr_only_format(&addrs, host, text);
+        for (uint32_t i = 0; i < r->waiters; i++){
+            fwrite(text, 1, len, stdout);
+        }
+        TRACE_END(TRACE_PRINT, t_print);
+        DNS_PROBE4(print, host, qtype, id, r->waiters);
+        return;
+    }
+
+    if (ntohs(dns->ancount) > 50 || ntohs(dns->nscount) > 50 || ntohs(dns->arcount) > 50){
+        metric_add(METRIC_DECODE_ERRORS, 1);
+        fprintf(stderr, "ERROR: reply for query #%u has too many records to decode\r\n", id);
+        return;
+    }
+
+    struct dns_replies dns_rep;
+    DNS_PROBE4(decode_start, host, qtype, id, r->len);
+    TRACE_START(t_decode);
+    int bad = dns_reply_load(buf, r->len, &buf[sizeof(struct dns_header_t) + qlen + sizeof(struct dns_question_t)], dns, &dns_rep);
+    TRACE_END(TRACE_DECODE, t_decode);
+    if (bad){ //record running past the end of the reply, nothing of it is printed
+        metric_add(METRIC_DECODE_ERRORS, 1);
+        fprintf(stderr, "ERROR: reply for query #%u is malformed\r\n", id);
+        return;
+    }
+    DNS_PROBE4(decode_end, host, qtype, id, ntohs(dns->ancount) + ntohs(dns->nscount) + ntohs(dns->arcount));
+
+    TRACE_START(t_print);
+    if (shmw.hdr != NULL){ //published once with its waiter count, readers fan it out
+        shm_add_reply(&shmw, dns, qinfo, &dns_rep, host, r->waiters);
+    } else if (colw.fd >= 0){ //stored once with its waiter count, the reader fans it out
+        if (col_add_reply(&colw, dns, qinfo, &dns_rep, host, r->waiters) != 0){
+            perror("ERROR: output file write failure");
+            exit(1);
+        }
+    } else {
+        for (uint32_t i = 0; i < r->waiters; i++){ //fan out to every waiter
+            project_print(dns, qinfo, &dns_rep, host);
+        }
+    }
+    TRACE_END(TRACE_PRINT, t_print);
+    DNS_PROBE4(print, host, qtype, id, r->waiters);
+
+    clean_exit(dns, &dns_rep);
+}
+
+//checkpoint: output written so far goes to disk first, then the journal block saying it's done
+static void batch_checkpoint(){
+    fflush(stdout);
+    fdatasync(STDOUT_FILENO); //fails on terminals and pipes, nothing to keep there anyway
+    if (colw.fd >= 0 && col_sync(&colw) != 0){
+        perror("ERROR: output file write failure");
+        exit(1);
+    }
+    if (journal_sync(&jr, batch_now_ns()) != 0){
+        perror("ERROR: journal write failure");
+        exit(1);
+    }
+}
+
+//output thread: decodes and prints results, the only one writing stdout (or the '-o' file, or the '--shm' ring)
+static void *batch_output_stage(void *arg){
+    (void)arg;
+    while (true){
+        while (jr.fd >= 0 && spsc_peek(&results) == NULL){ //idle, completions still waiting get their checkpoint once it's due
+            if (journal_due(&jr, batch_now_ns())){
+                batch_checkpoint();
+            }
+            poll(NULL, 0, 1);
+        }
+        struct batch_result *r = spsc_peek_wait(&results);
+        if (r->kind == BATCH_RESULT_END){
+            spsc_release(&results);
+            break;
+        }
+        if (r->kind == BATCH_RESULT_REPLY){
+            batch_output_reply(r);
+        } else {
+            unsigned char host[256];
+            memcpy(host, r->data, r->len);
+            DNSname_to_hostname(host);
+            for (uint32_t i = 0; i < r->waiters; i++){
+                fprintf(stderr, "ERROR: no reply received for %s after %u attempts\r\n", host, r->tries);
+            }
+        }
+        if (r->data != r->inline_data){
+            free(r->data);
+        }
+        if (r->done != NULL){ //'--journal'
+            for (uint32_t i = 0; i < r->waiters; i++){
+                journal_add(&jr, r->done[i].seq, r->done[i].key);
+            }
+            if (r->done != r->inline_done){
+                free(r->done);
+            }
+            if (journal_due(&jr, batch_now_ns())){
+                batch_checkpoint();
+            }
+        }
+        spsc_release(&results);
+    }
+    if (jr.fd >= 0){
+        batch_checkpoint();
+    }
+    fflush(stdout);
+    return NULL;
+}
+
+/*************************************************
+ *                  BATCH RUN
+*************************************************/
+int batch_run(){
+  //open input
+    struct input_reader in;
+    if (input_open(&in, par.infile) != 0){
+        return 1;
+    }
+
+  //open journal (names done by an earlier run are skipped, their output is already there)
+    jr.fd = -1;
+    if (strcmp(par.journalfile, "") != 0 && journal_open(&jr, par.journalfile, par.infile) != 0){
+        input_close(&in);
+        return 1;
+    }
+
+  //open columnar output (a resumed run appends to it)
+    colw.fd = -1;
+    if (strcmp(par.outfile, "") != 0 && col_open(&colw, par.outfile, jr.resumed) != 0){
+        input_close(&in);
+        return 1;
+    }
+    if (strcmp(par.shmname, "") != 0 && shm_open_writer(&shmw, par.shmname, par.shmsize) != 0){
+        input_close(&in);
+        return 1;
+    }
+
+  //prepare socket (non-blocking, we wait in poll instead)
+    struct sockaddr_in dest;
+    struct sockaddr_in6 dest6;
+    memset(&dest, 0, sizeof(dest));
+    memset(&dest6, 0, sizeof(dest6));
+    TRACE_START(t_socket);
+    sock_prep(&socks[0], &dest, &dest6);
+    if (pool_open(&pool, is_it_IPv6(par.server) ? AF_INET6 : AF_INET, batch_now_ns()) != 0){ //every server over the sockets' family
+        return 1;
+    }
+    srandom((unsigned int)(batch_now_ns() ^ (uint64_t)getpid()));
+    nsocks = par.uring ? 1 : par.sockets; //io_uring instance works on one socket
+    for (unsigned int i = 0; i < nsocks; i++){
+        if (i > 0 && (socks[i] = socket(pool.servers[0].addr.ss_family, SOCK_DGRAM, IPPROTO_UDP)) < 0){
+            perror("ERROR: socket failure");
+            exit(1);
+        }
+        batch_sock_setup(i);
+    }
+    TRACE_END(TRACE_SOCKET, t_socket);
+    ring.fd = -1;
+    if (par.uring){ //connected socket, so sends need no address and the kernel drops foreign datagrams
+        if (connect(socks[0], (struct sockaddr *)&pool.servers[0].addr, pool.servers[0].addr_len) != 0 ||
+            uring_open(&ring, socks[0]) != 0){
+            fprintf(stderr, "WARNING: io_uring isn't available, using plain sockets\r\n");
+        }
+    }
+
+  //prepare in-flight tables
+    if (par.dual && par.window < 2){ //both queries of a name have to fit
+        par.window = 2;
+    }
+    uint32_t nbuckets = 1;
+    while (nbuckets < par.window * 2){
+        nbuckets <<= 1;
+    }
+    bucket_mask = nbuckets - 1;
+    slots = calloc(par.window, sizeof(struct batch_slot));
+    buckets = malloc(nbuckets * sizeof(int32_t));
+    free_slots = malloc(par.window * sizeof(int32_t));
+    dl_heap = malloc(par.window * sizeof(int32_t));
+    unsigned char *buf = malloc(65536);
+    if (slots == NULL || buckets == NULL || free_slots == NULL || dl_heap == NULL || buf == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    memset(buckets, 0xff, nbuckets * sizeof(int32_t)); //-1
+    memset(id_map, 0xff, sizeof(id_map));              //-1
+    for (unsigned int i = 0; i < par.window; i++){     //lowest index on top
+        free_slots[i] = (int32_t)(par.window - 1 - i);
+    }
+    uint64_t start = batch_now_ns();
+
+  //start input and output stages, this thread drives the sockets only
+    if (spsc_init(&names, BATCH_NAME_RING, sizeof(struct batch_name)) != 0 ||
+        spsc_init(&results, BATCH_RESULT_RING, sizeof(struct batch_result)) != 0){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    if (par.compress != ZOUT_NONE && zout_open(&zo, par.compress, par.compress_level) != 0){ //before printing starts
+        return 1;
+    }
+    pthread_t input_thread, output_thread;
+    if (pthread_create(&input_thread, NULL, batch_input_stage, &in) != 0 ||
+        pthread_create(&output_thread, NULL, batch_output_stage, NULL) != 0){
+        fprintf(stderr, "ERROR: couldn't create thread\r\n");
+        return 1;
+    }
+
+  //main loop
+    bool eof = false;
+    struct pollfd pfds[BATCH_SOCKETS_MAX];
+    for (unsigned int i = 0; i < nsocks; i++){
+        pfds[i].fd = socks[i];
+        pfds[i].events = POLLIN;
+    }
+
+    uint64_t held_since = 0;
+    while (!eof || inflight > 0){
+        //output thread is behind: replies stay in socket buffers, nothing new is sent and deadlines
+        //don't run (the replies are here, just not read yet), so a slow stdout never causes retransmits
+        if (spsc_reserve(&results) == NULL){
+            if (held_since == 0){
+                held_since = batch_now_ns();
+            }
+            if (ring.fd >= 0 && uring_wait(&ring, 0) != 0){ //already queued sends still go out
+                perror("ERROR: io_uring failure");
+                exit(1);
+            }
+            poll(NULL, 0, 1);
+            continue;
+        }
+        if (held_since != 0){
+            uint64_t held = batch_now_ns() - held_since;
+            for (unsigned int i = 0; i < inflight; i++){ //same shift for all, heap order holds
+                slots[dl_heap[i]].deadline += held;
+            }
+            bstats.held_ns += held;
+            held_since = 0;
+        }
+
+        //keep the windows full (but don't read ahead unboundedly while duplicates keep coalescing),
+        //sending only as fast as the pacers allow
+        int paced = -1;
+        bool starved = false;
+        while (!eof && waiting < (uint64_t)par.window * BATCH_BACKLOG){
+            struct batch_name *n = spsc_peek(&names);
+            if (n == NULL){
+                starved = true;
+                bstats.starved++;
+                break;
+            }
+            if (n->end){
+                eof = true;
+                spsc_release(&names);
+                break;
+            }
+            if (!batch_submit(n, &paced)){
+                break; //name stays pending until there's room for it
+            }
+            spsc_release(&names);
+        }
+        if (eof && inflight == 0){
+            break;
+        }
+
+        //wait for replies (or nearest timeout, or next token if sending is held back by pacing),
+        //looking back at the input ring every millisecond while the input thread is behind
+        int timeout = batch_next_timeout();
+        if (paced >= 0){
+            int wait = batch_pacer_wait_ms(&pool.servers[paced].pacer, batch_now_ns());
+            timeout = (timeout < 0 || wait < timeout) ? wait : timeout;
+        }
+        if (starved && (timeout < 0 || timeout > 1)){
+            timeout = 1;
+        }
+        if (ring.fd >= 0){
+            if (uring_wait(&ring, timeout) != 0){
+                perror("ERROR: io_uring failure");
+                exit(1);
+            }
+            batch_recv_all(buf, pfds);
+        } else {
+            int ready = poll(pfds, nsocks, timeout);
+            if (ready < 0 && errno != EINTR){
+                perror("ERROR: poll failure");
+                exit(1);
+            }
+            if (ready > 0){
+                batch_recv_all(buf, pfds);
+            }
+        }
+        batch_check_timeouts();
+    }
+
+  //let output drain, every stage is done after this
+    struct batch_result *r = spsc_reserve_wait(&results);
+    r->kind = BATCH_RESULT_END;
+    r->data = r->inline_data;
+    r->done = NULL;
+    spsc_commit(&results);
+    pthread_join(output_thread, NULL);
+    pthread_join(input_thread, NULL);
+    if (par.compress != ZOUT_NONE && zout_close(&zo) != 0){ //ends compressed stream
+        exit(1);
+    }
+
+    batch_stats_print();
+    batch_pacer_print(batch_now_ns() - start);
+    if (pool.nservers > 1){
+        pool_print(&pool);
+    }
+    batch_socks_print();
+    if (ring.fd >= 0){
+        batch_uring_print();
+    }
+    batch_pipeline_print();
+    if (par.compress != ZOUT_NONE){
+        zout_print(&zo);
+    }
+    if (colw.fd >= 0){
+        if (col_close(&colw) != 0){ //writes last block
+            perror("ERROR: output file write failure");
+            exit(1);
+        }
+        fprintf(stderr, "Columnar: %lu replies, %lu records in %lu blocks, %lu bytes written to %s\r\n",
+                colw.replies, colw.records, colw.blocks, (unsigned long)colw.bytes, par.outfile);
+    }
+    if (jr.fd >= 0){
+        fprintf(stderr, "Journal: %lu queries done by an earlier run skipped, %lu completions checkpointed to %s "
+                        "in %lu blocks (%lu bytes)\r\n", jr.skipped, jr.completions, par.journalfile, jr.blocks,
+                (unsigned long)jr.bytes);
+        journal_close(&jr);
+    }
+    if (shmw.hdr != NULL){
+        shm_close_writer(&shmw);
+        fprintf(stderr, "Shared memory: %lu replies published to /dev/shm/%s (%lu byte ring, wrapped %lu times), "
+                        "%lu too large for the ring\r\n", shmw.replies, par.shmname, (unsigned long)par.shmsize, shmw.laps,
+                shmw.dropped);
+    }
+
+  //cleanup
+    for (unsigned int i = 0; i < par.window; i++){
+        free(slots[i].waiters);
+    }
+    free(slots);
+    free(free_slots);
+    free(dl_heap);
+    free(buckets);
+    free(buf);
+    spsc_free(&names);
+    spsc_free(&results);
+    uring_close(&ring);
+    pool_close(&pool);
+    for (unsigned int i = 0; i < nsocks; i++){
+        close(socks[i]);
+    }
+    input_close(&in);
+
+    return (bstats.failed > 0 || bstats.invalid > 0) ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+/** @file:   batch.h
+ *  @brief:  Batch resolution of name lists with in-flight query coalescing
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "dns.h"
+
+#define BATCH_WINDOW_DEFAULT 1024 //default upper limit of queries kept in flight at once (pacing adapts below it)
+#define BATCH_WINDOW_MAX     4096 //upper limit of '-w'
+#define BATCH_TIMEOUT_MS     2000 //how long to wait for a reply before retransmitting (before round trip is known)
+#define BATCH_RTO_MIN_MS     200  //retransmit timeout lower limit once it's derived from measured round trips
+#define BATCH_RETRIES        2    //retransmits before a query is given up on
+#define BATCH_BACKLOG        16   //names per window slot read ahead (waiting on coalesced queries) at most
+#define BATCH_CWND_INIT      10   //in-flight window a batch starts with (like TCP initial window)
+#define BATCH_BURST          4    //token bucket depth (queries sent back-to-back at most)
+#define BATCH_PACING_GAIN    1.25 //send rate relative to window / round trip time
+#define BATCH_SOCKETS_DEFAULT 4         //UDP sockets (source ports) queries are spread across
+#define BATCH_SOCKETS_MAX    64         //upper limit of '--sockets'
+#define BATCH_RCVBUF_DEFAULT (4 << 20)  //requested SO_RCVBUF of every socket
+#define BATCH_SNDBUF_DEFAULT (1 << 20)  //requested SO_SNDBUF of every socket
+#define BATCH_PORT_TRIES     16         //random source ports tried before leaving the choice to the kernel
+#define BATCH_NAME_RING      4096       //encoded names queued between input and I/O thread (power of two)
+#define BATCH_RESULT_RING    1024       //replies queued between I/O and output thread (power of two)
+#define BATCH_RESULT_INLINE  1232       //reply bytes kept in the result slot itself (bigger replies go to heap)
+#define BATCH_RESULT_WAITERS 4          //waiters kept in the result slot itself for '--journal' (more go to heap)
+
+/**
+ * @struct: input line waiting for a query
+*/
+struct batch_waiter{
+    uint64_t key;         /* JOURNAL_KEY of the line's query (input offset and query type part) */
+    uint64_t seq;         /* sequence number of the line's query in this run (input order) */
+};
+
+/**
+ * @struct: one outstanding (in-flight) query
+ *
+ * Every input line asking the same (qname, qtype) while this query is in flight
+ * is attached to it as a waiter instead of being sent again.
+*/
+struct batch_slot{
+    bool used;
+    uint16_t id;          /* transaction ID the query was sent with */
+    uint16_t qtype;       /* query type (host byte order) */
+    struct dns_query_t query; /* the query packet (serialized once, resent as is) */
+    unsigned char *qname; /* points to qname (DNSname, lowercase) inside @param query */
+    uint32_t hash;        /* coalescing key hash */
+    int32_t hnext;        /* next slot in the same coalescing bucket (-1 = none) */
+    unsigned int sock;    /* pool socket the query is sent from (reply has to arrive on it) */
+    unsigned int server;  /* pool server the last try went to */
+    uint32_t key;         /* ring position of qname in server pool */
+    uint32_t tried;       /* bit mask of pool servers the query went to (a reply has to come from one of them) */
+    unsigned int tries;   /* amount of times the query was sent */
+    uint64_t sent;        /* monotonic ns timestamp of first send */
+    uint64_t last_sent;   /* monotonic ns timestamp of latest try */
+#ifdef DNS_TRACE
+    uint64_t trace_sent;  /* trace clock ticks at first send (--trace-phases) */
+#endif
+    uint64_t deadline;    /* monotonic ns timestamp of retransmit/give up */
+    uint32_t heap_pos;    /* position of the slot in the deadline heap (while in use) */
+    struct batch_waiter *waiters; /* all lines waiting for this query */
+    uint32_t nwaiters;
+    uint32_t waiters_cap;
+};
+
+/**
+ * @struct: encoded name passed from input thread to I/O thread (one per query type asked)
+*/
+struct batch_name{
+    bool end;             /* input is exhausted (no name in this slot) */
+    uint16_t qtype;       /* query type (host byte order) */
+    uint16_t qlen;        /* length of @param qname including the terminating zero */
+    uint64_t key;         /* JOURNAL_KEY of the query (input offset of the line, query type part) */
+    uint64_t seq;         /* sequence number of the query (in input order, skipped ones don't get any) */
+    unsigned char qname[256]; /* lowercase DNSname */
+};
+
+/**
+ * @enum: what a result slot carries
+*/
+enum batch_result_kind{
+    BATCH_RESULT_REPLY,   /* reply to decode and print once per waiter */
+    BATCH_RESULT_FAILED,  /* query given up on, @param data holds its qname */
+    BATCH_RESULT_END      /* batch is over, output thread finishes */
+};
+
+/**
+ * @struct: finished query passed from I/O thread to output thread
+*/
+struct batch_result{
+    enum batch_result_kind kind;
+    uint32_t waiters;     /* input lines the result is printed for */
+    unsigned int tries;   /* amount of times the query was sent */
+    size_t len;           /* length of @param data (decoding must stay within it, a heap copy has nothing past it) */
+    unsigned char *data;  /* points to @param inline_data, or to exact-length heap copy of a bigger reply */
+    unsigned char inline_data[BATCH_RESULT_INLINE];
+    struct batch_waiter *done; /* lines answered (for '--journal' only, NULL otherwise), points to
+                                  @param inline_done, or to heap copy of a longer list */
+    struct batch_waiter inline_done[BATCH_RESULT_WAITERS];
+};
+
+/**
+ * @struct: per-server send pacing (AIMD window + token bucket)
+ *
+ * The window grows while replies keep arriving (doubling per round trip until the first loss,
+ * by one per round trip after it) and is halved on timeouts and SERVFAIL/REFUSED replies.
+ * Sends are spaced by a token bucket refilled at window / round trip time, so a window
+ * is spread across the round trip instead of going out in one burst.
+*/
+struct batch_pacer{
+    double cwnd;          /* in-flight window */
+    double ssthresh;      /* window doubles per round trip below this, grows by one above it */
+    double cwnd_max;      /* largest window reached */
+    double tokens;        /* token bucket fill (one token = one send) */
+    uint64_t refilled;    /* monotonic ns timestamp of last token refill */
+    uint64_t srtt_ns;     /* smoothed round trip time (0 = not measured yet) */
+    uint64_t rttvar_ns;   /* round trip time variation */
+    uint64_t recovery;    /* losses of queries sent before this don't cut the window again */
+    unsigned long cuts;   /* multiplicative decreases */
+};
+
+/**
+ * @struct: batch run counters
+*/
+struct batch_stats{
+    unsigned long names;       /* valid names read from input */
+    unsigned long invalid;     /* lines skipped because of invalid name */
+    unsigned long queries;     /* unique queries sent (not counting retransmits) */
+    unsigned long coalesced;   /* names attached to an already in-flight query */
+    unsigned long retransmits;
+    unsigned long answered;    /* queries which received a reply */
+    unsigned long failed;      /* queries given up on (timeout) */
+    unsigned long mismatched;  /* replies not matching any in-flight query */
+    unsigned long refused;     /* SERVFAIL/REFUSED replies (server overload signal) */
+    unsigned long starved;     /* I/O loop rounds input thread had no name ready */
+    uint64_t held_ns;          /* time I/O was paused because output thread was behind */
+};
+
+extern struct batch_stats bstats;
+
+/**
+ * @function: batch_now_ns
+ * @brief monotonic clock in nanoseconds
+ *
+ * @return current monotonic time
+*/
+uint64_t batch_now_ns();
+
+/**
+ * @function: batch_key_hash
+ * @brief coalescing key hash of a (qname, qtype) pair, case insensitive
+ *
+ * @param[in] qname: DNSname (3www6google3com0)
+ * @param[in] qtype: query type
+ * @return 32-bit hash
+*/
+uint32_t batch_key_hash(const unsigned char *qname, uint16_t qtype);
+
+/**
+ * @function: dnsname_equal
+ * @brief case insensitive comparison of two DNSnames
+ *
+ * @param[in] a: first DNSname
+ * @param[in] b: second DNSname
+ * @return 'true' if names are equal, 'false' if not
+*/
+bool dnsname_equal(const unsigned char *a, const unsigned char *b);
+
+/**
+ * @function: batch_qname_build
+ * @brief converts one input line into a lowercase DNSname according to program parameters
+ *        (reverse name for '-x', plain hostname otherwise), without any libc lookups
+ *
+ * @param[in] name:  input name (doesn't have to be NUL terminated)
+ * @param[in] len:   length of @param name
+ * @param[in] qname: buffer (at least 256 chars) to save resulting DNSname into
+ * @return length of DNSname including the terminating zero, 0 if @param name is invalid
+*/
+size_t batch_qname_build(const char *name, size_t len, unsigned char *qname);
+
+/**
+ * @function: batch_pacer_init
+ * @brief sets pacer to its starting state (small window, full bucket, no round trip measured)
+ *
+ * @param[in] p:   pacer
+ * @param[in] now: current monotonic time
+*/
+void batch_pacer_init(struct batch_pacer *p, uint64_t now);
+
+/**
+ * @function: batch_pacer_window
+ * @brief current in-flight window
+ *
+ * @param[in] p: pacer
+ * @return amount of queries allowed in flight
+*/
+unsigned int batch_pacer_window(struct batch_pacer *p);
+
+/**
+ * @function: batch_pacer_ready
+ * @brief refills token bucket, checks one more query may be sent now
+ *
+ * @param[in] p:   pacer
+ * @param[in] now: current monotonic time
+ * @return 'true' if a token is available, 'false' if not
+*/
+bool batch_pacer_ready(struct batch_pacer *p, uint64_t now);
+
+/**
+ * @function: batch_pacer_sent
+ * @brief takes one token for a sent (or resent) query
+ *
+ * @param[in] p: pacer
+*/
+void batch_pacer_sent(struct batch_pacer *p);
+
+/**
+ * @function: batch_pacer_wait_ms
+ * @brief time until next token is available
+ *
+ * @param[in] p:   pacer
+ * @param[in] now: current monotonic time
+ * @return milliseconds to wait (0 if a token is available)
+*/
+int batch_pacer_wait_ms(struct batch_pacer *p, uint64_t now);
+
+/**
+ * @function: batch_pacer_rto
+ * @brief retransmit timeout (srtt + 4 * rttvar, clamped to BATCH_RTO_MIN_MS..BATCH_TIMEOUT_MS),
+ *        so losses are noticed (and the window cut) within a few round trips
+ *
+ * @param[in] p: pacer
+ * @return timeout in nanoseconds
+*/
+uint64_t batch_pacer_rto(struct batch_pacer *p);
+
+/**
+ * @function: batch_pacer_ack
+ * @brief additive increase after successful reply
+ *
+ * @param[in] p:      pacer
+ * @param[in] rtt_ns: round trip time of the query (0 if it was retransmitted, so ambiguous)
+ * @param[in] limit:  upper limit of window ('-w')
+*/
+void batch_pacer_ack(struct batch_pacer *p, uint64_t rtt_ns, unsigned int limit);
+
+/**
+ * @function: batch_pacer_loss
+ * @brief multiplicative decrease after timeout or SERVFAIL/REFUSED reply (once per round trip)
+ *
+ * @param[in] p:    pacer
+ * @param[in] sent: monotonic time the lost query was first sent
+ * @param[in] now:  current monotonic time
+*/
+void batch_pacer_loss(struct batch_pacer *p, uint64_t sent, uint64_t now);
+
+/**
+ * @function: batch_run
+ * @brief resolves every name in 'par.infile', keeping up to 'par.window' queries in flight
+ *        (input thread reads and encodes names, calling thread drives sockets, output thread
+ *        decodes and prints replies, connected by SPSC rings)
+ *
+ * @return exit code of the program (0 if every query got a reply, 1 otherwise)
+*/
+int batch_run();
+
+#endif
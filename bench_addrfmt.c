@@ -0,0 +1,99 @@
+/** @file:   bench_addrfmt.c
+ *  @brief:  Benchmark of A/AAAA rdata formatters (addrfmt.c vs. libc inet_ntop)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "addrfmt.h"
+
+#include <time.h>
+
+#define BENCH_ADDRS  1000000 //addresses generated per family
+#define BENCH_ROUNDS 5       //passes over all addresses per formatter
+
+static uint64_t bench_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//answer-like IPv6 addresses: zero groups of varying runs, small groups, some IPv4-mapped
+static void bench_addr6_gen(unsigned char *out, unsigned int seed){
+    for (int g = 0; g < 8; g++){
+        unsigned int v = (seed >> (g * 3)) & 7;
+        unsigned int word = (v < 3) ? 0 : (v < 5) ? (seed >> g) % 0x100 : (seed * 2654435761u >> g) & 0xffff;
+        out[2 * g] = (unsigned char)(word >> 8);
+        out[2 * g + 1] = (unsigned char)word;
+    }
+    if (seed % 16 == 0){
+        memset(out, 0, 10);
+        out[10] = 0xff;
+        out[11] = 0xff;
+    }
+}
+
+//formatter adapters (same signature for library and own code)
+static size_t bench_ntop4(const unsigned char *addr, char *out){
+    inet_ntop(AF_INET, addr, out, ADDR_TEXT_MAX);
+    return strlen(out);
+}
+
+static size_t bench_ntop6(const unsigned char *addr, char *out){
+    inet_ntop(AF_INET6, addr, out, ADDR_TEXT_MAX);
+    return strlen(out);
+}
+
+static double bench_run(const char *name, size_t (*fn)(const unsigned char *, char *), const unsigned char *addrs,
+                        size_t width, double ref_ns){
+    char text[ADDR_TEXT_MAX];
+    size_t sink = 0;
+    uint64_t start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++){
+        for (unsigned int i = 0; i < BENCH_ADDRS; i++){
+            sink += fn(&addrs[i * width], text);
+        }
+    }
+    double ns = (double)(bench_now_ns() - start) / ((double)BENCH_ADDRS * BENCH_ROUNDS);
+    fprintf(stdout, "%-14s %6.2f ns/record  %5.2fx inet_ntop  (checksum %zu)\r\n", name, ns, ref_ns > 0 ? ref_ns / ns : 1.0, sink);
+    return ns;
+}
+
+int main(){
+    unsigned char *v4 = malloc((size_t)BENCH_ADDRS * 4);
+    unsigned char *v6 = malloc((size_t)BENCH_ADDRS * 16);
+    if (v4 == NULL || v6 == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    for (unsigned int i = 0; i < BENCH_ADDRS; i++){
+        uint32_t a = i * 2654435761u;
+        memcpy(&v4[(size_t)i * 4], &a, 4);
+        bench_addr6_gen(&v6[(size_t)i * 16], i * 2246822519u + 1);
+    }
+    fprintf(stdout, "%d IPv4 and %d IPv6 addresses formatted %d times\r\n", BENCH_ADDRS, BENCH_ADDRS, BENCH_ROUNDS);
+
+  //output has to match the library's
+    char ref[ADDR_TEXT_MAX], text[ADDR_TEXT_MAX];
+    for (unsigned int i = 0; i < BENCH_ADDRS; i++){
+        bench_ntop4(&v4[(size_t)i * 4], ref);
+        if (addr_format_ipv4(&v4[(size_t)i * 4], text) != strlen(ref) || strcmp(ref, text) != 0){
+            fprintf(stderr, "ERROR: IPv4 formatter differs from inet_ntop: %s vs. %s\r\n", text, ref);
+            return 1;
+        }
+        bench_ntop6(&v6[(size_t)i * 16], ref);
+        if (addr_format_ipv6(&v6[(size_t)i * 16], text) != strlen(ref) || strcmp(ref, text) != 0){
+            fprintf(stderr, "ERROR: IPv6 formatter differs from inet_ntop: %s vs. %s\r\n", text, ref);
+            return 1;
+        }
+    }
+
+  //measure
+    double ns = bench_run("inet_ntop A", bench_ntop4, v4, 4, 0);
+    bench_run("addrfmt A", addr_format_ipv4, v4, 4, ns);
+    ns = bench_run("inet_ntop AAAA", bench_ntop6, v6, 16, 0);
+    bench_run("addrfmt AAAA", addr_format_ipv6, v6, 16, ns);
+
+    free(v4);
+    free(v6);
+    return 0;
+}
@@ -0,0 +1,204 @@
+/** @file:   bench_addronly.c
+ *  @brief:  Benchmark of reply decoding (dns_reply_load + project_print vs. addresses-only fast path)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "addronly.h"
+
+#include <time.h>
+
+#define BENCH_REPLIES 200000 //replies decoded per path and reply shape
+
+static uint64_t bench_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*************************************************
+ *                REPLY BUILDING                 *
+*************************************************/
+//"www.example.com" --> labels at 'pos', returns position after them
+static size_t bench_name(unsigned char *buf, size_t pos, const char *name, bool root){
+    while (*name){
+        const char *dot = strchr(name, '.');
+        size_t len = dot ? (size_t)(dot - name) : strlen(name);
+        buf[pos++] = (unsigned char)len;
+        memcpy(&buf[pos], name, len);
+        pos += len;
+        name += len + (dot ? 1 : 0);
+    }
+    if (root){
+        buf[pos++] = 0;
+    }
+    return pos;
+}
+
+static size_t bench_ptr(unsigned char *buf, size_t pos, size_t to){
+    buf[pos++] = (unsigned char)(0xc0 | (to >> 8));
+    buf[pos++] = (unsigned char)to;
+    return pos;
+}
+
+//type, class IN, TTL 300 and rdata length (rdata follows, its length patched by 'bench_rdlen')
+static size_t bench_rr(unsigned char *buf, size_t pos, uint16_t type){
+    unsigned char fields[10] = {type >> 8, type & 0xff, 0, DNS_QCLASS_IN, 0, 0, 0x01, 0x2c, 0, 0};
+    memcpy(&buf[pos], fields, sizeof(fields));
+    return pos + sizeof(fields);
+}
+
+static void bench_rdlen(unsigned char *buf, size_t rdata, size_t end){
+    buf[rdata - 2] = (unsigned char)((end - rdata) >> 8);
+    buf[rdata - 1] = (unsigned char)(end - rdata);
+}
+
+static size_t bench_header(unsigned char *buf, uint16_t an, uint16_t ns, uint16_t ar){
+    unsigned char hdr[12] = {0x12, 0x34, 0x81, 0x80, 0, 1, an >> 8, an & 0xff, ns >> 8, ns & 0xff, ar >> 8, ar & 0xff};
+    memcpy(buf, hdr, sizeof(hdr));
+    return sizeof(hdr);
+}
+
+//recursive resolver reply: addresses, NS records of the zone in authority, their glue in additional
+static size_t bench_reply_plain(unsigned char *buf, uint16_t qtype){
+    size_t pos = bench_header(buf, 2, 2, 2);
+    pos = bench_name(buf, pos, "www.example.com", true);
+    buf[pos++] = 0;
+    buf[pos++] = (unsigned char)qtype;
+    buf[pos++] = 0;
+    buf[pos++] = DNS_QCLASS_IN;
+    size_t alen = (qtype == DNS_QTYPE_A) ? 4 : 16;
+    for (int i = 0; i < 2; i++){
+        pos = bench_ptr(buf, pos, 12);
+        pos = bench_rr(buf, pos, qtype);
+        size_t rdata = pos;
+        for (size_t b = 0; b < alen; b++){
+            buf[pos++] = (unsigned char)(0x20 + i * 7 + b * 13);
+        }
+        bench_rdlen(buf, rdata, pos);
+    }
+    size_t ns[2];
+    for (int i = 0; i < 2; i++){
+        pos = bench_ptr(buf, pos, 16); //"example.com"
+        pos = bench_rr(buf, pos, DNS_QTYPE_NS);
+        size_t rdata = ns[i] = pos;
+        pos = bench_name(buf, pos, i ? "ns2" : "ns1", false);
+        pos = bench_ptr(buf, pos, 16);
+        bench_rdlen(buf, rdata, pos);
+    }
+    for (int i = 0; i < 2; i++){
+        pos = bench_ptr(buf, pos, ns[i]);
+        pos = bench_rr(buf, pos, qtype);
+        size_t rdata = pos;
+        for (size_t b = 0; b < alen; b++){
+            buf[pos++] = (unsigned char)(0x40 + i + b);
+        }
+        bench_rdlen(buf, rdata, pos);
+    }
+    return pos;
+}
+
+//CDN reply: CNAME to an edge name (written in full), four addresses of it
+static size_t bench_reply_cname(unsigned char *buf){
+    size_t pos = bench_header(buf, 5, 0, 0);
+    pos = bench_name(buf, pos, "static.shop.example.com", true);
+    unsigned char q[4] = {0, DNS_QTYPE_A, 0, DNS_QCLASS_IN};
+    memcpy(&buf[pos], q, sizeof(q));
+    pos += sizeof(q);
+    pos = bench_ptr(buf, pos, 12);
+    pos = bench_rr(buf, pos, DNS_QTYPE_CNAME);
+    size_t target = pos;
+    pos = bench_name(buf, pos, "e1234.a.edgecdn.example.net", true);
+    bench_rdlen(buf, target, pos);
+    for (int i = 0; i < 4; i++){
+        pos = bench_ptr(buf, pos, target);
+        pos = bench_rr(buf, pos, DNS_QTYPE_A);
+        unsigned char addr[4] = {198, 51, 100, (unsigned char)(10 + i)};
+        memcpy(&buf[pos], addr, sizeof(addr));
+        bench_rdlen(buf, pos, pos + 4);
+        pos += 4;
+    }
+    return pos;
+}
+
+/*************************************************
+ *                  MEASUREMENT                  *
+*************************************************/
+//general path: every record decoded (names decompressed into heap copies), all sections printed
+static void bench_general(unsigned char *buf, size_t len){
+    struct dns_header_t *dns = (struct dns_header_t *)buf;
+    unsigned char *qname = &buf[sizeof(struct dns_header_t)];
+    size_t qlen = strlen((const char *)qname) + 1;
+    struct dns_question_t *qinfo = (struct dns_question_t *)&buf[sizeof(struct dns_header_t) + qlen];
+    unsigned char host[256];
+    memcpy(host, qname, qlen);
+    DNSname_to_hostname(host);
+    struct dns_replies rep;
+    if (dns_reply_load(buf, len, &buf[sizeof(struct dns_header_t) + qlen + sizeof(struct dns_question_t)], dns, &rep) != 0){
+        return;
+    }
+    project_print(dns, qinfo, &rep, host);
+    clean_exit(dns, &rep);
+}
+
+//fast path: answer addresses pulled out in place, formatted into a stack buffer
+static void bench_fast(unsigned char *buf, size_t len){
+    unsigned char *qname = &buf[sizeof(struct dns_header_t)];
+    size_t qlen = strlen((const char *)qname) + 1;
+    unsigned char host[256];
+    memcpy(host, qname, qlen);
+    DNSname_to_hostname(host);
+    struct addr_only addrs;
+    char text[ADDR_ONLY_TEXT_MAX];
+    if (addr_only_extract(buf, len, &addrs) == 0){
+        fwrite(text, 1, addr_only_format(&addrs, host, text), stdout);
+    }
+}
+
+static double bench_run(FILE *report, const char *name, void (*fn)(unsigned char *, size_t), const unsigned char *reply,
+                        size_t len, double ref_ns){
+    unsigned char buf[512];
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_REPLIES; i++){
+        memcpy(buf, reply, len); //the general path writes into the reply (qname is converted in place)
+        fn(buf, len);
+    }
+    fflush(stdout);
+    double ns = (double)(bench_now_ns() - start) / BENCH_REPLIES;
+    fprintf(report, "%-22s %8.1f ns/reply  %5.2fx general path\r\n", name, ns, ref_ns > 0 ? ref_ns / ns : 1.0);
+    return ns;
+}
+
+int main(){
+    static unsigned char replies[3][512];
+    size_t lens[3] = {bench_reply_plain(replies[0], DNS_QTYPE_A), bench_reply_plain(replies[1], DNS_QTYPE_AAAA),
+                      bench_reply_cname(replies[2])};
+    const char *names[3][2] = {{"general A", "addresses-only A"}, {"general AAAA", "addresses-only AAAA"},
+                               {"general CNAME+A", "addresses-only CNAME+A"}};
+    uint16_t expect[3] = {2, 2, 4};
+
+  //results go to the terminal, the printed replies to /dev/null
+    FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL){
+        fprintf(stderr, "ERROR: couldn't redirect output\r\n");
+        return 1;
+    }
+    fprintf(report, "%d replies decoded and printed per path (answers, NS authority, glue; CNAME chain)\r\n", BENCH_REPLIES);
+
+  //fast path has to find exactly the answer addresses
+    for (int r = 0; r < 3; r++){
+        struct addr_only addrs;
+        if (addr_only_extract(replies[r], lens[r], &addrs) != 0 || addrs.count != expect[r]){
+            fprintf(stderr, "ERROR: %s found %u addresses instead of %u\r\n", names[r][1], addrs.count, expect[r]);
+            return 1;
+        }
+    }
+
+  //measure
+    for (int r = 0; r < 3; r++){
+        double ns = bench_run(report, names[r][0], bench_general, replies[r], lens[r], 0);
+        bench_run(report, names[r][1], bench_fast, replies[r], lens[r], ns);
+    }
+    fclose(report);
+    return 0;
+}
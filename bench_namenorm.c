@@ -0,0 +1,112 @@
+/** @file:   bench_namenorm.c
+ *  @brief:  Benchmark of hostname normalization kernels (scalar vs. SSE2 vs. AVX2)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "namenorm.h"
+
+#include <time.h>
+
+#define BENCH_NAMES  1000000 //names generated
+#define BENCH_ROUNDS 5       //passes over all names per kernel
+
+//kernels to compare
+struct bench_kernel{
+    const char *name;
+    name_norm_fn fn;
+    bool supported;
+};
+
+static uint64_t bench_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//log-like names: short and long (CDN style) hostnames in mixed case
+static size_t bench_name_gen(char *out, unsigned int seed){
+    static const char *words[] = {"www", "Mail", "cdn", "static-content", "api", "EDGE", "img",
+                                  "fit", "vutbr", "Example", "googleusercontent", "s3", "eu-central-1"};
+    static const char *tlds[] = {"com", "cz", "net", "ORG", "io"};
+    int labels = 1 + (int)(seed % 5);
+    size_t pos = 0;
+    for (int i = 0; i < labels; i++){
+        const char *w = words[(seed >> (i * 3)) % (sizeof(words) / sizeof(words[0]))];
+        pos += (size_t)sprintf(out + pos, "%s%u.", w, (seed >> i) % 100);
+    }
+    pos += (size_t)sprintf(out + pos, "%s", tlds[seed % (sizeof(tlds) / sizeof(tlds[0]))]);
+    return pos;
+}
+
+int main(){
+    struct bench_kernel kernels[] = {
+        {"scalar", name_normalize_scalar, true},
+#if defined(__x86_64__) || defined(__i386__)
+        {"sse2", name_normalize_sse2, __builtin_cpu_supports("sse2")},
+        {"avx2", name_normalize_avx2, __builtin_cpu_supports("avx2")},
+#endif
+    };
+    int nkernels = sizeof(kernels) / sizeof(kernels[0]);
+
+  //generate input
+    char *names = malloc((size_t)BENCH_NAMES * 256);
+    size_t *lens = malloc(BENCH_NAMES * sizeof(size_t));
+    unsigned char *wire = malloc(256);
+    unsigned char *ref = malloc(256);
+    if (names == NULL || lens == NULL || wire == NULL || ref == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    size_t bytes = 0;
+    for (unsigned int i = 0; i < BENCH_NAMES; i++){
+        lens[i] = bench_name_gen(&names[(size_t)i * 256], i * 2654435761u);
+        bytes += lens[i];
+    }
+    fprintf(stdout, "%d names, average length %.1f, dispatch picks '%s'\r\n",
+            BENCH_NAMES, (double)bytes / BENCH_NAMES, name_norm_impl());
+
+  //every kernel has to produce the same DNSnames as the scalar one
+    for (int k = 1; k < nkernels; k++){
+        if (!kernels[k].supported){
+            continue;
+        }
+        for (unsigned int i = 0; i < BENCH_NAMES; i++){
+            const char *name = &names[(size_t)i * 256];
+            size_t a = name_normalize_scalar(name, lens[i], ref);
+            size_t b = kernels[k].fn(name, lens[i], wire);
+            if (a != b || memcmp(ref, wire, a) != 0){
+                fprintf(stderr, "ERROR: kernel '%s' differs from scalar on %.*s\r\n", kernels[k].name, (int)lens[i], name);
+                return 1;
+            }
+        }
+    }
+
+  //measure
+    double scalar_ns = 0;
+    for (int k = 0; k < nkernels; k++){
+        if (!kernels[k].supported){
+            fprintf(stdout, "%-8s not supported by this CPU\r\n", kernels[k].name);
+            continue;
+        }
+        size_t sink = 0;
+        uint64_t start = bench_now_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++){
+            for (unsigned int i = 0; i < BENCH_NAMES; i++){
+                sink += kernels[k].fn(&names[(size_t)i * 256], lens[i], wire);
+            }
+        }
+        double ns = (double)(bench_now_ns() - start) / ((double)BENCH_NAMES * BENCH_ROUNDS);
+        if (k == 0){
+            scalar_ns = ns;
+        }
+        fprintf(stdout, "%-8s %7.2f ns/name  %8.1f MB/s  %5.2fx scalar  (checksum %zu)\r\n", kernels[k].name, ns,
+                (double)bytes / BENCH_NAMES / ns * 1000.0, scalar_ns / ns, sink);
+    }
+
+    free(names);
+    free(lens);
+    free(wire);
+    free(ref);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/** @file:   bench_uring.c
+ *  @brief:  Benchmark of UDP send/receive paths over loopback (plain sockets vs. io_uring)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "uring.h"
+
+#include <time.h>
+
+#define BENCH_BATCHES 20000 //rounds of sends followed by receives
+#define BENCH_BATCH   64    //datagrams in flight per round (below URING_BUFS and socket buffer)
+#define BENCH_LEN     40    //datagram size (about a DNS query)
+
+static uint64_t bench_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//UDP socket connected to itself, everything sent to it comes back to it
+static int bench_socket(){
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &len) != 0 || connect(fd, (struct sockaddr *)&addr, len) != 0){
+        perror("ERROR: loopback socket failure");
+        exit(1);
+    }
+    return fd;
+}
+
+static void bench_print(const char *name, uint64_t elapsed_ns, unsigned long syscalls, double plain_ns){
+    double datagrams = (double)BENCH_BATCHES * BENCH_BATCH;
+    double ns = (double)elapsed_ns / datagrams;
+    fprintf(stdout, "%-8s %7.1f ns/datagram  %6.3f syscalls/datagram  %5.2fx plain\r\n", name, ns,
+            (double)syscalls / datagrams, plain_ns > 0 ? plain_ns / ns : 1.0);
+}
+
+int main(){
+    unsigned char pkt[BENCH_LEN], buf[512];
+    memset(pkt, 0xab, sizeof(pkt));
+    fprintf(stdout, "%d rounds of %d datagrams (%d bytes) sent and received over loopback\r\n",
+            BENCH_BATCHES, BENCH_BATCH, BENCH_LEN);
+
+  //plain sockets, one syscall per datagram each way
+    int fd = bench_socket();
+    uint64_t start = bench_now_ns();
+    for (int b = 0; b < BENCH_BATCHES; b++){
+        for (int i = 0; i < BENCH_BATCH; i++){
+            if (send(fd, pkt, sizeof(pkt), 0) < 0){
+                perror("ERROR: send failure");
+                return 1;
+            }
+        }
+        for (int i = 0; i < BENCH_BATCH; i++){
+            if (recv(fd, buf, sizeof(buf), 0) < 0){
+                perror("ERROR: recv failure");
+                return 1;
+            }
+        }
+    }
+    uint64_t plain = bench_now_ns() - start;
+    double plain_ns = (double)plain / ((double)BENCH_BATCHES * BENCH_BATCH);
+    bench_print("plain", plain, 2UL * BENCH_BATCHES * BENCH_BATCH, 0);
+    close(fd);
+
+  //io_uring, sends submitted together with the wait, replies through multishot receive
+    fd = bench_socket();
+    struct uring ring;
+    if (uring_open(&ring, fd) != 0){
+        fprintf(stdout, "%-8s not supported by this kernel\r\n", "io_uring");
+        close(fd);
+        return 0;
+    }
+    start = bench_now_ns();
+    for (int b = 0; b < BENCH_BATCHES; b++){
+        for (int i = 0; i < BENCH_BATCH; i++){
+            uring_send(&ring, pkt, sizeof(pkt));
+        }
+        int got = 0;
+        while (got < BENCH_BATCH){
+            if (uring_wait(&ring, 1000) != 0){
+                perror("ERROR: io_uring failure");
+                return 1;
+            }
+            unsigned char *data;
+            size_t len;
+            unsigned short bid;
+            while (uring_recv_next(&ring, &data, &len, &bid)){
+                uring_recv_done(&ring, bid);
+                got++;
+            }
+        }
+    }
+    bench_print("io_uring", bench_now_ns() - start, ring.enters, plain_ns);
+    if (ring.sends != ring.recvs || ring.send_errors != 0){
+        fprintf(stderr, "ERROR: %lu sent, %lu received, %lu send errors\r\n", ring.sends, ring.recvs, ring.send_errors);
+        return 1;
+    }
+    uring_close(&ring);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,279 @@
+/** @file:   columnar.c
+ *  @brief:  Columnar binary result output (-o) for batch mode, read back by dnscol
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "columnar.h"
+#include "rrtypes.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//append bytes to column (growing it by doubling)
+static void col_put(struct col_buf *b, const void *data, size_t len){
+    if (b->len + len > b->cap){
+        size_t cap = b->cap ? b->cap : 4096;
+        while (cap < b->len + len){
+            cap *= 2;
+        }
+        unsigned char *grown = realloc(b->data, cap);
+        if (grown == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+        b->data = grown;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static void col_put32(struct col_buf *b, uint32_t v){
+    col_put(b, &v, sizeof(v));
+}
+
+static void col_put16(struct col_buf *b, uint16_t v){
+    col_put(b, &v, sizeof(v));
+}
+
+static void col_put8(struct col_buf *b, uint8_t v){
+    col_put(b, &v, sizeof(v));
+}
+
+static uint32_t col_hash(const char *name){
+    uint32_t h = 2166136261u; //FNV-1a
+    for (; *name; name++){
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    }
+    return h;
+}
+
+//write whole buffer (short writes retried)
+static int col_write_all(int fd, const void *data, size_t len){
+    const unsigned char *p = data;
+    while (len > 0){
+        ssize_t n = write(fd, p, len);
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return 1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+//index of name in block dictionary (added if not there yet)
+static uint32_t col_name(struct col_writer *w, const char *name){
+    if ((w->nnames + 1) * 2 > w->dict_mask + 1){ //keep load under one half
+        uint32_t size = (w->dict_mask + 1) * 2;
+        uint32_t *dict = calloc(size, sizeof(uint32_t));
+        if (dict == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+        uint32_t *offs = (uint32_t *)w->cols[COL_NAME_OFF].data;
+        for (uint32_t i = 0; i < w->nnames; i++){
+            uint32_t h = col_hash((const char *)&w->cols[COL_NAMES].data[offs[i]]) & (size - 1);
+            while (dict[h] != 0){
+                h = (h + 1) & (size - 1);
+            }
+            dict[h] = i + 1;
+        }
+        free(w->dict);
+        w->dict = dict;
+        w->dict_mask = size - 1;
+    }
+
+    uint32_t h = col_hash(name) & w->dict_mask;
+    while (w->dict[h] != 0){
+        uint32_t off = ((uint32_t *)w->cols[COL_NAME_OFF].data)[w->dict[h] - 1];
+        if (strcmp((const char *)&w->cols[COL_NAMES].data[off], name) == 0){
+            return w->dict[h] - 1;
+        }
+        h = (h + 1) & w->dict_mask;
+    }
+    col_put32(&w->cols[COL_NAME_OFF], (uint32_t)w->cols[COL_NAMES].len);
+    col_put(&w->cols[COL_NAMES], name, strlen(name) + 1);
+    w->dict[h] = ++w->nnames;
+    return w->nnames - 1;
+}
+
+//write buffered block (header + columns, 8 byte aligned) in one go and start next one
+static int col_flush(struct col_writer *w){
+    if (w->nreplies == 0){
+        return 0;
+    }
+    col_put32(&w->cols[COL_NAME_OFF], (uint32_t)w->cols[COL_NAMES].len);  //closing offsets
+    col_put32(&w->cols[COL_RDATA_OFF], (uint32_t)w->cols[COL_RDATA].len);
+
+    struct col_block_hdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, COL_BLOCK_MAGIC, sizeof(hdr.magic));
+    hdr.nreplies = w->nreplies;
+    hdr.nrecords = w->nrecords;
+    hdr.nnames = w->nnames;
+    uint64_t pos = (sizeof(hdr) + COL_ALIGN - 1) & ~(uint64_t)(COL_ALIGN - 1);
+    for (int c = 0; c < COL_COLUMNS; c++){
+        hdr.col_off[c] = pos;
+        hdr.col_len[c] = w->cols[c].len;
+        pos = (pos + w->cols[c].len + COL_ALIGN - 1) & ~(uint64_t)(COL_ALIGN - 1);
+    }
+    hdr.size = pos;
+
+  //assemble block in one buffer (one large sequential write per block)
+    unsigned char *block = calloc(1, pos);
+    if (block == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        exit(1);
+    }
+    memcpy(block, &hdr, sizeof(hdr));
+    for (int c = 0; c < COL_COLUMNS; c++){
+        if (w->cols[c].len > 0){
+            memcpy(block + hdr.col_off[c], w->cols[c].data, w->cols[c].len);
+        }
+        w->cols[c].len = 0;
+    }
+    int ret = col_write_all(w->fd, block, pos);
+    free(block);
+
+    w->bytes += pos;
+    w->blocks++;
+    w->nreplies = 0;
+    w->nrecords = 0;
+    w->nnames = 0;
+    memset(w->dict, 0, (w->dict_mask + 1) * sizeof(uint32_t));
+    return ret;
+}
+
+//append records of one section
+static void col_add_section(struct col_writer *w, struct dns_record_a_t *records, uint16_t count, uint8_t section){
+    for (uint16_t i = 0; i < count; i++){
+        col_put32(&w->cols[COL_REC_REPLY], w->nreplies);
+        col_put32(&w->cols[COL_REC_OWNER], col_name(w, (const char *)records[i].name));
+        col_put16(&w->cols[COL_REC_TYPE], ntohs(records[i].resource->type));
+        col_put16(&w->cols[COL_REC_CLASS], ntohs(records[i].resource->class));
+        col_put32(&w->cols[COL_REC_TTL], ntohl(records[i].resource->ttl));
+        col_put8(&w->cols[COL_REC_SECTION], section);
+        col_put32(&w->cols[COL_RDATA_OFF], (uint32_t)w->cols[COL_RDATA].len);
+        col_put(&w->cols[COL_RDATA], records[i].rdata, rr_rdata_len(&records[i]));
+        col_put8(&w->cols[COL_RDATA], 0);
+        w->nrecords++;
+    }
+}
+
+/*************************************************
+ *                    WRITER                     *
+*************************************************/
+//keeps whole blocks of output file written by an interrupted run, 'false' if it isn't a columnar file
+static bool col_resume(struct col_writer *w, const char *path){
+    struct col_file_hdr hdr;
+    struct stat st;
+    if (fstat(w->fd, &st) != 0 || pread(w->fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+        memcmp(hdr.magic, COL_MAGIC, sizeof(COL_MAGIC)) != 0 || hdr.version != COL_VERSION || hdr.endian != COL_ENDIAN){
+        return false;
+    }
+    uint64_t pos = sizeof(hdr);
+    struct col_block_hdr b;
+    while (pread(w->fd, &b, sizeof(b), (off_t)pos) == (ssize_t)sizeof(b) && memcmp(b.magic, COL_BLOCK_MAGIC, sizeof(b.magic)) == 0 &&
+           b.size >= sizeof(b) && pos + b.size <= (uint64_t)st.st_size){
+        pos += b.size;
+    }
+    if (pos < (uint64_t)st.st_size){
+        fprintf(stderr, "WARNING: dropping torn end of output file %s (%lu bytes)\r\n", path, (unsigned long)(st.st_size - pos));
+        if (ftruncate(w->fd, (off_t)pos) != 0){
+            return false;
+        }
+    }
+    lseek(w->fd, (off_t)pos, SEEK_SET);
+    return true;
+}
+
+int col_open(struct col_writer *w, const char *path, bool resume){
+    memset(w, 0, sizeof(*w));
+    if ((w->fd = open(path, resume ? (O_RDWR | O_CREAT) : (O_WRONLY | O_CREAT | O_TRUNC), 0644)) < 0){
+        fprintf(stderr, "ERROR: couldn't create output file: %s\r\n", path);
+        return 1;
+    }
+    w->dict_mask = 1023;
+    w->dict = calloc(w->dict_mask + 1, sizeof(uint32_t));
+    if (w->dict == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        close(w->fd);
+        return 1;
+    }
+    if (resume && lseek(w->fd, 0, SEEK_END) > 0){ //continue after the blocks already there
+        if (!col_resume(w, path)){
+            fprintf(stderr, "ERROR: output file to resume isn't a columnar file (or can't be truncated): %s\r\n", path);
+            close(w->fd);
+            return 1;
+        }
+        return 0;
+    }
+
+    struct col_file_hdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, COL_MAGIC, sizeof(COL_MAGIC));
+    hdr.version = COL_VERSION;
+    hdr.endian = COL_ENDIAN;
+    if (col_write_all(w->fd, &hdr, sizeof(hdr)) != 0){
+        fprintf(stderr, "ERROR: couldn't write output file: %s\r\n", path);
+        return 1;
+    }
+    w->bytes = sizeof(hdr);
+    return 0;
+}
+
+int col_add_reply(struct col_writer *w, struct dns_header_t *dns, struct dns_question_t *qinfo,
+                  struct dns_replies *dns_rep, unsigned char *qname, uint32_t waiters){
+    uint8_t flags = 0;
+    flags |= (dns->aa != 0) ? COL_F_AUTHORITATIVE : 0;
+    flags |= (dns->ra == 1 && par.recursion == 1) ? COL_F_RECURSIVE : 0;
+    flags |= (dns->tc != 0) ? COL_F_TRUNCATED : 0;
+
+    col_put32(&w->cols[COL_R_QNAME], col_name(w, (const char *)qname));
+    col_put16(&w->cols[COL_R_QTYPE], ntohs(qinfo->q_type));
+    col_put16(&w->cols[COL_R_QCLASS], ntohs(qinfo->q_class));
+    col_put8(&w->cols[COL_R_FLAGS], flags);
+    col_put8(&w->cols[COL_R_RCODE], (uint8_t)dns->rcode);
+    col_put16(&w->cols[COL_R_COUNTS], ntohs(dns->ancount));
+    col_put16(&w->cols[COL_R_COUNTS], ntohs(dns->nscount));
+    col_put16(&w->cols[COL_R_COUNTS], ntohs(dns->arcount));
+    col_put32(&w->cols[COL_R_WAITERS], waiters);
+    col_add_section(w, dns_rep->answers, ntohs(dns->ancount), 0);
+    col_add_section(w, dns_rep->auth, ntohs(dns->nscount), 1);
+    col_add_section(w, dns_rep->addit, ntohs(dns->arcount), 2);
+    w->nreplies++;
+    w->replies++;
+    w->records += (unsigned long)ntohs(dns->ancount) + ntohs(dns->nscount) + ntohs(dns->arcount);
+
+    if (w->nrecords >= COL_BLOCK_RECORDS || w->cols[COL_NAMES].len + w->cols[COL_RDATA].len >= COL_BLOCK_BYTES){
+        return col_flush(w);
+    }
+    return 0;
+}
+
+int col_sync(struct col_writer *w){
+    if (col_flush(w) != 0 || fdatasync(w->fd) != 0){
+        return 1;
+    }
+    return 0;
+}
+
+int col_close(struct col_writer *w){
+    int ret = col_flush(w);
+    for (int c = 0; c < COL_COLUMNS; c++){
+        free(w->cols[c].data);
+    }
+    free(w->dict);
+    if (close(w->fd) != 0){
+        ret = 1;
+    }
+    return ret;
+}
@@ -0,0 +1,148 @@
+/** @file:   columnar.h
+ *  @brief:  Columnar binary result output (-o) for batch mode, read back by dnscol
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include "dns.h"
+
+#define COL_MAGIC          "DNSCOL1" //file magic (8 bytes with the terminating zero)
+#define COL_BLOCK_MAGIC    "CBLK"    //block magic (4 bytes, no terminating zero)
+#define COL_VERSION        1
+#define COL_ENDIAN         0x01020304 //written in native byte order, readers check it
+#define COL_BLOCK_RECORDS  65536     //records buffered before a block is written
+#define COL_BLOCK_BYTES    (4 << 20) //name and rdata bytes buffered before a block is written
+#define COL_ALIGN          8         //every column starts at a multiple of this (from block start)
+
+//reply flags (as project_print would print them)
+#define COL_F_AUTHORITATIVE 0x01
+#define COL_F_RECURSIVE     0x02
+#define COL_F_TRUNCATED     0x04
+
+/**
+ * @enum: columns of one block
+ *
+ * Reply columns have 'nreplies' entries, record columns 'nrecords' entries (records are stored
+ * in reply order, answers first, then authority and additional). Names are kept in a dictionary
+ * per block and referenced by index. Rdata is the decoded form the formatters print: raw
+ * network order bytes for address types (A, AAAA), presentation text otherwise. Names and
+ * rdata are NUL terminated in their blobs, so mapped values can be used in place.
+*/
+enum col_column{
+    COL_NAME_OFF,    /* uint32_t [nnames + 1] offsets into COL_NAMES */
+    COL_NAMES,       /* names (no trailing dot), NUL terminated */
+    COL_R_QNAME,     /* uint32_t name index of question */
+    COL_R_QTYPE,     /* uint16_t */
+    COL_R_QCLASS,    /* uint16_t */
+    COL_R_FLAGS,     /* uint8_t COL_F_* */
+    COL_R_RCODE,     /* uint8_t */
+    COL_R_COUNTS,    /* uint16_t [3] answer, authority and additional record counts */
+    COL_R_WAITERS,   /* uint32_t input lines answered by reply (coalesced duplicates) */
+    COL_REC_REPLY,   /* uint32_t reply index within block */
+    COL_REC_OWNER,   /* uint32_t name index of owner */
+    COL_REC_TYPE,    /* uint16_t */
+    COL_REC_CLASS,   /* uint16_t */
+    COL_REC_TTL,     /* uint32_t */
+    COL_REC_SECTION, /* uint8_t 0 = answer, 1 = authority, 2 = additional */
+    COL_RDATA_OFF,   /* uint32_t [nrecords + 1] offsets into COL_RDATA (value length = difference - 1) */
+    COL_RDATA,       /* rdata values, NUL terminated */
+    COL_COLUMNS
+};
+
+/**
+ * @struct: file header
+*/
+struct col_file_hdr{
+    char magic[8];     /* COL_MAGIC */
+    uint32_t version;  /* COL_VERSION */
+    uint32_t endian;   /* COL_ENDIAN */
+};
+
+/**
+ * @struct: block header, followed by the columns (the next block starts 'size' bytes after it)
+*/
+struct col_block_hdr{
+    char magic[4];     /* COL_BLOCK_MAGIC */
+    uint32_t nreplies;
+    uint32_t nrecords;
+    uint32_t nnames;
+    uint64_t size;     /* whole block including header */
+    uint64_t col_off[COL_COLUMNS]; /* column start, from block start */
+    uint64_t col_len[COL_COLUMNS]; /* column length in bytes */
+};
+
+/**
+ * @struct: growable column buffer
+*/
+struct col_buf{
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+};
+
+/**
+ * @struct: columnar writer (one block is buffered in memory, then written at once)
+*/
+struct col_writer{
+    int fd;
+    struct col_buf cols[COL_COLUMNS];
+    uint32_t nreplies;
+    uint32_t nrecords;
+    uint32_t nnames;
+    uint32_t *dict;       /* name hash table (name index + 1, 0 = empty) */
+    uint32_t dict_mask;
+    unsigned long blocks; /* blocks written */
+    unsigned long replies;
+    unsigned long records;
+    uint64_t bytes;       /* bytes written */
+};
+
+/**
+ * @function: col_open
+ * @brief creates (truncates) output file and writes file header, or with 'resume' appends to the blocks
+ *        an interrupted run already wrote (a torn last block is dropped)
+ *
+ * @param[in] w:      writer to initialize
+ * @param[in] path:   output file path
+ * @param[in] resume: keep blocks already in file (created if there's none)
+ * @return 0 if successful, 1 if not
+*/
+int col_open(struct col_writer *w, const char *path, bool resume);
+
+/**
+ * @function: col_add_reply
+ * @brief appends decoded reply to current block (block is written once full)
+ *
+ * @param[in] w:       writer
+ * @param[in] dns:     reply header
+ * @param[in] qinfo:   question fields of reply
+ * @param[in] dns_rep: decoded records
+ * @param[in] qname:   question name (printable form)
+ * @param[in] waiters: amount of input lines the reply answers
+ * @return 0 if successful, 1 on write failure
+*/
+int col_add_reply(struct col_writer *w, struct dns_header_t *dns, struct dns_question_t *qinfo,
+                  struct dns_replies *dns_rep, unsigned char *qname, uint32_t waiters);
+
+/**
+ * @function: col_sync
+ * @brief writes current (partial) block and syncs file, so everything added so far is on disk
+ *
+ * @param[in] w: writer
+ * @return 0 if successful, 1 on write failure
+*/
+int col_sync(struct col_writer *w);
+
+/**
+ * @function: col_close
+ * @brief writes last (partial) block, frees buffers and closes output file
+ *
+ * @param[in] w: writer
+ * @return 0 if successful, 1 on write failure
+*/
+int col_close(struct col_writer *w);
+
+#endif
@@ -5,6 +5,31 @@
 **/
 
 #include "dns.h"
+#include "batch.h"
+#include "iterative.h"
+#include "dualstack.h"
+#include "rrtypes.h"
+#include "uring.h"
+#include "trace.h"
+#include "xfr.h"
+#include "loadgen.h"
+#include "monitor.h"
+#include "shmring.h"
+#include "addronly.h"
+#include "zout.h"
+#include "metrics.h"
+#include "probes.h"
+
+//global params struct definition
+struct params par = {.recursion = false, .reverse = false, .Qtype = DNS_QTYPE_A, .server = "", .port = 53, .address = "",
+                     .infile = "", .window = BATCH_WINDOW_DEFAULT, .iterative = false, .hints = "",
+                     .dual = false, .uring = false, .trace_phases = false,
+                     .sockets = BATCH_SOCKETS_DEFAULT, .rcvbuf = BATCH_RCVBUF_DEFAULT, .sndbuf = BATCH_SNDBUF_DEFAULT,
+                     .outfile = "", .serial = 0, .serial_given = false,
+                     .loadfile = "", .qps = 0, .duration = 0, .interval = LOAD_INTERVAL_DEFAULT,
+                     .timeout = LOAD_TIMEOUT_DEFAULT, .monitorfile = "",
+                     .shmname = "", .shmsize = SHM_SIZE_DEFAULT, .journalfile = "", .addresses_only = false,
+                     .compress = 0, .compress_level = 0, .metrics = ""}; //create struct var
 
 /*************************************************
  *           AUXILIARY PRINT FUNCTIONS           *
@@ -13,17 +38,86 @@
 void helpmsg(){
     fprintf(stdout, 
     "--- dns.c ---\r\n"
-    "usage:  dns [-r] [-x] [-6] -s server [-p port] address\r\n"
+    "usage:  dns [-r] [-x] [-u] [-6 | -d | -t type] -s server [-p port] [--trace-phases] [--addresses-only] address\r\n"
+    "        dns [-r] [-x] [-u] [-6 | -d | -t type] -s server[,server...] [-p port] [--trace-phases] -f file [-w window] [-o out]\r\n"
+    "            [--sockets n] [--rcvbuf bytes] [--sndbuf bytes] [--shm name [--shm-size bytes]]\r\n"
+    "            [--journal file] [--addresses-only] [--compress method[:level]]\r\n"
+    "            [--metrics target]\r\n"
+    "        dns -i [-x] [-6 | -t type] [-H hints | -s server] [-p port] {address | -f file}\r\n"
+    "        dns -t AXFR -s server [-p port] zone\r\n"
+    "        dns [-r] -s server [-p port] --load file [--qps n] [--duration s] [--interval s] [--timeout s] [-w window]\r\n"
+    "            [--metrics target]\r\n"
+    "        dns -t IXFR --serial n -s server [-p port] zone\r\n"
+    "        dns [-r] [-p port] --monitor file [--interval s] [--timeout s] [--duration s] [--metrics target]\r\n"
     "where:  [-r] = recursion desired\r\n"
     "        [-x] = make reverse request instead of direct request\r\n"
     "               (reverse request requires 'server' to be an address)\r\n"
     "               (incompatible with '-6')\r\n"
     "        [-6] = make request of type AAAA instead of default A\r\n"
     "               (inpompatible with '-x')\r\n"
+    "        [-t type] = make request of given type (TYPE<n> for unregistered ones), registered:\r\n"
+    "                    ");
+    rr_type_list(stdout);
+    fprintf(stdout, "\r\n"
+    "                    (incompatible with '-x' and '-6')\r\n"
+    "        [-d] = dual-stack, send A and AAAA requests back-to-back and print both answers together\r\n"
+    "               (incompatible with '-x', '-6' and '-i')\r\n"
     "         -s server = IP or hostname of server to which request will be sent\r\n"
+    "         -s server,server... = batch server pool (up to %d servers, \"host\" or \"host#port\", '-s' may repeat),\r\n"
+    "                     every name goes to the server its registrable domain hashes to, a server that keeps\r\n"
+    "                     timing out is left out (its names fail over to the next servers) until it answers again\r\n"
+    "                     (incompatible with '-u')\r\n"
     "        [-p port]  = port number to use\r\n"
     "                     (set to 53 by default)\r\n"
-    "         address   = address that is the object of query(request)\r\n");
+    "         address   = address that is the object of query(request)\r\n"
+    "        [-f file]  = batch mode, resolve every name listed in file (one per line, '-' = stdin)\r\n"
+    "                     (identical in-flight queries are coalesced into one)\r\n"
+    "        [-w window] = maximum amount of batch queries in flight at once\r\n"
+    "                     (set to %d by default, the actual window adapts below it\r\n"
+    "                      to what the server sustains)\r\n"
+    "        [-i] = iterative resolution, follow referrals from root hints to the authoritative answer\r\n"
+    "               ('server', if given, is used as the only root hint)\r\n"
+    "        [-H hints] = root hints file (\"address\", \"name address\" or named.root lines)\r\n"
+    "                     (built-in root servers by default)\r\n"
+    "        [-u] = send and receive through io_uring (falls back to plain sockets if the kernel lacks it)\r\n"
+    "               (incompatible with '-d' and '-i')\r\n"
+    "        [-o out] = write batch results to file 'out' in columnar binary format instead of printing them\r\n"
+    "                   (read back with 'dnscol out')\r\n"
+    "        [--shm name] = publish batch results to shared-memory ring /dev/shm/name instead of printing them\r\n"
+    "                       (the writer never waits, readers like 'dnsshm name' detect being overrun)\r\n"
+    "        [--shm-size bytes] = data bytes of '--shm' ring, power of two (%d by default)\r\n"
+    "        [--journal file] = checkpoint batch progress to 'file' (every second), run again with the same input\r\n"
+    "                           and journal to skip the names already done and resume where it stopped\r\n"
+    "                           (requires '-f' with a regular file, incompatible with '-i')\r\n"
+    "        [--sockets n] = UDP sockets (random source ports) batch queries are spread across (%d by default, 1 with '-u')\r\n"
+    "        [--rcvbuf bytes], [--sndbuf bytes] = kernel buffer sizes of batch sockets (%d and %d by default)\r\n", SERVERS_MAX,
+    BATCH_WINDOW_DEFAULT, SHM_SIZE_DEFAULT, BATCH_SOCKETS_DEFAULT, BATCH_RCVBUF_DEFAULT, BATCH_SNDBUF_DEFAULT);
+    fprintf(stdout,
+    "        [-t AXFR] = full zone transfer over TCP, records are printed as they arrive\r\n"
+    "        [-t IXFR --serial n] = incremental zone transfer, changes since SOA serial 'n'\r\n"
+    "        [--load file] = load generation, replay queries from file (\"name [type]\" per line, type A if missing)\r\n"
+    "                        and report achieved rate, loss, response codes and latency percentiles\r\n"
+    "        [--qps n] = target rate of '--load' (as fast as '-w' window allows by default)\r\n"
+    "        [--duration s] = replay '--load' file in a loop for 's' seconds (one pass by default)\r\n"
+    "        [--interval s] = seconds between '--load' progress reports (%g by default)\r\n"
+    "        [--timeout s] = seconds after which unanswered '--load' query counts as lost (%g by default)\r\n"
+    "        [--monitor file] = probe servers (\"server address [port]\" lines) with queries (\"query name [type]\" lines)\r\n"
+    "                           every '--interval' seconds (until '--duration' ends or SIGINT), one line per round:\r\n"
+    "                           result of the round, rolling success rate and latency percentiles of the last %d rounds\r\n"
+    "                           ('--timeout' is capped to '--interval')\r\n"
+    "        [--addresses-only] = print only the addresses of A/AAAA answers (CNAME chains followed), \"name. address\"\r\n"
+    "                             per line (\"name. RCODE\" if there's none), decoded without the full record parser\r\n"
+    "                             (requires query type A or AAAA, incompatible with '-i', '-o' and '--shm')\r\n"
+    "        [--compress method[:level]] = compress batch output ('gzip', levels 1-9, or 'zstd', levels 1-19, if built\r\n"
+    "                                      with it) in a writer thread, throughput and ratio reported at exit\r\n"
+    "                                      (requires '-f', incompatible with '-i', '-o', '--shm' and '--journal')\r\n"
+    "        [--metrics target] = export counters (queries, bytes, responses by rcode, timeouts, truncations,\r\n"
+    "                             mismatched replies, decode errors) in Prometheus text format: served over HTTP\r\n"
+    "                             on 'http:port' (127.0.0.1) or 'unix:path', or rewritten every second to file\r\n"
+    "                             'target' (requires '-f', '--load' or '--monitor', incompatible with '-i')\r\n"
+    "        [--trace-phases] = print time spent in each lookup phase (validation, qname, socket, wire, decode, print)\r\n"
+    "                           to stderr at exit (requires build with 'make TRACE=1', the default)\r\n", LOAD_INTERVAL_DEFAULT,
+    LOAD_TIMEOUT_DEFAULT, MONITOR_WINDOW_ROUNDS);
 }
 
 //auxiliary param print function
@@ -34,6 +128,15 @@ void list_args(struct params s){
     fprintf(stdout, "server:    %s\r\n", s.server);
     fprintf(stdout, "port:      %d\r\n", s.port);
     fprintf(stdout, "address:   %s\r\n", s.address);
+    fprintf(stdout, "infile:    %s\r\n", s.infile);
+    fprintf(stdout, "window:    %u\r\n", s.window);
+    fprintf(stdout, "iterative: %d\r\n", s.iterative);
+    fprintf(stdout, "hints:     %s\r\n", s.hints);
+    fprintf(stdout, "dual:      %d\r\n", s.dual);
+    fprintf(stdout, "uring:     %d\r\n", s.uring);
+    fprintf(stdout, "trace:     %d\r\n", s.trace_phases);
+    fprintf(stdout, "outfile:   %s\r\n", s.outfile);
+    fprintf(stdout, "sockets:   %u (rcvbuf %d, sndbuf %d)\r\n", s.sockets, s.rcvbuf, s.sndbuf);
 }
 
 //auxiliary dns header contents print function
@@ -79,87 +182,35 @@ void project_print(struct dns_header_t *dns, struct dns_question_t *question,
         fprintf(stdout, " %s., %s, %s\n\r", qname, DNS_Qtype_tostr(ntohs(question->q_type)), DNS_Qclass_tostr(ntohs(question->q_class)));
     }
 
-  //prep for rest of sections
-    long *p;
-    char ipaddr[128];
-    //char a6string[INET6_ADDRSTRLEN];
-    struct sockaddr_in a;
-    //struct sockaddr_in6 a6;
-    
-  //answer section
-    fprintf(stdout, "Answer Section(%d)\n\r", ntohs(dns->ancount));
-    for (uint16_t i = 0; i < ntohs(dns->ancount); i++){
-        fprintf(stdout, " %s., %s, %s, %u", dns_rep->answers[i].name, 
-                                     DNS_Qtype_tostr(ntohs(dns_rep->answers[i].resource->type)), 
-                                     DNS_Qclass_tostr(ntohs(dns_rep->answers[i].resource->class)), 
-                                     htonl(dns_rep->answers[i].resource->ttl));
-        // A
-        if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->answers[i].resource->type)), "A") == 0){
-            p=(long*)dns_rep->answers[i].rdata;
-            a.sin_addr.s_addr=(*p); //working without ntohl
-            fprintf(stdout, ", %s\n\r",inet_ntoa(a.sin_addr));
-        // AAAA
-        } else if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->answers[i].resource->type)), "AAAA") == 0){
-            dec_to_hex_IPv6(dns_rep->answers[i].rdata, ipaddr, (int)ntohs(dns_rep->answers[i].resource->data_len));
-            fprintf(stdout, ", %s\n\r", ipaddr);
-        // CNAME
-        } else if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->answers[i].resource->type)), "CNAME") == 0){
-            fprintf(stdout, ", %s\n\r",dns_rep->answers[i].rdata);
-        // ELSE
-        } else {
-            fprintf(stdout, ", %s\n\r",dns_rep->answers[i].rdata);
-        }
-    }
-  //authority section
-    fprintf(stdout, "Authority Section(%d)\n\r", ntohs(dns->nscount));
-    for (uint16_t i = 0; i < ntohs(dns->nscount); i++){
-        fprintf(stdout, " %s., %s, %s, %u", dns_rep->auth[i].name, 
-                                     DNS_Qtype_tostr(ntohs(dns_rep->auth[i].resource->type)), 
-                                     DNS_Qclass_tostr(ntohs(dns_rep->auth[i].resource->class)), 
-                                     htonl(dns_rep->auth[i].resource->ttl));
-        // A
-        if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->auth[i].resource->type)), "A") == 0){
-            p=(long*)dns_rep->auth[i].rdata;
-            a.sin_addr.s_addr=(*p); //working without ntohl
-            fprintf(stdout, ", %s\n\r",inet_ntoa(a.sin_addr));
-        // AAAA
-        } else if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->auth[i].resource->type)), "AAAA") == 0){
-            dec_to_hex_IPv6(dns_rep->auth[i].rdata, ipaddr, (int)ntohs(dns_rep->auth[i].resource->data_len));
-            fprintf(stdout, ", %s\n\r", ipaddr);
-        // CNAME
-        } else if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->auth[i].resource->type)), "CNAME") == 0){
-            fprintf(stdout, ", %s\n\r",dns_rep->auth[i].rdata);
-        // ELSE
-        } else {
-            fprintf(stdout, ", %s\n\r",dns_rep->auth[i].rdata);
-        }
-    }
-  //additional section
-    fprintf(stdout, "Additional Section(%d)\n\r", ntohs(dns->arcount));
-    for (uint16_t i = 0; i < ntohs(dns->arcount); i++){
-        fprintf(stdout, " %s., %s, %s, %u", dns_rep->addit[i].name, 
-                                     DNS_Qtype_tostr(ntohs(dns_rep->addit[i].resource->type)), 
-                                     DNS_Qclass_tostr(ntohs(dns_rep->addit[i].resource->class)), 
-                                     htonl(dns_rep->addit[i].resource->ttl));
-        // A
-        if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->addit[i].resource->type)), "A") == 0){
-            p=(long*)dns_rep->addit[i].rdata;
-            a.sin_addr.s_addr=(*p); //working without ntohl
-            fprintf(stdout, ", %s\n\r",inet_ntoa(a.sin_addr));
-        // AAAA
-        } else if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->addit[i].resource->type)), "AAAA") == 0){
-            dec_to_hex_IPv6(dns_rep->addit[i].rdata, ipaddr, (int)ntohs(dns_rep->addit[i].resource->data_len));
-            fprintf(stdout, ", %s\n\r", ipaddr);
-        // CNAME
-        } else if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->addit[i].resource->type)), "CNAME") == 0){
-            fprintf(stdout, ", %s\n\r",dns_rep->addit[i].rdata);
-        // ELSE
-        } else {
-            fprintf(stdout, ", %s\n\r",dns_rep->addit[i].rdata);
-        }
+    project_print_records(dns, dns_rep);
+}
+
+//prints one record of received packet (rdata formatted by its type's formatter)
+void project_print_record(struct dns_record_a_t *rec){
+    const struct rr_type *type = rr_type_get(ntohs(rec->resource->type));
+    fprintf(stdout, " %s., %s, %s, %u, ", rec->name, 
+                                 DNS_Qtype_tostr(ntohs(rec->resource->type)), 
+                                 DNS_Qclass_tostr(ntohs(rec->resource->class)), 
+                                 htonl(rec->resource->ttl));
+    type->format(stdout, rec);
+    fprintf(stdout, "\n\r");
+}
+
+//prints one section of received packet
+static void project_print_section(const char *title, struct dns_record_a_t *records, uint16_t count){
+    fprintf(stdout, "%s Section(%d)\n\r", title, count);
+    for (uint16_t i = 0; i < count; i++){
+        project_print_record(&records[i]);
     }
 }
 
+//prints answer, authority and additional sections of received packet
+void project_print_records(struct dns_header_t *dns, struct dns_replies *dns_rep){
+    project_print_section("Answer", dns_rep->answers, ntohs(dns->ancount));
+    project_print_section("Authority", dns_rep->auth, ntohs(dns->nscount));
+    project_print_section("Additional", dns_rep->addit, ntohs(dns->arcount));
+}
+
 /*************************************************
  *           AUXILIARY TASK FUNCTIONS            *
 *************************************************/
@@ -203,7 +254,7 @@ bool is_it_IPv6(char *addr){
 //host validity checker
 bool is_it_hostname(char *host){
     regex_t reg;
-    if ((regcomp(&reg, "^(([a-zA-Z0-9]|[a-zA-Z0-9][a-zA-Z0-9\\-]*[a-zA-Z0-9])\\.)*([A-Za-z0-9]|[A-Za-z0-9][A-Za-z0-9\\-]*[A-Za-z0-9])$", REG_EXTENDED)) != 0){
+    if ((regcomp(&reg, "^(([a-zA-Z0-9_]|[a-zA-Z0-9_][a-zA-Z0-9_\\-]*[a-zA-Z0-9_])\\.)*([A-Za-z0-9_]|[A-Za-z0-9_][A-Za-z0-9_\\-]*[A-Za-z0-9_])$", REG_EXTENDED)) != 0){
         fprintf(stderr, "INTERNAL ERROR: regcomp() failure\r\n");
         exit(1);
     } else {
@@ -260,33 +311,25 @@ void DNSname_to_hostname(unsigned char *str){
 		}
 		str[i] = '.';
 	}
-	str[i - 1] = '\0';
+	if (i > 0){ //root name stays empty
+		str[i - 1] = '\0';
+	}
 }
 
-//Qtype integer to string converter
+//Qtype integer to string converter (registered types, see rrtypes.c)
 char* DNS_Qtype_tostr(uint16_t Qtype){
-    switch (Qtype){
-        case (DNS_QTYPE_A):
-            return "A";
-        case (DNS_QTYPE_AAAA):
-            return "AAAA";
-        case (DNS_QTYPE_CNAME):
-            return "CNAME";
-        case (DNS_QTYPE_SOA):
-            return "SOA";
-        case (DNS_QTYPE_NS):
-            return "NS";
-        case (DNS_QTYPE_MX):
-            return "MX";
-        case (DNS_QTYPE_PTR):
-            return "PTR";
-        default:
-            return "UNKNOWN";
+    static _Thread_local char generic[16];
+    const struct rr_type *t = rr_type_get(Qtype);
+    if (t->code == 0){ //unregistered type, RFC 3597 generic name
+        snprintf(generic, sizeof(generic), "TYPE%u", Qtype);
+        return generic;
     }
+    return (char *)t->name;
 }
 
 //Qclass integer to string converter
 char* DNS_Qclass_tostr(uint16_t Qclass){
+    static _Thread_local char generic[16];
     switch (Qclass){
         case (DNS_QCLASS_RESERVED):
             return "RESERVED";
@@ -300,68 +343,59 @@ char* DNS_Qclass_tostr(uint16_t Qclass){
             return "NONE";
         case (DNS_QCLASS_ANY):
             return "ANY";
-        default:
-            return "UNKNOWN";
+        default: //RFC 3597 generic name
+            snprintf(generic, sizeof(generic), "CLASS%u", Qclass);
+            return generic;
     }
 }
 
-//function that takes IPv6 in decimal form and transforms it into an actual IPv6 (hexa)
-char* dec_to_hex_IPv6(unsigned char *input_string, char* output, int length){
-    char save[3];
-    output[0] = '\0';
-    bool doubledot = false;
-    int pos = 0;
-    for (int i = 0; i < length; ++i){
-        sprintf(save, "%02X", (uint16_t)(input_string[i]));
-        strcat(output, save);
-        pos += 2;
-        if (doubledot == true && length-i != 1){ 
-            strcat(output, ":"); 
-            doubledot=false; 
-            pos += 1;
-        } else { 
-            doubledot=true; 
-        }
-    }
-    //now convert it to shortened IPv6
-    struct in6_addr addr;
-    inet_pton(AF_INET6, (const char *)output, &addr);
-    inet_ntop(AF_INET6, &addr, output, strlen(output));
-    return output;
-}
-
 //read compressed name from a dns record
-unsigned char* read_compressed_name(unsigned char* reader, unsigned char* buffer, int* count){
-	unsigned char *name = (unsigned char*)malloc(256);
-    unsigned int offset;
+unsigned char* read_compressed_name(unsigned char* reader, unsigned char* buffer, size_t len, int* count){
+    unsigned char *end = buffer + len;
     bool jumped = false;
+    int jumps = 0; //compression pointer loop protection
+    int length = 0;
 
-	*count = 1;
+    *count = 0;
+	unsigned char *name = (unsigned char*)malloc(256);
+    if (name == NULL){
+        return NULL;
+    }
 
-    int length = 0;
     //this next part deals with dns compression - http://www.tcpipguide.com/free/t_DNSNameNotationandMessageCompressionTechnique-2.htm
     //in the Name field of the answer record, we would instead put two "1" bits, followed by the number 47 encoded in binary
     //so:   11000000 00101111
-	while (*reader != 0){
-		if (*reader < 192){ //(192)dec = (11000000)bin
-			name[length++] = *reader;
-		} else {
-			offset = (*reader)*256 + *(reader+1); //calculate where to jump to the new location
-            //now get rid of MSBs
-            offset -= 49152; //(49152)dec = (11000000 00000000)bin
-            //now jump to the new location
-			reader = buffer + offset - 1;
+    //every label, pointer and the terminating zero has to lie within the reply
+	while (reader < end && *reader != 0){
+		unsigned int label = *reader;
+		if (label >= 192){ //(192)dec = (11000000)bin
+            if (reader + 1 >= end || ++jumps > 64){
+                break;
+            }
+            if (jumped == false){
+                *count = *count + 2; //pointer ends the name in the record itself
+            }
+            //calculate where to jump to the new location (without the two MSBs)
+			reader = buffer + (((label & 0x3f) << 8) | *(reader + 1));
 			jumped = true; //we have jumped to another location
+            continue;
 		}
-
-		reader += 1;
-
-		if(jumped == false){
-			*count = *count + 1; //if we havent jumped to another location then we can count up
+        if (label > 63 || reader + 1 + label >= end || length + 1 + label > 254){ //reserved label type, past the end or too long
+            break;
+        }
+        memcpy(&name[length], reader, label + 1);
+        length += label + 1;
+        reader += label + 1;
+		if (jumped == false){
+			*count = *count + label + 1; //if we havent jumped to another location then we can count up
 		}
 	}
-	if(jumped == true){
-		*count = *count + 1; //number of steps we actually moved forward in the packet
+    if (reader >= end || *reader != 0){ //malformed
+        free(name);
+        return NULL;
+    }
+	if (jumped == false){
+		*count = *count + 1; //terminating zero
 	}
 
 	name[length] = '\0'; //string complete
@@ -372,6 +406,31 @@ unsigned char* read_compressed_name(unsigned char* reader, unsigned char* buffer
 	return name;
 }
 
+//skip whole resource record (without decompressing its name)
+unsigned char* dns_record_skip(unsigned char* buffer, size_t len, unsigned char* reader){
+    unsigned char *end = buffer + len;
+    while (reader < end && *reader != 0){
+        if (*reader >= 192){ //compression pointer ends the name
+            reader += 1;
+            break;
+        }
+        if (*reader > 63){ //neither a label length nor a pointer
+            return NULL;
+        }
+        reader += *reader + 1;
+    }
+    reader += 1;
+    if (reader > end || (size_t)(end - reader) < sizeof(struct record_data)){
+        return NULL;
+    }
+    struct record_data *resource = (struct record_data*)reader;
+    reader += sizeof(struct record_data);
+    if ((size_t)(end - reader) < ntohs(resource->data_len)){
+        return NULL;
+    }
+    return reader + ntohs(resource->data_len);
+}
+
 //switch: first 4 bits of byte #1 with last 4 bits of byte #2
 //   and  last 4 bits of byte #1 with first 4 bits of byte #2
 void switch_bytes(uint8_t *first_field, uint8_t *second_field){
@@ -414,12 +473,50 @@ void clean_exit(struct dns_header_t *dns, struct dns_replies *dns_rep){
  *          INTERNAL PROGRAM FUNCTIONS           *
 *************************************************/
 //arguments parser
+//'-s' operand: one server or a comma separated list of them, each "host" or "host#port" (appended to 'par.servers',
+//the first one is 'par.server')
+static bool servers_add(const char *list, bool *port_given){
+    while (true){
+        const char *comma = strchr(list, ',');
+        size_t len = comma ? (size_t)(comma - list) : strlen(list);
+        const char *hash = memchr(list, '#', len);
+        size_t hlen = hash ? (size_t)(hash - list) : len;
+        char host[128];
+        if (hlen == 0 || hlen >= sizeof(host) || par.nservers == SERVERS_MAX){
+            return false;
+        }
+        memcpy(host, list, hlen);
+        host[hlen] = '\0';
+        if (!is_it_hostname(host) && !is_it_IPv4(host) && !is_it_IPv6(host)){
+            return false;
+        }
+        if (hash != NULL){
+            char *end;
+            long num = strtol(hash + 1, &end, 10);
+            if (end == hash + 1 || end != list + len || !is_it_valid_port(num)){
+                return false;
+            }
+            *port_given = true;
+        }
+
+        memcpy(par.servers[par.nservers], list, len);
+        par.servers[par.nservers][len] = '\0';
+        if (par.nservers++ == 0){
+            strcpy(par.server, host);
+        }
+        if (comma == NULL){
+            return true;
+        }
+        list = comma + 1;
+    }
+}
+
 int parse_args(int argc, char *argv[]){
-    if (argc < 4){
+    if (argc < 3 || (argc == 3 && strcmp(argv[1], "--monitor") != 0)){ //'dns --monitor file' is the only 2 argument form
         fprintf(stderr,"ERROR: insufficient amount of arguments received\r\n");
         helpmsg();
         return 1;
-    } else if (argc > 9){
+    } else if (argc > 30){
         fprintf(stderr,"ERROR: too many arguments received\r\n");
         helpmsg();
         return 1;
@@ -427,7 +524,33 @@ int parse_args(int argc, char *argv[]){
 
     int c;
     long num;
-    while((c = getopt(argc, argv, ":rx6s:p:")) != -1){
+    char *end;
+    double secs;
+    bool load_opts = false; //'--qps', '--duration', '--interval' or '--timeout' received
+    bool type_given = false; //'-6' or '-t' received
+    bool shm_size_given = false;
+    bool server_port_given = false; //'-s server#port' received
+    static struct option long_opts[] = {
+        {"trace-phases", no_argument, NULL, OPT_TRACE_PHASES},
+        {"sockets", required_argument, NULL, OPT_SOCKETS},
+        {"rcvbuf", required_argument, NULL, OPT_RCVBUF},
+        {"sndbuf", required_argument, NULL, OPT_SNDBUF},
+        {"serial", required_argument, NULL, OPT_SERIAL},
+        {"load", required_argument, NULL, OPT_LOAD},
+        {"qps", required_argument, NULL, OPT_QPS},
+        {"duration", required_argument, NULL, OPT_DURATION},
+        {"interval", required_argument, NULL, OPT_INTERVAL},
+        {"timeout", required_argument, NULL, OPT_TIMEOUT},
+        {"monitor", required_argument, NULL, OPT_MONITOR},
+        {"shm", required_argument, NULL, OPT_SHM},
+        {"shm-size", required_argument, NULL, OPT_SHM_SIZE},
+        {"journal", required_argument, NULL, OPT_JOURNAL},
+        {"addresses-only", no_argument, NULL, OPT_ADDRESSES_ONLY},
+        {"compress", required_argument, NULL, OPT_COMPRESS},
+        {"metrics", required_argument, NULL, OPT_METRICS},
+        {NULL, 0, NULL, 0}
+    };
+    while((c = getopt_long(argc, argv, ":rx6t:duis:p:f:w:H:o:", long_opts, NULL)) != -1){
         switch(c){
             case 'r':
                 par.recursion = true;
@@ -436,14 +559,51 @@ int parse_args(int argc, char *argv[]){
                 par.reverse = true;
                 break;
             case '6':
+                if (type_given){
+                    fprintf(stderr, "ERROR: '-6' and '-t' parameters are incompatible\r\n");
+                    return 1;
+                }
                 par.Qtype = DNS_QTYPE_AAAA;
+                type_given = true;
+                break;
+            case 'd':
+                par.dual = true;
+                break;
+            case 't':
+                if ((par.Qtype = rr_type_by_name(optarg)) == 0 || type_given){
+                    fprintf(stderr, "ERROR: unknown query type or more than one type requested: %s\r\n", optarg);
+                    return 1;
+                }
+                type_given = true;
+                break;
+            case 'i':
+                par.iterative = true;
+                break;
+            case 'u':
+                par.uring = true;
                 break;
+            case OPT_TRACE_PHASES:
+#ifdef DNS_TRACE
+                par.trace_phases = true;
+                break;
+#else
+                fprintf(stderr, "ERROR: '--trace-phases' isn't available, program was built with 'make TRACE=0'\r\n");
+                return 1;
+#endif
+            case 'H':
+                if (strlen(optarg) < sizeof(par.hints)){
+                    strcpy(par.hints, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: root hints file path too long: %s\r\n", optarg);
+                    return 1;
+                }
             case 's':
-                if (is_it_hostname(optarg) || is_it_IPv4(optarg) || is_it_IPv6(optarg)){
-                    strcpy(par.server, optarg);
-                    break;             
+                if (servers_add(optarg, &server_port_given)){
+                    break;
                 } else {
-                    fprintf(stderr, "ERROR: invalid hostname received: %s\r\n", optarg);
+                    fprintf(stderr, "ERROR: invalid hostname received (or more than %d servers, or invalid 'server#port'): %s\r\n",
+                            SERVERS_MAX, optarg);
                     return 1;
                 }
             case 'p':
@@ -455,7 +615,149 @@ int parse_args(int argc, char *argv[]){
                     fprintf(stderr, "ERROR: invalid port number: %s\r\n", optarg);
                     return 1;
                 }
-            case ':': //-s or -p without operand
+            case 'f':
+                if (strlen(optarg) < sizeof(par.infile)){
+                    strcpy(par.infile, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: input file path too long: %s\r\n", optarg);
+                    return 1;
+                }
+            case 'o':
+                if (strlen(optarg) < sizeof(par.outfile)){
+                    strcpy(par.outfile, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: output file path too long: %s\r\n", optarg);
+                    return 1;
+                }
+            case 'w':
+                num = strtol(optarg, &end, 0);
+                if (*end == '\0' && num >= 1 && num <= BATCH_WINDOW_MAX){
+                    par.window = (unsigned int)num;
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid window size (1 to %d): %s\r\n", BATCH_WINDOW_MAX, optarg);
+                    return 1;
+                }
+            case OPT_SOCKETS:
+                num = strtol(optarg, &end, 0);
+                if (*end == '\0' && num >= 1 && num <= BATCH_SOCKETS_MAX){
+                    par.sockets = (unsigned int)num;
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid amount of sockets (1 to %d): %s\r\n", BATCH_SOCKETS_MAX, optarg);
+                    return 1;
+                }
+            case OPT_RCVBUF:
+            case OPT_SNDBUF:
+                num = strtol(optarg, &end, 0);
+                if (*end == '\0' && num >= 4096 && num <= (1L << 30)){
+                    *((c == OPT_RCVBUF) ? &par.rcvbuf : &par.sndbuf) = (int)num;
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid buffer size (4096 to %ld bytes): %s\r\n", 1L << 30, optarg);
+                    return 1;
+                }
+            case OPT_SERIAL:
+                errno = 0;
+                num = strtol(optarg, &end, 0);
+                if (errno == 0 && *end == '\0' && num >= 0 && num <= 0xffffffffL){
+                    par.serial = (uint32_t)num;
+                    par.serial_given = true;
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid SOA serial (0 to 4294967295): %s\r\n", optarg);
+                    return 1;
+                }
+            case OPT_LOAD:
+                if (strlen(optarg) < sizeof(par.loadfile)){
+                    strcpy(par.loadfile, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: query file path too long: %s\r\n", optarg);
+                    return 1;
+                }
+            case OPT_MONITOR:
+                if (strlen(optarg) < sizeof(par.monitorfile)){
+                    strcpy(par.monitorfile, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: monitor file path too long: %s\r\n", optarg);
+                    return 1;
+                }
+            case OPT_SHM:
+                if (strlen(optarg) > 0 && strlen(optarg) < NAME_MAX && strchr(optarg, '/') == NULL){
+                    strcpy(par.shmname, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid shared memory name (no '/', shorter than %d characters): %s\r\n", NAME_MAX, optarg);
+                    return 1;
+                }
+            case OPT_SHM_SIZE:
+                num = strtol(optarg, &end, 0);
+                if (*end == '\0' && num >= SHM_SIZE_MIN && num <= SHM_SIZE_MAX && (num & (num - 1)) == 0){
+                    par.shmsize = (uint64_t)num;
+                    shm_size_given = true;
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid ring size (power of two, %d to %d bytes): %s\r\n", SHM_SIZE_MIN, SHM_SIZE_MAX, optarg);
+                    return 1;
+                }
+            case OPT_ADDRESSES_ONLY:
+                par.addresses_only = true;
+                break;
+            case OPT_COMPRESS:
+                if (zout_method(optarg, &par.compress, &par.compress_level) == 0){
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: unknown compression method (gzip[:1-9], zstd[:1-19] if built with zstd): %s\r\n", optarg);
+                    return 1;
+                }
+            case OPT_METRICS:
+                if (strlen(optarg) > 0 && strlen(optarg) < sizeof(par.metrics)){
+                    strcpy(par.metrics, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid metrics target: %s\r\n", optarg);
+                    return 1;
+                }
+            case OPT_JOURNAL:
+                if (strlen(optarg) < sizeof(par.journalfile)){
+                    strcpy(par.journalfile, optarg);
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: journal file path too long: %s\r\n", optarg);
+                    return 1;
+                }
+            case OPT_QPS:
+                num = strtol(optarg, &end, 0);
+                if (*end == '\0' && num >= 1 && num <= LOAD_QPS_MAX){
+                    par.qps = (unsigned int)num;
+                    load_opts = true;
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid target rate (1 to %d queries per second): %s\r\n", LOAD_QPS_MAX, optarg);
+                    return 1;
+                }
+            case OPT_DURATION:
+            case OPT_INTERVAL:
+            case OPT_TIMEOUT:
+                secs = strtod(optarg, &end);
+                if (*end == '\0' && secs >= 0.01 && secs <= 86400){
+                    *((c == OPT_DURATION) ? &par.duration : (c == OPT_INTERVAL) ? &par.interval : &par.timeout) = secs;
+                    load_opts = true;
+                    break;
+                } else {
+                    fprintf(stderr, "ERROR: invalid amount of seconds (0.01 to 86400): %s\r\n", optarg);
+                    return 1;
+                }
+            case ':': //option without operand
+                if (optopt >= OPT_TRACE_PHASES){ //long option
+                    fprintf(stderr, "ERROR: option %s requires an operand\r\n", argv[optind - 1]);
+                    helpmsg();
+                    return 1;
+                }
                 fprintf(stderr, "ERROR: option -%c requires an operand\r\n", optopt);
                 helpmsg();
                 return 1;
@@ -469,8 +771,14 @@ int parse_args(int argc, char *argv[]){
     //getopt won't find 'address', so we have to do that manually
     for (int i = 1; i < argc; i++){
         if (strncmp(argv[i], "-", 1) == 0){ //find only arguments which begin with '-' and skip those
-            if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "-p") == 0){ //in case of '-s' and '-p', skip their operand as well
+            if (strlen(argv[i]) == 2 && strchr(ARGS_WITH_OPERAND, argv[i][1]) != NULL){ //in case of '-s', '-p',... skip their operand as well
                 i++;
+            } else if (strncmp(argv[i], "--", 2) == 0 && strchr(argv[i], '=') == NULL){ //'--sockets 8' as well (not '--sockets=8')
+                for (struct option *o = long_opts; o->name != NULL; o++){
+                    if (o->has_arg == required_argument && strcmp(argv[i] + 2, o->name) == 0){
+                        i++;
+                    }
+                }
             }
         } else { //we found potential address
             if (strcmp(par.address, "") == 0){ //if address is still empty
@@ -489,6 +797,152 @@ int parse_args(int argc, char *argv[]){
         }
     }
 
+    //dual-stack mode decides query types itself
+    if (par.dual && (par.reverse || par.iterative || type_given)){
+        fprintf(stderr, "ERROR: '-d' parameter is incompatible with '-x', '-6', '-t' and '-i'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //io_uring backend covers the single query and batch send/receive paths
+    if (par.uring && (par.dual || par.iterative)){
+        fprintf(stderr, "ERROR: '-u' parameter is incompatible with '-d' and '-i'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //columnar output is written by the batch loop only
+    if (strcmp(par.outfile, "") != 0 && (strcmp(par.infile, "") == 0 || par.iterative)){
+        fprintf(stderr, "ERROR: '-o' parameter requires batch mode ('-f') and is incompatible with '-i'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //shared-memory ring is fed by the batch output thread, in place of printing or '-o'
+    if (strcmp(par.shmname, "") != 0 && (strcmp(par.infile, "") == 0 || par.iterative || strcmp(par.outfile, "") != 0)){
+        fprintf(stderr, "ERROR: '--shm' parameter requires batch mode ('-f') and is incompatible with '-i' and '-o'\r\n");
+        helpmsg();
+        return 1;
+    }
+    if (shm_size_given && strcmp(par.shmname, "") == 0){
+        fprintf(stderr, "ERROR: '--shm-size' is only used with '--shm'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //checkpoint journal refers to lines of the batch input, which has to be there to be read again
+    if (strcmp(par.journalfile, "") != 0 && (strcmp(par.infile, "") == 0 || strcmp(par.infile, "-") == 0 || par.iterative)){
+        fprintf(stderr, "ERROR: '--journal' parameter requires batch mode ('-f' with a file, not stdin) and is incompatible with '-i'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //compressed stream is one whole gzip member/zstd frame, it can't go elsewhere or be appended to by a resumed run
+    if (par.compress != ZOUT_NONE && (strcmp(par.infile, "") == 0 || par.iterative || strcmp(par.outfile, "") != 0 ||
+                                      strcmp(par.shmname, "") != 0 || strcmp(par.journalfile, "") != 0)){
+        fprintf(stderr, "ERROR: '--compress' parameter requires batch mode ('-f') and is incompatible with '-i', '-o', '--shm' and '--journal'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //counters are kept by the batch, load and probe loops (iterative mode has a send path of its own)
+    if (strcmp(par.metrics, "") != 0 && ((strcmp(par.infile, "") == 0 && strcmp(par.loadfile, "") == 0 &&
+                                          strcmp(par.monitorfile, "") == 0) || par.iterative)){
+        fprintf(stderr, "ERROR: '--metrics' parameter requires '-f', '--load' or '--monitor' and is incompatible with '-i'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //server pool (and per-server ports) is spread over by the batch loop only
+    if ((par.nservers > 1 || server_port_given) && (strcmp(par.infile, "") == 0 || par.iterative || par.uring)){
+        fprintf(stderr, "ERROR: more than one server (or 'server#port') requires batch mode ('-f') and is incompatible with '-i' and '-u'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //addresses-only fast path reads A/AAAA answers straight from the reply, in place of the text printer
+    if (par.addresses_only && ((!par.dual && par.Qtype != DNS_QTYPE_A && par.Qtype != DNS_QTYPE_AAAA) || par.reverse ||
+                               par.iterative || strcmp(par.outfile, "") != 0 || strcmp(par.shmname, "") != 0 ||
+                               strcmp(par.loadfile, "") != 0 || strcmp(par.monitorfile, "") != 0)){
+        fprintf(stderr, "ERROR: '--addresses-only' requires query type A or AAAA ('-6', '-d', '-t A' or '-t AAAA') and is "
+                        "incompatible with '-x', '-i', '-o', '--shm', '--load' and '--monitor'\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //zone transfers run over their own TCP connection, for one zone given as 'address'
+    bool xfr = (par.Qtype == DNS_QTYPE_AXFR || par.Qtype == DNS_QTYPE_IXFR);
+    if (xfr && (par.reverse || par.iterative || par.dual || par.uring || strcmp(par.infile, "") != 0)){
+        fprintf(stderr, "ERROR: zone transfers ('-t AXFR', '-t IXFR') are incompatible with '-x', '-i', '-d', '-u' and '-f'\r\n");
+        helpmsg();
+        return 1;
+    }
+    if ((par.Qtype == DNS_QTYPE_IXFR) != par.serial_given){
+        fprintf(stderr, "ERROR: '-t IXFR' requires '--serial' (and '--serial' is only used by it)\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //probe mode takes servers and queries from its own file
+    if (strcmp(par.monitorfile, "") != 0){
+        if (strcmp(par.server, "") != 0 || strcmp(par.address, "") != 0 || strcmp(par.infile, "") != 0 ||
+            strcmp(par.outfile, "") != 0 || strcmp(par.loadfile, "") != 0 || par.qps != 0 || par.reverse ||
+            par.iterative || par.dual || par.uring || type_given){
+            fprintf(stderr, "ERROR: '--monitor' takes servers and query types from its file and is incompatible "
+                            "with '-s', 'address', '-f', '-o', '--load', '--qps', '-x', '-i', '-d', '-u', '-6' and '-t'\r\n");
+            helpmsg();
+            return 1;
+        }
+        return 0;
+    }
+
+    //load generation replays its own query file against 'server'
+    if (strcmp(par.loadfile, "") != 0){
+        if (strcmp(par.server, "") == 0 || strcmp(par.address, "") != 0 || strcmp(par.infile, "") != 0 ||
+            strcmp(par.outfile, "") != 0 || par.reverse || par.iterative || par.dual || par.uring || type_given){
+            fprintf(stderr, "ERROR: '--load' requires the 'server' parameter, takes query types from its file and is incompatible "
+                            "with 'address', '-f', '-o', '-x', '-i', '-d', '-u', '-6' and '-t'\r\n");
+            helpmsg();
+            return 1;
+        }
+        return 0;
+    } else if (load_opts){
+        fprintf(stderr, "ERROR: '--qps', '--duration', '--interval' and '--timeout' are only used with '--load' (and all but "
+                        "'--qps' with '--monitor')\r\n");
+        helpmsg();
+        return 1;
+    }
+
+    //iterative mode doesn't need 'server' (root hints are used instead)
+    if (par.iterative){
+        if ((strcmp(par.address, "") == 0) == (strcmp(par.infile, "") == 0)){
+            fprintf(stderr, "ERROR: iterative mode ('-i') requires either the 'address' parameter or '-f'\r\n");
+            helpmsg();
+            return 1;
+        }
+        if (type_given && par.reverse == true){
+            fprintf(stderr, "ERROR: '-x' parameter is incompatible with '-6' and '-t' - the former requires query type 'PTR', while the latter set another type\r\n");
+            helpmsg();
+            return 1;
+        }
+        return 0;
+    }
+
+    //batch mode takes its addresses from the input file instead
+    if (strcmp(par.infile, "") != 0){
+        if (strcmp(par.server, "") == 0 || strcmp(par.address, "") != 0){
+            fprintf(stderr, "ERROR: batch mode ('-f') requires the 'server' parameter and no 'address'\r\n");
+            helpmsg();
+            return 1;
+        }
+        if (type_given && par.reverse == true){
+            fprintf(stderr, "ERROR: '-x' parameter is incompatible with '-6' and '-t' - the former requires query type 'PTR', while the latter set another type\r\n");
+            helpmsg();
+            return 1;
+        }
+        return 0;
+    }
+
     //if either 'server' or 'address' is missing
     if (strcmp(par.address, "") == 0 || strcmp(par.server, "") == 0){
         fprintf(stderr, "ERROR: the 'server' and 'address' parameters are required\r\n");
@@ -497,8 +951,8 @@ int parse_args(int argc, char *argv[]){
     }
 
     //if '-x' and '-6' are set ('-x' expects to send a packet of type 'PTR', but '-6' demands a packet of type 'AAAA' is sent - those are directly contradictory)
-    if (par.Qtype == DNS_QTYPE_AAAA && par.reverse == true){
-        fprintf(stderr, "ERROR: '-x' and '-6' parameters are incompatible - the former requires query type 'PTR', while the latter 'AAAA'\r\n");
+    if (type_given && par.reverse == true){
+        fprintf(stderr, "ERROR: '-x' parameter is incompatible with '-6' and '-t' - the former requires query type 'PTR', while the latter set another type\r\n");
         helpmsg();
         return 1;
     }
@@ -625,6 +1079,54 @@ void dns_pack_prep(struct dns_header_t *dns){
 	dns->arcount = 0; //no additional records yet
 }
 
+//builds reverse lookup name out of an IPv4 or IPv6 address
+int dns_reverse_name(const char *address, char *out){
+    if (is_it_IPv4((char *)address)){ //147.229.8.12  -->  12.8.229.147.in-addr.arpa
+        struct in_addr addr;
+        inet_pton(AF_INET, address, &addr);
+        //revert the bytes
+        addr.s_addr = ((addr.s_addr & 0xff000000) >> 24) | 
+                      ((addr.s_addr & 0x00ff0000) >>  8) | 
+                      ((addr.s_addr & 0x0000ff00) <<  8) |
+                      ((addr.s_addr & 0x000000ff) << 24);
+        inet_ntop(AF_INET, &addr, out, 32);
+        strcat(out, ".in-addr.arpa"); //add .in-addr.arpa
+        return 0;
+    } else if (is_it_IPv6((char *)address)){ //2001:67c:1220:809::93e5:917  -->  7.1.9.0.5.e.3.9.0.0.0.0.0.0.0.0.9.0.8.0.0.2.2.1.c.7.6.0.1.0.0.2.ip6.arpa
+        struct in6_addr addr;
+        out[0] = '\0';
+
+        inet_pton(AF_INET6, address, &addr);
+        //revert the bytes
+        for (int i = 0; i < 8; i++){
+            switch_bytes(&addr.s6_addr[i], &addr.s6_addr[15-i]);
+        }
+        //save 'XX.XX.XX.XX...' as 'C.C.C.C.C.C.C.C...'
+        char save[3];
+        char save2[3];
+        for (int i = 0; i < 16; i++){
+            //XY -> X.Y.
+            //X.
+            sprintf(save, "%02X", addr.s6_addr[i]);
+            save[1] = '.';
+            strcat(out, save);
+            //Y.
+            sprintf(save2, "%02X", addr.s6_addr[i]);
+            string_firstnchars_remove(save2, 1);
+            strcat(save2, ".");
+            strcat(out, save2);
+        }
+        //set string to lowercase
+        for(int i = 0; out[i]; i++){
+            out[i] = tolower(out[i]);
+        }
+        //add ".ip6.arpa"
+        strcat(out, "ip6.arpa");
+        return 0;
+    }
+    return 1;
+}
+
 //resolves query hostname into DNSname and saves it into buffer
 void dns_qname_insert(unsigned char *qname){
   //if reverse DNS lookup
@@ -633,51 +1135,9 @@ void dns_qname_insert(unsigned char *qname){
         //        2001:67c:1220:809::93e5:917  -->  7.1.9.0.5.e.3.9.0.0.0.0.0.0.0.0.9.0.8.0.0.2.2.1.c.7.6.0.1.0.0.2.ip6.arpa,
         //        www.fit.vutbr.cz  -->  23.9.229.147.in-addr.arpa)
 
-        if (is_it_IPv4(par.address)){ //147.229.8.12  -->  12.8.229.147.in-addr.arpa
-            struct in_addr addr;
-            char reversed_ip[32]; //an IP is a 32-bit unsigned integer
-            inet_pton(AF_INET, (const char *)par.address, &addr);
-            //revert the bytes
-            addr.s_addr = ((addr.s_addr & 0xff000000) >> 24) | 
-                          ((addr.s_addr & 0x00ff0000) >>  8) | 
-                          ((addr.s_addr & 0x0000ff00) <<  8) |
-                          ((addr.s_addr & 0x000000ff) << 24);
-            inet_ntop(AF_INET, &addr, reversed_ip, sizeof(reversed_ip));
-            strcat(reversed_ip, ".in-addr.arpa"); //add .in-addr.arpa
-            hostname_to_DNSname((unsigned char *)reversed_ip, qname);
-        } else if (is_it_IPv6(par.address)){ //2001:67c:1220:809::93e5:917  -->  7.1.9.0.5.e.3.9.0.0.0.0.0.0.0.0.9.0.8.0.0.2.2.1.c.7.6.0.1.0.0.2.ip6.arpa
-            struct in6_addr addr;
-            char reversed_ip6[128];
-            reversed_ip6[0] = '\0';
-
-            inet_pton(AF_INET6, (const char *)par.address, &addr);
-            //revert the bytes
-            for (int i = 0; i < 8; i++){
-                switch_bytes(&addr.s6_addr[i], &addr.s6_addr[15-i]);
-            }
-            //save 'XX.XX.XX.XX...' as 'C.C.C.C.C.C.C.C...'
-            char save[3];
-            char save2[3];
-            for (int i = 0; i < 16; i++){
-                //XY -> X.Y.
-                //X.
-                sprintf(save, "%02X", addr.s6_addr[i]);
-                save[1] = '.';
-                strcat(reversed_ip6, save);
-                //Y.
-                sprintf(save2, "%02X", addr.s6_addr[i]);
-                string_firstnchars_remove(save2, 1);
-                strcat(save2, ".");
-                strcat(reversed_ip6, save2);
-            }
-            //set string to lowercase
-            for(int i = 0; reversed_ip6[i]; i++){
-                reversed_ip6[i] = tolower(reversed_ip6[i]);
-            }
-            //add ".ip6.arpa"
-            strcat(reversed_ip6, "ip6.arpa"); //add .in-addr.arpa
-
-            hostname_to_DNSname((unsigned char *)reversed_ip6, qname);
+        char reversed[128];
+        if (dns_reverse_name(par.address, reversed) == 0){
+            hostname_to_DNSname((unsigned char *)reversed, qname);
         }
         return;
     }
@@ -702,6 +1162,10 @@ void dns_qname_insert(unsigned char *qname){
         }
         hostname_to_DNSname((unsigned char *)hp->h_name, qname);
     } else if (is_it_hostname(par.address)){
+        if (par.Qtype != DNS_QTYPE_A && par.Qtype != DNS_QTYPE_AAAA){ //service names (_sip._tcp...) need not have addresses
+            hostname_to_DNSname((unsigned char *)par.address, qname);
+            return;
+        }
         struct hostent *hp = gethostbyname((const char *)par.address);
         if (hp == NULL){ //if gethostname() wasn't successful in retrieving address info
             fprintf(stderr, "ERROR: couldn't resolve 'address' hostname, make sure it is accessible and written correctly\r\n");
@@ -720,83 +1184,143 @@ void dns_qinfo_prep(struct dns_question_t *qinfo, uint32_t qtype, uint32_t qclas
 	qinfo->q_class = htons((int)qclass); //qclass (IN, CH, HS,...)
 }
 
-//fills pre-prepared reply arrays with received data
-void dns_reply_load(unsigned char *buf, unsigned char *reader, struct dns_header_t *dns, struct dns_replies *dns_rep){
-	int stop = 0;
+//serializes query template, everything after it only patches ID/flags
+void dns_query_build(struct dns_query_t *q, const unsigned char *qname, size_t qname_len, uint16_t qtype, bool rd){
+    struct dns_header_t *dns = (struct dns_header_t *)q->pkt;
+    dns_pack_prep(dns);
+    dns->rd = rd;
+    memcpy(&q->pkt[sizeof(struct dns_header_t)], qname, qname_len);
+    dns_qinfo_prep((struct dns_question_t *)&q->pkt[sizeof(struct dns_header_t) + qname_len], qtype, DNS_QCLASS_IN);
+    q->qname_len = (uint16_t)qname_len;
+    q->len = (uint16_t)(sizeof(struct dns_header_t) + qname_len + sizeof(struct dns_question_t));
+}
 
-    //start reading answers
-	for(int i = 0; i < ntohs(dns->ancount); i++){
-		dns_rep->answers[i].name = read_compressed_name(reader, buf, &stop);
-		reader = reader + stop;
+//patches ID and flags of query template in place
+void dns_query_patch(struct dns_query_t *q, uint16_t id, bool rd){
+    struct dns_header_t *dns = (struct dns_header_t *)q->pkt;
+    dns->id = htons(id);
+    dns->rd = rd;
+}
 
-		dns_rep->answers[i].resource = (struct record_data*)(reader);
-		reader = reader + sizeof(struct record_data);
+//frees names and rdata of first 'count' records of a section
+static void dns_section_free(struct dns_record_a_t *records, int count){
+    for (int i = 0; i < count; i++){
+        free(records[i].name);
+        free(records[i].rdata);
+    }
+}
 
-		if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->answers[i].resource->type)), "A") == 0 ||    //if it's an ipv4
-            strcmp(DNS_Qtype_tostr(ntohs(dns_rep->answers[i].resource->type)), "AAAA") == 0){  //or ipv6 address
-			dns_rep->answers[i].rdata = (unsigned char*)malloc(ntohs(dns_rep->answers[i].resource->data_len+1));
+//fills one section's records, returns where the next section starts (NULL if a record runs past the reply,
+//'loaded' holds the amount of records filled then)
+static unsigned char* dns_section_load(unsigned char *buf, size_t len, unsigned char *reader, struct dns_record_a_t *records,
+                                       uint16_t count, int *loaded){
+	int stop = 0;
+    unsigned char *end = buf + len;
 
-			for(int j = 0; j < ntohs(dns_rep->answers[i].resource->data_len); j++){
-				dns_rep->answers[i].rdata[j]=reader[j];
-			}
+	for(*loaded = 0; *loaded < count; (*loaded)++){
+        struct dns_record_a_t *rec = &records[*loaded];
+		if ((rec->name = read_compressed_name(reader, buf, len, &stop)) == NULL){
+            return NULL;
+        }
+		reader = reader + stop;
 
-			dns_rep->answers[i].rdata[ntohs(dns_rep->answers[i].resource->data_len)] = '\0';
+		rec->resource = (struct record_data*)(reader);
+        if ((size_t)(end - reader) < sizeof(struct record_data) ||
+            (size_t)(end - reader) - sizeof(struct record_data) < ntohs(rec->resource->data_len)){
+            free(rec->name);
+            return NULL;
+        }
+		reader = reader + sizeof(struct record_data);
 
-			reader = reader + ntohs(dns_rep->answers[i].resource->data_len);
-		} else {
-			dns_rep->answers[i].rdata = read_compressed_name(reader, buf, &stop);
-			reader = reader + stop;
+		//decode rdata according to its type (falls back to generic form if malformed)
+		uint16_t rdlen = ntohs(rec->resource->data_len);
+		rec->rdata = rr_type_get(ntohs(rec->resource->type))->decode(buf, len, reader, rdlen);
+		if (rec->rdata == NULL){
+			rec->rdata = rr_type_get(0)->decode(buf, len, reader, rdlen);
 		}
+        if (rec->rdata == NULL){ //out of memory
+            free(rec->name);
+            return NULL;
+        }
+		reader = reader + rdlen;
 	}
+	return reader;
+}
 
-    //read authorities
-	for(int i = 0; i < ntohs(dns->nscount); i++){
-		dns_rep->auth[i].name = read_compressed_name(reader, buf, &stop);
-		reader+=stop;
-
-		dns_rep->auth[i].resource=(struct record_data*)(reader);
-		reader+=sizeof(struct record_data);
-
-		dns_rep->auth[i].rdata = read_compressed_name(reader, buf, &stop);
-		reader += stop;
-	}
-
-    //read additional
-	for(int i = 0; i < ntohs(dns->arcount); i++){
-		dns_rep->addit[i].name = read_compressed_name(reader, buf, &stop);
-		reader+=stop;
-
-		dns_rep->addit[i].resource=(struct record_data*)(reader);
-		reader+=sizeof(struct record_data);
-
-		if (strcmp(DNS_Qtype_tostr(ntohs(dns_rep->addit[i].resource->type)), "A") == 0 ||    //if it's an ipv4
-            strcmp(DNS_Qtype_tostr(ntohs(dns_rep->addit[i].resource->type)), "AAAA") == 0){  //or ipv6 address
-			dns_rep->addit[i].rdata = (unsigned char*)malloc(ntohs(dns_rep->addit[i].resource->data_len+1));
-
-			for(int j = 0; j < ntohs(dns_rep->addit[i].resource->data_len); j++){
-                dns_rep->addit[i].rdata[j]=reader[j];
-            }
-
-			dns_rep->addit[i].rdata[ntohs(dns_rep->addit[i].resource->data_len)] = '\0';
-
-			reader = reader + ntohs(dns_rep->addit[i].resource->data_len);
-		} else {
-			dns_rep->addit[i].rdata = read_compressed_name(reader, buf, &stop);
-			reader += stop;
-		}
-	}
+//fills pre-prepared reply arrays with received data
+int dns_reply_load(unsigned char *buf, size_t len, unsigned char *reader, struct dns_header_t *dns, struct dns_replies *dns_rep){
+    int an = 0, ns = 0, ar = 0;
+    if (ntohs(dns->ancount) > 50 || ntohs(dns->nscount) > 50 || ntohs(dns->arcount) > 50 || reader > buf + len){
+        return 1;
+    }
+    //start reading answers, then authorities, then additional
+	if ((reader = dns_section_load(buf, len, reader, dns_rep->answers, ntohs(dns->ancount), &an)) == NULL ||
+        (reader = dns_section_load(buf, len, reader, dns_rep->auth, ntohs(dns->nscount), &ns)) == NULL ||
+        dns_section_load(buf, len, reader, dns_rep->addit, ntohs(dns->arcount), &ar) == NULL){
+        dns_section_free(dns_rep->answers, an);
+        dns_section_free(dns_rep->auth, ns);
+        dns_section_free(dns_rep->addit, ar);
+        return 1;
+    }
+    return 0;
 }
 
 /*************************************************
  *                     MAIN
 *************************************************/
+#ifndef DNS_NO_MAIN //left out when the resolver is linked into tools (dnscol)
 int main (int argc, char *argv[]){
 //parse input arguments
+    TRACE_INIT();
+    TRACE_START(t_validate);
     if (parse_args(argc, argv)){
         exit (1);
     }
+    TRACE_END(TRACE_VALIDATE, t_validate);
     //list_args(par);
 
+//iterative mode follows referrals itself (for a single address or a whole file)
+    if (par.iterative){
+        return iter_run();
+    }
+
+//counters are exported while the modes below run
+    if (strcmp(par.metrics, "") != 0 && metrics_start(par.metrics) != 0){
+        return 1;
+    }
+
+//load generation replays query file at target rate and reports what the server sustained
+    if (strcmp(par.loadfile, "") != 0){
+        int ret = load_run();
+        metrics_stop();
+        return ret;
+    }
+
+//probe mode watches its servers round after round from one event loop
+    if (strcmp(par.monitorfile, "") != 0){
+        int ret = monitor_run();
+        metrics_stop();
+        return ret;
+    }
+
+//batch mode (names read from file) runs its own send/receive loop
+    if (strcmp(par.infile, "") != 0){
+        int ret = batch_run();
+        metrics_stop();
+        TRACE_REPORT();
+        return ret;
+    }
+
+//dual-stack mode sends two queries and merges their replies
+    if (par.dual){
+        return dual_run();
+    }
+
+//zone transfers stream records from a TCP connection as they arrive
+    if (par.Qtype == DNS_QTYPE_AXFR || par.Qtype == DNS_QTYPE_IXFR){
+        return xfr_run();
+    }
+
 //OBSOLETE!!!
 //get DNS servers from /etc/resolv.conf
     //dns_servers_get();
@@ -808,55 +1332,73 @@ int main (int argc, char *argv[]){
     int sockfd; //socket
     struct sockaddr_in dest;   //IPv4 address
 	struct sockaddr_in6 dest6; //IPv6 address
+    TRACE_START(t_socket);
     sock_prep(&sockfd, &dest, &dest6);
+    TRACE_END(TRACE_SOCKET, t_socket);
 
-//prepare packet DNS header and DNS reply structures
-	struct dns_header_t *dns = (struct dns_header_t *)&buf; //point header structure to packet header portion
-    dns_pack_prep(dns);
-    //the above function sets the header to defaults (standard query), we need to modify some bits/flags)
-	dns->rd = par.recursion; //set Recursion Desired
-
-//prepare empty dns query structure and insert qname into packet
-    unsigned char *qname; //query name string
-	//point to the query portion
-	qname =(unsigned char*)&buf[sizeof(struct dns_header_t)]; //buffer: [{dns header}{qname}{...}]
+//prepare query packet (header, qname and question fields serialized at once)
+    struct dns_query_t query;
+    unsigned char qname[256];
+    TRACE_START(t_qname);
     dns_qname_insert(qname);
-	struct dns_question_t *qinfo = NULL;
-    //point after qname
-	qinfo =(struct dns_question_t*)&buf[sizeof(struct dns_header_t) + (strlen((const char*)qname) + 1)];
-    if (par.reverse){
-        dns_qinfo_prep(qinfo, DNS_QTYPE_PTR, DNS_QCLASS_IN); //PTR for reverse DNS lookup
-    } else {
-        dns_qinfo_prep(qinfo, par.Qtype, DNS_QCLASS_IN); //class IN = internet
-    }
-
-
-//send packet
-    if (is_it_IPv6(par.server)){
-        if(sendto(sockfd,(char*)buf,sizeof(struct dns_header_t) + (strlen((const char*)qname)+1) + sizeof(struct dns_question_t),0,(struct sockaddr*)&dest6,sizeof(dest6)) < 0){
-            perror("ERROR: sendto failure");
+    TRACE_END(TRACE_QNAME, t_qname);
+    size_t qlen = strlen((const char*)qname) + 1; //only place qname length is computed
+    uint16_t qtype = par.reverse ? DNS_QTYPE_PTR : par.Qtype; //PTR for reverse DNS lookup
+    dns_query_build(&query, qname, qlen, qtype, par.recursion);
+    uint16_t id = ntohs(((struct dns_header_t *)query.pkt)->id);
+    unsigned char host[256]; //printable qname for probes
+    memcpy(host, qname, qlen);
+    DNSname_to_hostname(host);
+    DNS_PROBE4(query_build, host, qtype, id, query.len);
+
+//send packet and receive the answer (through io_uring if requested and available)
+    struct sockaddr *to = is_it_IPv6(par.server) ? (struct sockaddr *)&dest6 : (struct sockaddr *)&dest;
+    socklen_t tolen = is_it_IPv6(par.server) ? sizeof(dest6) : sizeof(dest);
+    struct uring ring;
+    TRACE_START(t_wire);
+    DNS_PROBE6(query_send, host, qtype, id, par.server, query.len, 1);
+    ssize_t rlen;
+    if (par.uring && connect(sockfd, to, tolen) == 0 && uring_open(&ring, sockfd) == 0){
+        if ((rlen = uring_exchange(&ring, query.pkt, query.len, buf, sizeof(buf), 10000)) < 0){ //same 10 second timeout as plain socket
+            perror("ERROR: io_uring failure");
             exit(1);
         }
+        uring_close(&ring);
     } else {
-        if(sendto(sockfd,(char*)buf,sizeof(struct dns_header_t) + (strlen((const char*)qname)+1) + sizeof(struct dns_question_t),0,(struct sockaddr*)&dest,sizeof(dest)) < 0){
+        if (par.uring){
+            fprintf(stderr, "WARNING: io_uring isn't available, using plain sockets\r\n");
+        }
+        if(sendto(sockfd,(char*)query.pkt,query.len,0,to,tolen) < 0){
             perror("ERROR: sendto failure");
             exit(1);
         }
-    }
-
-//receive the answer
-    if (is_it_IPv6(par.server)){
-        int i = sizeof dest6;
-        if(recvfrom (sockfd,(char*)buf , 65536 , 0 , (struct sockaddr*)&dest6 , (socklen_t*)&i ) < 0){
+        if((rlen = recvfrom(sockfd,(char*)buf,65536,0,NULL,NULL)) < 0){
             perror("ERROR: recvfrom failure");
             exit(1);
         }
-    } else {
-        int i = sizeof dest;
-        if(recvfrom (sockfd,(char*)buf , 65536 , 0 , (struct sockaddr*)&dest , (socklen_t*)&i ) < 0){
-            perror("ERROR: recvfrom failure");
-            exit(1);
+    }
+    TRACE_END(TRACE_WIRE, t_wire);
+    DNS_PROBE3(reply_receive, par.server, rlen, ntohs(((struct dns_header_t *)buf)->id));
+
+//addresses only: pulled out of the reply in place, nothing decoded or allocated
+    if (par.addresses_only){
+        struct addr_only addrs;
+        char text[ADDR_ONLY_TEXT_MAX];
+        DNS_PROBE4(decode_start, host, qtype, id, rlen);
+        TRACE_START(t_decode);
+        int bad = addr_only_extract(buf, (size_t)rlen, &addrs);
+        TRACE_END(TRACE_DECODE, t_decode);
+        if (bad){
+            fprintf(stderr, "ERROR: malformed reply\r\n");
+            return 1;
         }
+        DNS_PROBE4(decode_end, host, qtype, id, addrs.count);
+        TRACE_START(t_print);
+        fwrite(text, 1, addr_only_format(&addrs, host, text), stdout);
+        TRACE_END(TRACE_PRINT, t_print);
+        DNS_PROBE4(print, host, qtype, id, 1);
+        TRACE_REPORT();
+        return 0;
     }
 
 //load answers into pre-prepared records string arrays
@@ -864,19 +1406,32 @@ int main (int argc, char *argv[]){
     //we need to read data which is saved past the dns header and query fields, 
     //so we need to create a pointer which we will then point ahead of them
     unsigned char *reader;
-	reader = &buf[sizeof(struct dns_header_t) +    //move past dns header
-                  (strlen((const char*)qname)+1) + //move past qname
-                   sizeof(struct dns_question_t)]; //move past qinfo
+	struct dns_header_t *dns = (struct dns_header_t *)&buf; //point header structure to packet header portion
+	struct dns_question_t *qinfo = (struct dns_question_t*)&buf[sizeof(struct dns_header_t) + qlen];
+	reader = &buf[query.len]; //move past dns header, qname and qinfo (the reply repeats our question)
     //buffer: [{dns header}{qname}{qinfo} *reader--> {...}]
-    dns_reply_load(buf, reader, dns, &dns_rep);
+    DNS_PROBE4(decode_start, host, qtype, id, rlen);
+    TRACE_START(t_decode);
+    int bad = dns_reply_load(buf, (size_t)rlen, reader, dns, &dns_rep);
+    TRACE_END(TRACE_DECODE, t_decode);
+    if (bad){
+        fprintf(stderr, "ERROR: malformed reply\r\n");
+        return 1;
+    }
+    DNS_PROBE4(decode_end, host, qtype, id, ntohs(dns->ancount) + ntohs(dns->nscount) + ntohs(dns->arcount));
 
 //print results
     DNSname_to_hostname(qname); //convert qname into printable format for qol
+    TRACE_START(t_print);
     project_print(dns, qinfo, &dns_rep, qname);
+    TRACE_END(TRACE_PRINT, t_print);
+    DNS_PROBE4(print, host, qtype, id, 1);
+    TRACE_REPORT();
 
 //free allocated memory (program only ever allocates memory for the 'dns_replies' structure 
 //inside 'dns_reply_load' function (and by extension 'read_compressed_name' function))
     clean_exit(dns, &dns_rep);
 
 	return 0;
-}
\ No newline at end of file
+}
+#endif
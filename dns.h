@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
 #include <getopt.h>
@@ -36,7 +37,11 @@ https://0x00sec.org/t/dns-header-for-c/618 */
 #define DNS_QTYPE_SOA		6
 #define DNS_QTYPE_PTR       12
 #define DNS_QTYPE_MX		15
+#define DNS_QTYPE_TXT		16
 #define DNS_QTYPE_AAAA		28
+#define DNS_QTYPE_SRV		33
+#define DNS_QTYPE_IXFR		251
+#define DNS_QTYPE_AXFR		252
 
 /* DNS QCLASS */
 #define DNS_QCLASS_RESERVED	0
@@ -50,6 +55,9 @@ https://0x00sec.org/t/dns-header-for-c/618 */
 //2D array of first 5 DNS servers found in /etc/resolv.conf file
 //char dns_list[5][50];
 
+//servers '-s' takes at most (more than one form the batch server pool)
+#define SERVERS_MAX 32
+
 /**
  * @struct: structure for program's input parameters
 */
@@ -59,14 +67,79 @@ struct params{
     bool reverse;   /* [-x] (not received = direct request (we know hostname and want IP of host), 
                             received = reverse request (we know IP of host and want hostname) */
     unsigned int Qtype; /* [-6] (not received = request of type A (IPv4),
-                                received = request of type AAAA (IPv6)) */
+                                received = request of type AAAA (IPv6)),
+                           [-t type] (request of any type registered in rrtypes.c) */
     char server[128];  /* -s server (IP address or domain name of server to which requests will be sent) */
+    char servers[SERVERS_MAX][136]; /* -s server[,server...] (every server given, "host" or "host#port";
+                                                            more than one = batch server pool) */
+    unsigned int nservers;
     uint16_t port; /* [-p port] (not received = set to 53 by default,
                                     received = set to number specified on input (from 0 to 65353)) */
     char address[128]; /* address (address that is the object of query(request)) */
+    char infile[256];  /* [-f file] (not received = single query for 'address',
+                                     received = batch of names (one per line) read from file, '-' = stdin) */
+    unsigned int window; /* [-w window] (maximum amount of batch queries kept in flight at once) */
+    bool iterative; /* [-i] (not received = single query sent to 'server',
+                            received = iterative resolution following referrals from root hints) */
+    char hints[256];   /* [-H file] (root hints file for iterative resolution, built-in root servers if not received) */
+    bool dual;      /* [-d] (not received = one query of type 'Qtype',
+                            received = A and AAAA queries sent back-to-back, answers printed together) */
+    bool uring;     /* [-u] (not received = sendto/recvfrom per datagram,
+                            received = io_uring backend if the kernel supports it) */
+    bool trace_phases; /* [--trace-phases] (per-phase timing of lookups printed to stderr at exit) */
+    unsigned int sockets; /* [--sockets n] (UDP sockets on random source ports batch queries are spread across) */
+    int rcvbuf;        /* [--rcvbuf bytes] (SO_RCVBUF of batch sockets) */
+    int sndbuf;        /* [--sndbuf bytes] (SO_SNDBUF of batch sockets) */
+    char outfile[256]; /* [-o file] (not received = batch results printed as text,
+                                     received = batch results written to file in columnar binary format) */
+    uint32_t serial;   /* [--serial n] (SOA serial of the zone copy we hold, required for '-t IXFR') */
+    bool serial_given;
+    char loadfile[256]; /* [--load file] (not received = resolve 'address' or '-f' names,
+                                         received = replay queries ("name [type]" lines) as load, report rate/loss/latency) */
+    unsigned int qps;   /* [--qps n] (target queries per second of '--load', 0 = as fast as the window allows) */
+    double duration;    /* [--duration s] (replay '--load' queries in a loop for this long, 0 = one pass;
+                                          '--monitor' for this long, 0 = until SIGINT/SIGTERM) */
+    double interval;    /* [--interval s] (seconds between '--load' progress reports or '--monitor' rounds) */
+    double timeout;     /* [--timeout s] (seconds after which unanswered '--load'/'--monitor' query counts as lost) */
+    char monitorfile[256]; /* [--monitor file] (servers ("server address [port]" lines) probed with queries
+                                                ("query name [type]" lines) every '--interval' seconds) */
+    char shmname[256]; /* [--shm name] (not received = batch results printed or written to '-o' file,
+                                        received = batch results published to shared-memory ring /dev/shm/name) */
+    uint64_t shmsize;  /* [--shm-size bytes] (data bytes of '--shm' ring, power of two) */
+    char journalfile[256]; /* [--journal file] (not received = batch starts from the first line,
+                                               received = completed lines checkpointed to file, a rerun skips them) */
+    bool addresses_only; /* [--addresses-only] (not received = replies printed in full,
+                                                received = only A/AAAA addresses of answers printed, one per line) */
+    unsigned int compress; /* [--compress method[:level]] (not received = batch output written as text,
+                                                         received = gzip/zstd compressed by a writer thread) */
+    int compress_level;
+    char metrics[256];  /* [--metrics target] (not received = counters not exported, received = Prometheus text
+                                              format served on "http:port"/"unix:path" or written to file) */
 };
-//global params struct declaration
-struct params par = {.recursion = false, .reverse = false, .Qtype = DNS_QTYPE_A, .server = "", .port = 53, .address = ""}; //create struct var
+//global params struct declaration (defined in dns.c)
+extern struct params par;
+
+//options which take an operand (so the 'address' search in 'parse_args' knows to skip it)
+#define ARGS_WITH_OPERAND "spfwHto"
+
+//long-only options (values outside of the single character range)
+#define OPT_TRACE_PHASES 256
+#define OPT_SOCKETS      257
+#define OPT_RCVBUF       258
+#define OPT_SNDBUF       259
+#define OPT_SERIAL       260
+#define OPT_LOAD         261
+#define OPT_QPS          262
+#define OPT_DURATION     263
+#define OPT_INTERVAL     264
+#define OPT_TIMEOUT      265
+#define OPT_MONITOR      266
+#define OPT_SHM          267
+#define OPT_SHM_SIZE     268
+#define OPT_JOURNAL      269
+#define OPT_ADDRESSES_ONLY 270
+#define OPT_COMPRESS     271
+#define OPT_METRICS      272
 
 /**
  * @struct: DNS header structure
@@ -137,6 +210,20 @@ struct dns_question_t{
     uint16_t q_class;    /* The QCLASS (1 = IN) */
 };
 
+#define DNS_QUERY_MAX 272 //header (12) + longest DNSname (255) + question fields (4), rounded up
+
+/**
+ * @struct: pre-serialized query (header, qname, question fields)
+ *
+ * Built once per (qname, qtype), every send (first one, retransmit, other server)
+ * then only patches ID and flags in place instead of rebuilding the packet.
+*/
+struct dns_query_t{
+    unsigned char pkt[DNS_QUERY_MAX];
+    uint16_t len;       /* packet length */
+    uint16_t qname_len; /* qname length including the terminating zero */
+};
+
 //Constant sized fields of the resource record structure
 #pragma pack(push, 1)
 struct record_data
@@ -209,6 +296,23 @@ void dns_header_fullprint(struct dns_header_t *dns);
 void project_print(struct dns_header_t *dns, struct dns_question_t *question, 
                    struct dns_replies *dns_rep, unsigned char *qname);
 
+/**
+ * @function: project_print_records
+ * @brief prints answer, authority and additional sections in the format the assignment desires
+ *
+ * @param[in] dns:     pointer to dns header structure (section record counts are taken from it)
+ * @param[in] dns_rep: a response record structure containing all (answer, authority, additional) records
+ */
+void project_print_records(struct dns_header_t *dns, struct dns_replies *dns_rep);
+
+/**
+ * @function: project_print_record
+ * @brief prints one resource record line in the format the assignment desires
+ *
+ * @param[in] rec: decoded resource record
+ */
+void project_print_record(struct dns_record_a_t *rec);
+
 /*************************************************
  *           AUXILIARY TASK FUNCTIONS            *
 *************************************************/
@@ -277,10 +381,10 @@ void DNSname_to_hostname(unsigned char *str);
 
 /**
  * @function: DNS_Qtype_tostr
- * @brief Qtype short to string converter
+ * @brief Qtype short to string converter (looks the type up in the rrtypes.c registry)
  * 
  * @param[in] Qtype: short value of query type
- * @return string version of query type
+ * @return string version of query type ("TYPE<n>" per RFC 3597 for unregistered types, valid until next call)
  */
 char* DNS_Qtype_tostr(uint16_t Qtype);
 
@@ -289,32 +393,34 @@ char* DNS_Qtype_tostr(uint16_t Qtype);
  * @brief Qclass short to string converter
  * 
  * @param[in] Qclass: short value of query class
- * @return string version of query class
+ * @return string version of query class ("CLASS<n>" per RFC 3597 for unknown classes, valid until next call)
  */
 char* DNS_Qclass_tostr(uint16_t Qclass);
 
 /**
- * @function: dec_to_hex_IPv6
- * @brief function that takes IPv6 in decimal form and transforms it into an actual IPv6 (hexa)
+ * @function: read_compressed_name
+ * @brief read compressed name from a dns record
  * 
- * @param[in] input_string:  string containing the decimal form of an IPv6
- * @param[in] output_string: string to save the hexa form of an IPv6 into
- * @param[in] length:        length of @param input_string
- * @return hexa form of IPv6 saved in @param output_string
+ * @param[in] reader: pointer to where compressed name is in @param buffer
+ * @param[in] buffer: buffer string containing the whole packet reply
+ * @param[in] len:    length of @param buffer (no label or pointer may lead past it)
+ * @param[in] count:  set to the amount of bytes the name takes at @param reader
+ * 
+ * @return string containing the decompressed name, NULL if the name is malformed or runs past @param len
  */
-char* dec_to_hex_IPv6(unsigned char *input_string, char* output, int length);
+unsigned char* read_compressed_name(unsigned char* reader, unsigned char* buffer, size_t len, int* count);
 
 /**
- * @function: read_compressed_name
- * @brief read compressed name from a dns record
+ * @function: dns_record_skip
+ * @brief skip over whole resource record without decompressing its name
  * 
- * @param[in] reader: pointer to where compressed name is in @param buffer
  * @param[in] buffer: buffer string containing the whole packet reply
- * @param[in] count:  jump counter
+ * @param[in] len:    length of @param buffer (the record may not run past it)
+ * @param[in] reader: pointer to where the record starts in @param buffer
  * 
- * @return string containing the decompressed name
+ * @return pointer to where the next record starts, NULL if the record is malformed or runs past @param len
  */
-unsigned char* read_compressed_name(unsigned char* reader, unsigned char* buffer, int* count);
+unsigned char* dns_record_skip(unsigned char* buffer, size_t len, unsigned char* reader);
 
 /**
  * @function: switch_bytes
@@ -377,6 +483,17 @@ void sock_prep(int *sockfd, struct sockaddr_in *dest, struct sockaddr_in6 *dest6
 */
 void dns_pack_prep(struct dns_header_t *dns);
 
+/**
+ * @function: dns_reverse_name
+ * @brief builds reverse lookup hostname out of an IP address 
+ *        (147.229.8.12 --> 12.8.229.147.in-addr.arpa)
+ * 
+ * @param[in] address: IPv4 or IPv6 address string
+ * @param[in] out:     string (at least 128 chars) to save resulting hostname into
+ * @return 0 if successful, 1 if @param address isn't an IP address
+*/
+int dns_reverse_name(const char *address, char *out);
+
 /**
  * @function: dns_qname_insert
  * @brief resolves query hostname into DNSname and saves it into buffer. Also handles reverse DNS query
@@ -395,15 +512,41 @@ void dns_qname_insert(unsigned char *qname);
 */
 void dns_qinfo_prep(struct dns_question_t *qinfo, uint32_t qtype, uint32_t qclass);
 
+/**
+ * @function: dns_query_build
+ * @brief serializes query template (header with given flags, qname, question fields)
+ * 
+ * @param[in] q:         template to fill
+ * @param[in] qname:     DNSname (3www6google3com0), at most 255 chars long
+ * @param[in] qname_len: length of @param qname including the terminating zero
+ * @param[in] qtype:     query type
+ * @param[in] rd:        Recursion Desired flag
+*/
+void dns_query_build(struct dns_query_t *q, const unsigned char *qname, size_t qname_len, uint16_t qtype, bool rd);
+
+/**
+ * @function: dns_query_patch
+ * @brief patches transaction ID and Recursion Desired flag of query template in place
+ * 
+ * @param[in] q:  query template
+ * @param[in] id: transaction ID (host byte order)
+ * @param[in] rd: Recursion Desired flag
+*/
+void dns_query_patch(struct dns_query_t *q, uint16_t id, bool rd);
+
 /**
  * @function: dns_reply_load
- * @brief fills pre-prepared reply arrays with received data
+ * @brief fills pre-prepared reply arrays with received data 
+ *        (rdata is decoded by its type's decoder from the rrtypes.c registry)
  * 
  * @param[in] buf:     buffer holding whole packet reply
+ * @param[in] len:     length of the reply in @param buf
  * @param[in] reader:  pointer to where answer data starts in @param buf
  * @param[in] dns:     pointer to where dns header structure starts in @param buf
  * @param[in] dns_rep: pointer to where dns replies structure starts in @param buf
+ * @return 0 if successful (free with 'clean_exit'), 1 if a section has more than 50 records or a record
+ *         runs past @param len (nothing is left allocated then)
 */
-void dns_reply_load(unsigned char *buf, unsigned char *reader, struct dns_header_t *dns, struct dns_replies *dns_rep);
+int dns_reply_load(unsigned char *buf, size_t len, unsigned char *reader, struct dns_header_t *dns, struct dns_replies *dns_rep);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+/** @file:   dnscol.c
+ *  @brief:  Reader of columnar batch output (-o), prints it in the resolver's text format
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "columnar.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//column of block as typed array
+#define COL(block, hdr, c, type) ((const type *)((block) + (hdr)->col_off[c]))
+
+//check block is complete and every column is inside it, long enough for its entry count
+static bool dnscol_block_valid(const struct col_block_hdr *hdr, uint64_t avail){
+    static const size_t width[COL_COLUMNS] = {
+        [COL_NAME_OFF] = 4, [COL_R_QNAME] = 4, [COL_R_QTYPE] = 2, [COL_R_QCLASS] = 2, [COL_R_FLAGS] = 1,
+        [COL_R_RCODE] = 1, [COL_R_COUNTS] = 6, [COL_R_WAITERS] = 4, [COL_REC_REPLY] = 4, [COL_REC_OWNER] = 4,
+        [COL_REC_TYPE] = 2, [COL_REC_CLASS] = 2, [COL_REC_TTL] = 4, [COL_REC_SECTION] = 1, [COL_RDATA_OFF] = 4,
+    };
+    if (memcmp(hdr->magic, COL_BLOCK_MAGIC, sizeof(hdr->magic)) != 0 || hdr->size < sizeof(*hdr) || hdr->size > avail){
+        return false;
+    }
+    for (int c = 0; c < COL_COLUMNS; c++){
+        if (hdr->col_off[c] > hdr->size || hdr->col_len[c] > hdr->size - hdr->col_off[c] || hdr->col_off[c] % COL_ALIGN != 0){
+            return false;
+        }
+        uint64_t entries = (c == COL_NAME_OFF) ? (uint64_t)hdr->nnames + 1 :
+                           (c == COL_RDATA_OFF) ? (uint64_t)hdr->nrecords + 1 :
+                           (c >= COL_R_QNAME && c <= COL_R_WAITERS) ? hdr->nreplies : hdr->nrecords;
+        if (width[c] != 0 && hdr->col_len[c] < entries * width[c]){
+            return false;
+        }
+    }
+    return true;
+}
+
+//value of NUL terminated blob at given offset (NULL if offset is out of the blob)
+static unsigned char *dnscol_str(const unsigned char *blob, uint64_t len, uint32_t off){
+    if (off >= len || memchr(blob + off, 0, len - off) == NULL){
+        return NULL;
+    }
+    return (unsigned char *)(blob + off);
+}
+
+//prints all replies of one block
+static bool dnscol_block_print(const unsigned char *block, const struct col_block_hdr *hdr){
+    const uint32_t *name_off = COL(block, hdr, COL_NAME_OFF, uint32_t);
+    const unsigned char *names = block + hdr->col_off[COL_NAMES];
+    const uint32_t *r_qname = COL(block, hdr, COL_R_QNAME, uint32_t);
+    const uint16_t *r_qtype = COL(block, hdr, COL_R_QTYPE, uint16_t);
+    const uint16_t *r_qclass = COL(block, hdr, COL_R_QCLASS, uint16_t);
+    const uint8_t *r_flags = COL(block, hdr, COL_R_FLAGS, uint8_t);
+    const uint8_t *r_rcode = COL(block, hdr, COL_R_RCODE, uint8_t);
+    const uint16_t *r_counts = COL(block, hdr, COL_R_COUNTS, uint16_t);
+    const uint32_t *r_waiters = COL(block, hdr, COL_R_WAITERS, uint32_t);
+    const uint32_t *rec_owner = COL(block, hdr, COL_REC_OWNER, uint32_t);
+    const uint16_t *rec_type = COL(block, hdr, COL_REC_TYPE, uint16_t);
+    const uint16_t *rec_class = COL(block, hdr, COL_REC_CLASS, uint16_t);
+    const uint32_t *rec_ttl = COL(block, hdr, COL_REC_TTL, uint32_t);
+    const uint32_t *rdata_off = COL(block, hdr, COL_RDATA_OFF, uint32_t);
+    const unsigned char *rdata = block + hdr->col_off[COL_RDATA];
+
+    static struct dns_replies rep;
+    static struct record_data res[150];
+    struct dns_record_a_t *sections[3] = {rep.answers, rep.auth, rep.addit};
+    uint32_t rec = 0;
+
+    for (uint32_t r = 0; r < hdr->nreplies; r++){
+      //rebuild header and question the way project_print reads them
+        struct dns_header_t dns;
+        struct dns_question_t qinfo;
+        memset(&dns, 0, sizeof(dns));
+        dns.aa = (r_flags[r] & COL_F_AUTHORITATIVE) ? 1 : 0;
+        dns.ra = (r_flags[r] & COL_F_RECURSIVE) ? 1 : 0; //printed as "Recursive: Yes" only with 'par.recursion'
+        dns.tc = (r_flags[r] & COL_F_TRUNCATED) ? 1 : 0;
+        dns.rcode = r_rcode[r] & 0x0f;
+        dns.qdcount = htons(1);
+        dns.ancount = htons(r_counts[r * 3]);
+        dns.nscount = htons(r_counts[r * 3 + 1]);
+        dns.arcount = htons(r_counts[r * 3 + 2]);
+        qinfo.q_type = htons(r_qtype[r]);
+        qinfo.q_class = htons(r_qclass[r]);
+        unsigned char *qname = (r_qname[r] < hdr->nnames) ? dnscol_str(names, hdr->col_len[COL_NAMES], name_off[r_qname[r]]) : NULL;
+        if (qname == NULL){
+            return false;
+        }
+
+      //point records straight into the mapping (rdata is NUL terminated there)
+        unsigned int used = 0;
+        for (int sec = 0; sec < 3; sec++){
+            uint16_t count = r_counts[r * 3 + sec];
+            if (count > 50 || rec + count > hdr->nrecords){
+                return false;
+            }
+            for (uint16_t i = 0; i < count; i++, rec++, used++){
+                struct dns_record_a_t *out = &sections[sec][i];
+                if (rec_owner[rec] >= hdr->nnames || rdata_off[rec + 1] <= rdata_off[rec] ||
+                    (out->name = dnscol_str(names, hdr->col_len[COL_NAMES], name_off[rec_owner[rec]])) == NULL ||
+                    (out->rdata = dnscol_str(rdata, hdr->col_len[COL_RDATA], rdata_off[rec])) == NULL){
+                    return false;
+                }
+                res[used].type = htons(rec_type[rec]);
+                res[used].class = htons(rec_class[rec]);
+                res[used].ttl = htonl(rec_ttl[rec]);
+                res[used].data_len = htons((uint16_t)(rdata_off[rec + 1] - rdata_off[rec] - 1));
+                out->resource = &res[used];
+            }
+        }
+        for (uint32_t w = 0; w < r_waiters[r]; w++){
+            project_print(&dns, &qinfo, &rep, qname);
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]){
+    if (argc != 2){
+        fprintf(stderr, "usage: dnscol file   (prints columnar batch output written with 'dns -o file')\r\n");
+        return 1;
+    }
+    par.recursion = true; //"Recursive" flag was already resolved by the writer
+
+  //map whole file, blocks are read in place
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0){
+        fprintf(stderr, "ERROR: couldn't open file: %s\r\n", argv[1]);
+        return 1;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+    struct col_file_hdr fhdr;
+    if (size < sizeof(fhdr)){
+        fprintf(stderr, "ERROR: not a columnar output file: %s\r\n", argv[1]);
+        return 1;
+    }
+    unsigned char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED){
+        perror("ERROR: mmap failure");
+        return 1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    memcpy(&fhdr, map, sizeof(fhdr));
+    if (memcmp(fhdr.magic, COL_MAGIC, sizeof(COL_MAGIC)) != 0 || fhdr.version != COL_VERSION){
+        fprintf(stderr, "ERROR: not a columnar output file (or unsupported version): %s\r\n", argv[1]);
+        return 1;
+    }
+    if (fhdr.endian != COL_ENDIAN){
+        fprintf(stderr, "ERROR: file was written on a machine of different byte order: %s\r\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t pos = sizeof(fhdr);
+    while (pos < size){
+        const struct col_block_hdr *hdr = (const struct col_block_hdr *)(map + pos);
+        if (size - pos < sizeof(*hdr) || !dnscol_block_valid(hdr, size - pos) || !dnscol_block_print(map + pos, hdr)){
+            fprintf(stderr, "ERROR: corrupted block at offset %lu: %s\r\n", (unsigned long)pos, argv[1]);
+            return 1;
+        }
+        pos += hdr->size;
+    }
+
+    munmap(map, size);
+    close(fd);
+    return 0;
+}
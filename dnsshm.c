@@ -0,0 +1,131 @@
+/** @file:   dnsshm.c
+ *  @brief:  Reader of the shared-memory result ring (--shm), follows it and prints replies in the resolver's text format
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "shmring.h"
+
+#include <time.h>
+
+//points reply and its records into private copy 'rec' of a ring record ('len' bytes), false if it doesn't hold together
+static bool dnsshm_view(const unsigned char *rec, size_t len, struct dns_header_t *dns, struct dns_question_t *qinfo,
+                        struct dns_replies *rep, struct record_data *res, unsigned char **qname, uint32_t *waiters){
+    const unsigned char *p = rec, *end = rec + len;
+    const struct shm_reply *r = (const struct shm_reply *)(p + sizeof(struct shm_rec_hdr));
+    if (len < sizeof(struct shm_rec_hdr) + sizeof(*r) || r->qname_len == 0 ||
+        r->qname_len > (size_t)(end - (const unsigned char *)(r + 1)) || ((const unsigned char *)(r + 1))[r->qname_len - 1] != '\0'){
+        return false;
+    }
+
+  //rebuild header and question the way project_print reads them
+    memset(dns, 0, sizeof(*dns));
+    dns->aa = (r->flags & SHM_F_AUTHORITATIVE) ? 1 : 0;
+    dns->ra = (r->flags & SHM_F_RECURSIVE) ? 1 : 0; //printed as "Recursive: Yes" only with 'par.recursion'
+    dns->tc = (r->flags & SHM_F_TRUNCATED) ? 1 : 0;
+    dns->rcode = r->rcode & 0x0f;
+    dns->qdcount = htons(1);
+    dns->ancount = htons(r->counts[0]);
+    dns->nscount = htons(r->counts[1]);
+    dns->arcount = htons(r->counts[2]);
+    qinfo->q_type = htons(r->qtype);
+    qinfo->q_class = htons(r->qclass);
+    *qname = (unsigned char *)(r + 1);
+    *waiters = r->waiters;
+
+    struct dns_record_a_t *sections[3] = {rep->answers, rep->auth, rep->addit};
+    p = rec + ((sizeof(struct shm_rec_hdr) + sizeof(*r) + r->qname_len + 3) & ~(size_t)3);
+    unsigned int used = 0;
+    for (int sec = 0; sec < 3; sec++){
+        if (r->counts[sec] > 50){
+            return false;
+        }
+        for (uint16_t i = 0; i < r->counts[sec]; i++, used++){
+            const struct shm_record *in = (const struct shm_record *)p;
+            const unsigned char *v = p + sizeof(*in);
+            if (p > end || (size_t)(end - p) < sizeof(*in) ||
+                (size_t)in->owner_len + in->rdata_len + 1 > (size_t)(end - v) || in->owner_len == 0 ||
+                v[in->owner_len - 1] != '\0' || v[in->owner_len + in->rdata_len] != '\0'){
+                return false;
+            }
+            struct dns_record_a_t *out = &sections[sec][i];
+            out->name = (unsigned char *)v;
+            out->rdata = (unsigned char *)v + in->owner_len;
+            res[used].type = htons(in->type);
+            res[used].class = htons(in->class);
+            res[used].ttl = htonl(in->ttl);
+            res[used].data_len = htons(in->rdata_len);
+            out->resource = &res[used];
+            p += (sizeof(*in) + in->owner_len + in->rdata_len + 1 + 3) & ~(size_t)3;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]){
+    if (argc != 2){
+        fprintf(stderr, "usage: dnsshm name   (follows result ring published with 'dns -f file --shm name')\r\n");
+        return 1;
+    }
+    par.recursion = true; //"Recursive" flag was already resolved by the writer
+
+    struct shm_reader r;
+    if (shm_open_reader(&r, argv[1]) != 0){
+        return 1;
+    }
+
+    static struct dns_replies rep;
+    static struct record_data res[150];
+    unsigned char *copy = NULL;
+    size_t copy_cap = 0;
+    unsigned long replies = 0, torn = 0;
+    struct timespec idle = {.tv_sec = 0, .tv_nsec = 1000000};
+    while (true){
+        const struct shm_rec_hdr *rec = shm_reader_peek(&r);
+        if (rec == NULL){
+            if (shm_reader_done(&r)){
+                break;
+            }
+            fflush(stdout);
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+      //copied out of the ring and checked the writer didn't overwrite it meanwhile, only then printed
+      //(a torn record never reaches stdout)
+        if (r.size > copy_cap){
+            free(copy);
+            copy_cap = r.size;
+            if ((copy = malloc(copy_cap)) == NULL){
+                fprintf(stderr, "ERROR: memory allocation failure\r\n");
+                return 1;
+            }
+        }
+        size_t len = r.size;
+        memcpy(copy, rec, len);
+        if (!shm_reader_advance(&r)){
+            torn++;
+            fprintf(stderr, "WARNING: reply overwritten while it was read (reader too slow)\r\n");
+            continue;
+        }
+        struct dns_header_t dns;
+        struct dns_question_t qinfo;
+        unsigned char *qname;
+        uint32_t waiters;
+        if (!dnsshm_view(copy, len, &dns, &qinfo, &rep, res, &qname, &waiters)){
+            torn++;
+            fprintf(stderr, "WARNING: malformed reply record in ring, skipped\r\n");
+            continue;
+        }
+        for (uint32_t w = 0; w < waiters; w++){
+            project_print(&dns, &qinfo, &rep, qname);
+        }
+        replies++;
+    }
+    fflush(stdout);
+    fprintf(stderr, "Ring: %lu replies read, %lu lost to overruns (%lu of them torn while read, %lu times lapped)\r\n",
+            replies, r.lost, torn, r.overruns);
+    shm_close_reader(&r);
+    free(copy);
+    return 0;
+}
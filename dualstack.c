@@ -0,0 +1,229 @@
+/** @file:   dualstack.c
+ *  @brief:  Concurrent A and AAAA lookup of one address (both queries in one round trip)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "dualstack.h"
+#include "addronly.h"
+
+#include <time.h>
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//type of resource record starting at 'reader' (0 if the record runs past 'len')
+static uint16_t dual_record_type(unsigned char *buf, size_t len, unsigned char *reader){
+    unsigned char *end = buf + len;
+    while (reader < end && *reader != 0 && *reader < 192){
+        reader += *reader + 1;
+    }
+    if (reader >= end){
+        return 0;
+    }
+    reader += (*reader == 0) ? 1 : 2;
+    if (reader > end || (size_t)(end - reader) < sizeof(struct record_data)){
+        return 0;
+    }
+    return ntohs(((struct record_data *)reader)->type);
+}
+
+//shared CNAME chain counter
+int dual_shared_cnames(unsigned char *buf_a, size_t len_a, unsigned char *buf_aaaa, size_t len_aaaa,
+                       size_t offset, unsigned char **end){
+    unsigned char *ra = buf_a + offset;
+    unsigned char *rb = buf_aaaa + offset;
+    int an_a = ntohs(((struct dns_header_t *)buf_a)->ancount);
+    int an_b = ntohs(((struct dns_header_t *)buf_aaaa)->ancount);
+    int shared = 0;
+
+    while (shared < an_a && shared < an_b && ra < buf_a + len_a && rb < buf_aaaa + len_aaaa){
+        unsigned char *na = dns_record_skip(buf_a, len_a, ra);
+        unsigned char *nb = dns_record_skip(buf_aaaa, len_aaaa, rb);
+        if (na == NULL || nb == NULL || na - ra != nb - rb ||
+            dual_record_type(buf_a, len_a, ra) != DNS_QTYPE_CNAME || memcmp(ra, rb, na - ra) != 0){
+            break; //a malformed record is left to dns_reply_load() to reject
+        }
+        shared++;
+        ra = na;
+        rb = nb;
+    }
+    *end = rb;
+    return shared;
+}
+
+//decoded record comparison (for leaving out authority/additional records both replies carry)
+static bool dual_record_equal(struct dns_record_a_t *a, struct dns_record_a_t *b){
+    uint16_t type = ntohs(a->resource->type);
+    if (type != ntohs(b->resource->type) || a->resource->class != b->resource->class ||
+        strcmp((char *)a->name, (char *)b->name) != 0){
+        return false;
+    }
+    if (type == DNS_QTYPE_A || type == DNS_QTYPE_AAAA){
+        return a->resource->data_len == b->resource->data_len &&
+               memcmp(a->rdata, b->rdata, ntohs(a->resource->data_len)) == 0;
+    }
+    return strcmp((char *)a->rdata, (char *)b->rdata) == 0;
+}
+
+//append records of 'src' not yet present in 'dst'
+static int dual_section_merge(struct dns_record_a_t *dst, int ndst, struct dns_record_a_t *src, int nsrc){
+    for (int i = 0; i < nsrc; i++){
+        bool dup = false;
+        for (int j = 0; j < ndst && !dup; j++){
+            dup = dual_record_equal(&dst[j], &src[i]);
+        }
+        if (!dup && ndst < 50){
+            dst[ndst++] = src[i];
+        }
+    }
+    return ndst;
+}
+
+/*************************************************
+ *                 DUAL-STACK RUN
+*************************************************/
+int dual_run(){
+    static unsigned char bufs[3][65536]; //A reply, AAAA reply, receive buffer
+    unsigned char *reply_a = NULL, *reply_aaaa = NULL, *in = bufs[2];
+    ssize_t len_a = 0, len_aaaa = 0;
+
+  //prepare socket and its necessities
+    int sockfd;
+    struct sockaddr_in dest;
+    struct sockaddr_in6 dest6;
+    sock_prep(&sockfd, &dest, &dest6);
+    struct sockaddr *to = is_it_IPv6(par.server) ? (struct sockaddr *)&dest6 : (struct sockaddr *)&dest;
+    socklen_t tolen = is_it_IPv6(par.server) ? sizeof(dest6) : sizeof(dest);
+
+  //build A query, the AAAA one only differs in ID and qtype
+    struct dns_query_t query;
+    unsigned char qname[256];
+    dns_qname_insert(qname);
+    size_t qlen = strlen((const char *)qname) + 1;
+    dns_query_build(&query, qname, qlen, DNS_QTYPE_A, par.recursion);
+    struct dns_question_t *qinfo = (struct dns_question_t *)&query.pkt[sizeof(struct dns_header_t) + qlen];
+    size_t query_len = query.len;
+
+    srandom((unsigned int)(time(NULL) ^ getpid()));
+    uint16_t id_a = (uint16_t)random();
+    uint16_t id_aaaa = id_a ^ (uint16_t)(1 + random() % 0xfffe); //never the same as 'id_a'
+
+  //send both back-to-back
+    dns_query_patch(&query, id_a, par.recursion);
+    if (sendto(sockfd, query.pkt, query_len, 0, to, tolen) < 0){
+        perror("ERROR: sendto failure");
+        exit(1);
+    }
+    dns_query_patch(&query, id_aaaa, par.recursion);
+    dns_qinfo_prep(qinfo, DNS_QTYPE_AAAA, DNS_QCLASS_IN);
+    if (sendto(sockfd, query.pkt, query_len, 0, to, tolen) < 0){
+        perror("ERROR: sendto failure");
+        exit(1);
+    }
+
+  //collect both replies (in whichever order they come)
+    while (reply_a == NULL || reply_aaaa == NULL){
+        ssize_t len = recvfrom(sockfd, in, 65536, 0, NULL, NULL);
+        if (len < 0){
+            perror("ERROR: recvfrom failure");
+            exit(1);
+        }
+        struct dns_header_t *reply = (struct dns_header_t *)in;
+        if ((size_t)len < query_len || reply->qr != 1 ||
+            memcmp(&in[sizeof(struct dns_header_t)], qname, qlen) != 0){
+            continue;
+        }
+        if (ntohs(reply->id) == id_a && reply_a == NULL){
+            reply_a = in;
+            len_a = len;
+        } else if (ntohs(reply->id) == id_aaaa && reply_aaaa == NULL){
+            reply_aaaa = in;
+            len_aaaa = len;
+        } else {
+            continue;
+        }
+        for (int i = 0; i < 3; i++){ //receive next reply into the free buffer
+            if (bufs[i] != reply_a && bufs[i] != reply_aaaa){
+                in = bufs[i];
+                break;
+            }
+        }
+    }
+    close(sockfd);
+
+  //addresses only: A ones, then AAAA ones, straight out of both replies
+    if (par.addresses_only){
+        struct addr_only addrs;
+        char text[ADDR_ONLY_TEXT_MAX];
+        DNSname_to_hostname(qname);
+        if (addr_only_extract(reply_a, (size_t)len_a, &addrs) != 0){
+            fprintf(stderr, "ERROR: malformed reply\r\n");
+            return 1;
+        }
+        fwrite(text, 1, addr_only_format(&addrs, qname, text), stdout);
+        if (addr_only_extract(reply_aaaa, (size_t)len_aaaa, &addrs) != 0){
+            fprintf(stderr, "ERROR: malformed reply\r\n");
+            return 1;
+        }
+        fwrite(text, 1, addr_only_format(&addrs, qname, text), stdout);
+        return 0;
+    }
+
+    struct dns_header_t *ha = (struct dns_header_t *)reply_a;
+    struct dns_header_t *hb = (struct dns_header_t *)reply_aaaa;
+    if (ntohs(ha->ancount) > 50 || ntohs(ha->nscount) > 50 || ntohs(ha->arcount) > 50 ||
+        ntohs(hb->ancount) > 50 || ntohs(hb->nscount) > 50 || ntohs(hb->arcount) > 50){
+        fprintf(stderr, "ERROR: reply has too many records to decode\r\n");
+        return 1;
+    }
+
+  //decode A reply fully, AAAA reply without the CNAME chain both share
+    struct dns_replies rep_a, rep_aaaa;
+    if (dns_reply_load(reply_a, (size_t)len_a, &reply_a[query_len], ha, &rep_a) != 0){
+        fprintf(stderr, "ERROR: malformed reply\r\n");
+        return 1;
+    }
+    unsigned char *reader;
+    int shared = dual_shared_cnames(reply_a, len_a, reply_aaaa, len_aaaa, query_len, &reader);
+    struct dns_header_t hb_rest = *hb;
+    hb_rest.ancount = htons(ntohs(hb->ancount) - shared);
+    if (dns_reply_load(reply_aaaa, (size_t)len_aaaa, reader, &hb_rest, &rep_aaaa) != 0){
+        clean_exit(ha, &rep_a);
+        fprintf(stderr, "ERROR: malformed reply\r\n");
+        return 1;
+    }
+
+  //merge both into one set of sections
+    static struct dns_replies merged;
+    struct dns_header_t hm = *ha;
+    int an = ntohs(ha->ancount), ns = ntohs(ha->nscount), ar = ntohs(ha->arcount);
+    memcpy(merged.answers, rep_a.answers, an * sizeof(struct dns_record_a_t));
+    memcpy(merged.auth, rep_a.auth, ns * sizeof(struct dns_record_a_t));
+    memcpy(merged.addit, rep_a.addit, ar * sizeof(struct dns_record_a_t));
+    for (int i = 0; i < ntohs(hb_rest.ancount) && an < 50; i++){
+        merged.answers[an++] = rep_aaaa.answers[i];
+    }
+    ns = dual_section_merge(merged.auth, ns, rep_aaaa.auth, ntohs(hb->nscount));
+    ar = dual_section_merge(merged.addit, ar, rep_aaaa.addit, ntohs(hb->arcount));
+    hm.ancount = htons(an);
+    hm.nscount = htons(ns);
+    hm.arcount = htons(ar);
+
+  //print results
+    DNSname_to_hostname(qname);
+    fprintf(stdout, "Authoritative: ");
+    (ha->aa == 0 || hb->aa == 0) ? fprintf(stdout, "No, ") : fprintf(stdout, "Yes, ");
+    fprintf(stdout, "Recursive: ");
+    (ha->ra == 1 && hb->ra == 1 && par.recursion == 1) ? fprintf(stdout, "Yes, ") : fprintf(stdout, "No, ");
+    fprintf(stdout, "Truncated: ");
+    (ha->tc == 0 && hb->tc == 0) ? fprintf(stdout, "No\n\r") : fprintf(stdout, "Yes\n\r");
+    fprintf(stdout, "Question Section(2)\n\r");
+    fprintf(stdout, " %s., %s, %s\n\r", qname, DNS_Qtype_tostr(DNS_QTYPE_A), DNS_Qclass_tostr(DNS_QCLASS_IN));
+    fprintf(stdout, " %s., %s, %s\n\r", qname, DNS_Qtype_tostr(DNS_QTYPE_AAAA), DNS_Qclass_tostr(DNS_QCLASS_IN));
+    project_print_records(&hm, &merged);
+
+    clean_exit(ha, &rep_a);
+    clean_exit(&hb_rest, &rep_aaaa);
+    return 0;
+}
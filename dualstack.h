@@ -0,0 +1,37 @@
+/** @file:   dualstack.h
+ *  @brief:  Concurrent A and AAAA lookup of one address (both queries in one round trip)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef DUALSTACK_H
+#define DUALSTACK_H
+
+#include "dns.h"
+
+/**
+ * @function: dual_shared_cnames
+ * @brief counts CNAME records at the start of both answer sections which are byte-for-byte identical
+ *        (the chain both replies share, so it only has to be decoded once)
+ *
+ * @param[in] buf_a:    A reply packet
+ * @param[in] len_a:    length of @param buf_a
+ * @param[in] buf_aaaa: AAAA reply packet
+ * @param[in] len_aaaa: length of @param buf_aaaa
+ * @param[in] offset:   where answer section starts (same in both, questions only differ in qtype)
+ * @param[in] end:      set to where the shared chain ends in @param buf_aaaa
+ * @return amount of shared CNAME records
+*/
+int dual_shared_cnames(unsigned char *buf_a, size_t len_a, unsigned char *buf_aaaa, size_t len_aaaa,
+                       size_t offset, unsigned char **end);
+
+/**
+ * @function: dual_run
+ * @brief sends A and AAAA queries for 'par.address' back-to-back on one socket, collects both
+ *        replies and prints them together
+ *
+ * @return exit code of the program (0 if successful, 1 otherwise)
+*/
+int dual_run();
+
+#endif
@@ -0,0 +1,146 @@
+/** @file:   input.c
+ *  @brief:  Zero-copy name list reader (memory-mapped file or chunked stdin) for batch mode
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "input.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//streamed input: keep unconsumed bytes, read more after them
+static void input_fill(struct input_reader *r){
+    memmove(r->buf, &r->buf[r->pos], r->len - r->pos);
+    r->base += r->pos;
+    r->len -= r->pos;
+    r->pos = 0;
+
+    ssize_t got;
+    do {
+        got = read(r->fd, &r->buf[r->len], INPUT_CHUNK - r->len);
+    } while (got < 0 && errno == EINTR);
+    if (got < 0){
+        perror("ERROR: input read failure");
+        exit(1);
+    }
+    if (got == 0){
+        r->eof = true;
+    }
+    r->len += (size_t)got;
+}
+
+//mapped input: drop pages already consumed, so resident memory stays flat
+static void input_release(struct input_reader *r){
+    static size_t page = 0;
+    if (page == 0){
+        page = (size_t)sysconf(_SC_PAGESIZE);
+    }
+    if (r->pos - r->released < INPUT_RELEASE){
+        return;
+    }
+    size_t upto = r->pos & ~(page - 1);
+    madvise(&r->buf[r->released], upto - r->released, MADV_DONTNEED);
+    r->released = upto;
+}
+
+/*************************************************
+ *                    READER                     *
+*************************************************/
+int input_open(struct input_reader *r, const char *path){
+    memset(r, 0, sizeof(*r));
+    if (strcmp(path, "-") == 0){
+        r->fd = STDIN_FILENO;
+    } else if ((r->fd = open(path, O_RDONLY)) < 0){
+        fprintf(stderr, "ERROR: couldn't open input file: %s\r\n", path);
+        return 1;
+    }
+
+  //regular files get mapped whole (the kernel reads ahead, we never copy)
+    struct stat st;
+    if (fstat(r->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+        if (map != MAP_FAILED){
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+            r->buf = map;
+            r->len = (size_t)st.st_size;
+            r->mapped = true;
+            r->eof = true;
+            return 0;
+        }
+    }
+
+  //anything else (or mmap failure) is streamed
+    if ((r->buf = malloc(INPUT_CHUNK)) == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+bool input_next(struct input_reader *r, const char **name, size_t *len, uint64_t *offset){
+    while (true){
+        size_t start = r->pos;
+        char *nl = memchr(&r->buf[start], '\n', r->len - start);
+        size_t end;
+        if (nl != NULL){
+            end = (size_t)(nl - r->buf);
+            r->pos = end + 1;
+        } else if (r->eof){ //last line without newline
+            if (start == r->len){
+                return false;
+            }
+            end = r->len;
+            r->pos = end;
+            if (r->skipping){ //tail of overlong line
+                r->skipping = false;
+                continue;
+            }
+        } else if (start == 0 && r->len == INPUT_CHUNK){ //line doesn't fit the buffer
+            end = r->len;
+            r->pos = end;
+            if (r->skipping){
+                input_fill(r);
+                continue;
+            }
+            r->skipping = true; //hand out its start (it'll be rejected as invalid), drop the rest
+        } else {
+            input_fill(r);
+            continue;
+        }
+
+        if (r->skipping && nl != NULL){ //tail of overlong line
+            r->skipping = false;
+            continue;
+        }
+        if (r->mapped){
+            input_release(r);
+        }
+
+        while (end > start && isspace((unsigned char)r->buf[end - 1])){
+            end--;
+        }
+        if (end == start || r->buf[start] == '#'){
+            continue;
+        }
+        *name = &r->buf[start];
+        *len = end - start;
+        *offset = r->base + start;
+        return true;
+    }
+}
+
+void input_close(struct input_reader *r){
+    if (r->mapped){
+        munmap(r->buf, r->len);
+    } else {
+        free(r->buf);
+    }
+    if (r->fd != STDIN_FILENO){
+        close(r->fd);
+    }
+}
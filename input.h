@@ -0,0 +1,64 @@
+/** @file:   input.h
+ *  @brief:  Zero-copy name list reader (memory-mapped file or chunked stdin) for batch mode
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "dns.h"
+
+#define INPUT_CHUNK   (1 << 20)  //read buffer size for streamed (non-mappable) input
+#define INPUT_RELEASE (8 << 20)  //mapped bytes consumed before they're dropped from memory
+
+/**
+ * @struct: name list reader
+ *
+ * Regular files are memory-mapped and split in place, everything else (pipes, stdin)
+ * is read in INPUT_CHUNK sized pieces. Either way memory use doesn't depend on input size.
+*/
+struct input_reader{
+    int fd;
+    bool mapped;         /* input is memory-mapped (otherwise streamed through @param buf) */
+    char *buf;           /* mapped file or read buffer */
+    size_t len;          /* bytes valid in @param buf */
+    size_t pos;          /* first unconsumed byte in @param buf */
+    size_t released;     /* mapped bytes already dropped from memory */
+    uint64_t base;       /* input offset of @param buf[0] */
+    bool eof;            /* nothing more to read from @param fd */
+    bool skipping;       /* discarding rest of overlong line */
+};
+
+/**
+ * @function: input_open
+ * @brief opens name list for reading
+ *
+ * @param[in] r:    reader to initialize
+ * @param[in] path: file path, "-" for stdin
+ * @return 0 if successful, 1 if not
+*/
+int input_open(struct input_reader *r, const char *path);
+
+/**
+ * @function: input_next
+ * @brief returns next name from list (trailing whitespace stripped, empty and '#' lines skipped)
+ *        name isn't copied nor NUL terminated, it stays valid until the next call
+ *
+ * @param[in] r:      reader
+ * @param[in] name:   pointer to set to the start of name
+ * @param[in] len:    length of name
+ * @param[in] offset: input offset of line the name is on
+ * @return 'true' if name was returned, 'false' at end of input
+*/
+bool input_next(struct input_reader *r, const char **name, size_t *len, uint64_t *offset);
+
+/**
+ * @function: input_close
+ * @brief unmaps/frees everything reader holds and closes input
+ *
+ * @param[in] r: reader
+*/
+void input_close(struct input_reader *r);
+
+#endif
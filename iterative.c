@@ -0,0 +1,581 @@
+/** @file:   iterative.c
+ *  @brief:  Iterative resolution (following referrals from root hints) with a delegation cache
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "iterative.h"
+#include "batch.h"
+#include "input.h"
+
+#include <poll.h>
+#include <strings.h>
+
+struct iter_stats istats;
+
+static struct iter_zone *cache[ITER_CACHE_BUCKETS]; //delegation cache
+static struct iter_zone *root;                      //root hints (never expire)
+static int sock4 = -1;
+static int sock6 = -1;
+
+//IANA root servers (used when no root hints file is given)
+static const char *root_hints[][2] = {
+    {"a.root-servers.net", "198.41.0.4"},     {"b.root-servers.net", "170.247.170.2"},
+    {"c.root-servers.net", "192.33.4.12"},    {"d.root-servers.net", "199.7.91.13"},
+    {"e.root-servers.net", "192.203.230.10"}, {"f.root-servers.net", "192.5.5.241"},
+    {"g.root-servers.net", "192.112.36.4"},   {"h.root-servers.net", "198.97.190.53"},
+    {"i.root-servers.net", "192.36.148.17"},  {"j.root-servers.net", "192.58.128.30"},
+    {"k.root-servers.net", "193.0.14.129"},   {"l.root-servers.net", "199.7.83.42"},
+    {"m.root-servers.net", "202.12.27.33"},
+};
+
+//reply classification
+#define ITER_ANSWER   0
+#define ITER_REFERRAL 1
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//hostname in zone checker
+bool iter_in_zone(const char *name, const char *zone){
+    size_t nlen = strlen(name);
+    size_t zlen = strlen(zone);
+    if (zlen == 0){
+        return true;
+    }
+    if (nlen < zlen || strcasecmp(name + nlen - zlen, zone) != 0){
+        return false;
+    }
+    return nlen == zlen || name[nlen - zlen - 1] == '.';
+}
+
+//lowercase hostname copy without trailing dot
+static void iter_name_copy(char *dst, const char *src){
+    size_t i;
+    for (i = 0; src[i] && i < 255; i++){
+        dst[i] = tolower((unsigned char)src[i]);
+    }
+    dst[i] = '\0';
+    if (i > 0 && dst[i - 1] == '.'){
+        dst[i - 1] = '\0';
+    }
+}
+
+//fill server address (port is 'par.port')
+static bool iter_server_addr(struct iter_server *srv, const char *address){
+    memset(&srv->addr, 0, sizeof(srv->addr));
+    if (is_it_IPv4((char *)address)){
+        struct sockaddr_in *a = (struct sockaddr_in *)&srv->addr;
+        a->sin_family = AF_INET;
+        a->sin_port = htons(par.port);
+        inet_pton(AF_INET, address, &a->sin_addr);
+        srv->addrlen = sizeof(struct sockaddr_in);
+    } else if (is_it_IPv6((char *)address)){
+        struct sockaddr_in6 *a = (struct sockaddr_in6 *)&srv->addr;
+        a->sin6_family = AF_INET6;
+        a->sin6_port = htons(par.port);
+        inet_pton(AF_INET6, address, &a->sin6_addr);
+        srv->addrlen = sizeof(struct sockaddr_in6);
+    } else {
+        return false;
+    }
+    srv->has_addr = true;
+    return true;
+}
+
+//fill server address out of A/AAAA record data, 'false' if rdata isn't an address of that type
+static bool iter_server_rdata(struct iter_server *srv, uint16_t type, const unsigned char *rdata, uint16_t rdlen){
+    memset(&srv->addr, 0, sizeof(srv->addr));
+    if (type == DNS_QTYPE_AAAA && rdlen == 16){
+        struct sockaddr_in6 *a = (struct sockaddr_in6 *)&srv->addr;
+        a->sin6_family = AF_INET6;
+        a->sin6_port = htons(par.port);
+        memcpy(&a->sin6_addr, rdata, 16);
+        srv->addrlen = sizeof(struct sockaddr_in6);
+    } else if (type == DNS_QTYPE_A && rdlen == 4){
+        struct sockaddr_in *a = (struct sockaddr_in *)&srv->addr;
+        a->sin_family = AF_INET;
+        a->sin_port = htons(par.port);
+        memcpy(&a->sin_addr, rdata, 4);
+        srv->addrlen = sizeof(struct sockaddr_in);
+    } else {
+        return false;
+    }
+    srv->has_addr = true;
+    return true;
+}
+
+/*************************************************
+ *               DELEGATION CACHE                *
+*************************************************/
+static uint32_t iter_zone_hash(const char *zone){
+    uint32_t h = 2166136261u;
+    for (; *zone; zone++){
+        h = (h ^ (uint32_t)tolower((unsigned char)*zone)) * 16777619u;
+    }
+    return h % ITER_CACHE_BUCKETS;
+}
+
+//find cached zone (expired ones included)
+static struct iter_zone *iter_cache_find(const char *zone){
+    for (struct iter_zone *z = cache[iter_zone_hash(zone)]; z != NULL; z = z->next){
+        if (strcasecmp(z->zone, zone) == 0){
+            return z;
+        }
+    }
+    return NULL;
+}
+
+//find or create cache entry for zone (entries are reused in place, never freed while running)
+static struct iter_zone *iter_cache_entry(const char *zone){
+    struct iter_zone *z = iter_cache_find(zone);
+    if (z == NULL){
+        if ((z = calloc(1, sizeof(struct iter_zone))) == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+        iter_name_copy(z->zone, zone);
+        uint32_t h = iter_zone_hash(zone);
+        z->next = cache[h];
+        cache[h] = z;
+        istats.zones++;
+    }
+    return z;
+}
+
+//closest known zone cut
+struct iter_zone *iter_cache_closest(const char *name){
+    uint64_t now = batch_now_ns();
+    const char *p = name;
+    while (*p){
+        struct iter_zone *z = iter_cache_find(p);
+        if (z != NULL && z->nservers > 0 && (z->expires == 0 || z->expires > now)){
+            return z;
+        }
+        //strip leftmost label
+        const char *dot = strchr(p, '.');
+        p = (dot == NULL) ? "" : dot + 1;
+    }
+    return root;
+}
+
+//store delegation (NS records of 'cut' in authority section, glue in additional section)
+static struct iter_zone *iter_cache_insert(const char *cut, struct dns_header_t *dns, struct dns_replies *rep){
+    struct iter_zone *z = iter_cache_entry(cut);
+    uint64_t now = batch_now_ns();
+    if (z->nservers > 0 && z->expires > now){ //still valid, keep measured round trip times
+        return z;
+    }
+
+    uint32_t ttl = UINT32_MAX;
+    z->nservers = 0;
+    for (int i = 0; i < ntohs(dns->nscount); i++){
+        if (ntohs(rep->auth[i].resource->type) != DNS_QTYPE_NS || strcasecmp((char *)rep->auth[i].name, cut) != 0){
+            continue;
+        }
+        if (ntohl(rep->auth[i].resource->ttl) < ttl){
+            ttl = ntohl(rep->auth[i].resource->ttl);
+        }
+        char nsname[256];
+        iter_name_copy(nsname, (const char *)rep->auth[i].rdata);
+
+        //one server entry per glue address
+        bool glued = false;
+        for (int j = 0; j < ntohs(dns->arcount) && z->nservers < ITER_ZONE_SERVERS; j++){
+            uint16_t type = ntohs(rep->addit[j].resource->type);
+            if ((type == DNS_QTYPE_A || type == DNS_QTYPE_AAAA) && strcasecmp((char *)rep->addit[j].name, nsname) == 0){
+                struct iter_server *srv = &z->servers[z->nservers];
+                if (!iter_server_rdata(srv, type, rep->addit[j].rdata, ntohs(rep->addit[j].resource->data_len))){
+                    continue; //glue of wrong length is ignored
+                }
+                z->nservers++;
+                strcpy(srv->name, nsname);
+                srv->srtt_ms = 0;
+                glued = true;
+            }
+        }
+        if (!glued && z->nservers < ITER_ZONE_SERVERS){
+            struct iter_server *srv = &z->servers[z->nservers++];
+            strcpy(srv->name, nsname);
+            srv->has_addr = false;
+            srv->srtt_ms = 0;
+        }
+    }
+    z->expires = now + (uint64_t)ttl * 1000000000ULL;
+    return z;
+}
+
+//root hints loader
+int iter_hints_load(const char *path){
+    root = iter_cache_entry("");
+    root->expires = 0;
+    root->nservers = 0;
+
+    if (path == NULL){
+        for (size_t i = 0; i < sizeof(root_hints) / sizeof(root_hints[0]); i++){
+            struct iter_server *srv = &root->servers[root->nservers++];
+            strcpy(srv->name, root_hints[i][0]);
+            iter_server_addr(srv, root_hints[i][1]);
+        }
+        return 0;
+    }
+
+    FILE *fp;
+    char line[512];
+    if ((fp = fopen(path, "r")) == NULL){
+        fprintf(stderr, "ERROR: couldn't open root hints file: %s\r\n", path);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), fp) && root->nservers < ITER_ZONE_SERVERS){
+        char *tokens[8];
+        int ntokens = 0;
+        for (char *t = strtok(line, " \t\r\n"); t != NULL && ntokens < 8; t = strtok(NULL, " \t\r\n")){
+            tokens[ntokens++] = t;
+        }
+        if (ntokens == 0 || tokens[0][0] == '#' || tokens[0][0] == ';'){
+            continue;
+        }
+        struct iter_server *srv = &root->servers[root->nservers];
+        if (iter_server_addr(srv, tokens[ntokens - 1])){ //last token is the address
+            iter_name_copy(srv->name, tokens[0]);
+            root->nservers++;
+        }
+    }
+    fclose(fp);
+
+    if (root->nservers == 0){
+        fprintf(stderr, "ERROR: root hints file contains no usable server address: %s\r\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+/*************************************************
+ *          INTERNAL ITERATIVE FUNCTIONS         *
+*************************************************/
+//send one non-recursive query to server, wait for its reply in 'buf'
+static ssize_t iter_query(struct iter_server *srv, struct dns_query_t *query, unsigned char *buf){
+
+  //get socket of the right family
+    int *fd = (srv->addr.ss_family == AF_INET6) ? &sock6 : &sock4;
+    if (*fd == -1 && (*fd = socket(srv->addr.ss_family, SOCK_DGRAM, 0)) < 0){
+        return -1; //no support for this address family
+    }
+
+  //fresh ID for every server asked, rest of the query is prebuilt
+    uint16_t id = (uint16_t)random();
+    dns_query_patch(query, id, false); //we do the recursion ourselves
+    size_t pkt_len = query->len;
+
+    uint64_t sent = batch_now_ns();
+    if (sendto(*fd, query->pkt, pkt_len, 0, (struct sockaddr *)&srv->addr, srv->addrlen) < 0){
+        return -1;
+    }
+    istats.queries++;
+
+  //wait for matching reply (stray datagrams are dropped)
+    uint64_t deadline = sent + (uint64_t)ITER_TIMEOUT_MS * 1000000ULL;
+    struct pollfd pfd = {.fd = *fd, .events = POLLIN};
+    while (true){
+        uint64_t now = batch_now_ns();
+        if (now >= deadline || poll(&pfd, 1, (int)((deadline - now) / 1000000ULL) + 1) <= 0){
+            istats.timeouts++;
+            srv->srtt_ms += ITER_TIMEOUT_MS; //penalize, other servers of the zone will be preferred
+            return -1;
+        }
+        struct sockaddr_storage from;
+        socklen_t fromlen = sizeof(from);
+        ssize_t len = recvfrom(*fd, buf, 65536, 0, (struct sockaddr *)&from, &fromlen);
+        if (len < (ssize_t)pkt_len || fromlen != srv->addrlen || memcmp(&from, &srv->addr, fromlen) != 0){
+            continue;
+        }
+        struct dns_header_t *reply = (struct dns_header_t *)buf;
+        if (reply->qr != 1 || ntohs(reply->id) != id || ntohs(reply->qdcount) != 1 ||
+            memcmp(&buf[sizeof(struct dns_header_t)], &query->pkt[sizeof(struct dns_header_t)], pkt_len - sizeof(struct dns_header_t)) != 0){
+            continue;
+        }
+
+        //measure round trip time
+        unsigned int rtt = (unsigned int)((batch_now_ns() - sent) / 1000000ULL) + 1;
+        srv->srtt_ms = (srv->srtt_ms == 0) ? rtt : (srv->srtt_ms * 7 + rtt) / 8;
+        return len;
+    }
+}
+
+//decode reply (question is known to be ours, it was checked in 'iter_query'), 1 if malformed or too big
+static int iter_reply_parse(unsigned char *buf, ssize_t len, struct dns_replies *rep){
+    struct dns_header_t *dns = (struct dns_header_t *)buf;
+    size_t qlen = strlen((const char *)&buf[sizeof(struct dns_header_t)]) + 1;
+    return dns_reply_load(buf, (size_t)len, &buf[sizeof(struct dns_header_t) + qlen + sizeof(struct dns_question_t)], dns, rep);
+}
+
+static ssize_t iter_resolve(const char *name, uint16_t qtype, int depth, unsigned char *buf);
+
+//find address of name server without glue
+static bool iter_ns_address(struct iter_server *srv, int depth){
+    if (depth >= ITER_MAX_DEPTH){
+        return false;
+    }
+    unsigned char *buf = malloc(65536);
+    if (buf == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        exit(1);
+    }
+    bool found = false;
+    ssize_t len = iter_resolve(srv->name, DNS_QTYPE_A, depth + 1, buf);
+    if (len > 0){
+        struct dns_header_t *dns = (struct dns_header_t *)buf;
+        struct dns_replies rep;
+        if (iter_reply_parse(buf, len, &rep) == 0){
+            for (int i = 0; i < ntohs(dns->ancount) && !found; i++){
+                if (ntohs(rep.answers[i].resource->type) == DNS_QTYPE_A){
+                    found = iter_server_rdata(srv, DNS_QTYPE_A, rep.answers[i].rdata, ntohs(rep.answers[i].resource->data_len));
+                }
+            }
+            clean_exit(dns, &rep);
+        }
+    }
+    free(buf);
+    return found;
+}
+
+//ask servers of zone (fastest first) until one gives an answer or a downward referral
+static int iter_ask_zone(struct iter_zone *zone, const char *name, struct dns_query_t *query, int depth,
+                         unsigned char *buf, ssize_t *len, char *cut){
+    bool tried[ITER_ZONE_SERVERS] = {false};
+
+    while (true){
+        //pick server with lowest round trip time (unmeasured ones get tried first)
+        int best = -1;
+        for (int i = 0; i < zone->nservers; i++){
+            if (!tried[i] && zone->servers[i].has_addr &&
+                (best == -1 || zone->servers[i].srtt_ms < zone->servers[best].srtt_ms)){
+                best = i;
+            }
+        }
+        if (best == -1){ //no server with known address left, look one up
+            for (int i = 0; i < zone->nservers && best == -1; i++){
+                if (!tried[i] && !zone->servers[i].has_addr){
+                    if (iter_ns_address(&zone->servers[i], depth)){
+                        best = i;
+                    } else {
+                        tried[i] = true;
+                    }
+                }
+            }
+            if (best == -1){
+                return -1;
+            }
+        }
+        tried[best] = true;
+
+        if ((*len = iter_query(&zone->servers[best], query, buf)) < 0){
+            continue;
+        }
+
+      //classify reply
+        struct dns_header_t *dns = (struct dns_header_t *)buf;
+        if (dns->rcode == 2 || dns->rcode == 4 || dns->rcode == 5){ //SERVFAIL, NOTIMP, REFUSED --> lame server
+            continue;
+        }
+        if (dns->rcode != 0 || dns->aa || dns->ancount != 0 || dns->nscount == 0){
+            return ITER_ANSWER;
+        }
+        struct dns_replies rep;
+        if (iter_reply_parse(buf, *len, &rep) != 0){
+            continue;
+        }
+        int kind = ITER_ANSWER;
+        for (int i = 0; i < ntohs(dns->nscount); i++){
+            if (ntohs(rep.auth[i].resource->type) == DNS_QTYPE_NS){
+                iter_name_copy(cut, (const char *)rep.auth[i].name);
+                kind = ITER_REFERRAL;
+                break;
+            }
+        }
+        clean_exit(dns, &rep);
+        if (kind == ITER_ANSWER){ //NODATA (SOA in authority section)
+            return ITER_ANSWER;
+        }
+        //referral has to lead downwards, towards the name
+        if (iter_in_zone(name, cut) && strcasecmp(cut, zone->zone) != 0 && iter_in_zone(cut, zone->zone)){
+            return ITER_REFERRAL;
+        }
+        //lame referral, try other server
+    }
+}
+
+//resolve name iteratively from closest known zone cut, final reply is left in 'buf'
+static ssize_t iter_resolve(const char *name, uint16_t qtype, int depth, unsigned char *buf){
+    struct iter_zone *zone = iter_cache_closest(name);
+    if (zone != root && depth == 0){
+        istats.cache_hits++;
+    }
+
+  //serialize query once, every server on the way down only gets a new ID patched in
+    struct dns_query_t query;
+    unsigned char qname[256];
+    char host[256];
+    strcpy(host, name);
+    hostname_to_DNSname((unsigned char *)host, qname);
+    dns_query_build(&query, qname, strlen((const char *)qname) + 1, qtype, false);
+
+    for (int i = 0; i < ITER_MAX_REFERRALS; i++){
+        ssize_t len;
+        char cut[256];
+        int kind = iter_ask_zone(zone, name, &query, depth, buf, &len, cut);
+        if (kind < 0){
+            return -1;
+        }
+        if (kind == ITER_ANSWER){
+            return len;
+        }
+
+      //follow referral (and remember it)
+        istats.referrals++;
+        struct dns_header_t *dns = (struct dns_header_t *)buf;
+        struct dns_replies rep;
+        if (iter_reply_parse(buf, len, &rep) != 0){
+            return -1;
+        }
+        zone = iter_cache_insert(cut, dns, &rep);
+        clean_exit(dns, &rep);
+        if (zone->nservers == 0){
+            return -1;
+        }
+    }
+    return -1;
+}
+
+//look hostname up and print every reply of the CNAME chain
+static int iter_lookup_name(const char *host, uint16_t qtype, unsigned char *buf){
+    char name[256];
+    iter_name_copy(name, host);
+    istats.lookups++;
+
+    for (int chain = 0; chain < ITER_MAX_CNAMES; chain++){
+        ssize_t len = iter_resolve(name, qtype, 0, buf);
+        if (len < 0){
+            fprintf(stderr, "ERROR: couldn't resolve %s, no name server replied usefully\r\n", name);
+            return 1;
+        }
+
+      //print reply
+        struct dns_header_t *dns = (struct dns_header_t *)buf;
+        unsigned char *qname = &buf[sizeof(struct dns_header_t)];
+        size_t qlen = strlen((const char *)qname) + 1;
+        struct dns_question_t *qinfo = (struct dns_question_t *)&buf[sizeof(struct dns_header_t) + qlen];
+        struct dns_replies rep;
+        if (iter_reply_parse(buf, len, &rep) != 0){
+            fprintf(stderr, "ERROR: reply for %s is malformed or has too many records to decode\r\n", name);
+            return 1;
+        }
+        unsigned char host[256];
+        memcpy(host, qname, qlen);
+        DNSname_to_hostname(host);
+        project_print(dns, qinfo, &rep, host);
+
+      //follow CNAME if the answer doesn't contain the wanted type
+        bool done = true;
+        char target[256] = "";
+        for (int i = 0; i < ntohs(dns->ancount); i++){
+            uint16_t type = ntohs(rep.answers[i].resource->type);
+            if (type == qtype){
+                done = true;
+                break;
+            }
+            if (type == DNS_QTYPE_CNAME){
+                iter_name_copy(target, (const char *)rep.answers[i].rdata);
+                done = false;
+            }
+        }
+        clean_exit(dns, &rep);
+        if (done || qtype == DNS_QTYPE_CNAME){
+            return 0;
+        }
+        strcpy(name, target);
+    }
+    fprintf(stderr, "ERROR: CNAME chain of %s too long\r\n", host);
+    return 1;
+}
+
+//look up 'address' given on command line (reverse name of it for '-x')
+static int iter_lookup(const char *address, unsigned char *buf){
+    if (par.reverse){
+        char reversed[128];
+        if (dns_reverse_name(address, reversed) != 0){
+            fprintf(stderr, "ERROR: reverse request requires an IP address: %s\r\n", address);
+            return 1;
+        }
+        return iter_lookup_name(reversed, DNS_QTYPE_PTR, buf);
+    }
+    return iter_lookup_name(address, par.Qtype, buf);
+}
+
+/*************************************************
+ *                ITERATIVE RUN
+*************************************************/
+int iter_run(){
+  //root hints ('-H' file, '-s' server, or built-in root servers)
+    if (strcmp(par.hints, "") != 0){
+        if (iter_hints_load(par.hints)){
+            return 1;
+        }
+    } else if (strcmp(par.server, "") != 0){
+        iter_hints_load(NULL);
+        root->nservers = 0;
+        if (!iter_server_addr(&root->servers[0], par.server)){
+            fprintf(stderr, "ERROR: iterative mode requires 'server' to be an IP address\r\n");
+            return 1;
+        }
+        strcpy(root->servers[0].name, par.server);
+        root->nservers = 1;
+    } else {
+        iter_hints_load(NULL);
+    }
+    srandom((unsigned int)(batch_now_ns() ^ (uint64_t)getpid()));
+
+    unsigned char *buf = malloc(65536);
+    if (buf == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    int ret = 0;
+
+    if (strcmp(par.infile, "") == 0){
+        ret = iter_lookup(par.address, buf);
+    } else { //names one after another, sharing the delegation cache
+        struct input_reader in;
+        if (input_open(&in, par.infile) != 0){
+            free(buf);
+            return 1;
+        }
+        const char *name;
+        size_t name_len;
+        uint64_t offset;
+        unsigned char host[256];
+        uint16_t qtype = par.reverse ? DNS_QTYPE_PTR : par.Qtype;
+        while (input_next(&in, &name, &name_len, &offset)){
+          //same validation (and reverse names for '-x') as batch mode
+            if (batch_qname_build(name, name_len, host) == 0){
+                fprintf(stderr, "WARNING: skipping invalid name: %.*s\r\n", (int)(name_len > 255 ? 255 : name_len), name);
+                istats.invalid++;
+                ret = 1;
+                continue;
+            }
+            DNSname_to_hostname(host);
+            if (iter_lookup_name((const char *)host, qtype, buf) != 0){
+                ret = 1;
+            }
+        }
+        input_close(&in);
+    }
+
+    fprintf(stderr, "Iterative: %lu lookups, %lu queries sent, %lu timeouts, %lu referrals followed, "
+                    "%lu delegation cache hits (%lu zones cached), %lu invalid names\r\n",
+            istats.lookups, istats.queries, istats.timeouts, istats.referrals, istats.cache_hits, istats.zones,
+            istats.invalid);
+
+    free(buf);
+    return ret;
+}
@@ -0,0 +1,93 @@
+/** @file:   iterative.h
+ *  @brief:  Iterative resolution (following referrals from root hints) with a delegation cache
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef ITERATIVE_H
+#define ITERATIVE_H
+
+#include "dns.h"
+
+#define ITER_MAX_REFERRALS  32   //referrals followed before a lookup is given up on
+#define ITER_MAX_CNAMES     8    //CNAME chain length limit
+#define ITER_MAX_DEPTH      4    //nesting limit of name server address lookups (NS without glue)
+#define ITER_TIMEOUT_MS     2000 //how long to wait for a name server to reply
+#define ITER_ZONE_SERVERS   32   //name server addresses kept per zone
+#define ITER_CACHE_BUCKETS  1024 //delegation cache hash table size
+
+/**
+ * @struct: one name server of a zone
+*/
+struct iter_server{
+    char name[256];                /* name server hostname (lowercase, no trailing dot) */
+    struct sockaddr_storage addr;  /* name server address (port is 'par.port') */
+    socklen_t addrlen;
+    bool has_addr;                 /* 'false' until address is known (NS without glue) */
+    unsigned int srtt_ms;          /* smoothed round trip time (0 = not measured yet) */
+};
+
+/**
+ * @struct: delegation cache entry (zone cut --> name servers)
+*/
+struct iter_zone{
+    char zone[256];                /* zone name (lowercase, no trailing dot, "" = root) */
+    struct iter_server servers[ITER_ZONE_SERVERS];
+    int nservers;
+    uint64_t expires;              /* monotonic ns timestamp, 0 = never (root hints) */
+    struct iter_zone *next;        /* next entry in the same hash bucket */
+};
+
+/**
+ * @struct: iterative run counters
+*/
+struct iter_stats{
+    unsigned long lookups;     /* names looked up (not counting name server address lookups) */
+    unsigned long queries;     /* queries sent to name servers */
+    unsigned long timeouts;
+    unsigned long referrals;   /* referrals followed */
+    unsigned long cache_hits;  /* lookups started below root thanks to the delegation cache */
+    unsigned long zones;       /* zones in delegation cache */
+    unsigned long invalid;     /* '-f' lines skipped as invalid names */
+};
+
+extern struct iter_stats istats;
+
+/**
+ * @function: iter_in_zone
+ * @brief checks whether hostname lies in zone (is equal to or below the zone cut)
+ *
+ * @param[in] name: hostname (no trailing dot)
+ * @param[in] zone: zone name (no trailing dot, "" = root)
+ * @return 'true' if @param name is in @param zone, 'false' if not
+*/
+bool iter_in_zone(const char *name, const char *zone);
+
+/**
+ * @function: iter_hints_load
+ * @brief loads root hints into delegation cache; lines are either "address", "name address"
+ *        or named.root style "name ttl A address" (built-in root servers if @param path is NULL)
+ *
+ * @param[in] path: path to root hints file (or NULL)
+ * @return 0 if successful, 1 if no usable hint was found
+*/
+int iter_hints_load(const char *path);
+
+/**
+ * @function: iter_cache_closest
+ * @brief finds closest known (cached, unexpired) zone cut enclosing hostname
+ *
+ * @param[in] name: hostname (lowercase, no trailing dot)
+ * @return delegation cache entry (root hints at the very least)
+*/
+struct iter_zone *iter_cache_closest(const char *name);
+
+/**
+ * @function: iter_run
+ * @brief resolves 'par.address' (or every name in 'par.infile') iteratively, starting from root hints
+ *
+ * @return exit code of the program (0 if successful, 1 otherwise)
+*/
+int iter_run();
+
+#endif
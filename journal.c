@@ -0,0 +1,319 @@
+/** @file:   journal.c
+ *  @brief:  Checkpoint journal of batch runs ('--journal'): completed input lines, so a restarted run skips them
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "journal.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define JOURNAL_WINDOW_INIT  65536 //sequence numbers tracked past the lowest one not done (grows when needed)
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static uint32_t journal_fnv(uint32_t h, const void *data, size_t len){
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++){
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t journal_check(struct journal_block *b, const unsigned char *payload){
+    struct journal_block hdr = *b;
+    hdr.check = 0;
+    return journal_fnv(journal_fnv(2166136261u, &hdr, sizeof(hdr)), payload, b->len);
+}
+
+static int journal_cmp(const void *a, const void *b){
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+//grows array of keys to hold at least one more
+static void journal_reserve(uint64_t **keys, size_t n, size_t *cap){
+    if (n == *cap){
+        *cap = (*cap == 0) ? 4096 : *cap * 2;
+        if ((*keys = realloc(*keys, *cap * sizeof(uint64_t))) == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+    }
+}
+
+//header the journal of this run has to have: query types asked and identity of input
+static int journal_ident(struct journal_hdr *hdr, const char *input){
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    hdr->version = JOURNAL_VERSION;
+    hdr->qtype = par.Qtype;
+    hdr->flags = (par.dual ? JOURNAL_F_DUAL : 0) | (par.reverse ? JOURNAL_F_REVERSE : 0);
+
+    struct stat st;
+    int fd = open(input, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        fprintf(stderr, "ERROR: '--journal' requires a regular input file (stdin can't be read again on resume): %s\r\n", input);
+        if (fd >= 0){
+            close(fd);
+        }
+        return 1;
+    }
+    hdr->input_size = (uint64_t)st.st_size;
+    unsigned char *head = malloc(JOURNAL_IDENT_BYTES);
+    ssize_t n = (head != NULL) ? read(fd, head, JOURNAL_IDENT_BYTES) : -1;
+    close(fd);
+    if (n < 0){
+        fprintf(stderr, "ERROR: couldn't read input file: %s\r\n", input);
+        free(head);
+        return 1;
+    }
+    hdr->input_hash = journal_fnv(2166136261u, head, (size_t)n);
+    free(head);
+    return 0;
+}
+
+//reads blocks of existing journal, cuts off a torn end
+static int journal_load(struct journal *j, const char *path, uint64_t size){
+    uint64_t pos = sizeof(struct journal_hdr);
+    unsigned char *payload = NULL;
+    size_t payload_cap = 0, cap = 0;
+    while (pos + sizeof(struct journal_block) <= size){
+        struct journal_block b;
+        if (pread(j->fd, &b, sizeof(b), (off_t)pos) != (ssize_t)sizeof(b) || b.magic != JOURNAL_BLOCK_MAGIC ||
+            pos + sizeof(b) + b.len > size){
+            break;
+        }
+        if (b.len > payload_cap){
+            payload_cap = b.len;
+            if ((payload = realloc(payload, payload_cap)) == NULL){
+                fprintf(stderr, "ERROR: memory allocation failure\r\n");
+                exit(1);
+            }
+        }
+        if (pread(j->fd, payload, b.len, (off_t)(pos + sizeof(b))) != (ssize_t)b.len || journal_check(&b, payload) != b.check){
+            break;
+        }
+
+      //decode keys (difference from the watermark, then from the previous key)
+        uint64_t key = b.watermark;
+        uint32_t i = 0;
+        for (size_t p = 0; p < b.len && i < b.count; i++){
+            uint64_t delta = 0;
+            for (int shift = 0; p < b.len; shift += 7){
+                delta |= (uint64_t)(payload[p] & 0x7f) << shift;
+                if ((payload[p++] & 0x80) == 0){
+                    break;
+                }
+            }
+            key += delta;
+            journal_reserve(&j->done, j->ndone, &cap);
+            j->done[j->ndone++] = key;
+        }
+        if (i != b.count){
+            break;
+        }
+        if (b.watermark > j->done_below){
+            j->done_below = b.watermark;
+        }
+
+      //keys the watermark went past aren't needed any more
+        if (j->ndone == cap){
+            size_t kept = 0;
+            for (size_t k = 0; k < j->ndone; k++){
+                if (j->done[k] >= j->done_below){
+                    j->done[kept++] = j->done[k];
+                }
+            }
+            j->ndone = kept;
+        }
+        pos += sizeof(b) + b.len;
+    }
+    free(payload);
+
+    if (pos < size){
+        fprintf(stderr, "WARNING: dropping torn end of journal %s (%lu bytes)\r\n", path, (unsigned long)(size - pos));
+        if (ftruncate(j->fd, (off_t)pos) != 0){
+            perror("ERROR: journal truncation failure");
+            return 1;
+        }
+    }
+    j->bytes = pos;
+
+  //sorted list of keys done past the final watermark
+    size_t kept = 0;
+    for (size_t k = 0; k < j->ndone; k++){
+        if (j->done[k] >= j->done_below){
+            j->done[kept++] = j->done[k];
+        }
+    }
+    qsort(j->done, kept, sizeof(uint64_t), journal_cmp);
+    j->ndone = 0;
+    for (size_t k = 0; k < kept; k++){
+        if (j->ndone == 0 || j->done[j->ndone - 1] != j->done[k]){
+            j->done[j->ndone++] = j->done[k];
+        }
+    }
+    return 0;
+}
+
+/*************************************************
+ *                    JOURNAL                    *
+*************************************************/
+int journal_open(struct journal *j, const char *path, const char *input){
+    memset(j, 0, sizeof(*j));
+    j->fd = -1;
+    struct journal_hdr want, have;
+    if (journal_ident(&want, input) != 0){
+        return 1;
+    }
+
+    struct stat st;
+    if ((j->fd = open(path, O_RDWR | O_CREAT, 0644)) < 0 || fstat(j->fd, &st) != 0){
+        fprintf(stderr, "ERROR: couldn't open journal: %s\r\n", path);
+        journal_close(j);
+        return 1;
+    }
+    if (st.st_size == 0){ //new journal
+        if (write(j->fd, &want, sizeof(want)) != (ssize_t)sizeof(want) || fdatasync(j->fd) != 0){
+            fprintf(stderr, "ERROR: couldn't write journal: %s\r\n", path);
+            journal_close(j);
+            return 1;
+        }
+        j->bytes = sizeof(want);
+    } else {
+        if (pread(j->fd, &have, sizeof(have), 0) != (ssize_t)sizeof(have) || memcmp(have.magic, want.magic, sizeof(have.magic)) != 0){
+            fprintf(stderr, "ERROR: not a journal: %s\r\n", path);
+            journal_close(j);
+            return 1;
+        }
+        if (memcmp(&have, &want, sizeof(have)) != 0){
+            fprintf(stderr, "ERROR: journal %s was written for another input file or other query types\r\n", path);
+            journal_close(j);
+            return 1;
+        }
+        if (journal_load(j, path, (uint64_t)st.st_size) != 0){
+            journal_close(j);
+            return 1;
+        }
+        j->resumed = true;
+    }
+    lseek(j->fd, (off_t)j->bytes, SEEK_SET);
+
+    j->watermark = j->done_below;
+    j->window_cap = JOURNAL_WINDOW_INIT;
+    j->window = calloc(j->window_cap, sizeof(uint64_t));
+    if (j->window == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        journal_close(j);
+        return 1;
+    }
+    return 0;
+}
+
+bool journal_skip(struct journal *j, uint64_t key){
+    if (key < j->done_below){
+        j->skipped++;
+        return true;
+    }
+    while (j->done_pos < j->ndone && j->done[j->done_pos] < key){
+        j->done_pos++;
+    }
+    if (j->done_pos < j->ndone && j->done[j->done_pos] == key){
+        j->done_pos++;
+        j->skipped++;
+        return true;
+    }
+    return false;
+}
+
+void journal_add(struct journal *j, uint64_t seq, uint64_t key){
+    j->completions++;
+    journal_reserve(&j->pending, j->npending, &j->pending_cap);
+    j->pending[j->npending++] = key;
+
+  //a query far ahead of the lowest one still out doesn't fit the window: double it, ring order kept
+    while (seq - j->base >= j->window_cap){
+        uint64_t *window = calloc(j->window_cap * 2, sizeof(uint64_t));
+        if (window == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+        for (uint64_t s = j->base; s < j->base + j->window_cap; s++){
+            window[s & (j->window_cap * 2 - 1)] = j->window[s & (j->window_cap - 1)];
+        }
+        free(j->window);
+        j->window = window;
+        j->window_cap *= 2;
+    }
+    j->window[seq & (j->window_cap - 1)] = key + 1;
+
+  //move watermark past every query done in a row
+    uint64_t *slot;
+    while (*(slot = &j->window[j->base & (j->window_cap - 1)]) != 0){
+        if (*slot > j->watermark){
+            j->watermark = *slot;
+        }
+        *slot = 0;
+        j->base++;
+    }
+}
+
+bool journal_due(struct journal *j, uint64_t now){
+    return j->npending >= JOURNAL_PENDING_MAX ||
+           (j->npending > 0 && now - j->last_sync >= (uint64_t)JOURNAL_SYNC_MS * 1000000ULL);
+}
+
+int journal_sync(struct journal *j, uint64_t now){
+    j->last_sync = now;
+    if (j->npending == 0){
+        return 0;
+    }
+
+  //keys the watermark already covers don't need listing
+    qsort(j->pending, j->npending, sizeof(uint64_t), journal_cmp);
+    unsigned char *buf = malloc(sizeof(struct journal_block) + j->npending * 10);
+    if (buf == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        exit(1);
+    }
+    struct journal_block b = {.magic = JOURNAL_BLOCK_MAGIC, .count = 0, .watermark = j->watermark, .len = 0, .check = 0};
+    unsigned char *p = buf + sizeof(b);
+    uint64_t prev = j->watermark;
+    for (size_t i = 0; i < j->npending; i++){
+        if (j->pending[i] < j->watermark){
+            continue;
+        }
+        uint64_t delta = j->pending[i] - prev;
+        prev = j->pending[i];
+        do {
+            *p++ = (unsigned char)((delta & 0x7f) | ((delta > 0x7f) ? 0x80 : 0));
+            delta >>= 7;
+        } while (delta > 0);
+        b.count++;
+    }
+    b.len = (uint32_t)(p - buf - sizeof(b));
+    b.check = journal_check(&b, buf + sizeof(b));
+    memcpy(buf, &b, sizeof(b));
+
+    size_t len = (size_t)(p - buf);
+    int ret = (write(j->fd, buf, len) != (ssize_t)len || fdatasync(j->fd) != 0) ? 1 : 0;
+    free(buf);
+    j->npending = 0;
+    j->blocks++;
+    j->bytes += len;
+    return ret;
+}
+
+void journal_close(struct journal *j){
+    if (j->fd >= 0){
+        close(j->fd);
+    }
+    j->fd = -1;
+    free(j->done);
+    free(j->window);
+    free(j->pending);
+    j->done = j->window = j->pending = NULL;
+}
@@ -0,0 +1,146 @@
+/** @file:   journal.h
+ *  @brief:  Checkpoint journal of batch runs ('--journal'): completed input lines, so a restarted run skips them
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "dns.h"
+
+#define JOURNAL_MAGIC       "DNSJRN1"  //file magic (8 bytes with the terminating zero)
+#define JOURNAL_VERSION     1
+#define JOURNAL_BLOCK_MAGIC 0x4b4c424aU //"JBLK"
+#define JOURNAL_SYNC_MS     1000       //completions are written (and synced) at most this often
+#define JOURNAL_PENDING_MAX (1 << 18)  //...or as soon as this many pile up
+#define JOURNAL_IDENT_BYTES 65536      //input bytes hashed into the header (tells a different input apart)
+
+//flags of the header (query types asked for every line have to match on resume)
+#define JOURNAL_F_DUAL      0x01
+#define JOURNAL_F_REVERSE   0x02
+
+//journal key of an input line's query: its input offset and which of the line's query types it is
+//(0, or 1 for AAAA of '-d'), keys of one run increase in input order
+#define JOURNAL_KEY(offset, part) (((uint64_t)(offset) << 1) | (uint64_t)(part))
+
+/**
+ * @struct: file header
+*/
+struct journal_hdr{
+    char magic[8];        /* JOURNAL_MAGIC */
+    uint32_t version;     /* JOURNAL_VERSION */
+    uint32_t qtype;       /* 'par.Qtype' */
+    uint32_t flags;       /* JOURNAL_F_* */
+    uint32_t input_hash;  /* FNV-1a of the first JOURNAL_IDENT_BYTES bytes of input */
+    uint64_t input_size;
+};
+
+/**
+ * @struct: checkpoint block, followed by 'len' bytes of keys done since the previous block
+ *          (not below 'watermark'), ascending, LEB128 varints of the differences
+ *
+ * A block is appended and synced once the output it covers is written and synced, so every key
+ * in the journal has its result on disk. A torn block at the end (crash mid-write) fails its
+ * check and is dropped on resume.
+*/
+struct journal_block{
+    uint32_t magic;       /* JOURNAL_BLOCK_MAGIC */
+    uint32_t count;       /* keys listed */
+    uint64_t watermark;   /* every key below this is done */
+    uint32_t len;         /* varint bytes */
+    uint32_t check;       /* FNV-1a of the fields above and the varints */
+};
+
+/**
+ * @struct: journal of one batch run
+ *
+ * Input thread asks 'journal_skip' about every key it reads (resume state is read-only by then),
+ * output thread reports completions and writes checkpoints (the writer state is its own).
+ * A completion is reported with the sequence number of its query in this run, sequence numbers
+ * are handed out in input order, so the lowest one not done yet gives the watermark - the journal
+ * only ever lists keys completed out of order past it.
+*/
+struct journal{
+    int fd;
+    bool resumed;         /* journal already existed (its keys are skipped) */
+
+  /* resume state */
+    uint64_t done_below;  /* watermark of the last block read */
+    uint64_t *done;       /* keys done at or past 'done_below', ascending */
+    size_t ndone, done_pos;
+    unsigned long skipped; /* queries skipped as done */
+
+  /* writer state */
+    uint64_t watermark;   /* key after the highest one below which everything is done */
+    uint64_t *window;     /* key + 1 of done sequence numbers from 'base' on (0 = not done yet), ring */
+    size_t window_cap;    /* power of two */
+    uint64_t base;        /* lowest sequence number not done */
+    uint64_t *pending;    /* keys done since the last block */
+    size_t npending, pending_cap;
+    uint64_t last_sync;   /* monotonic ns of the last block */
+    unsigned long completions, blocks;
+    uint64_t bytes;       /* journal size */
+};
+
+/**
+ * @function: journal_open
+ * @brief opens journal 'path' for batch run over 'input': loads an existing one (dropping a torn last block)
+ *        after checking it was written for the same input and query types, creates it otherwise
+ *
+ * @param[in] j:     journal to initialize
+ * @param[in] path:  journal file path
+ * @param[in] input: input file path (a regular file, stdin can't be read twice)
+ * @return 0 if successful, 1 if not
+*/
+int journal_open(struct journal *j, const char *path, const char *input);
+
+/**
+ * @function: journal_skip
+ * @brief checks query was already done by an earlier run (keys have to be asked in increasing order)
+ *
+ * @param[in] j:   journal
+ * @param[in] key: JOURNAL_KEY of the query
+ * @return 'true' if it's done, 'false' if it has to be sent
+*/
+bool journal_skip(struct journal *j, uint64_t key);
+
+/**
+ * @function: journal_add
+ * @brief records query as done (its result was handed to output)
+ *
+ * @param[in] j:   journal
+ * @param[in] seq: sequence number of the query in this run (from 0, in input order)
+ * @param[in] key: JOURNAL_KEY of the query
+*/
+void journal_add(struct journal *j, uint64_t seq, uint64_t key);
+
+/**
+ * @function: journal_due
+ * @brief checks it's time for a checkpoint (JOURNAL_SYNC_MS passed or JOURNAL_PENDING_MAX completions waiting)
+ *
+ * @param[in] j:   journal
+ * @param[in] now: current monotonic time
+ * @return 'true' if 'journal_sync' should be called (after syncing the output the completions went to)
+*/
+bool journal_due(struct journal *j, uint64_t now);
+
+/**
+ * @function: journal_sync
+ * @brief appends block of completions since the last one and syncs journal
+ *
+ * @param[in] j:   journal
+ * @param[in] now: current monotonic time
+ * @return 0 if successful, 1 on write failure
+*/
+int journal_sync(struct journal *j, uint64_t now);
+
+/**
+ * @function: journal_close
+ * @brief frees journal and closes its file (completions since the last 'journal_sync' are lost)
+ *
+ * @param[in] j: journal
+*/
+void journal_close(struct journal *j);
+
+#endif
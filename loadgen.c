@@ -0,0 +1,411 @@
+/** @file:   loadgen.c
+ *  @brief:  Load generation mode (--load): query file replayed at target rate, rate/loss/latency reports
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#define _GNU_SOURCE //ppoll (sub-millisecond waits between paced sends)
+
+#include "loadgen.h"
+#include "batch.h"
+#include "input.h"
+#include "rrtypes.h"
+#include "metrics.h"
+
+#include <fcntl.h>
+#include <poll.h>
+
+/**
+ * @struct: outstanding query (indexed by transaction ID)
+*/
+struct load_flight{
+    bool used;
+    uint32_t query;  /* index of query in 'queries' */
+    uint32_t seq;    /* send sequence number (tells reused ID apart in timeout FIFO) */
+    uint64_t sent;   /* monotonic ns timestamp of send */
+};
+
+/**
+ * @struct: timeout FIFO entry (sends in send order)
+*/
+struct load_fifo_entry{
+    uint16_t id;
+    uint32_t seq;
+};
+
+//queries serialized once at load time, back-to-back in one arena
+static unsigned char *arena;
+static size_t arena_len, arena_cap;
+static uint32_t *queries;   //start of every query in arena (one extra at the end)
+static uint32_t nqueries, queries_cap;
+
+static struct load_flight flights[65536];
+static struct load_fifo_entry fifo[LOAD_FIFO];
+static uint32_t fifo_head, fifo_n;
+
+static struct load_stats total, ival;
+
+static const char *load_rcode_names[16] = {"NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED",
+                                           "YXDOMAIN", "YXRRSET", "NXRRSET", "NOTAUTH", "NOTZONE"};
+
+/*************************************************
+ *              LATENCY HISTOGRAM                *
+*************************************************/
+//bucket of latency: exact below LOAD_HIST_SUB, then LOAD_HIST_SUB buckets per power of two
+static unsigned int load_hist_bucket(uint64_t us){
+    if (us < LOAD_HIST_SUB){
+        return (unsigned int)us;
+    }
+    unsigned int msb = 63 - (unsigned int)__builtin_clzll(us);
+    unsigned int b = (msb - 3) * LOAD_HIST_SUB + (unsigned int)((us >> (msb - 4)) & (LOAD_HIST_SUB - 1));
+    return (b < LOAD_HIST_BUCKETS) ? b : LOAD_HIST_BUCKETS - 1;
+}
+
+void load_hist_add(struct load_hist *h, uint64_t us){
+    if (h->count == 0 || us < h->min_us){
+        h->min_us = us;
+    }
+    if (us > h->max_us){
+        h->max_us = us;
+    }
+    h->count++;
+    h->sum_us += us;
+    h->buckets[load_hist_bucket(us)]++;
+}
+
+uint64_t load_hist_percentile(const struct load_hist *h, double p){
+    if (h->count == 0){
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p * (double)h->count);
+    uint64_t seen = 0;
+    for (unsigned int b = 0; b < LOAD_HIST_BUCKETS; b++){
+        seen += h->buckets[b];
+        if (seen > rank){
+            if (b < LOAD_HIST_SUB){
+                return b;
+            }
+            unsigned int shift = b / LOAD_HIST_SUB - 1; //bucket width is 2^shift
+            uint64_t low = (uint64_t)(LOAD_HIST_SUB + b % LOAD_HIST_SUB) << shift;
+            uint64_t mid = low + ((1ULL << shift) >> 1);
+            return (mid > h->max_us) ? h->max_us : (mid < h->min_us) ? h->min_us : mid;
+        }
+    }
+    return h->max_us;
+}
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//append query to arena (grown by doubling)
+static void load_query_add(const struct dns_query_t *q){
+    if (arena_len + q->len > arena_cap){
+        arena_cap = arena_cap ? arena_cap * 2 : (1 << 20);
+        if ((arena = realloc(arena, arena_cap)) == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+    }
+    if (nqueries + 2 > queries_cap){
+        queries_cap = queries_cap ? queries_cap * 2 : 65536;
+        if ((queries = realloc(queries, queries_cap * sizeof(uint32_t))) == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+    }
+    queries[nqueries++] = (uint32_t)arena_len;
+    memcpy(arena + arena_len, q->pkt, q->len);
+    arena_len += q->len;
+    queries[nqueries] = (uint32_t)arena_len;
+}
+
+//reads query file ("name [type]" lines), returns amount of invalid lines
+static unsigned long load_queries_read(const char *path){
+    struct input_reader in;
+    if (input_open(&in, path) != 0){
+        exit(1);
+    }
+    const char *line;
+    size_t len;
+    uint64_t offset;
+    unsigned long invalid = 0;
+    while (input_next(&in, &line, &len, &offset)){
+        size_t nlen = 0;
+        while (nlen < len && line[nlen] != ' ' && line[nlen] != '\t'){
+            nlen++;
+        }
+        size_t t = nlen;
+        while (t < len && (line[t] == ' ' || line[t] == '\t')){
+            t++;
+        }
+        uint16_t qtype = (uint16_t)par.Qtype;
+        if (t < len){
+            char type[16];
+            if (len - t >= sizeof(type)){
+                invalid++;
+                continue;
+            }
+            memcpy(type, line + t, len - t);
+            type[len - t] = '\0';
+            qtype = rr_type_by_name(type);
+        }
+        unsigned char qname[258];
+        size_t qlen = (qtype != 0) ? batch_qname_build(line, nlen, qname) : 0;
+        if (qlen == 0){
+            invalid++;
+            continue;
+        }
+        struct dns_query_t q;
+        dns_query_build(&q, qname, qlen, qtype, par.recursion);
+        load_query_add(&q);
+    }
+    input_close(&in);
+    return invalid;
+}
+
+//milliseconds (from microseconds) for reports
+static double load_ms(uint64_t us){
+    return (double)us / 1000.0;
+}
+
+//one progress line for the interval just finished
+static void load_report(double at, double secs){
+    fprintf(stdout, "[%7.1f s] sent %lu, received %lu (%.1f qps), lost %lu (%.2f %%), "
+            "latency p50 %.3f, p90 %.3f, p99 %.3f, max %.3f ms\r\n", at, ival.sent, ival.received,
+            secs > 0 ? (double)ival.received / secs : 0.0, ival.lost,
+            (ival.received + ival.lost) ? 100.0 * (double)ival.lost / (double)(ival.received + ival.lost) : 0.0,
+            load_ms(load_hist_percentile(&ival.lat, 0.5)), load_ms(load_hist_percentile(&ival.lat, 0.9)),
+            load_ms(load_hist_percentile(&ival.lat, 0.99)), load_ms(ival.lat.max_us));
+    fflush(stdout);
+    memset(&ival, 0, sizeof(ival));
+}
+
+//final summary
+static void load_summary(unsigned long invalid, double send_secs, double run_secs){
+    double done = (double)(total.received + total.lost);
+    fprintf(stdout, "Load summary:\r\n");
+    fprintf(stdout, " Queries loaded:    %u (%lu invalid lines skipped), target ", nqueries, invalid);
+    if (par.qps){
+        fprintf(stdout, "%u qps\r\n", par.qps);
+    } else {
+        fprintf(stdout, "unlimited (window %u)\r\n", par.window);
+    }
+    fprintf(stdout, " Queries sent:      %lu in %.3f s (%.1f qps), %lu send errors\r\n", total.sent, send_secs,
+            send_secs > 0 ? (double)total.sent / send_secs : 0.0, total.send_errors);
+    fprintf(stdout, " Queries completed: %lu (%.2f %%), %.1f qps\r\n", total.received,
+            done > 0 ? 100.0 * (double)total.received / done : 0.0, run_secs > 0 ? (double)total.received / run_secs : 0.0);
+    fprintf(stdout, " Queries lost:      %lu (%.2f %%), %lu unmatched replies\r\n", total.lost,
+            done > 0 ? 100.0 * (double)total.lost / done : 0.0, total.mismatched);
+    fprintf(stdout, " Response codes:   ");
+    for (int i = 0; i < 16; i++){
+        if (total.rcodes[i] == 0){
+            continue;
+        }
+        if (load_rcode_names[i] != NULL){
+            fprintf(stdout, " %s", load_rcode_names[i]);
+        } else {
+            fprintf(stdout, " RCODE%d", i);
+        }
+        fprintf(stdout, " %lu (%.2f %%)", total.rcodes[i], 100.0 * (double)total.rcodes[i] / (double)total.received);
+    }
+    fprintf(stdout, "\r\n");
+    fprintf(stdout, " Latency (ms):      min %.3f, avg %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f\r\n",
+            load_ms(total.lat.min_us), total.lat.count ? load_ms(total.lat.sum_us / total.lat.count) : 0.0,
+            load_ms(load_hist_percentile(&total.lat, 0.5)), load_ms(load_hist_percentile(&total.lat, 0.9)),
+            load_ms(load_hist_percentile(&total.lat, 0.99)), load_ms(load_hist_percentile(&total.lat, 0.999)),
+            load_ms(total.lat.max_us));
+}
+
+//matches reply to its outstanding query (same ID and question)
+static void load_reply(unsigned char *buf, size_t len, uint64_t now, uint32_t *outstanding){
+    struct dns_header_t *dns = (struct dns_header_t *)buf;
+    metric_add(METRIC_BYTES_IN, len);
+    if (len < sizeof(*dns) || dns->qr != 1){
+        total.mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return;
+    }
+    struct load_flight *f = &flights[ntohs(dns->id)];
+    if (!f->used){
+        total.mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return;
+    }
+    const unsigned char *q = arena + queries[f->query];
+    size_t qlen = queries[f->query + 1] - queries[f->query];
+    if (len < qlen || memcmp(buf + sizeof(*dns), q + sizeof(*dns), qlen - sizeof(*dns)) != 0){
+        total.mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return;
+    }
+    f->used = false;
+    (*outstanding)--;
+    uint64_t us = (now - f->sent) / 1000;
+    load_hist_add(&total.lat, us);
+    load_hist_add(&ival.lat, us);
+    total.received++;
+    ival.received++;
+    total.rcodes[dns->rcode]++;
+    ival.rcodes[dns->rcode]++;
+    metric_add(METRIC_RCODE + dns->rcode, 1);
+    if (dns->tc){
+        metric_add(METRIC_TRUNCATED, 1);
+    }
+}
+
+/*************************************************
+ *                 LOAD GENERATOR                *
+*************************************************/
+int load_run(){
+  //everything is serialized before the clock starts
+    unsigned long invalid = load_queries_read(par.loadfile);
+    if (nqueries == 0){
+        fprintf(stderr, "ERROR: no valid queries in file: %s\r\n", par.loadfile);
+        return 1;
+    }
+
+  //one connected non-blocking socket (the kernel drops datagrams from anyone but 'server')
+    int fd;
+    struct sockaddr_in dest;
+    struct sockaddr_in6 dest6;
+    memset(&dest, 0, sizeof(dest));
+    memset(&dest6, 0, sizeof(dest6));
+    sock_prep(&fd, &dest, &dest6);
+    bool v6 = is_it_IPv6(par.server);
+    if (connect(fd, v6 ? (struct sockaddr *)&dest6 : (struct sockaddr *)&dest, v6 ? sizeof(dest6) : sizeof(dest)) != 0){
+        perror("ERROR: couldn't connect to 'server'");
+        return 1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &par.rcvbuf, sizeof(par.rcvbuf));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &par.sndbuf, sizeof(par.sndbuf));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    srandom((unsigned int)(batch_now_ns() ^ (uint64_t)getpid()));
+    uint16_t next_id = (uint16_t)random();
+    uint32_t next_query = 0, seq = 0, outstanding = 0;
+    uint64_t timeout_ns = (uint64_t)(par.timeout * 1e9);
+    uint64_t interval_ns = (uint64_t)(par.interval * 1e9);
+    uint64_t start = batch_now_ns();
+    uint64_t stop_at = par.duration > 0 ? start + (uint64_t)(par.duration * 1e9) : 0;
+    uint64_t last_report = start, next_report = start + interval_ns;
+    uint64_t send_end = start, last_reply = start;
+    bool sending = true;
+    unsigned char buf[65536];
+
+    while (sending || outstanding > 0){
+        uint64_t now = batch_now_ns();
+
+      //queries unanswered for too long are lost (FIFO is in send order, stale entries are skipped)
+        while (fifo_n > 0){
+            struct load_fifo_entry *e = &fifo[fifo_head];
+            struct load_flight *f = &flights[e->id];
+            if (f->used && f->seq == e->seq){
+                if (now - f->sent < timeout_ns){
+                    break;
+                }
+                f->used = false;
+                outstanding--;
+                total.lost++;
+                ival.lost++;
+                metric_add(METRIC_TIMEOUTS, 1);
+            }
+            fifo_head = (fifo_head + 1) % LOAD_FIFO;
+            fifo_n--;
+        }
+
+      //send everything due (by target rate), as long as window and FIFO have room
+        if (sending && stop_at != 0 && now >= stop_at){
+            sending = false;
+            send_end = now;
+        }
+        while (sending && outstanding < par.window && fifo_n < LOAD_FIFO &&
+               (par.qps == 0 || now >= start + (uint64_t)((double)(total.sent + total.send_errors) * 1e9 / par.qps))){
+            while (flights[next_id].used){
+                next_id++;
+            }
+            unsigned char *q = arena + queries[next_query];
+            size_t qlen = queries[next_query + 1] - queries[next_query];
+            uint16_t nid = htons(next_id);
+            memcpy(q, &nid, sizeof(nid));
+            if (send(fd, q, qlen, 0) < 0){
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS){
+                    break; //socket buffer full, retry after poll
+                }
+                total.send_errors++;
+            } else {
+                metric_add(METRIC_QUERIES, 1);
+                metric_add(METRIC_BYTES_OUT, qlen);
+                struct load_flight *f = &flights[next_id];
+                f->used = true;
+                f->query = next_query;
+                f->seq = ++seq;
+                f->sent = now;
+                fifo[(fifo_head + fifo_n) % LOAD_FIFO] = (struct load_fifo_entry){next_id, seq};
+                fifo_n++;
+                outstanding++;
+                next_id++;
+                total.sent++;
+                ival.sent++;
+            }
+            if (++next_query == nqueries){
+                next_query = 0;
+                if (stop_at == 0){ //one pass over file
+                    sending = false;
+                    send_end = now;
+                }
+            }
+        }
+
+      //progress report
+        if (now >= next_report){
+            load_report((double)(now - start) / 1e9, (double)(now - last_report) / 1e9);
+            last_report = now;
+            next_report += interval_ns;
+        }
+
+      //wait for replies until next send, report, timeout or end of run
+        uint64_t wake = next_report;
+        if (sending && stop_at != 0 && stop_at < wake){
+            wake = stop_at;
+        }
+        if (sending && par.qps != 0 && outstanding < par.window){
+            uint64_t due = start + (uint64_t)((double)(total.sent + total.send_errors) * 1e9 / par.qps);
+            if (due < wake){
+                wake = due;
+            }
+        }
+        if (fifo_n > 0){
+            uint64_t expiry = flights[fifo[fifo_head].id].sent + timeout_ns;
+            if (expiry < wake){
+                wake = expiry;
+            }
+        }
+        now = batch_now_ns();
+        struct timespec ts = {0, 0};
+        if (wake > now && !(sending && par.qps == 0 && outstanding < par.window)){
+            ts.tv_sec = (time_t)((wake - now) / 1000000000ULL);
+            ts.tv_nsec = (long)((wake - now) % 1000000000ULL);
+        }
+        struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+        if (ppoll(&pfd, 1, &ts, NULL) > 0){
+            ssize_t n;
+            while ((n = recv(fd, buf, sizeof(buf), 0)) >= 0 || errno == ECONNREFUSED){ //ICMP errors aren't replies
+                if (n >= 0){
+                    last_reply = batch_now_ns();
+                    load_reply(buf, (size_t)n, last_reply, &outstanding);
+                }
+            }
+        }
+    }
+
+    uint64_t end = batch_now_ns();
+    if (ival.sent > 0 || ival.received > 0 || ival.lost > 0){
+        load_report((double)(end - start) / 1e9, (double)(end - last_report) / 1e9);
+    }
+    uint64_t last = (last_reply > send_end) ? last_reply : send_end; //drain wait for lost queries isn't counted
+    load_summary(invalid, (double)(send_end - start) / 1e9, (double)(last - start) / 1e9);
+    close(fd);
+    free(arena);
+    free(queries);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/** @file:   loadgen.h
+ *  @brief:  Load generation mode (--load): query file replayed at target rate, rate/loss/latency reports
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include "dns.h"
+
+#define LOAD_INTERVAL_DEFAULT 1.0     //seconds between progress reports
+#define LOAD_TIMEOUT_DEFAULT  5.0     //seconds after which unanswered query counts as lost
+#define LOAD_QPS_MAX          1000000 //upper limit of '--qps'
+#define LOAD_FIFO             (1 << 20) //sends tracked for timeouts at once (sending pauses when full)
+#define LOAD_HIST_SUB         16      //latency histogram sub-buckets per power of two (about 6 % precision)
+#define LOAD_HIST_BUCKETS     (40 * LOAD_HIST_SUB) //covers latencies up to 2^40 microseconds
+
+/**
+ * @struct: latency histogram (log-linear buckets of microseconds)
+*/
+struct load_hist{
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t min_us;
+    uint64_t max_us;
+    uint64_t buckets[LOAD_HIST_BUCKETS];
+};
+
+/**
+ * @struct: load counters (kept for whole run and for current report interval)
+*/
+struct load_stats{
+    unsigned long sent;
+    unsigned long received;    /* replies matched to a query */
+    unsigned long lost;        /* queries unanswered within '--timeout' */
+    unsigned long mismatched;  /* replies not matching any outstanding query (late, foreign) */
+    unsigned long send_errors;
+    unsigned long rcodes[16];  /* replies by response code */
+    struct load_hist lat;
+};
+
+/**
+ * @function: load_hist_add
+ * @brief adds one latency sample to histogram
+ *
+ * @param[in] h:  histogram
+ * @param[in] us: latency in microseconds
+*/
+void load_hist_add(struct load_hist *h, uint64_t us);
+
+/**
+ * @function: load_hist_percentile
+ * @brief latency below which given share of samples lies (middle of the bucket it falls into)
+ *
+ * @param[in] h: histogram
+ * @param[in] p: share (0.5 = median, 0.99 = 99th percentile)
+ * @return latency in microseconds, 0 if histogram is empty
+*/
+uint64_t load_hist_percentile(const struct load_hist *h, double p);
+
+/**
+ * @function: load_run
+ * @brief loads 'par.loadfile' queries, sends them to 'par.server' at 'par.qps' (for 'par.duration'
+ *        seconds or one pass), prints a report every 'par.interval' seconds and a summary at the end
+ *
+ * @return exit code of the program (0 if successful, 1 otherwise)
+*/
+int load_run();
+
+#endif
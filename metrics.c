@@ -0,0 +1,268 @@
+/** @file:   metrics.c
+ *  @brief:  Resolver counters (per-thread shards) and their Prometheus text export ('--metrics')
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "metrics.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+_Thread_local struct metrics_shard *metrics_local;
+
+static struct metrics_shard shards[METRICS_SHARDS] = {[METRICS_SHARDS - 1].shared = true};
+static _Atomic unsigned int nshards;
+
+static const struct{
+    const char *name;
+    const char *help;
+} metrics_desc[METRIC_RCODE] = {
+    [METRIC_QUERIES] = {"dns_queries_sent_total", "Queries sent, retransmissions included."},
+    [METRIC_BYTES_OUT] = {"dns_sent_bytes_total", "Bytes of queries sent."},
+    [METRIC_BYTES_IN] = {"dns_received_bytes_total", "Bytes of datagrams received, matching a query or not."},
+    [METRIC_TIMEOUTS] = {"dns_timeouts_total", "Queries whose reply didn't come in time (retransmitted or given up)."},
+    [METRIC_TRUNCATED] = {"dns_truncated_responses_total", "Responses with the TC flag set."},
+    [METRIC_MISMATCHED] = {"dns_mismatched_responses_total", "Datagrams matching no query in flight (ID, source or question)."},
+    [METRIC_DECODE_ERRORS] = {"dns_decode_errors_total", "Responses the decoder rejected as malformed."},
+};
+
+static const char *metrics_rcodes[16] = {"NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED", "YXDOMAIN",
+                                         "YXRRSET", "NXRRSET", "NOTAUTH", "NOTZONE", "RCODE11", "RCODE12", "RCODE13",
+                                         "RCODE14", "RCODE15"};
+
+/**
+ * @struct: exporter thread and where it exports to
+*/
+struct metrics_exporter{
+    bool running;
+    int listen_fd;        /* HTTP endpoint (TCP or Unix socket), -1 when writing a file */
+    int stop[2];          /* pipe waking the thread up to stop */
+    bool unix_socket;
+    char path[256];       /* file or Unix socket path */
+    char tmp[264];        /* file is written here first, then renamed over 'path' */
+    const char *target;
+    pthread_t thread;
+    unsigned long exports; /* file writes or scrapes served */
+    unsigned long failures;
+};
+static struct metrics_exporter ex = {.listen_fd = -1, .stop = {-1, -1}};
+
+/*************************************************
+ *                   COUNTERS                    *
+*************************************************/
+struct metrics_shard *metrics_attach(){
+    unsigned int i = atomic_fetch_add_explicit(&nshards, 1, memory_order_relaxed);
+    metrics_local = &shards[(i < METRICS_SHARDS - 1) ? i : METRICS_SHARDS - 1];
+    return metrics_local;
+}
+
+void metrics_write(FILE *f){
+    uint64_t sum[METRIC_COUNT] = {0};
+    for (unsigned int s = 0; s < METRICS_SHARDS; s++){
+        for (unsigned int m = 0; m < METRIC_COUNT; m++){
+            sum[m] += atomic_load_explicit(&shards[s].c[m], memory_order_relaxed);
+        }
+    }
+    for (unsigned int m = 0; m < METRIC_RCODE; m++){
+        fprintf(f, "# HELP %s %s\n# TYPE %s counter\n%s %lu\n", metrics_desc[m].name, metrics_desc[m].help,
+                metrics_desc[m].name, metrics_desc[m].name, (unsigned long)sum[m]);
+    }
+
+  //common rcodes are always there (series don't appear mid-scrape), the rest once seen
+    fprintf(f, "# HELP dns_responses_total Responses matched to their query, by rcode.\n# TYPE dns_responses_total counter\n");
+    for (unsigned int r = 0; r < 16; r++){
+        if (r <= 5 || sum[METRIC_RCODE + r] != 0){
+            fprintf(f, "dns_responses_total{rcode=\"%s\"} %lu\n", metrics_rcodes[r], (unsigned long)sum[METRIC_RCODE + r]);
+        }
+    }
+}
+
+/*************************************************
+ *                EXPORTER THREAD                *
+*************************************************/
+//file is replaced in one rename, so a collector never reads it half written
+static void metrics_file_write(){
+    FILE *f = fopen(ex.tmp, "w");
+    if (f != NULL){
+        metrics_write(f);
+        if (fclose(f) == 0 && rename(ex.tmp, ex.path) == 0){
+            ex.exports++;
+            return;
+        }
+    }
+    if (ex.failures++ == 0){ //reported once, the run goes on
+        perror("WARNING: couldn't write metrics file");
+    }
+}
+
+//answers one scrape (every request path gets the counters)
+static void metrics_serve(int fd){
+    struct timeval tv = {.tv_sec = METRICS_HTTP_TIMEOUT, .tv_usec = 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+  //request is read up to its blank line, so closing afterwards doesn't reset the connection
+    char req[2048];
+    size_t got = 0;
+    ssize_t n;
+    while (got < sizeof(req) - 1 && (n = recv(fd, &req[got], sizeof(req) - 1 - got, 0)) > 0){
+        got += (size_t)n;
+        req[got] = '\0';
+        if (strstr(req, "\r\n\r\n") != NULL){
+            break;
+        }
+    }
+
+    char *body = NULL;
+    size_t blen = 0;
+    FILE *f = open_memstream(&body, &blen);
+    if (f == NULL){
+        close(fd);
+        ex.failures++;
+        return;
+    }
+    metrics_write(f);
+    fclose(f);
+    char head[160];
+    int hlen = snprintf(head, sizeof(head), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                            "Content-Length: %zu\r\nConnection: close\r\n\r\n", blen);
+    if (send(fd, head, (size_t)hlen, MSG_NOSIGNAL) == hlen && send(fd, body, blen, MSG_NOSIGNAL) == (ssize_t)blen){
+        ex.exports++;
+    } else {
+        ex.failures++;
+    }
+    free(body);
+    close(fd);
+}
+
+static void *metrics_thread(void *arg){
+    (void)arg;
+    struct pollfd pfds[2] = {{.fd = ex.stop[0], .events = POLLIN, .revents = 0},
+                             {.fd = ex.listen_fd, .events = POLLIN, .revents = 0}};
+    nfds_t nfds = (ex.listen_fd >= 0) ? 2 : 1;
+    while (true){
+        if (ex.listen_fd < 0){
+            metrics_file_write();
+        }
+        int ready = poll(pfds, nfds, (ex.listen_fd >= 0) ? -1 : METRICS_FILE_INTERVAL);
+        if (ready < 0 && errno != EINTR){
+            perror("ERROR: poll failure");
+            exit(1);
+        }
+        if (ready > 0 && pfds[0].revents != 0){
+            return NULL;
+        }
+        if (ready > 0 && nfds == 2 && (pfds[1].revents & POLLIN)){
+            int fd = accept(ex.listen_fd, NULL, NULL);
+            if (fd >= 0){
+                metrics_serve(fd);
+            }
+        }
+    }
+}
+
+/*************************************************
+ *                    EXPORT                     *
+*************************************************/
+//listening socket of "http:port" (loopback only) or "unix:path" target
+static int metrics_listen(const char *target){
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    memset(&addr, 0, sizeof(addr));
+    if (strncmp(target, "http:", 5) == 0){
+        char *end;
+        long port = strtol(target + 5, &end, 10);
+        if (end == target + 5 || *end != '\0' || !is_it_valid_port(port)){
+            fprintf(stderr, "ERROR: invalid metrics port: %s\r\n", target + 5);
+            return -1;
+        }
+        struct sockaddr_in *in = (struct sockaddr_in *)&addr;
+        in->sin_family = AF_INET;
+        in->sin_port = htons((uint16_t)port);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr_len = sizeof(*in);
+    } else {
+        struct sockaddr_un *un = (struct sockaddr_un *)&addr;
+        if (strlen(ex.path) == 0 || strlen(ex.path) >= sizeof(un->sun_path)){
+            fprintf(stderr, "ERROR: invalid metrics socket path: %s\r\n", ex.path);
+            return -1;
+        }
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, ex.path);
+        addr_len = sizeof(*un);
+        struct stat st;
+        if (stat(ex.path, &st) == 0 && S_ISSOCK(st.st_mode)){ //left over by an earlier run (never removes anything else)
+            unlink(ex.path);
+        }
+    }
+
+    int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(fd, (struct sockaddr *)&addr, addr_len) != 0 || listen(fd, METRICS_HTTP_BACKLOG) != 0){
+        perror("ERROR: couldn't open metrics endpoint");
+        if (fd >= 0){
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+int metrics_start(const char *target){
+    ex.target = target;
+    ex.unix_socket = (strncmp(target, "unix:", 5) == 0);
+    snprintf(ex.path, sizeof(ex.path), "%s", ex.unix_socket ? target + 5 : target);
+    if (strncmp(target, "http:", 5) == 0 || ex.unix_socket){
+        if ((ex.listen_fd = metrics_listen(target)) < 0){
+            return 1;
+        }
+    } else {
+        snprintf(ex.tmp, sizeof(ex.tmp), "%s.tmp", ex.path); //not "*.prom", the textfile collector skips it
+    }
+    if (pipe(ex.stop) != 0){
+        perror("ERROR: pipe failure");
+        return 1;
+    }
+
+  //signals stay with the thread running the mode (probe mode stops on SIGINT/SIGTERM)
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    int err = pthread_create(&ex.thread, NULL, metrics_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0){
+        fprintf(stderr, "ERROR: couldn't create thread\r\n");
+        return 1;
+    }
+    ex.running = true;
+    return 0;
+}
+
+void metrics_stop(){
+    if (!ex.running){
+        return;
+    }
+    char b = 1;
+    if (write(ex.stop[1], &b, 1) != 1){
+        perror("ERROR: pipe failure");
+        exit(1);
+    }
+    pthread_join(ex.thread, NULL);
+    ex.running = false;
+    close(ex.stop[0]);
+    close(ex.stop[1]);
+    if (ex.listen_fd >= 0){
+        close(ex.listen_fd);
+        if (ex.unix_socket){
+            unlink(ex.path);
+        }
+        fprintf(stderr, "Metrics: %lu scrapes served on %s, %lu failed\r\n", ex.exports, ex.target, ex.failures);
+    } else {
+        metrics_file_write(); //final counts
+        fprintf(stderr, "Metrics: written %lu times to %s, %lu failed\r\n", ex.exports, ex.path, ex.failures);
+    }
+}
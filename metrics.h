@@ -0,0 +1,99 @@
+/** @file:   metrics.h
+ *  @brief:  Resolver counters (per-thread shards) and their Prometheus text export ('--metrics')
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "dns.h"
+
+#include <stdatomic.h>
+
+#define METRICS_SHARDS         16   //threads with a shard of their own (further ones share the last, with atomic adds)
+#define METRICS_CACHE_LINE     64   //shards live on separate lines (no false sharing between counting threads)
+#define METRICS_FILE_INTERVAL  1000 //ms between rewrites of a '--metrics' file
+#define METRICS_HTTP_BACKLOG   16
+#define METRICS_HTTP_TIMEOUT   1    //seconds a scrape connection may take to send its request
+
+/**
+ * @enum: counters (index into a shard), responses have one counter per rcode
+*/
+enum metric_id{
+    METRIC_QUERIES,       /* queries sent, retransmissions included */
+    METRIC_BYTES_OUT,     /* bytes of queries sent */
+    METRIC_BYTES_IN,      /* bytes of datagrams received (matching or not) */
+    METRIC_TIMEOUTS,      /* queries whose time ran out (each retransmitted or given up) */
+    METRIC_TRUNCATED,     /* matched responses with TC set */
+    METRIC_MISMATCHED,    /* datagrams matching no query in flight (ID, source or question) */
+    METRIC_DECODE_ERRORS, /* matched responses the decoder rejected */
+    METRIC_RCODE,         /* + rcode: matched responses by rcode (16 of them) */
+    METRIC_COUNT = METRIC_RCODE + 16
+};
+
+/**
+ * @struct: counters of one thread
+ *
+ * Only the owning thread writes its shard, so an increment is a relaxed load and store
+ * (no locked instruction); the exporter sums all shards with relaxed loads when asked.
+*/
+struct metrics_shard{
+    _Alignas(METRICS_CACHE_LINE) _Atomic uint64_t c[METRIC_COUNT];
+    bool shared; /* the overflow shard, written by several threads */
+};
+
+//shard of calling thread (NULL until its first count)
+extern _Thread_local struct metrics_shard *metrics_local;
+
+/**
+ * @function: metrics_attach
+ * @brief hands calling thread its shard (the next free one, the shared last one once they run out)
+ *
+ * @return shard of calling thread
+*/
+struct metrics_shard *metrics_attach();
+
+/**
+ * @function: metric_add
+ * @brief adds 'n' to counter 'm' of calling thread
+ *
+ * @param[in] m: METRIC_* (METRIC_RCODE + rcode for responses)
+ * @param[in] n: amount
+*/
+static inline void metric_add(unsigned int m, uint64_t n){
+    struct metrics_shard *s = (metrics_local != NULL) ? metrics_local : metrics_attach();
+    if (s->shared){
+        atomic_fetch_add_explicit(&s->c[m], n, memory_order_relaxed);
+    } else {
+        atomic_store_explicit(&s->c[m], atomic_load_explicit(&s->c[m], memory_order_relaxed) + n, memory_order_relaxed);
+    }
+}
+
+/**
+ * @function: metrics_write
+ * @brief sums counters of every shard and writes them in Prometheus text format (version 0.0.4)
+ *
+ * @param[in] f: stream to write to
+*/
+void metrics_write(FILE *f);
+
+/**
+ * @function: metrics_start
+ * @brief starts exporter thread for 'target': "http:port" (HTTP on 127.0.0.1:port), "unix:path" (HTTP on Unix
+ *        socket 'path') or a file path (rewritten every METRICS_FILE_INTERVAL ms through a temporary file and
+ *        a rename, as node_exporter's textfile collector expects)
+ *
+ * @param[in] target: '--metrics' operand
+ * @return 0 if successful, 1 if not
+*/
+int metrics_start(const char *target);
+
+/**
+ * @function: metrics_stop
+ * @brief stops exporter thread (a file gets the final counts first), prints summary to stderr;
+ *        does nothing when none was started
+*/
+void metrics_stop();
+
+#endif
@@ -0,0 +1,492 @@
+/** @file:   monitor.c
+ *  @brief:  Probe mode (--monitor): fixed query set sent to a list of servers every interval, rolling health lines
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#define _GNU_SOURCE //ppoll (sub-millisecond waits between staggered rounds)
+
+#include "monitor.h"
+#include "batch.h"
+#include "input.h"
+#include "rrtypes.h"
+#include "metrics.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+
+/**
+ * @struct: outstanding query (indexed by transaction ID)
+*/
+struct monitor_flight{
+    bool used;
+    uint32_t server; /* index of server in 'servers' */
+    uint32_t query;  /* index of query in 'queries' */
+    uint64_t sent;   /* monotonic ns timestamp of send */
+};
+
+/**
+ * @struct: round in progress (rounds start, and so time out, in order)
+*/
+struct monitor_fifo_entry{
+    uint32_t server;
+    uint64_t deadline; /* tells entry of round that finished early (all replies in) apart */
+};
+
+//query packets serialized once at load time, only the ID is patched before every send
+static struct dns_query_t queries[MONITOR_QUERIES_MAX];
+static uint32_t nqueries;
+
+static struct monitor_server *servers;
+static uint32_t nservers, servers_cap;
+
+static struct monitor_flight flights[65536];
+static struct monitor_fifo_entry *fifo;
+static uint32_t fifo_head, fifo_n;
+
+static uint32_t *scratch; //window latencies being sorted for percentiles
+static volatile sig_atomic_t monitor_stop;
+static unsigned long mismatched;
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static void monitor_signal(int sig){
+    (void)sig;
+    monitor_stop = 1;
+}
+
+//splits next whitespace separated word off 'line', returns its length (0 = no more words)
+static size_t monitor_word(const char **line, size_t *len, const char **word){
+    while (*len > 0 && (**line == ' ' || **line == '\t')){
+        (*line)++;
+        (*len)--;
+    }
+    *word = *line;
+    size_t n = 0;
+    while (n < *len && (*line)[n] != ' ' && (*line)[n] != '\t'){
+        n++;
+    }
+    *line += n;
+    *len -= n;
+    return n;
+}
+
+//"server ADDRESS [PORT]" (literal IPv4/IPv6 address, port of '-p' if missing)
+static bool monitor_server_add(const char *line, size_t len){
+    const char *word;
+    char addr[INET6_ADDRSTRLEN], port[8];
+    size_t n = monitor_word(&line, &len, &word);
+    if (n == 0 || n >= sizeof(addr)){
+        return false;
+    }
+    memcpy(addr, word, n);
+    addr[n] = '\0';
+    long portnum = par.port;
+    if ((n = monitor_word(&line, &len, &word)) != 0){
+        char *end;
+        if (n >= sizeof(port)){
+            return false;
+        }
+        memcpy(port, word, n);
+        port[n] = '\0';
+        portnum = strtol(port, &end, 10);
+        if (*end != '\0' || !is_it_valid_port(portnum)){
+            return false;
+        }
+    }
+    if (monitor_word(&line, &len, &word) != 0){
+        return false;
+    }
+
+    if (nservers == servers_cap){
+        servers_cap = servers_cap ? servers_cap * 2 : 64;
+        if ((servers = realloc(servers, servers_cap * sizeof(*servers))) == NULL){
+            fprintf(stderr, "ERROR: memory allocation failure\r\n");
+            exit(1);
+        }
+    }
+    struct monitor_server *s = &servers[nservers];
+    memset(s, 0, sizeof(*s));
+    struct sockaddr_in *in4 = (struct sockaddr_in *)&s->addr;
+    struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)&s->addr;
+    if (inet_pton(AF_INET, addr, &in4->sin_addr) == 1){
+        in4->sin_family = AF_INET;
+        in4->sin_port = htons((uint16_t)portnum);
+        s->addr_len = sizeof(*in4);
+    } else if (inet_pton(AF_INET6, addr, &in6->sin6_addr) == 1){
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons((uint16_t)portnum);
+        s->addr_len = sizeof(*in6);
+    } else {
+        return false;
+    }
+    snprintf(s->name, sizeof(s->name), "%s#%ld", addr, portnum);
+    nservers++;
+    return true;
+}
+
+//"query NAME [TYPE]" (type A if missing)
+static bool monitor_query_add(const char *line, size_t len){
+    const char *name, *word;
+    size_t nlen = monitor_word(&line, &len, &name);
+    size_t n = monitor_word(&line, &len, &word);
+    uint16_t qtype = DNS_QTYPE_A;
+    if (n != 0){
+        char type[16];
+        if (n >= sizeof(type)){
+            return false;
+        }
+        memcpy(type, word, n);
+        type[n] = '\0';
+        qtype = rr_type_by_name(type);
+    }
+    if (nlen == 0 || qtype == 0 || monitor_word(&line, &len, &word) != 0){
+        return false;
+    }
+    if (nqueries == MONITOR_QUERIES_MAX){
+        fprintf(stderr, "ERROR: more than %d queries in monitor file\r\n", MONITOR_QUERIES_MAX);
+        exit(1);
+    }
+    unsigned char qname[258];
+    size_t qlen = batch_qname_build(name, nlen, qname);
+    if (qlen == 0){
+        return false;
+    }
+    dns_query_build(&queries[nqueries++], qname, qlen, qtype, par.recursion);
+    return true;
+}
+
+//reads monitor file, exits on first invalid line
+static void monitor_config_read(const char *path){
+    struct input_reader in;
+    if (input_open(&in, path) != 0){
+        exit(1);
+    }
+    const char *line, *word;
+    size_t len;
+    uint64_t offset;
+    while (input_next(&in, &line, &len, &offset)){
+        const char *rest = line;
+        size_t rlen = len;
+        size_t n = monitor_word(&rest, &rlen, &word);
+        bool valid = (n == 6 && strncasecmp(word, "server", 6) == 0) ? monitor_server_add(rest, rlen) :
+                     (n == 5 && strncasecmp(word, "query", 5) == 0) ? monitor_query_add(rest, rlen) : false;
+        if (!valid){
+            fprintf(stderr, "ERROR: invalid line in monitor file (expected \"server ADDRESS [PORT]\" or "
+                            "\"query NAME [TYPE]\"): %.*s\r\n", (int)len, line);
+            exit(1);
+        }
+    }
+    input_close(&in);
+}
+
+//non-blocking unconnected socket of given family (replies of all its servers arrive there)
+static int monitor_socket(int family){
+    int fd = socket(family, SOCK_DGRAM, 0);
+    if (fd < 0){
+        perror("ERROR: socket");
+        exit(1);
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &par.rcvbuf, sizeof(par.rcvbuf));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &par.sndbuf, sizeof(par.sndbuf));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+//reply came from the server the query was sent to (address and port)
+static bool monitor_same_addr(const struct sockaddr_storage *a, const struct monitor_server *s){
+    if (a->ss_family != s->addr.ss_family){
+        return false;
+    }
+    if (a->ss_family == AF_INET){
+        const struct sockaddr_in *x = (const struct sockaddr_in *)a, *y = (const struct sockaddr_in *)&s->addr;
+        return x->sin_port == y->sin_port && x->sin_addr.s_addr == y->sin_addr.s_addr;
+    }
+    const struct sockaddr_in6 *x = (const struct sockaddr_in6 *)a, *y = (const struct sockaddr_in6 *)&s->addr;
+    return x->sin6_port == y->sin6_port && memcmp(&x->sin6_addr, &y->sin6_addr, sizeof(x->sin6_addr)) == 0;
+}
+
+static int monitor_cmp(const void *a, const void *b){
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+//nearest-rank percentile of 'n' sorted latencies, in milliseconds
+static double monitor_percentile(const uint32_t *sorted, uint32_t n, double p){
+    uint32_t rank = (uint32_t)(p * (double)n + 0.999999);
+    return (double)sorted[(rank > 0) ? rank - 1 : 0] / 1000.0;
+}
+
+//sends every query to server 's' (a query the socket refuses counts as lost right away)
+static void monitor_round_start(uint32_t si, uint64_t now, uint64_t timeout_ns, int fd4, int fd6, uint16_t *next_id){
+    struct monitor_server *s = &servers[si];
+    int fd = (s->addr.ss_family == AF_INET6) ? fd6 : fd4;
+    s->active = true;
+    s->deadline = now + timeout_ns;
+    s->pending = 0;
+    s->err = 0;
+    for (uint32_t q = 0; q < nqueries; q++){
+        while (flights[*next_id].used){
+            (*next_id)++;
+        }
+        uint16_t nid = htons(*next_id);
+        memcpy(queries[q].pkt, &nid, sizeof(nid));
+        s->round[q] = MONITOR_FAILED;
+        if (sendto(fd, queries[q].pkt, queries[q].len, 0, (struct sockaddr *)&s->addr, s->addr_len) < 0){
+            continue;
+        }
+        metric_add(METRIC_QUERIES, 1);
+        metric_add(METRIC_BYTES_OUT, queries[q].len);
+        flights[*next_id] = (struct monitor_flight){true, si, q, now};
+        s->ids[q] = *next_id;
+        s->round[q] = MONITOR_PENDING;
+        s->pending++;
+        s->sent++;
+        (*next_id)++;
+    }
+    fifo[(fifo_head + fifo_n) % (nservers + 1)] = (struct monitor_fifo_entry){si, s->deadline};
+    fifo_n++;
+}
+
+//closes round of server 's' (unanswered queries are lost), moves it into the window and prints its line
+static void monitor_round_finish(struct monitor_server *s){
+    uint32_t ok = 0, lost = 0;
+    uint64_t sum = 0, max = 0;
+    for (uint32_t q = 0; q < nqueries; q++){
+        if (s->round[q] == MONITOR_PENDING){
+            flights[s->ids[q]].used = false;
+            s->round[q] = MONITOR_FAILED;
+            metric_add(METRIC_TIMEOUTS, 1);
+        }
+        if (s->round[q] == MONITOR_FAILED){
+            lost++;
+        } else {
+            ok++;
+            sum += s->round[q];
+            max = (s->round[q] > max) ? s->round[q] : max;
+        }
+        s->window[s->wpos] = s->round[q];
+        s->wpos = (s->wpos + 1) % (MONITOR_WINDOW_ROUNDS * nqueries);
+    }
+    lost -= s->err; //error rcodes were stored as failures too
+    s->wcount = (s->wcount + nqueries > MONITOR_WINDOW_ROUNDS * nqueries) ? MONITOR_WINDOW_ROUNDS * nqueries : s->wcount + nqueries;
+    s->active = false;
+    s->rounds++;
+    s->ok += ok;
+    s->lost += lost;
+
+  //rolling window (successful latencies sorted for percentiles)
+    uint32_t wok = 0;
+    for (uint32_t i = 0; i < s->wcount; i++){
+        if (s->window[i] != MONITOR_FAILED){
+            scratch[wok++] = s->window[i];
+        }
+    }
+    qsort(scratch, wok, sizeof(uint32_t), monitor_cmp);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    fprintf(stdout, "%lld.%03ld %s ok=%u/%u err=%u lost=%u", (long long)ts.tv_sec, ts.tv_nsec / 1000000, s->name,
+            ok, nqueries, s->err, lost);
+    if (ok > 0){
+        fprintf(stdout, " avg=%.3f max=%.3f", (double)sum / ok / 1000.0, (double)max / 1000.0);
+    } else {
+        fprintf(stdout, " avg=- max=-");
+    }
+    fprintf(stdout, " win=%.2f%%", 100.0 * (double)wok / (double)s->wcount);
+    if (wok > 0){
+        fprintf(stdout, " p50=%.3f p90=%.3f p99=%.3f\r\n", monitor_percentile(scratch, wok, 0.5),
+                monitor_percentile(scratch, wok, 0.9), monitor_percentile(scratch, wok, 0.99));
+    } else {
+        fprintf(stdout, " p50=- p90=- p99=-\r\n");
+    }
+}
+
+//matches reply to its outstanding query (same ID, source and question), returns server whose round it completed
+static struct monitor_server *monitor_reply(unsigned char *buf, size_t len, const struct sockaddr_storage *from, uint64_t now){
+    struct dns_header_t *dns = (struct dns_header_t *)buf;
+    metric_add(METRIC_BYTES_IN, len);
+    if (len < sizeof(*dns) || dns->qr != 1){
+        mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return NULL;
+    }
+    struct monitor_flight *f = &flights[ntohs(dns->id)];
+    if (!f->used || !monitor_same_addr(from, &servers[f->server])){
+        mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return NULL;
+    }
+    const struct dns_query_t *q = &queries[f->query];
+    if (len < q->len || memcmp(buf + sizeof(*dns), q->pkt + sizeof(*dns), q->len - sizeof(*dns)) != 0){
+        mismatched++;
+        metric_add(METRIC_MISMATCHED, 1);
+        return NULL;
+    }
+    struct monitor_server *s = &servers[f->server];
+    f->used = false;
+    s->pending--;
+    metric_add(METRIC_RCODE + dns->rcode, 1);
+    if (dns->tc){
+        metric_add(METRIC_TRUNCATED, 1);
+    }
+    if (dns->rcode == 0 || dns->rcode == 3){ //NOERROR and NXDOMAIN are healthy answers
+        s->round[f->query] = (uint32_t)((now - f->sent) / 1000);
+    } else {
+        s->round[f->query] = MONITOR_FAILED;
+        s->err++;
+    }
+    return (s->pending == 0) ? s : NULL;
+}
+
+/*************************************************
+ *                    MONITOR                    *
+*************************************************/
+int monitor_run(){
+  //servers and query packets are set up before the first round
+    monitor_config_read(par.monitorfile);
+    if (nservers == 0 || nqueries == 0){
+        fprintf(stderr, "ERROR: monitor file needs at least one 'server' and one 'query' line: %s\r\n", par.monitorfile);
+        return 1;
+    }
+    if ((uint64_t)nservers * nqueries >= 65536){
+        fprintf(stderr, "ERROR: servers times queries per round exceeds 65535 transaction IDs\r\n");
+        return 1;
+    }
+    uint32_t wsize = MONITOR_WINDOW_ROUNDS * nqueries;
+    uint32_t *slab = calloc((size_t)nservers * (wsize + nqueries) + wsize, sizeof(uint32_t));
+    uint16_t *ids = calloc((size_t)nservers * nqueries, sizeof(uint16_t));
+    fifo = calloc(nservers + 1, sizeof(*fifo));
+    if (slab == NULL || ids == NULL || fifo == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    scratch = slab;
+    int fd4 = -1, fd6 = -1;
+    for (uint32_t i = 0; i < nservers; i++){
+        servers[i].window = slab + wsize + (size_t)i * (wsize + nqueries);
+        servers[i].round = servers[i].window + wsize;
+        servers[i].ids = ids + (size_t)i * nqueries;
+        if (servers[i].addr.ss_family == AF_INET && fd4 < 0){
+            fd4 = monitor_socket(AF_INET);
+        } else if (servers[i].addr.ss_family == AF_INET6 && fd6 < 0){
+            fd6 = monitor_socket(AF_INET6);
+        }
+    }
+
+  //SIGINT/SIGTERM stop starting rounds, the ones in progress still finish
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = monitor_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+  //rounds of consecutive servers start 'interval / servers' apart (every server once per interval)
+    srandom((unsigned int)(batch_now_ns() ^ (uint64_t)getpid()));
+    uint16_t next_id = (uint16_t)random();
+    uint64_t interval_ns = (uint64_t)(par.interval * 1e9);
+    uint64_t timeout_ns = (uint64_t)(((par.timeout < par.interval) ? par.timeout : par.interval) * 1e9);
+    uint64_t start = batch_now_ns();
+    uint64_t stop_at = par.duration > 0 ? start + (uint64_t)(par.duration * 1e9) : 0;
+    uint64_t turn = 0; //rounds started so far (server 'turn % nservers' is next)
+    bool running = true;
+    unsigned char buf[65536];
+    struct pollfd pfds[2] = {{.fd = fd4, .events = POLLIN, .revents = 0}, {.fd = fd6, .events = POLLIN, .revents = 0}};
+
+    while (running || fifo_n > 0){
+        uint64_t now = batch_now_ns();
+        bool printed = false;
+
+      //rounds past their deadline (FIFO is in start order, entries of rounds finished early are skipped)
+        while (fifo_n > 0){
+            struct monitor_fifo_entry *e = &fifo[fifo_head];
+            struct monitor_server *s = &servers[e->server];
+            if (s->active && s->deadline == e->deadline){
+                if (now < e->deadline){
+                    break;
+                }
+                monitor_round_finish(s);
+                printed = true;
+            }
+            fifo_head = (fifo_head + 1) % (nservers + 1);
+            fifo_n--;
+        }
+
+      //start every round due
+        uint64_t due = start + turn * interval_ns / nservers;
+        if (running && (monitor_stop || (stop_at != 0 && due >= stop_at))){
+            running = false;
+        }
+        while (running && now >= due){
+            uint32_t si = (uint32_t)(turn % nservers);
+            if (!servers[si].active){ //(always true, timeout is capped to interval)
+                monitor_round_start(si, now, timeout_ns, fd4, fd6, &next_id);
+            }
+            turn++;
+            due = start + turn * interval_ns / nservers;
+            if (stop_at != 0 && due >= stop_at){
+                running = false;
+            }
+        }
+
+      //wait for replies until next round starts or oldest round in progress times out
+        uint64_t wake = running ? due : UINT64_MAX;
+        if (fifo_n > 0 && fifo[fifo_head].deadline < wake){
+            wake = fifo[fifo_head].deadline;
+        }
+        now = batch_now_ns();
+        struct timespec ts = {0, 0};
+        if (wake == UINT64_MAX){
+            ts.tv_sec = 1;
+        } else if (wake > now){
+            ts.tv_sec = (time_t)((wake - now) / 1000000000ULL);
+            ts.tv_nsec = (long)((wake - now) % 1000000000ULL);
+        }
+        if (ppoll(pfds, 2, &ts, NULL) > 0){
+            for (int i = 0; i < 2; i++){
+                if (!(pfds[i].revents & POLLIN)){
+                    continue;
+                }
+                ssize_t n;
+                struct sockaddr_storage from;
+                socklen_t from_len = sizeof(from);
+                while ((n = recvfrom(pfds[i].fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len)) >= 0 ||
+                       errno == ECONNREFUSED){ //ICMP errors aren't replies
+                    from_len = sizeof(from);
+                    struct monitor_server *s = (n >= 0) ? monitor_reply(buf, (size_t)n, &from, batch_now_ns()) : NULL;
+                    if (s != NULL){
+                        monitor_round_finish(s); //all replies in, FIFO entry becomes stale
+                        printed = true;
+                    }
+                }
+            }
+        }
+        if (printed){
+            fflush(stdout);
+        }
+    }
+
+    unsigned long sent = 0, ok = 0, lost = 0, rounds = 0;
+    for (uint32_t i = 0; i < nservers; i++){
+        sent += servers[i].sent;
+        ok += servers[i].ok;
+        lost += servers[i].lost;
+        rounds += servers[i].rounds;
+    }
+    fprintf(stderr, "Monitor: %u servers, %u queries per round, %lu rounds, %lu queries sent, %lu answered, "
+                    "%lu lost, %lu unmatched replies\r\n", nservers, nqueries, rounds, sent, ok, lost, mismatched);
+    if (fd4 >= 0){
+        close(fd4);
+    }
+    if (fd6 >= 0){
+        close(fd6);
+    }
+    free(slab);
+    free(ids);
+    free(fifo);
+    free(servers);
+    return 0;
+}
@@ -0,0 +1,45 @@
+/** @file:   monitor.h
+ *  @brief:  Probe mode (--monitor): fixed query set sent to a list of servers every interval, rolling health lines
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include "dns.h"
+
+#define MONITOR_WINDOW_ROUNDS 60  //rounds the rolling per-server success rate and latency percentiles cover
+#define MONITOR_QUERIES_MAX   32  //queries sent to every server per round
+#define MONITOR_PENDING       0xfffffffeU //round sample: query still waiting for its reply
+#define MONITOR_FAILED        0xffffffffU //round/window sample: query lost or answered with an error rcode
+
+/**
+ * @struct: monitored server (one round of queries in progress at most)
+*/
+struct monitor_server{
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    char name[INET6_ADDRSTRLEN + 8]; /* "address#port" as printed */
+    bool active;            /* round in progress */
+    uint64_t deadline;      /* monotonic ns the round in progress gives up at */
+    uint32_t pending;       /* queries of round in progress without reply */
+    uint32_t err;           /* replies of round in progress with rcode other than NOERROR/NXDOMAIN */
+    uint16_t *ids;          /* transaction ID of every query of round in progress */
+    uint32_t *round;        /* latency (us) of every query of round in progress, MONITOR_PENDING/MONITOR_FAILED */
+    uint32_t *window;       /* last MONITOR_WINDOW_ROUNDS rounds of samples (latency in us or MONITOR_FAILED) */
+    uint32_t wpos, wcount;
+    unsigned long rounds, sent, ok, lost;
+};
+
+/**
+ * @function: monitor_run
+ * @brief reads servers and queries from 'par.monitorfile', sends every query to every server each 'par.interval'
+ *        seconds (servers staggered across the interval) for 'par.duration' seconds or until SIGINT/SIGTERM, and
+ *        prints one line per finished round with its result and the server's rolling window statistics
+ *
+ * @return exit code of the program (0 if successful, 1 otherwise)
+*/
+int monitor_run();
+
+#endif
@@ -0,0 +1,203 @@
+/** @file:   namenorm.c
+ *  @brief:  Bulk hostname normalization (lowercase, validate, DNSname encode) with SSE2/AVX2 kernels
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "namenorm.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/* All kernels work the same way: hostname bytes are lowercased and stored one position to
+ * the right in 'wire' (wire[i + 1] = in[i]), character classes are checked and positions of
+ * dots are collected. 'name_labels_finish' then replaces every dot (and wire[0]) with the
+ * length of the label that follows it - which is exactly the DNSname encoding. */
+
+static name_norm_fn name_norm_best = NULL; //kernel chosen for this CPU
+static const char *name_norm_best_name = "scalar";
+static pthread_once_t name_norm_once = PTHREAD_ONCE_INIT; //kernel is chosen once, whichever thread normalizes first
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//label lengths and edges check, dots --> length bytes
+static size_t name_labels_finish(unsigned char *wire, size_t len, const uint8_t *dots, int ndots){
+    size_t start = 0; //first char of current label (in hostname positions)
+    for (int d = 0; d <= ndots; d++){
+        size_t end = (d < ndots) ? dots[d] : len; //position of dot ending the label
+        size_t label = end - start;
+        if (label == 0 || label > NAME_LABEL_MAX || wire[start + 1] == '-' || wire[end] == '-'){
+            return 0;
+        }
+        wire[start] = (unsigned char)label; //dot before label (or wire[0]) becomes its length
+        start = end + 1;
+    }
+    wire[len + 1] = 0;
+    return len + 2;
+}
+
+//strip one trailing dot, check total length
+static bool name_len_check(const char *in, size_t *len){
+    if (*len > 0 && in[*len - 1] == '.'){
+        (*len)--;
+    }
+    return *len > 0 && *len <= NAME_MAX_LEN;
+}
+
+//byte-at-a-time tail shared by all kernels, returns 'false' on invalid char
+static bool name_scalar_part(const char *in, size_t from, size_t len, unsigned char *wire, uint8_t *dots, int *ndots){
+    for (size_t i = from; i < len; i++){
+        unsigned char c = (unsigned char)in[i];
+        if (c >= 'A' && c <= 'Z'){
+            c |= 0x20;
+        } else if (c == '.'){
+            dots[(*ndots)++] = (uint8_t)i;
+        } else if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_')){
+            return false;
+        }
+        wire[i + 1] = c;
+    }
+    return true;
+}
+
+/*************************************************
+ *                    KERNELS                    *
+*************************************************/
+//portable kernel
+size_t name_normalize_scalar(const char *in, size_t len, unsigned char *wire){
+    uint8_t dots[NAME_MAX_LEN];
+    int ndots = 0;
+    if (!name_len_check(in, &len) || !name_scalar_part(in, 0, len, wire, dots, &ndots)){
+        return 0;
+    }
+    return name_labels_finish(wire, len, dots, ndots);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+//collect set bits of 'mask' as dot positions (starting at 'base')
+static inline void name_dots_collect(uint32_t mask, size_t base, uint8_t *dots, int *ndots){
+    while (mask){
+        dots[(*ndots)++] = (uint8_t)(base + (size_t)__builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+}
+
+//one 16 byte block, returns 'false' on invalid char
+__attribute__((target("sse2")))
+static inline bool name_sse2_block(const char *in, size_t i, unsigned char *wire, uint8_t *dots, int *ndots){
+    const __m128i A_1 = _mm_set1_epi8('A' - 1), Z_1 = _mm_set1_epi8('Z' + 1);
+    const __m128i a_1 = _mm_set1_epi8('a' - 1), z_1 = _mm_set1_epi8('z' + 1);
+    const __m128i d0_1 = _mm_set1_epi8('0' - 1), d9_1 = _mm_set1_epi8('9' + 1);
+    const __m128i hyphen = _mm_set1_epi8('-'), uscore = _mm_set1_epi8('_'), dot = _mm_set1_epi8('.'), bit5 = _mm_set1_epi8(0x20);
+
+    __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+    //lowercase ('A'..'Z' get bit 5 set; signed compares leave bytes >= 0x80 out)
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, A_1), _mm_cmplt_epi8(v, Z_1));
+    v = _mm_or_si128(v, _mm_and_si128(upper, bit5));
+    //character classes
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(v, a_1), _mm_cmplt_epi8(v, z_1));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, d0_1), _mm_cmplt_epi8(v, d9_1));
+    __m128i dots_v = _mm_cmpeq_epi8(v, dot);
+    __m128i sym = _mm_or_si128(_mm_cmpeq_epi8(v, hyphen), _mm_cmpeq_epi8(v, uscore));
+    __m128i ok = _mm_or_si128(_mm_or_si128(letter, digit), _mm_or_si128(sym, dots_v));
+    if (_mm_movemask_epi8(ok) != 0xffff){
+        return false;
+    }
+    _mm_storeu_si128((__m128i *)(wire + 1 + i), v);
+    name_dots_collect((uint32_t)_mm_movemask_epi8(dots_v), i, dots, ndots);
+    return true;
+}
+
+//16 bytes at a time
+__attribute__((target("sse2")))
+size_t name_normalize_sse2(const char *in, size_t len, unsigned char *wire){
+    uint8_t dots[NAME_MAX_LEN];
+    int ndots = 0;
+    if (!name_len_check(in, &len)){
+        return 0;
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16){
+        if (!name_sse2_block(in, i, wire, dots, &ndots)){
+            return 0;
+        }
+    }
+    if (!name_scalar_part(in, i, len, wire, dots, &ndots)){
+        return 0;
+    }
+    return name_labels_finish(wire, len, dots, ndots);
+}
+
+//32 bytes at a time
+__attribute__((target("avx2")))
+size_t name_normalize_avx2(const char *in, size_t len, unsigned char *wire){
+    uint8_t dots[NAME_MAX_LEN];
+    int ndots = 0;
+    if (!name_len_check(in, &len)){
+        return 0;
+    }
+
+    const __m256i A_1 = _mm256_set1_epi8('A' - 1), Z_1 = _mm256_set1_epi8('Z' + 1);
+    const __m256i a_1 = _mm256_set1_epi8('a' - 1), z_1 = _mm256_set1_epi8('z' + 1);
+    const __m256i d0_1 = _mm256_set1_epi8('0' - 1), d9_1 = _mm256_set1_epi8('9' + 1);
+    const __m256i hyphen = _mm256_set1_epi8('-'), uscore = _mm256_set1_epi8('_'), dot = _mm256_set1_epi8('.'), bit5 = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32){
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, A_1), _mm256_cmpgt_epi8(Z_1, v));
+        v = _mm256_or_si256(v, _mm256_and_si256(upper, bit5));
+        __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(v, a_1), _mm256_cmpgt_epi8(z_1, v));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, d0_1), _mm256_cmpgt_epi8(d9_1, v));
+        __m256i dots_v = _mm256_cmpeq_epi8(v, dot);
+        __m256i sym = _mm256_or_si256(_mm256_cmpeq_epi8(v, hyphen), _mm256_cmpeq_epi8(v, uscore));
+        __m256i ok = _mm256_or_si256(_mm256_or_si256(letter, digit), _mm256_or_si256(sym, dots_v));
+        if ((uint32_t)_mm256_movemask_epi8(ok) != 0xffffffffu){
+            return 0;
+        }
+        _mm256_storeu_si256((__m256i *)(wire + 1 + i), v);
+        name_dots_collect((uint32_t)_mm256_movemask_epi8(dots_v), i, dots, &ndots);
+    }
+    if (i + 16 <= len){ //one more 16 byte block before the scalar tail
+        if (!name_sse2_block(in, i, wire, dots, &ndots)){
+            return 0;
+        }
+        i += 16;
+    }
+    if (!name_scalar_part(in, i, len, wire, dots, &ndots)){
+        return 0;
+    }
+    return name_labels_finish(wire, len, dots, ndots);
+}
+#endif
+
+/*************************************************
+ *                   DISPATCH                    *
+*************************************************/
+//pick fastest kernel for this CPU
+static void name_norm_init(){
+    name_norm_best = name_normalize_scalar;
+    name_norm_best_name = "scalar";
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")){
+        name_norm_best = name_normalize_avx2;
+        name_norm_best_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")){
+        name_norm_best = name_normalize_sse2;
+        name_norm_best_name = "sse2";
+    }
+#endif
+}
+
+size_t name_normalize(const char *in, size_t len, unsigned char *wire){
+    pthread_once(&name_norm_once, name_norm_init);
+    return name_norm_best(in, len, wire);
+}
+
+const char *name_norm_impl(){
+    pthread_once(&name_norm_once, name_norm_init);
+    return name_norm_best_name;
+}
@@ -0,0 +1,62 @@
+/** @file:   namenorm.h
+ *  @brief:  Bulk hostname normalization (lowercase, validate, DNSname encode) with SSE2/AVX2 kernels
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef NAMENORM_H
+#define NAMENORM_H
+
+#include "dns.h"
+
+#define NAME_MAX_LEN   253 //longest hostname (without trailing dot)
+#define NAME_LABEL_MAX 63  //longest label
+
+/**
+ * @typedef: name_norm_fn
+ * @brief normalizes hostname straight into lowercase DNSname (www.Google.com --> 3www6google3com0),
+ *        validating it on the way (letters, digits, '_' for service labels, '-' not at label edges, label and name lengths)
+ *
+ * @param[in] in:   hostname (not NUL terminated, one trailing dot allowed)
+ * @param[in] len:  length of @param in
+ * @param[in] wire: buffer (at least @param len + 2 chars) to save resulting DNSname into
+ * @return length of DNSname including the terminating zero, 0 if @param in isn't a valid hostname
+*/
+typedef size_t (*name_norm_fn)(const char *in, size_t len, unsigned char *wire);
+
+/**
+ * @function: name_normalize
+ * @brief normalizes hostname using the fastest kernel this CPU supports (chosen at first call)
+ *        see 'name_norm_fn' for parameters
+*/
+size_t name_normalize(const char *in, size_t len, unsigned char *wire);
+
+/**
+ * @function: name_normalize_scalar
+ * @brief portable byte-at-a-time kernel, see 'name_norm_fn' for parameters
+*/
+size_t name_normalize_scalar(const char *in, size_t len, unsigned char *wire);
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @function: name_normalize_sse2
+ * @brief 16 bytes at a time kernel, see 'name_norm_fn' for parameters
+*/
+size_t name_normalize_sse2(const char *in, size_t len, unsigned char *wire);
+
+/**
+ * @function: name_normalize_avx2
+ * @brief 32 bytes at a time kernel (only call if CPU supports AVX2), see 'name_norm_fn' for parameters
+*/
+size_t name_normalize_avx2(const char *in, size_t len, unsigned char *wire);
+#endif
+
+/**
+ * @function: name_norm_impl
+ * @brief name of kernel 'name_normalize' dispatches to ("avx2", "sse2" or "scalar")
+ *
+ * @return kernel name
+*/
+const char *name_norm_impl();
+
+#endif
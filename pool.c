@@ -0,0 +1,288 @@
+/** @file:   pool.c
+ *  @brief:  Batch server pool ('-s a,b,c'): names spread over servers by consistent hashing, failover to ring successors
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "pool.h"
+
+#include <strings.h> //strncasecmp
+
+//second level labels under which registrations happen one level deeper (co.uk, com.au, ...)
+static const char *pool_slds[] = {"ac", "co", "com", "edu", "gov", "ne", "net", "or", "org", NULL};
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//case insensitive FNV-1a, finished with a murmur3 mix (FNV alone clusters similar names on the ring)
+static uint32_t pool_hash(const unsigned char *s, size_t len){
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++){
+        h = (h ^ (uint32_t)tolower(s[i])) * 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+//label at 'label' (length byte first) equals 'text'
+static bool pool_label_is(const unsigned char *label, const char *text){
+    return label[0] == strlen(text) && strncasecmp((const char *)&label[1], text, label[0]) == 0;
+}
+
+static int pool_vnode_cmp(const void *a, const void *b){
+    const struct pool_vnode *x = a, *y = b;
+    if (x->point != y->point){
+        return (x->point > y->point) - (x->point < y->point);
+    }
+    return (x->server > y->server) - (x->server < y->server); //same order whatever order servers were listed in
+}
+
+//"host" or "host#port" --> address of given family
+static bool pool_resolve(struct pool_server *s, const char *entry, int family){
+    char host[128];
+    long port = par.port;
+    const char *hash = strchr(entry, '#');
+    size_t len = hash ? (size_t)(hash - entry) : strlen(entry);
+    if (len >= sizeof(host)){
+        return false;
+    }
+    memcpy(host, entry, len);
+    host[len] = '\0';
+    if (hash != NULL){
+        port = strtol(hash + 1, NULL, 10);
+    }
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0){
+        return false;
+    }
+    memcpy(&s->addr, res->ai_addr, res->ai_addrlen);
+    s->addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    char addr[INET6_ADDRSTRLEN];
+    if (family == AF_INET6){
+        ((struct sockaddr_in6 *)&s->addr)->sin6_port = htons((uint16_t)port);
+        inet_ntop(AF_INET6, &((struct sockaddr_in6 *)&s->addr)->sin6_addr, addr, sizeof(addr));
+    } else {
+        ((struct sockaddr_in *)&s->addr)->sin_port = htons((uint16_t)port);
+        inet_ntop(AF_INET, &((struct sockaddr_in *)&s->addr)->sin_addr, addr, sizeof(addr));
+    }
+    snprintf(s->name, sizeof(s->name), "%s#%ld", addr, port);
+    return true;
+}
+
+//server takes new queries (a down one only takes its single probe query, once its out period is over)
+static bool pool_usable(struct pool_server *s, uint64_t now){
+    return !s->down || (now >= s->retry_at && s->inflight == 0);
+}
+
+//first ring point at or clockwise after 'key'
+static unsigned int pool_first(struct pool *p, uint32_t key){
+    unsigned int lo = 0, hi = p->nvnodes;
+    while (lo < hi){
+        unsigned int mid = lo + (hi - lo) / 2;
+        if (p->ring[mid].point < key){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo == p->nvnodes) ? 0 : lo;
+}
+
+/*************************************************
+ *                  SERVER POOL                  *
+*************************************************/
+int pool_open(struct pool *p, int family, uint64_t now){
+    memset(p, 0, sizeof(*p));
+    p->nservers = par.nservers;
+    p->nvnodes = p->nservers * POOL_VNODES;
+    p->servers = calloc(p->nservers, sizeof(struct pool_server));
+    p->ring = malloc(p->nvnodes * sizeof(struct pool_vnode));
+    if (p->servers == NULL || p->ring == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        pool_close(p);
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < p->nservers; i++){
+        struct pool_server *s = &p->servers[i];
+        if (!pool_resolve(s, par.servers[i], family)){
+            fprintf(stderr, "ERROR: couldn't resolve server %s as %s (all servers have to share the address family of the first one)\r\n",
+                    par.servers[i], (family == AF_INET6) ? "IPv6" : "IPv4");
+            pool_close(p);
+            return 1;
+        }
+        for (unsigned int j = 0; j < i; j++){
+            if (strcmp(p->servers[j].name, s->name) == 0){
+                fprintf(stderr, "ERROR: server %s listed more than once\r\n", s->name);
+                pool_close(p);
+                return 1;
+            }
+        }
+        batch_pacer_init(&s->pacer, now);
+        s->backoff_ns = (uint64_t)POOL_RETRY_MS * 1000000ULL;
+
+      //ring points from the resolved address, so the mapping doesn't depend on how the server was written
+        for (unsigned int v = 0; v < POOL_VNODES; v++){
+            char point[sizeof(s->name) + 8];
+            int len = snprintf(point, sizeof(point), "%s#%u", s->name, v);
+            p->ring[i * POOL_VNODES + v].point = pool_hash((const unsigned char *)point, (size_t)len);
+            p->ring[i * POOL_VNODES + v].server = i;
+        }
+    }
+    qsort(p->ring, p->nvnodes, sizeof(struct pool_vnode), pool_vnode_cmp);
+    return 0;
+}
+
+uint32_t pool_key(const unsigned char *qname){
+    const unsigned char *labels[3] = {qname, qname, qname}; //starts of the last three labels
+    unsigned int nlabels = 0;
+    const unsigned char *l;
+    for (l = qname; *l; l += *l + 1){
+        labels[0] = labels[1];
+        labels[1] = labels[2];
+        labels[2] = l;
+        nlabels++;
+    }
+    size_t len = (size_t)(l - qname);
+
+  //registrable domain (no public suffix list at hand, so a rule of thumb)
+    if (nlabels <= 2 || pool_label_is(labels[2], "arpa")){ //reverse names share 'in-addr.arpa', key them by all of it
+        return pool_hash(qname, len);
+    }
+    const unsigned char *start = labels[1];
+    if (labels[2][0] == 2){ //country code TLD, maybe with a registry second level
+        for (int i = 0; pool_slds[i] != NULL; i++){
+            if (pool_label_is(labels[1], pool_slds[i])){
+                start = labels[0];
+                break;
+            }
+        }
+    }
+    return pool_hash(start, (size_t)(l - start));
+}
+
+unsigned int pool_pick(struct pool *p, uint32_t key, uint64_t now, bool *failover){
+    *failover = false;
+    if (p->nservers == 1){
+        return 0;
+    }
+    unsigned int first = pool_first(p, key);
+    unsigned int owner = p->ring[first].server;
+    for (unsigned int i = 0; i < p->nvnodes; i++){
+        unsigned int s = p->ring[(first + i) % p->nvnodes].server;
+        if (pool_usable(&p->servers[s], now)){
+            *failover = (s != owner);
+            return s;
+        }
+    }
+    return owner; //whole pool is down, keep trying the owner
+}
+
+unsigned int pool_next(struct pool *p, uint32_t key, unsigned int after, uint64_t now){
+    if (p->nservers == 1){
+        return 0;
+    }
+
+  //servers in the order they follow the key clockwise (its preference list)
+    unsigned int order[SERVERS_MAX], n = 0, at = 0;
+    bool seen[SERVERS_MAX] = {false};
+    unsigned int first = pool_first(p, key);
+    for (unsigned int i = 0; i < p->nvnodes && n < p->nservers; i++){
+        unsigned int s = p->ring[(first + i) % p->nvnodes].server;
+        if (!seen[s]){
+            seen[s] = true;
+            if (s == after){
+                at = n;
+            }
+            order[n++] = s;
+        }
+    }
+    for (unsigned int i = 1; i < n; i++){
+        unsigned int s = order[(at + i) % n];
+        if (pool_usable(&p->servers[s], now)){
+            return s;
+        }
+    }
+    return after;
+}
+
+int pool_find(struct pool *p, const struct sockaddr_storage *from){
+    for (unsigned int i = 0; i < p->nservers; i++){
+        const struct sockaddr_storage *a = &p->servers[i].addr;
+        if (from->ss_family != a->ss_family){
+            continue;
+        }
+        if (from->ss_family == AF_INET6){
+            const struct sockaddr_in6 *x = (const struct sockaddr_in6 *)from, *y = (const struct sockaddr_in6 *)a;
+            if (x->sin6_port == y->sin6_port && memcmp(&x->sin6_addr, &y->sin6_addr, sizeof(struct in6_addr)) == 0){
+                return (int)i;
+            }
+        } else {
+            const struct sockaddr_in *x = (const struct sockaddr_in *)from, *y = (const struct sockaddr_in *)a;
+            if (x->sin_port == y->sin_port && x->sin_addr.s_addr == y->sin_addr.s_addr){
+                return (int)i;
+            }
+        }
+    }
+    return -1;
+}
+
+void pool_reply(struct pool *p, unsigned int i, uint64_t now){
+    struct pool_server *s = &p->servers[i];
+    s->answered++;
+    s->fails = 0;
+    s->last_reply = now;
+    if (s->down){ //probe (or a late reply) came back, its keys return to it
+        s->down = false;
+        s->backoff_ns = (uint64_t)POOL_RETRY_MS * 1000000ULL;
+    }
+}
+
+void pool_timeout(struct pool *p, unsigned int i, uint64_t sent, uint64_t now){
+    struct pool_server *s = &p->servers[i];
+    s->timeouts++;
+    if (sent < s->last_reply){ //answered something since, alive
+        return;
+    }
+    s->fails++;
+    if (!s->down){
+        if (s->fails >= POOL_DOWN_AFTER){
+            s->down = true;
+            s->downs++;
+            s->retry_at = now + s->backoff_ns;
+        }
+    } else if (now >= s->retry_at){ //probe failed (queries sent before the outage time out before it's let through)
+        s->backoff_ns *= 2;
+        if (s->backoff_ns > (uint64_t)POOL_RETRY_MAX_MS * 1000000ULL){
+            s->backoff_ns = (uint64_t)POOL_RETRY_MAX_MS * 1000000ULL;
+        }
+        s->retry_at = now + s->backoff_ns;
+    }
+}
+
+void pool_print(struct pool *p){
+    fprintf(stderr, "Pool: %u servers, %d ring points each, names keyed by registrable domain\r\n", p->nservers, POOL_VNODES);
+    for (unsigned int i = 0; i < p->nservers; i++){
+        struct pool_server *s = &p->servers[i];
+        fprintf(stderr, "      %s: %lu queries (%lu failed over to it), %lu answered, %lu timeouts, out of the ring %lu times%s, "
+                        "window %u max, srtt %.2f ms\r\n", s->name, s->queries, s->failovers, s->answered, s->timeouts, s->downs,
+                s->down ? " (still out)" : "", (unsigned int)s->pacer.cwnd_max, (double)s->pacer.srtt_ns / 1e6);
+    }
+}
+
+void pool_close(struct pool *p){
+    free(p->servers);
+    free(p->ring);
+    p->servers = NULL;
+    p->ring = NULL;
+}
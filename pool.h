@@ -0,0 +1,155 @@
+/** @file:   pool.h
+ *  @brief:  Batch server pool ('-s a,b,c'): names spread over servers by consistent hashing, failover to ring successors
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "batch.h"
+
+#define POOL_VNODES        160   //points every server takes on the hash ring (evens out the share of each server)
+#define POOL_DOWN_AFTER    3     //timeouts without any reply meanwhile after which a server is taken out of the ring
+#define POOL_RETRY_MS      1000  //how long a server stays out before one probe query is let through to it
+#define POOL_RETRY_MAX_MS  30000 //the out period doubles with every failed probe up to this
+
+/**
+ * @struct: pool server (its own pacer, so a slow server doesn't hold the window of the others down)
+*/
+struct pool_server{
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    char name[INET6_ADDRSTRLEN + 8]; /* "address#port" as printed */
+    struct batch_pacer pacer;
+    unsigned int inflight;   /* queries currently waiting for this server */
+    unsigned int fails;      /* timeouts of queries sent after the last reply (any reply resets it) */
+    uint64_t last_reply;     /* monotonic ns of the last reply */
+    bool down;               /* out of the ring, its names go to their next server clockwise */
+    uint64_t retry_at;       /* monotonic ns a down server gets its next probe query */
+    uint64_t backoff_ns;     /* current out period */
+    unsigned long queries;   /* sends (first tries and retransmits) */
+    unsigned long failovers; /* of them, sends this server got in place of another one */
+    unsigned long answered, timeouts, downs;
+};
+
+/**
+ * @struct: ring point (the server owns the keys between the previous point and this one)
+*/
+struct pool_vnode{
+    uint32_t point;
+    uint32_t server;
+};
+
+/**
+ * @struct: server pool and its hash ring
+ *
+ * Every server takes POOL_VNODES points on a 32-bit ring (hashes of "address#port#n"), a name is served
+ * by the server owning the first point clockwise from the hash of its key. A server going down
+ * (or being added) only moves the keys it owns - to the servers owning the next points, which are
+ * spread over the whole pool, so the moved load is spread as well.
+*/
+struct pool{
+    struct pool_server *servers;
+    unsigned int nservers;
+    struct pool_vnode *ring; /* sorted by point */
+    unsigned int nvnodes;
+};
+
+/**
+ * @function: pool_open
+ * @brief resolves servers of 'par.servers' ("host" or "host#port", port 'par.port' if missing)
+ *        and builds the hash ring
+ *
+ * @param[in] p:      pool to initialize
+ * @param[in] family: address family every server has to be reachable over (that of the batch sockets)
+ * @param[in] now:    current monotonic time (pacers start here)
+ * @return 0 if successful, 1 if not
+*/
+int pool_open(struct pool *p, int family, uint64_t now);
+
+/**
+ * @function: pool_key
+ * @brief hash of the part of a name its server is chosen by: the registrable domain, approximated
+ *        as the last two labels (three under "co.uk"-like second levels), the whole name under "arpa"
+ *
+ * @param[in] qname: DNSname (3www6google3com0)
+ * @return 32-bit ring position
+*/
+uint32_t pool_key(const unsigned char *qname);
+
+/**
+ * @function: pool_pick
+ * @brief server a new query for 'key' goes to: the owner of the key's point, or the next server clockwise
+ *        if that one is down (a down server is tried again with one probe query once its out period ends)
+ *
+ * @param[in] p:        pool
+ * @param[in] key:      ring position ('pool_key')
+ * @param[in] now:      current monotonic time
+ * @param[in] failover: set to 'true' if the owner was down and the query goes to another server
+ * @return server index
+*/
+unsigned int pool_pick(struct pool *p, uint32_t key, uint64_t now, bool *failover);
+
+/**
+ * @function: pool_next
+ * @brief server a retransmit for 'key' goes to: the next usable one clockwise after server 'after'
+ *        (which timed out), 'after' itself when it's the only usable one left
+ *
+ * @param[in] p:     pool
+ * @param[in] key:   ring position ('pool_key')
+ * @param[in] after: server the previous try went to
+ * @param[in] now:   current monotonic time
+ * @return server index
+*/
+unsigned int pool_next(struct pool *p, uint32_t key, unsigned int after, uint64_t now);
+
+/**
+ * @function: pool_find
+ * @brief pool server a datagram came from (address and port)
+ *
+ * @param[in] p:    pool
+ * @param[in] from: source address
+ * @return server index, -1 if it isn't one of the pool
+*/
+int pool_find(struct pool *p, const struct sockaddr_storage *from);
+
+/**
+ * @function: pool_reply
+ * @brief server answered, it's healthy (back in the ring if it was down)
+ *
+ * @param[in] p:   pool
+ * @param[in] i:   server index
+ * @param[in] now: current monotonic time
+*/
+void pool_reply(struct pool *p, unsigned int i, uint64_t now);
+
+/**
+ * @function: pool_timeout
+ * @brief query sent to server timed out; POOL_DOWN_AFTER of them sent after its last reply take it out
+ *        of the ring (a server still answering other queries is just losing some, its pacer deals with that)
+ *
+ * @param[in] p:    pool
+ * @param[in] i:    server index
+ * @param[in] sent: monotonic time the timed out try was sent
+ * @param[in] now:  current monotonic time
+*/
+void pool_timeout(struct pool *p, unsigned int i, uint64_t sent, uint64_t now);
+
+/**
+ * @function: pool_print
+ * @brief per-server summary to stderr (queries, failovers, answers, timeouts, outages, pacing)
+ *
+ * @param[in] p: pool
+*/
+void pool_print(struct pool *p);
+
+/**
+ * @function: pool_close
+ * @brief frees pool
+ *
+ * @param[in] p: pool
+*/
+void pool_close(struct pool *p);
+
+#endif
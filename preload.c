@@ -0,0 +1,615 @@
+/** @file:   preload.c
+ *  @brief:  LD_PRELOAD shim (libdnspreload.so) answering getaddrinfo/gethostbyname/gethostbyaddr through the resolver
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#define _GNU_SOURCE //RTLD_NEXT (the libc functions being shadowed), EAI_NODATA
+#include "dns.h"
+#include "batch.h"
+#include "namenorm.h"
+#include "addronly.h"
+#include "xfr.h"
+
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/random.h>
+
+#define PRELOAD_EXPORT __attribute__((visibility("default"))) //the rest of the library stays hidden (-fvisibility=hidden)
+
+#define PRELOAD_CACHE        1024  //cache entries (direct mapped by name and type, power of two)
+#define PRELOAD_NEG_TTL      30    //seconds NXDOMAIN and no-data answers are cached
+#define PRELOAD_TTL_MAX      86400 //longest time anything is cached
+#define PRELOAD_TIMEOUT      1000  //default ms before unanswered queries are resent ('DNS_PRELOAD_TIMEOUT')
+#define PRELOAD_TRIES        3     //sends of one query before libc is left to answer
+#define PRELOAD_HOSTS        256   //names and addresses of /etc/hosts (those are left to libc)
+#define PRELOAD_BUF          65536 //reply buffer
+#define PRELOAD_HOSTENT_BUF  2048  //static 'gethostbyname'/'gethostbyaddr' result (name, pointers, addresses)
+
+typedef int (*getaddrinfo_fn)(const char *, const char *, const struct addrinfo *, struct addrinfo **);
+typedef struct hostent *(*gethostbyname_fn)(const char *);
+typedef int (*gethostbyname_r_fn)(const char *, struct hostent *, char *, size_t, struct hostent **, int *);
+typedef struct hostent *(*gethostbyaddr_fn)(const void *, socklen_t, int);
+
+/**
+ * @struct: cached answer of one (name, type) pair
+*/
+struct preload_entry{
+    bool used;
+    uint16_t qtype;
+    uint8_t rcode;
+    uint16_t count;        /* addresses (A/AAAA) or 1 if @param ptr is set (PTR) */
+    uint64_t expires;      /* monotonic ns */
+    unsigned char qname[NAME_MAX_LEN + 2]; /* DNSname */
+    unsigned char addrs[ADDR_ONLY_MAX][16];
+    char ptr[256];         /* PTR target (printable, without trailing dot) */
+};
+
+/**
+ * @struct: shim state (set up once, on the first intercepted call)
+*/
+struct preload_state{
+    bool enabled;          /* a server is known, otherwise every call goes to libc */
+    struct sockaddr_storage server;
+    socklen_t server_len;
+    int timeout_ms;
+    bool has_v4, has_v6;   /* families with a route ('AI_ADDRCONFIG', order of results) */
+    getaddrinfo_fn real_getaddrinfo;
+    gethostbyname_fn real_gethostbyname;
+    gethostbyname_r_fn real_gethostbyname_r;
+    gethostbyaddr_fn real_gethostbyaddr;
+    pthread_mutex_t lock;  /* cache */
+    struct preload_entry cache[PRELOAD_CACHE];
+    unsigned int nhosts, nhost_addrs;
+    unsigned char hosts[PRELOAD_HOSTS][NAME_MAX_LEN + 2]; /* names of /etc/hosts (DNSname) */
+    struct{
+        int family;
+        unsigned char addr[16];
+    } host_addrs[PRELOAD_HOSTS];
+    _Atomic unsigned long lookups, hits, queries, fallbacks;
+};
+static struct preload_state pl = {.lock = PTHREAD_MUTEX_INITIALIZER};
+static pthread_once_t pl_once = PTHREAD_ONCE_INIT;
+
+//socket of calling thread (connected to the server, reopened after fork), closed when the thread exits
+static pthread_key_t pl_sock_key;
+static _Thread_local int pl_sock = -1;
+static _Thread_local pid_t pl_sock_pid;
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static void preload_sock_close(void *arg){
+    close((int)(intptr_t)arg - 1);
+}
+
+static int preload_sock(){
+    if (pl_sock >= 0 && pl_sock_pid == getpid()){
+        return pl_sock;
+    }
+    if (pl_sock >= 0){ //parent's copy, inherited over fork
+        close(pl_sock);
+    }
+    pl_sock = socket(pl.server.ss_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (pl_sock < 0){
+        return -1;
+    }
+    if (connect(pl_sock, (struct sockaddr *)&pl.server, pl.server_len) != 0){ //kernel drops datagrams from anyone else
+        close(pl_sock);
+        return pl_sock = -1;
+    }
+    pl_sock_pid = getpid();
+    pthread_setspecific(pl_sock_key, (void *)(intptr_t)(pl_sock + 1));
+    return pl_sock;
+}
+
+//family has a route (connecting a UDP socket only picks one, nothing is sent)
+static bool preload_routable(int family){
+    struct sockaddr_storage a;
+    memset(&a, 0, sizeof(a));
+    a.ss_family = (sa_family_t)family;
+    if (family == AF_INET){
+        ((struct sockaddr_in *)&a)->sin_port = htons(53);
+        inet_pton(AF_INET, "192.0.2.1", &((struct sockaddr_in *)&a)->sin_addr);
+    } else {
+        ((struct sockaddr_in6 *)&a)->sin6_port = htons(53);
+        inet_pton(AF_INET6, "2001:db8::1", &((struct sockaddr_in6 *)&a)->sin6_addr);
+    }
+    int fd = socket(family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    bool ok = (fd >= 0 && connect(fd, (struct sockaddr *)&a, (family == AF_INET) ? sizeof(struct sockaddr_in) :
+                                                                                    sizeof(struct sockaddr_in6)) == 0);
+    if (fd >= 0){
+        close(fd);
+    }
+    return ok;
+}
+
+//"address" or "address#port" into 'pl.server'
+static bool preload_server(const char *text){
+    char host[INET6_ADDRSTRLEN];
+    const char *hash = strchr(text, '#');
+    size_t len = hash ? (size_t)(hash - text) : strlen(text);
+    long port = 53;
+    if (len == 0 || len >= sizeof(host)){
+        return false;
+    }
+    memcpy(host, text, len);
+    host[len] = '\0';
+    if (hash != NULL){
+        char *end;
+        port = strtol(hash + 1, &end, 10);
+        if (end == hash + 1 || *end != '\0' || !is_it_valid_port(port)){
+            return false;
+        }
+    }
+    memset(&pl.server, 0, sizeof(pl.server));
+    struct sockaddr_in *in = (struct sockaddr_in *)&pl.server;
+    struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)&pl.server;
+    if (inet_pton(AF_INET, host, &in->sin_addr) == 1){
+        in->sin_family = AF_INET;
+        in->sin_port = htons((uint16_t)port);
+        pl.server_len = sizeof(*in);
+    } else if (inet_pton(AF_INET6, host, &in6->sin6_addr) == 1){
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons((uint16_t)port);
+        pl.server_len = sizeof(*in6);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+//names and addresses of /etc/hosts, so they keep being answered from there
+static void preload_hosts_load(){
+    FILE *fp = fopen("/etc/hosts", "re");
+    if (fp == NULL){
+        return;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), fp) != NULL){
+        char *hash = strchr(line, '#');
+        if (hash != NULL){
+            *hash = '\0';
+        }
+        char *save, *tok = strtok_r(line, " \t\r\n", &save);
+        if (tok == NULL){
+            continue;
+        }
+        unsigned char addr[16];
+        int family = (inet_pton(AF_INET, tok, addr) == 1) ? AF_INET : (inet_pton(AF_INET6, tok, addr) == 1) ? AF_INET6 : 0;
+        if (family != 0 && pl.nhost_addrs < PRELOAD_HOSTS){
+            pl.host_addrs[pl.nhost_addrs].family = family;
+            memcpy(pl.host_addrs[pl.nhost_addrs++].addr, addr, 16);
+        }
+        while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL && pl.nhosts < PRELOAD_HOSTS){
+            size_t len = strlen(tok);
+            if (len <= NAME_MAX_LEN + 1 && name_normalize(tok, len, pl.hosts[pl.nhosts]) != 0){
+                pl.nhosts++;
+            }
+        }
+    }
+    fclose(fp);
+}
+
+static bool preload_hosts_name(const unsigned char *qname){
+    for (unsigned int i = 0; i < pl.nhosts; i++){
+        if (dnsname_equal(pl.hosts[i], qname)){
+            return true;
+        }
+    }
+    return false;
+}
+
+//loopback or listed in /etc/hosts
+static bool preload_hosts_addr(const unsigned char *addr, int family){
+    if ((family == AF_INET && addr[0] == 127) || (family == AF_INET6 && IN6_IS_ADDR_LOOPBACK((const struct in6_addr *)addr))){
+        return true;
+    }
+    for (unsigned int i = 0; i < pl.nhost_addrs; i++){
+        if (pl.host_addrs[i].family == family && memcmp(pl.host_addrs[i].addr, addr, (family == AF_INET) ? 4 : 16) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+static void preload_stats(){
+    fprintf(stderr, "Preload: %lu lookups, %lu answered from cache, %lu queries sent, %lu left to libc\r\n", pl.lookups,
+            pl.hits, pl.queries, pl.fallbacks);
+}
+
+static void preload_init(){
+    *(void **)&pl.real_getaddrinfo = dlsym(RTLD_NEXT, "getaddrinfo");
+    *(void **)&pl.real_gethostbyname = dlsym(RTLD_NEXT, "gethostbyname");
+    *(void **)&pl.real_gethostbyname_r = dlsym(RTLD_NEXT, "gethostbyname_r");
+    *(void **)&pl.real_gethostbyaddr = dlsym(RTLD_NEXT, "gethostbyaddr");
+    pthread_key_create(&pl_sock_key, preload_sock_close);
+
+  //server: 'DNS_PRELOAD_SERVER' ("address" or "address#port"), first nameserver of /etc/resolv.conf otherwise
+    const char *env = getenv("DNS_PRELOAD_SERVER");
+    if (env != NULL){
+        pl.enabled = preload_server(env);
+    } else {
+        FILE *fp = fopen("/etc/resolv.conf", "re");
+        char line[256], addr[INET6_ADDRSTRLEN];
+        while (fp != NULL && !pl.enabled && fgets(line, sizeof(line), fp) != NULL){
+            if (sscanf(line, " nameserver %45s", addr) == 1){
+                pl.enabled = preload_server(addr);
+            }
+        }
+        if (fp != NULL){
+            fclose(fp);
+        }
+    }
+    env = getenv("DNS_PRELOAD_TIMEOUT");
+    pl.timeout_ms = (env != NULL && atoi(env) > 0) ? atoi(env) : PRELOAD_TIMEOUT;
+    pl.has_v4 = preload_routable(AF_INET);
+    pl.has_v6 = preload_routable(AF_INET6);
+    preload_hosts_load();
+    if (getenv("DNS_PRELOAD_STATS") != NULL){
+        atexit(preload_stats);
+    }
+}
+
+/*************************************************
+ *                    CACHE                      *
+*************************************************/
+static bool preload_cache_get(const unsigned char *qname, uint16_t qtype, struct preload_entry *out){
+    struct preload_entry *e = &pl.cache[batch_key_hash(qname, qtype) & (PRELOAD_CACHE - 1)];
+    pthread_mutex_lock(&pl.lock);
+    bool hit = e->used && e->qtype == qtype && e->expires > batch_now_ns() && dnsname_equal(e->qname, qname);
+    if (hit){
+        *out = *e;
+    }
+    pthread_mutex_unlock(&pl.lock);
+    return hit;
+}
+
+static void preload_cache_put(const struct preload_entry *e, uint32_t ttl){
+    if (ttl == 0){
+        return;
+    }
+    ttl = (ttl > PRELOAD_TTL_MAX) ? PRELOAD_TTL_MAX : ttl;
+    struct preload_entry *slot = &pl.cache[batch_key_hash(e->qname, e->qtype) & (PRELOAD_CACHE - 1)];
+    pthread_mutex_lock(&pl.lock);
+    *slot = *e;
+    slot->used = true;
+    slot->expires = batch_now_ns() + (uint64_t)ttl * 1000000000ULL;
+    pthread_mutex_unlock(&pl.lock);
+}
+
+/*************************************************
+ *                    LOOKUP                     *
+*************************************************/
+//answer of reply into 'e' (addresses through the addresses-only parser, PTR walked in place the same way),
+//its TTL into 'ttl'; reply is only known to hold our question, nothing past 'len' is read
+static int preload_parse(const unsigned char *buf, size_t len, size_t qlen, struct preload_entry *e, uint32_t *ttl){
+    const struct dns_header_t *dns = (const struct dns_header_t *)buf;
+    e->rcode = dns->rcode;
+    e->count = 0;
+    e->ptr[0] = '\0';
+    *ttl = PRELOAD_NEG_TTL;
+    if (e->qtype != DNS_QTYPE_PTR){
+        struct addr_only a;
+        if (addr_only_extract(buf, len, &a) != 0){
+            return 1;
+        }
+        e->count = a.count;
+        memcpy(e->addrs, a.addrs, sizeof(a.addrs[0]) * a.count);
+        *ttl = (a.count > 0) ? a.ttl : *ttl;
+        return 0;
+    }
+
+  //first PTR record of the answer section
+    size_t pos = sizeof(struct dns_header_t) + qlen + sizeof(struct dns_question_t);
+    for (uint16_t i = ntohs(dns->ancount); i > 0 && e->count == 0; i--){
+        if ((pos = xfr_name(buf, len, pos, NULL)) == 0 || pos + 10 > len){
+            return 1;
+        }
+        uint16_t type = (uint16_t)(buf[pos] << 8 | buf[pos + 1]);
+        uint16_t class = (uint16_t)(buf[pos + 2] << 8 | buf[pos + 3]);
+        size_t rdlen = (size_t)(buf[pos + 8] << 8 | buf[pos + 9]);
+        size_t rdata = pos + 10;
+        if (rdata + rdlen > len){
+            return 1;
+        }
+        if (type == DNS_QTYPE_PTR && class == DNS_QCLASS_IN){
+            size_t end = xfr_name(buf, len, rdata, e->ptr);
+            if (end == 0 || end > rdata + rdlen){
+                return 1;
+            }
+            *ttl = (uint32_t)buf[pos + 4] << 24 | (uint32_t)buf[pos + 5] << 16 | (uint32_t)buf[pos + 6] << 8 | buf[pos + 7];
+            e->count = 1;
+        }
+        pos = rdata + rdlen;
+    }
+    return 0;
+}
+
+//sends the queries of every entry at once (A and AAAA go out together) and waits for all their replies,
+//resending unanswered ones; 1 if libc should answer instead (no reply, truncated, SERVFAIL/REFUSED)
+static int preload_query(const unsigned char *qname, size_t qlen, struct preload_entry *e, uint32_t *ttls, int n){
+    int fd = preload_sock();
+    if (fd < 0){
+        return 1;
+    }
+    struct dns_query_t q[2];
+    uint16_t ids[2];
+    bool done[2] = {false, false};
+    if (getrandom(ids, sizeof(ids), 0) != sizeof(ids)){
+        ids[0] = (uint16_t)batch_now_ns();
+    }
+    ids[1] = (ids[1] == ids[0]) ? ids[0] + 1 : ids[1];
+    for (int i = 0; i < n; i++){
+        dns_query_build(&q[i], qname, qlen, e[i].qtype, true);
+        dns_query_patch(&q[i], ids[i], true);
+    }
+    unsigned char *buf = malloc(PRELOAD_BUF);
+    if (buf == NULL){
+        return 1;
+    }
+
+    int left = n, ret = 1;
+    for (int t = 0; t < PRELOAD_TRIES && left > 0; t++){
+        for (int i = 0; i < n; i++){
+            if (!done[i] && send(fd, q[i].pkt, q[i].len, 0) == (ssize_t)q[i].len){
+                pl.queries++;
+            }
+        }
+        uint64_t deadline = batch_now_ns() + (uint64_t)pl.timeout_ms * 1000000ULL;
+        while (left > 0){
+            uint64_t now = batch_now_ns();
+            struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+            if (now >= deadline || poll(&pfd, 1, (int)((deadline - now + 999999) / 1000000)) == 0){
+                break;
+            }
+            ssize_t len;
+            while (left > 0 && (len = recv(fd, buf, PRELOAD_BUF, 0)) >= 0){
+                struct dns_header_t *dns = (struct dns_header_t *)buf;
+                if ((size_t)len < sizeof(*dns) + qlen + sizeof(struct dns_question_t) || dns->qr != 1){
+                    continue;
+                }
+                for (int i = 0; i < n; i++){
+                    if (done[i] || ntohs(dns->id) != ids[i] || !dnsname_equal(&buf[sizeof(*dns)], qname) ||
+                        memcmp(&buf[sizeof(*dns) + qlen], &q[i].pkt[sizeof(*dns) + qlen], sizeof(struct dns_question_t)) != 0){
+                        continue;
+                    }
+                    if (dns->tc || dns->rcode == 2 || dns->rcode == 5 || preload_parse(buf, (size_t)len, qlen, &e[i], &ttls[i]) != 0){
+                        goto out; //libc has TCP and the other servers
+                    }
+                    done[i] = true;
+                    left--;
+                }
+            }
+            if (left > 0 && errno == ECONNREFUSED){ //nothing listens on the server port
+                goto out;
+            }
+        }
+    }
+    ret = (left > 0);
+out:
+    free(buf);
+    return ret;
+}
+
+//answers of 'name' for the families asked (A then AAAA in 'res'), 1 if libc should answer it: no server known,
+//numeric address, single label (search list), name of /etc/hosts, invalid name or the server not answering
+static int preload_resolve(const char *name, bool v4, bool v6, struct preload_entry *res, int *nres){
+    unsigned char addr[16], qname[NAME_MAX_LEN + 3];
+    size_t len = (name != NULL) ? strlen(name) : 0;
+    if (!pl.enabled || len == 0 || len > NAME_MAX_LEN + 1 || inet_pton(AF_INET, name, addr) == 1 ||
+        inet_pton(AF_INET6, name, addr) == 1 || memchr(name, '.', len - (name[len - 1] == '.')) == NULL){
+        pl.fallbacks++;
+        return 1;
+    }
+    size_t qlen = name_normalize(name, len, qname);
+    if (qlen == 0 || preload_hosts_name(qname)){
+        pl.fallbacks++;
+        return 1;
+    }
+    pl.lookups++;
+
+  //cached answers first, the rest is queried together
+    struct preload_entry miss[2];
+    uint32_t ttls[2];
+    memset(miss, 0, sizeof(miss));
+    int n = 0, m = 0;
+    uint16_t qtypes[2];
+    if (v4){
+        qtypes[n++] = DNS_QTYPE_A;
+    }
+    if (v6){
+        qtypes[n++] = DNS_QTYPE_AAAA;
+    }
+    for (int i = 0; i < n; i++){
+        if (preload_cache_get(qname, qtypes[i], &res[i])){
+            continue;
+        }
+        miss[m].qtype = qtypes[i];
+        memcpy(miss[m].qname, qname, qlen);
+        m++;
+    }
+    if (m == 0){
+        pl.hits++;
+    } else {
+        if (preload_query(qname, qlen, miss, ttls, m) != 0){
+            pl.fallbacks++;
+            return 1;
+        }
+        for (int i = 0, j = 0; i < n; i++){
+            if (!res[i].used){ //not from cache (callers pass zeroed entries)
+                preload_cache_put(&miss[j], ttls[j]);
+                res[i] = miss[j++];
+            }
+        }
+    }
+    *nres = n;
+    return 0;
+}
+
+//lays hostent of 'name' with 'count' addresses (16 bytes apart in 'addrs') out in 'buf', ERANGE if it doesn't fit
+static int preload_hostent(struct hostent *h, const char *name, int family, const unsigned char *addrs, unsigned int count,
+                           char *buf, size_t buflen){
+    size_t alen = (family == AF_INET) ? 4 : 16;
+    size_t nlen = strlen(name) + 1;
+    size_t pad = (size_t)(-(uintptr_t)buf & (sizeof(char *) - 1));
+    if (pad + (count + 2) * sizeof(char *) + count * alen + nlen > buflen){
+        return ERANGE;
+    }
+    char **aliases = (char **)(buf + pad);
+    char **list = aliases + 1;
+    char *data = (char *)(list + count + 1);
+    aliases[0] = NULL;
+    for (unsigned int i = 0; i < count; i++){
+        list[i] = memcpy(data + i * alen, addrs + i * 16, alen);
+    }
+    list[count] = NULL;
+    h->h_name = memcpy(data + count * alen, name, nlen);
+    if (nlen > 2 && h->h_name[nlen - 2] == '.'){ //absolute form is printed without the root dot
+        h->h_name[nlen - 2] = '\0';
+    }
+    h->h_aliases = aliases;
+    h->h_addrtype = family;
+    h->h_length = (int)alen;
+    h->h_addr_list = list;
+    return 0;
+}
+
+/*************************************************
+ *              INTERCEPTED FUNCTIONS            *
+*************************************************/
+PRELOAD_EXPORT int getaddrinfo(const char *node, const char *service, const struct addrinfo *hints, struct addrinfo **res){
+    pthread_once(&pl_once, preload_init);
+    int family = hints ? hints->ai_family : AF_UNSPEC;
+    int flags = hints ? hints->ai_flags : (AI_V4MAPPED | AI_ADDRCONFIG); //glibc's defaults without hints
+    bool v4 = (family != AF_INET6) && (!(flags & AI_ADDRCONFIG) || pl.has_v4);
+    bool v6 = (family != AF_INET) && (!(flags & AI_ADDRCONFIG) || pl.has_v6);
+    struct preload_entry ans[2];
+    int n = 0;
+    memset(ans, 0, sizeof(ans));
+    if (node == NULL || (family != AF_UNSPEC && family != AF_INET && family != AF_INET6) || (!v4 && !v6) ||
+        (flags & ~(AI_CANONNAME | AI_ADDRCONFIG | AI_NUMERICSERV | AI_PASSIVE | AI_V4MAPPED)) != 0 ||
+        (family == AF_INET6 && (flags & AI_V4MAPPED)) || preload_resolve(node, v4, v6, ans, &n) != 0){
+        return pl.real_getaddrinfo(node, service, hints, res);
+    }
+
+  //every address becomes a numeric libc lookup (no network), which expands 'service', socket types and protocols;
+  //families with a route come first
+    struct addrinfo h = {.ai_flags = (flags & AI_NUMERICSERV) | AI_NUMERICHOST, .ai_socktype = hints ? hints->ai_socktype : 0,
+                         .ai_protocol = hints ? hints->ai_protocol : 0};
+    struct addrinfo *head = NULL, **tail = &head;
+    bool v6_first = (n == 2 && pl.has_v6 && !pl.has_v4);
+    bool nxdomain = true;
+    for (int k = 0; k < n; k++){
+        const struct preload_entry *e = &ans[v6_first ? n - 1 - k : k];
+        h.ai_family = (e->qtype == DNS_QTYPE_A) ? AF_INET : AF_INET6;
+        nxdomain = nxdomain && (e->rcode == 3);
+        for (unsigned int i = 0; i < e->count; i++){
+            char text[INET6_ADDRSTRLEN];
+            inet_ntop(h.ai_family, e->addrs[i], text, sizeof(text));
+            struct addrinfo *part;
+            int err = pl.real_getaddrinfo(text, service, &h, &part);
+            if (err != 0){
+                if (head != NULL){
+                    freeaddrinfo(head);
+                }
+                return err;
+            }
+            *tail = part;
+            while (*tail != NULL){
+                tail = &(*tail)->ai_next;
+            }
+        }
+    }
+    if (head == NULL){
+        return nxdomain ? EAI_NONAME : EAI_NODATA;
+    }
+    if ((flags & AI_CANONNAME) && (head->ai_canonname = strdup(node)) == NULL){ //question name, the CNAME target isn't kept
+        freeaddrinfo(head);
+        return EAI_MEMORY;
+    }
+    *res = head;
+    return 0;
+}
+
+PRELOAD_EXPORT int gethostbyname_r(const char *name, struct hostent *ret, char *buf, size_t buflen, struct hostent **result,
+                                   int *h_errnop){
+    pthread_once(&pl_once, preload_init);
+    struct preload_entry ans[2];
+    int n;
+    memset(ans, 0, sizeof(ans));
+    if (preload_resolve(name, true, false, ans, &n) != 0){
+        return pl.real_gethostbyname_r(name, ret, buf, buflen, result, h_errnop);
+    }
+    *result = NULL;
+    if (ans[0].count == 0){
+        *h_errnop = (ans[0].rcode == 3) ? HOST_NOT_FOUND : NO_DATA;
+        return 0;
+    }
+    if (preload_hostent(ret, name, AF_INET, &ans[0].addrs[0][0], ans[0].count, buf, buflen) != 0){
+        *h_errnop = NETDB_INTERNAL;
+        return errno = ERANGE;
+    }
+    *result = ret;
+    return 0;
+}
+
+PRELOAD_EXPORT struct hostent *gethostbyname(const char *name){
+    static struct hostent h;
+    static char buf[PRELOAD_HOSTENT_BUF];
+    pthread_once(&pl_once, preload_init);
+    struct preload_entry ans[2];
+    int n;
+    memset(ans, 0, sizeof(ans));
+    if (preload_resolve(name, true, false, ans, &n) != 0){
+        return pl.real_gethostbyname(name);
+    }
+    if (ans[0].count == 0){
+        h_errno = (ans[0].rcode == 3) ? HOST_NOT_FOUND : NO_DATA;
+        return NULL;
+    }
+    preload_hostent(&h, name, AF_INET, &ans[0].addrs[0][0], ans[0].count, buf, sizeof(buf)); //always fits
+    return &h;
+}
+
+PRELOAD_EXPORT struct hostent *gethostbyaddr(const void *addr, socklen_t len, int type){
+    static struct hostent h;
+    static char buf[PRELOAD_HOSTENT_BUF];
+    pthread_once(&pl_once, preload_init);
+    if (!pl.enabled || !((type == AF_INET && len == 4) || (type == AF_INET6 && len == 16)) ||
+        preload_hosts_addr(addr, type)){
+        pl.fallbacks++;
+        return pl.real_gethostbyaddr(addr, len, type);
+    }
+    pl.lookups++;
+
+  //PTR of the reverse name (cached like addresses)
+    char text[INET6_ADDRSTRLEN], reversed[128];
+    struct preload_entry e;
+    uint32_t ttl;
+    memset(&e, 0, sizeof(e));
+    inet_ntop(type, addr, text, sizeof(text));
+    size_t qlen = (dns_reverse_name(text, reversed) == 0) ? name_normalize(reversed, strlen(reversed), e.qname) : 0;
+    if (qlen == 0){
+        pl.fallbacks++;
+        return pl.real_gethostbyaddr(addr, len, type);
+    }
+    if (preload_cache_get(e.qname, DNS_QTYPE_PTR, &e)){
+        pl.hits++;
+    } else {
+        e.qtype = DNS_QTYPE_PTR;
+        if (preload_query(e.qname, qlen, &e, &ttl, 1) != 0){
+            pl.fallbacks++;
+            return pl.real_gethostbyaddr(addr, len, type);
+        }
+        preload_cache_put(&e, ttl);
+    }
+    if (e.count == 0){
+        h_errno = (e.rcode == 3) ? HOST_NOT_FOUND : NO_DATA;
+        return NULL;
+    }
+    unsigned char a[16];
+    memcpy(a, addr, len);
+    preload_hostent(&h, e.ptr, type, a, 1, buf, sizeof(buf));
+    return &h;
+}
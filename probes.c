@@ -0,0 +1,20 @@
+/** @file:   probes.c
+ *  @brief:  USDT static tracepoints (provider 'dns') for perf/bpftrace, compiled out unless built with DNS_PROBES
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "probes.h"
+
+//semaphores live in their own section, the way tracers look for them (non-zero = somebody is attached)
+#define PROBES_SEMAPHORE(name) volatile unsigned short dns_##name##_semaphore __attribute__((section(".probes"))) = 0
+
+PROBES_SEMAPHORE(query_build);
+PROBES_SEMAPHORE(query_send);
+PROBES_SEMAPHORE(reply_receive);
+PROBES_SEMAPHORE(reply_match);
+PROBES_SEMAPHORE(reply_mismatch);
+PROBES_SEMAPHORE(query_timeout);
+PROBES_SEMAPHORE(decode_start);
+PROBES_SEMAPHORE(decode_end);
+PROBES_SEMAPHORE(print);
@@ -0,0 +1,117 @@
+/** @file:   probes.h
+ *  @brief:  USDT static tracepoints (provider 'dns') for perf/bpftrace, compiled out unless built with DNS_PROBES
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef PROBES_H
+#define PROBES_H
+
+#include <stdint.h>
+
+/*
+ * Probes (arguments in order, strings are NUL terminated, all arguments are 64-bit):
+ *   query_build    qname, qtype, id, bytes                  query packet serialized
+ *   query_send     qname, qtype, id, server, bytes, try     query (or retransmit) handed to the kernel
+ *   reply_receive  server, bytes, id                        datagram received (before it's matched)
+ *   reply_match    qname, qtype, id, rtt_ns, rcode          datagram matched to outstanding query
+ *   reply_mismatch server, bytes, id                        datagram matching no outstanding query
+ *   query_timeout  qname, qtype, id, tries, gave_up         retransmit deadline passed
+ *   decode_start   qname, qtype, id, bytes                  'dns_reply_load' starts
+ *   decode_end     qname, qtype, id, records                'dns_reply_load' done
+ *   print          qname, qtype, id, waiters                reply printed (once per waiter) or stored ('-o')
+ *
+ * Every probe site is a single nop until a tracer attaches. A tracer attaching also increments
+ * the probe's semaphore, so arguments which cost something to prepare (printable qname in batch
+ * mode) are only prepared under 'DNS_PROBE_ENABLED'.
+*/
+
+//semaphores (the tracer bumps them through the address stored in the probe's note)
+extern volatile unsigned short dns_query_build_semaphore;
+extern volatile unsigned short dns_query_send_semaphore;
+extern volatile unsigned short dns_reply_receive_semaphore;
+extern volatile unsigned short dns_reply_match_semaphore;
+extern volatile unsigned short dns_reply_mismatch_semaphore;
+extern volatile unsigned short dns_query_timeout_semaphore;
+extern volatile unsigned short dns_decode_start_semaphore;
+extern volatile unsigned short dns_decode_end_semaphore;
+extern volatile unsigned short dns_print_semaphore;
+
+#if defined(DNS_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define PROBES_SDT 1
+#elif defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+#define PROBES_OWN 1
+#endif
+#endif
+
+#if defined(PROBES_SDT)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define DNS_PROBE_ARG(x) ((uint64_t)(uintptr_t)(x))
+#define DNS_PROBE3(name, a1, a2, a3)                 STAP_PROBE3(dns, name, DNS_PROBE_ARG(a1), DNS_PROBE_ARG(a2), DNS_PROBE_ARG(a3))
+#define DNS_PROBE4(name, a1, a2, a3, a4)             STAP_PROBE4(dns, name, DNS_PROBE_ARG(a1), DNS_PROBE_ARG(a2), DNS_PROBE_ARG(a3), \
+                                                                 DNS_PROBE_ARG(a4))
+#define DNS_PROBE5(name, a1, a2, a3, a4, a5)         STAP_PROBE5(dns, name, DNS_PROBE_ARG(a1), DNS_PROBE_ARG(a2), DNS_PROBE_ARG(a3), \
+                                                                 DNS_PROBE_ARG(a4), DNS_PROBE_ARG(a5))
+#define DNS_PROBE6(name, a1, a2, a3, a4, a5, a6)     STAP_PROBE6(dns, name, DNS_PROBE_ARG(a1), DNS_PROBE_ARG(a2), DNS_PROBE_ARG(a3), \
+                                                                 DNS_PROBE_ARG(a4), DNS_PROBE_ARG(a5), DNS_PROBE_ARG(a6))
+#define DNS_PROBE_ENABLED(name)                      __builtin_expect(dns_##name##_semaphore != 0, 0)
+
+#elif defined(PROBES_OWN)
+//no systemtap-sdt headers installed: the same note layout (stapsdt, version 3) sys/sdt.h emits,
+//every argument passed as unsigned 64-bit ("8@<operand>")
+#if defined(__x86_64__)
+#define DNS_PROBE_CONSTRAINT "nor" //immediate, register or memory operand
+#else
+#define DNS_PROBE_CONSTRAINT "r"
+#endif
+#define DNS_PROBE_OP(x)  DNS_PROBE_CONSTRAINT ((uint64_t)(uintptr_t)(x))
+#define DNS_PROBE_NOTE(name, args, ...) \
+    __asm__ __volatile__ ("990: nop\n" \
+                          ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+                          ".balign 4\n" \
+                          ".4byte 992f-991f, 994f-993f, 3\n" \
+                          "991: .asciz \"stapsdt\"\n" \
+                          "992: .balign 4\n" \
+                          "993: .8byte 990b\n" \
+                          ".8byte _.stapsdt.base\n" \
+                          ".8byte dns_" #name "_semaphore\n" \
+                          ".asciz \"dns\"\n" \
+                          ".asciz \"" #name "\"\n" \
+                          ".asciz \"" args "\"\n" \
+                          "994: .balign 4\n" \
+                          ".popsection\n" \
+                          ".ifndef _.stapsdt.base\n" \
+                          ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+                          ".weak _.stapsdt.base\n" \
+                          ".hidden _.stapsdt.base\n" \
+                          "_.stapsdt.base: .space 1\n" \
+                          ".size _.stapsdt.base, 1\n" \
+                          ".popsection\n" \
+                          ".endif\n" \
+                          :: __VA_ARGS__)
+#define DNS_PROBE3(name, x1, x2, x3) \
+    DNS_PROBE_NOTE(name, "8@%[a1] 8@%[a2] 8@%[a3]", [a1] DNS_PROBE_OP(x1), [a2] DNS_PROBE_OP(x2), [a3] DNS_PROBE_OP(x3))
+#define DNS_PROBE4(name, x1, x2, x3, x4) \
+    DNS_PROBE_NOTE(name, "8@%[a1] 8@%[a2] 8@%[a3] 8@%[a4]", [a1] DNS_PROBE_OP(x1), [a2] DNS_PROBE_OP(x2), \
+                   [a3] DNS_PROBE_OP(x3), [a4] DNS_PROBE_OP(x4))
+#define DNS_PROBE5(name, x1, x2, x3, x4, x5) \
+    DNS_PROBE_NOTE(name, "8@%[a1] 8@%[a2] 8@%[a3] 8@%[a4] 8@%[a5]", [a1] DNS_PROBE_OP(x1), [a2] DNS_PROBE_OP(x2), \
+                   [a3] DNS_PROBE_OP(x3), [a4] DNS_PROBE_OP(x4), [a5] DNS_PROBE_OP(x5))
+#define DNS_PROBE6(name, x1, x2, x3, x4, x5, x6) \
+    DNS_PROBE_NOTE(name, "8@%[a1] 8@%[a2] 8@%[a3] 8@%[a4] 8@%[a5] 8@%[a6]", [a1] DNS_PROBE_OP(x1), [a2] DNS_PROBE_OP(x2), \
+                   [a3] DNS_PROBE_OP(x3), [a4] DNS_PROBE_OP(x4), [a5] DNS_PROBE_OP(x5), [a6] DNS_PROBE_OP(x6))
+#define DNS_PROBE_ENABLED(name)                      __builtin_expect(dns_##name##_semaphore != 0, 0)
+
+#else
+//arguments are still referenced (values computed only for probes don't trip unused warnings)
+#define DNS_PROBE3(name, a1, a2, a3)                 ((void)(a1), (void)(a2), (void)(a3))
+#define DNS_PROBE4(name, a1, a2, a3, a4)             ((void)(a1), (void)(a2), (void)(a3), (void)(a4))
+#define DNS_PROBE5(name, a1, a2, a3, a4, a5)         ((void)(a1), (void)(a2), (void)(a3), (void)(a4), (void)(a5))
+#define DNS_PROBE6(name, a1, a2, a3, a4, a5, a6)     ((void)(a1), (void)(a2), (void)(a3), (void)(a4), (void)(a5), (void)(a6))
+#define DNS_PROBE_ENABLED(name)                      0
+#endif
+
+#endif
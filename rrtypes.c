@@ -0,0 +1,256 @@
+/** @file:   rrtypes.c
+ *  @brief:  Resource record type registry (name, code, rdata decoder and formatter per type)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "rrtypes.h"
+#include "addrfmt.h"
+
+#include <strings.h>
+
+/*************************************************
+ *                RDATA DECODERS                 *
+*************************************************/
+//raw bytes (A, AAAA)
+static unsigned char* rr_decode_raw(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen){
+    (void)buf;
+    (void)len;
+    unsigned char *out = malloc(rdlen + 1);
+    if (out != NULL){
+        memcpy(out, rdata, rdlen);
+        out[rdlen] = '\0';
+    }
+    return out;
+}
+
+//single (compressed) domain name (NS, CNAME, PTR)
+static unsigned char* rr_decode_name(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen){
+    int stop;
+    if (rdlen < 1){
+        return NULL;
+    }
+    unsigned char *name = read_compressed_name(rdata, buf, len, &stop);
+    if (name != NULL && stop > rdlen){ //name runs past its record
+        free(name);
+        return NULL;
+    }
+    return name;
+}
+
+//preference + exchange name (MX)
+static unsigned char* rr_decode_mx(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen){
+    int stop;
+    if (rdlen < 3){
+        return NULL;
+    }
+    unsigned char *exchange = read_compressed_name(rdata + 2, buf, len, &stop);
+    if (exchange == NULL || stop > rdlen - 2){
+        free(exchange);
+        return NULL;
+    }
+    unsigned char *out = malloc(strlen((char *)exchange) + 8);
+    if (out != NULL){
+        sprintf((char *)out, "%u %s", (rdata[0] << 8) | rdata[1], exchange);
+    }
+    free(exchange);
+    return out;
+}
+
+//mname rname serial refresh retry expire minimum (SOA)
+static unsigned char* rr_decode_soa(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen){
+    int stop = 0;
+    unsigned char *reader = rdata;
+    unsigned char *rname = NULL;
+    unsigned char *mname = read_compressed_name(reader, buf, len, &stop);
+    if (mname != NULL && stop <= rdlen){
+        reader += stop;
+        rname = read_compressed_name(reader, buf, len, &stop);
+        reader += stop;
+    }
+    if (rname == NULL || (size_t)(reader - rdata) + 20 > rdlen){
+        free(mname);
+        free(rname);
+        return NULL;
+    }
+    uint32_t val[5];
+    for (int i = 0; i < 5; i++){
+        val[i] = ((uint32_t)reader[0] << 24) | ((uint32_t)reader[1] << 16) | ((uint32_t)reader[2] << 8) | reader[3];
+        reader += 4;
+    }
+    unsigned char *out = malloc(strlen((char *)mname) + strlen((char *)rname) + 64);
+    if (out != NULL){
+        sprintf((char *)out, "%s %s %u %u %u %u %u", mname, rname, val[0], val[1], val[2], val[3], val[4]);
+    }
+    free(mname);
+    free(rname);
+    return out;
+}
+
+//one or more character strings, quoted (TXT)
+static unsigned char* rr_decode_txt(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen){
+    (void)buf;
+    (void)len;
+    unsigned char *out = malloc((size_t)rdlen * 4 + 3); //worst case: every char escaped as \DDD
+    if (out == NULL){
+        return NULL;
+    }
+    size_t pos = 0;
+    for (uint16_t i = 0; i < rdlen; ){
+        uint8_t slen = rdata[i++]; //character-string length
+        if (i + slen > rdlen){
+            free(out);
+            return NULL;
+        }
+        if (pos > 0){
+            out[pos++] = ' ';
+        }
+        out[pos++] = '"';
+        for (uint8_t j = 0; j < slen; j++, i++){
+            unsigned char c = rdata[i];
+            if (c == '"' || c == '\\'){
+                out[pos++] = '\\';
+                out[pos++] = c;
+            } else if (c < 0x20 || c > 0x7e){
+                pos += sprintf((char *)&out[pos], "\\%03u", c);
+            } else {
+                out[pos++] = c;
+            }
+        }
+        out[pos++] = '"';
+    }
+    out[pos] = '\0';
+    return out;
+}
+
+//priority weight port target (SRV)
+static unsigned char* rr_decode_srv(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen){
+    int stop;
+    if (rdlen < 7){
+        return NULL;
+    }
+    unsigned char *target = read_compressed_name(rdata + 6, buf, len, &stop);
+    if (target == NULL || stop > rdlen - 6){
+        free(target);
+        return NULL;
+    }
+    unsigned char *out = malloc(strlen((char *)target) + 24);
+    if (out != NULL){
+        sprintf((char *)out, "%u %u %u %s", (rdata[0] << 8) | rdata[1], (rdata[2] << 8) | rdata[3],
+                (rdata[4] << 8) | rdata[5], target);
+    }
+    free(target);
+    return out;
+}
+
+//unknown type, RFC 3597 generic form (\# length hexdata)
+static unsigned char* rr_decode_generic(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen){
+    (void)buf;
+    (void)len;
+    unsigned char *out = malloc((size_t)rdlen * 2 + 16);
+    if (out != NULL){
+        int pos = sprintf((char *)out, "\\# %u ", rdlen);
+        for (uint16_t i = 0; i < rdlen; i++){
+            pos += sprintf((char *)&out[pos], "%02x", rdata[i]);
+        }
+    }
+    return out;
+}
+
+/*************************************************
+ *               RDATA FORMATTERS                *
+*************************************************/
+//address of unexpected length, RFC 3597 generic form instead
+static void rr_format_bad_addr(FILE *out, struct dns_record_a_t *rec){
+    unsigned char *text = rr_decode_generic(NULL, 0, rec->rdata, ntohs(rec->resource->data_len));
+    if (text != NULL){
+        fputs((const char *)text, out);
+        free(text);
+    }
+}
+
+//address types are formatted straight from raw bytes into a stack buffer
+static void rr_format_a(FILE *out, struct dns_record_a_t *rec){
+    char text[ADDR_TEXT_MAX];
+    if (ntohs(rec->resource->data_len) != 4){
+        rr_format_bad_addr(out, rec);
+        return;
+    }
+    fwrite(text, 1, addr_format_ipv4(rec->rdata, text), out);
+}
+
+static void rr_format_aaaa(FILE *out, struct dns_record_a_t *rec){
+    char text[ADDR_TEXT_MAX];
+    if (ntohs(rec->resource->data_len) != 16){
+        rr_format_bad_addr(out, rec);
+        return;
+    }
+    fwrite(text, 1, addr_format_ipv6(rec->rdata, text), out);
+}
+
+static void rr_format_text(FILE *out, struct dns_record_a_t *rec){
+    fprintf(out, "%s", rec->rdata);
+}
+
+/*************************************************
+ *                   REGISTRY                    *
+*************************************************/
+static const struct rr_type registry[RR_TYPES_MAX] = {
+    [DNS_QTYPE_A]     = {"A",     DNS_QTYPE_A,     rr_decode_raw,  rr_format_a},
+    [DNS_QTYPE_NS]    = {"NS",    DNS_QTYPE_NS,    rr_decode_name, rr_format_text},
+    [DNS_QTYPE_CNAME] = {"CNAME", DNS_QTYPE_CNAME, rr_decode_name, rr_format_text},
+    [DNS_QTYPE_SOA]   = {"SOA",   DNS_QTYPE_SOA,   rr_decode_soa,  rr_format_text},
+    [DNS_QTYPE_PTR]   = {"PTR",   DNS_QTYPE_PTR,   rr_decode_name, rr_format_text},
+    [DNS_QTYPE_MX]    = {"MX",    DNS_QTYPE_MX,    rr_decode_mx,   rr_format_text},
+    [DNS_QTYPE_TXT]   = {"TXT",   DNS_QTYPE_TXT,   rr_decode_txt,  rr_format_text},
+    [DNS_QTYPE_AAAA]  = {"AAAA",  DNS_QTYPE_AAAA,  rr_decode_raw,  rr_format_aaaa},
+    [DNS_QTYPE_SRV]   = {"SRV",   DNS_QTYPE_SRV,   rr_decode_srv,  rr_format_text},
+    [DNS_QTYPE_IXFR]  = {"IXFR",  DNS_QTYPE_IXFR,  rr_decode_generic, rr_format_text}, //query only (xfr.c)
+    [DNS_QTYPE_AXFR]  = {"AXFR",  DNS_QTYPE_AXFR,  rr_decode_generic, rr_format_text}, //query only (xfr.c)
+};
+
+static const struct rr_type generic = {"UNKNOWN", 0, rr_decode_generic, rr_format_text};
+
+//type code --> descriptor
+const struct rr_type *rr_type_get(uint16_t code){
+    if (code < RR_TYPES_MAX && registry[code].name != NULL){
+        return &registry[code];
+    }
+    return &generic;
+}
+
+//presentation name --> type code
+uint16_t rr_type_by_name(const char *name){
+    for (int i = 0; i < RR_TYPES_MAX; i++){
+        if (registry[i].name != NULL && strcasecmp(registry[i].name, name) == 0){
+            return registry[i].code;
+        }
+    }
+    if (strncasecmp(name, "TYPE", 4) == 0 && name[4] != '\0'){ //RFC 3597 TYPE<n>
+        char *end;
+        long code = strtol(name + 4, &end, 10);
+        if (*end == '\0' && code > 0 && code <= 65535){
+            return (uint16_t)code;
+        }
+    }
+    return 0;
+}
+
+//decoded rdata length (address types keep wire bytes, which may contain zeros)
+size_t rr_rdata_len(struct dns_record_a_t *rec){
+    if (rr_type_get(ntohs(rec->resource->type))->decode == rr_decode_raw){
+        return ntohs(rec->resource->data_len);
+    }
+    return strlen((const char *)rec->rdata);
+}
+
+//registered type names
+void rr_type_list(FILE *out){
+    const char *sep = "";
+    for (int i = 0; i < RR_TYPES_MAX; i++){
+        if (registry[i].name != NULL){
+            fprintf(out, "%s%s", sep, registry[i].name);
+            sep = " ";
+        }
+    }
+}
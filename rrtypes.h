@@ -0,0 +1,80 @@
+/** @file:   rrtypes.h
+ *  @brief:  Resource record type registry (name, code, rdata decoder and formatter per type)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef RRTYPES_H
+#define RRTYPES_H
+
+#include "dns.h"
+
+#define RR_TYPES_MAX 256 //registry is indexed directly by type code (codes below this limit)
+
+/**
+ * @typedef: rr_decode_fn
+ * @brief decodes record data into its in-memory form (raw bytes for addresses, text otherwise)
+ *
+ * @param[in] buf:    buffer holding whole packet reply (names in rdata may point anywhere into it)
+ * @param[in] len:    length of the reply in @param buf
+ * @param[in] rdata:  pointer to where record data starts in @param buf
+ * @param[in] rdlen:  length of record data (known to lie within @param len)
+ * @return malloc'd decoded record data (NUL terminated), NULL if record data is malformed
+*/
+typedef unsigned char* (*rr_decode_fn)(unsigned char *buf, size_t len, unsigned char *rdata, uint16_t rdlen);
+
+/**
+ * @typedef: rr_format_fn
+ * @brief prints decoded record data in presentation format
+ *
+ * @param[in] out: stream to print into
+ * @param[in] rec: decoded resource record
+*/
+typedef void (*rr_format_fn)(FILE *out, struct dns_record_a_t *rec);
+
+/**
+ * @struct: resource record type descriptor
+*/
+struct rr_type{
+    const char *name;    /* presentation name ("MX") */
+    uint16_t code;       /* type code (15) */
+    rr_decode_fn decode; /* rdata decoder */
+    rr_format_fn format; /* rdata formatter */
+};
+
+/**
+ * @function: rr_type_get
+ * @brief descriptor of type code (O(1), registry is indexed by code)
+ *
+ * @param[in] code: type code (host byte order)
+ * @return type descriptor, generic (RFC 3597) descriptor for unregistered types
+*/
+const struct rr_type *rr_type_get(uint16_t code);
+
+/**
+ * @function: rr_type_by_name
+ * @brief finds registered type by its presentation name (case insensitive, "TYPE<n>" also accepted)
+ *
+ * @param[in] name: type name ("mx", "AAAA", "TYPE99")
+ * @return type code, 0 if @param name isn't a known type
+*/
+uint16_t rr_type_by_name(const char *name);
+
+/**
+ * @function: rr_rdata_len
+ * @brief length of decoded record data (raw bytes for address types, text length otherwise)
+ *
+ * @param[in] rec: decoded resource record
+ * @return length of @param rec rdata, without the terminating zero
+*/
+size_t rr_rdata_len(struct dns_record_a_t *rec);
+
+/**
+ * @function: rr_type_list
+ * @brief prints names of all registered types separated by spaces
+ *
+ * @param[in] out: stream to print into
+*/
+void rr_type_list(FILE *out);
+
+#endif
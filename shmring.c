@@ -0,0 +1,286 @@
+/** @file:   shmring.c
+ *  @brief:  Shared-memory result ring (--shm) for batch mode, consumed in place by local readers (dnsshm)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "shmring.h"
+#include "rrtypes.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHM_DATA_OFF 4096 //data area starts on its own page
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static size_t shm_align(size_t len, size_t to){
+    return (len + to - 1) & ~(to - 1);
+}
+
+//"/name" for shm_open
+static bool shm_path(char *path, size_t size, const char *name){
+    return (size_t)snprintf(path, size, "/%s", name) < size;
+}
+
+//bytes one resource record takes in the ring
+static size_t shm_record_size(struct dns_record_a_t *rec){
+    return shm_align(sizeof(struct shm_record) + strlen((const char *)rec->name) + 1 + rr_rdata_len(rec) + 1, 4);
+}
+
+//writes one section's records at 'p', returns end of the last one
+static unsigned char *shm_put_section(unsigned char *p, struct dns_record_a_t *records, uint16_t count, uint8_t section){
+    for (uint16_t i = 0; i < count; i++){
+        struct shm_record *out = (struct shm_record *)p;
+        size_t owner_len = strlen((const char *)records[i].name) + 1;
+        size_t rdata_len = rr_rdata_len(&records[i]);
+        out->type = ntohs(records[i].resource->type);
+        out->class = ntohs(records[i].resource->class);
+        out->ttl = ntohl(records[i].resource->ttl);
+        out->section = section;
+        out->reserved = 0;
+        out->owner_len = (uint16_t)owner_len;
+        out->rdata_len = (uint16_t)rdata_len;
+        out->reserved2 = 0;
+        unsigned char *v = p + sizeof(*out);
+        memcpy(v, records[i].name, owner_len);
+        memcpy(v + owner_len, records[i].rdata, rdata_len);
+        v[owner_len + rdata_len] = '\0';
+        p += shm_record_size(&records[i]);
+    }
+    return p;
+}
+
+/*************************************************
+ *                    WRITER                     *
+*************************************************/
+int shm_open_writer(struct shm_writer *w, const char *name, uint64_t size){
+    memset(w, 0, sizeof(*w));
+    char path[NAME_MAX + 2];
+    if (!shm_path(path, sizeof(path), name)){
+        fprintf(stderr, "ERROR: shared memory name too long: %s\r\n", name);
+        return 1;
+    }
+
+  //a fresh object every run (readers still mapping an old one keep it until they let go)
+    shm_unlink(path);
+    int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    w->map_len = SHM_DATA_OFF + size;
+    if (fd < 0 || ftruncate(fd, (off_t)w->map_len) != 0){
+        fprintf(stderr, "ERROR: couldn't create shared memory object: /dev/shm/%s (%s)\r\n", name, strerror(errno));
+        if (fd >= 0){
+            close(fd);
+        }
+        return 1;
+    }
+    void *map = mmap(NULL, w->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        perror("ERROR: mmap failure");
+        shm_unlink(path);
+        return 1;
+    }
+
+    w->hdr = map;
+    w->data = (unsigned char *)map + SHM_DATA_OFF;
+    w->hdr->version = SHM_VERSION;
+    w->hdr->endian = SHM_ENDIAN;
+    w->hdr->size = size;
+    w->hdr->data_off = SHM_DATA_OFF;
+    w->hdr->pid = (int32_t)getpid();
+    atomic_init(&w->hdr->head, 0);
+    atomic_init(&w->hdr->oldest, 0);
+    atomic_init(&w->hdr->records, 0);
+    atomic_init(&w->hdr->closed, 0);
+    atomic_thread_fence(memory_order_release);
+    memcpy(w->hdr->magic, SHM_MAGIC, sizeof(w->hdr->magic)); //readers accept the object from here on
+    return 0;
+}
+
+void shm_add_reply(struct shm_writer *w, struct dns_header_t *dns, struct dns_question_t *qinfo,
+                   struct dns_replies *dns_rep, unsigned char *qname, uint32_t waiters){
+    struct dns_record_a_t *sections[3] = {dns_rep->answers, dns_rep->auth, dns_rep->addit};
+    uint16_t counts[3] = {ntohs(dns->ancount), ntohs(dns->nscount), ntohs(dns->arcount)};
+    size_t qname_len = strlen((const char *)qname) + 1;
+
+  //size of the whole record (a reply never wraps around the end of the data area)
+    size_t size = shm_align(sizeof(struct shm_rec_hdr) + sizeof(struct shm_reply) + qname_len, 4);
+    for (int sec = 0; sec < 3; sec++){
+        for (uint16_t i = 0; i < counts[sec]; i++){
+            size += shm_record_size(&sections[sec][i]);
+        }
+    }
+    size = shm_align(size, SHM_ALIGN);
+    uint64_t ring = w->hdr->size;
+    if (size > ring / 2){
+        w->dropped++;
+        return;
+    }
+    uint64_t off = w->head & (ring - 1);
+    uint64_t pad = (off + size > ring) ? ring - off : 0;
+    uint64_t start = w->head + pad, end = start + size;
+
+  //retire the records about to be overwritten first (readers check 'oldest' after reading)
+    while (w->oldest + ring < end){
+        if (w->oldest >= w->head){ //the padding written below is overwritten as well
+            w->oldest = start;
+            break;
+        }
+        w->oldest += ((struct shm_rec_hdr *)(w->data + (w->oldest & (ring - 1))))->size;
+    }
+    atomic_store_explicit(&w->hdr->oldest, w->oldest, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (pad > 0){
+        struct shm_rec_hdr *p = (struct shm_rec_hdr *)(w->data + off);
+        p->size = (uint32_t)pad;
+        p->kind = SHM_REC_PAD;
+        p->seq = 0;
+        w->laps++;
+    }
+    unsigned char *p = w->data + (start & (ring - 1));
+    struct shm_rec_hdr *rec = (struct shm_rec_hdr *)p;
+    rec->size = (uint32_t)size;
+    rec->kind = SHM_REC_REPLY;
+    rec->seq = w->replies;
+    struct shm_reply *rep = (struct shm_reply *)(p + sizeof(*rec));
+    rep->qtype = ntohs(qinfo->q_type);
+    rep->qclass = ntohs(qinfo->q_class);
+    rep->rcode = (uint8_t)dns->rcode;
+    rep->flags = (uint8_t)(((dns->aa != 0) ? SHM_F_AUTHORITATIVE : 0) | ((dns->ra == 1 && par.recursion == 1) ? SHM_F_RECURSIVE : 0) |
+                           ((dns->tc != 0) ? SHM_F_TRUNCATED : 0));
+    memcpy(rep->counts, counts, sizeof(counts));
+    rep->qname_len = (uint16_t)qname_len;
+    rep->waiters = waiters;
+    memcpy(p + sizeof(*rec) + sizeof(*rep), qname, qname_len);
+    unsigned char *r = p + shm_align(sizeof(*rec) + sizeof(*rep) + qname_len, 4);
+    for (int sec = 0; sec < 3; sec++){
+        r = shm_put_section(r, sections[sec], counts[sec], (uint8_t)sec);
+    }
+
+  //publish
+    w->head = end;
+    w->replies++;
+    atomic_store_explicit(&w->hdr->records, w->replies, memory_order_relaxed);
+    atomic_store_explicit(&w->hdr->head, end, memory_order_release);
+}
+
+void shm_close_writer(struct shm_writer *w){
+    atomic_store_explicit(&w->hdr->closed, 1, memory_order_release);
+    munmap(w->hdr, w->map_len);
+    w->hdr = NULL;
+}
+
+/*************************************************
+ *                    READER                     *
+*************************************************/
+int shm_open_reader(struct shm_reader *r, const char *name){
+    memset(r, 0, sizeof(*r));
+    char path[NAME_MAX + 2];
+    struct stat st;
+    int fd = shm_path(path, sizeof(path), name) ? shm_open(path, O_RDONLY, 0) : -1;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < SHM_DATA_OFF){
+        fprintf(stderr, "ERROR: no result ring in shared memory: /dev/shm/%s\r\n", name);
+        if (fd >= 0){
+            close(fd);
+        }
+        return 1;
+    }
+    r->map_len = (size_t)st.st_size;
+    void *map = mmap(NULL, r->map_len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        perror("ERROR: mmap failure");
+        return 1;
+    }
+    r->hdr = map;
+    if (memcmp(r->hdr->magic, SHM_MAGIC, sizeof(SHM_MAGIC)) != 0 || r->hdr->version != SHM_VERSION ||
+        r->hdr->endian != SHM_ENDIAN || r->hdr->data_off + r->hdr->size != r->map_len ||
+        (r->hdr->size & (r->hdr->size - 1)) != 0){
+        fprintf(stderr, "ERROR: not a result ring (or unsupported version or byte order): /dev/shm/%s\r\n", name);
+        munmap(map, r->map_len);
+        return 1;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    r->data = (const unsigned char *)map + r->hdr->data_off;
+    r->pos = atomic_load_explicit(&r->hdr->oldest, memory_order_acquire);
+    return 0;
+}
+
+//reader fell behind the writer: continue at the oldest record still in the ring
+static void shm_reader_lapped(struct shm_reader *r){
+    r->overruns++;
+    r->pos = atomic_load_explicit(&r->hdr->oldest, memory_order_acquire);
+}
+
+//record at reader position wasn't overwritten while it was read
+static bool shm_reader_intact(struct shm_reader *r){
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&((struct shm_hdr *)r->hdr)->oldest, memory_order_relaxed) <= r->pos;
+}
+
+const struct shm_rec_hdr *shm_reader_peek(struct shm_reader *r){
+    uint64_t mask = r->hdr->size - 1;
+    while (r->pos < atomic_load_explicit(&((struct shm_hdr *)r->hdr)->head, memory_order_acquire)){
+        if (r->pos < atomic_load_explicit(&((struct shm_hdr *)r->hdr)->oldest, memory_order_acquire)){
+            shm_reader_lapped(r);
+            continue;
+        }
+        const struct shm_rec_hdr *rec = (const struct shm_rec_hdr *)(r->data + (r->pos & mask));
+        uint32_t size = rec->size;
+        uint32_t kind = rec->kind;
+        if (size < sizeof(struct shm_rec_hdr) || size > r->hdr->size - (r->pos & mask)){ //torn while read
+            if (shm_reader_intact(r)){ //writer never publishes such a record, nothing to follow in this ring
+                r->overruns++;
+                r->pos = atomic_load_explicit(&((struct shm_hdr *)r->hdr)->head, memory_order_acquire);
+            } else {
+                shm_reader_lapped(r);
+            }
+            continue;
+        }
+        if (kind != SHM_REC_PAD){
+            r->size = size;
+            return rec;
+        }
+        if (!shm_reader_intact(r)){
+            shm_reader_lapped(r);
+            continue;
+        }
+        r->pos += size;
+    }
+    return NULL;
+}
+
+bool shm_reader_advance(struct shm_reader *r){
+    const struct shm_rec_hdr *rec = (const struct shm_rec_hdr *)(r->data + (r->pos & (r->hdr->size - 1)));
+    uint32_t size = r->size;
+    uint64_t seq = rec->seq;
+    if (!shm_reader_intact(r)){
+        shm_reader_lapped(r);
+        return false;
+    }
+    r->lost += seq - r->next_seq; //replies overwritten before the reader got to them
+    r->next_seq = seq + 1;
+    r->pos += size;
+    return true;
+}
+
+bool shm_reader_done(struct shm_reader *r){
+    struct shm_hdr *hdr = (struct shm_hdr *)r->hdr;
+    bool closed = atomic_load_explicit(&hdr->closed, memory_order_acquire) != 0 ||
+                  (kill(hdr->pid, 0) != 0 && errno == ESRCH);
+    if (!closed || r->pos < atomic_load_explicit(&hdr->head, memory_order_acquire)){
+        return false;
+    }
+    r->lost += atomic_load_explicit(&hdr->records, memory_order_relaxed) - r->next_seq; //tail lapped while waiting
+    r->next_seq = atomic_load_explicit(&hdr->records, memory_order_relaxed);
+    return true;
+}
+
+void shm_close_reader(struct shm_reader *r){
+    munmap((void *)r->hdr, r->map_len);
+    r->hdr = NULL;
+}
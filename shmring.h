@@ -0,0 +1,205 @@
+/** @file:   shmring.h
+ *  @brief:  Shared-memory result ring (--shm) for batch mode, consumed in place by local readers (dnsshm)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include "dns.h"
+
+#include <limits.h> //NAME_MAX
+#include <stdatomic.h>
+
+#define SHM_MAGIC        "DNSSHM1" //object magic (8 bytes with the terminating zero)
+#define SHM_VERSION      1
+#define SHM_ENDIAN       0x01020304 //written in native byte order, readers check it
+#define SHM_SIZE_DEFAULT (64 << 20) //data bytes of ring (power of two)
+#define SHM_SIZE_MIN     (64 << 10)
+#define SHM_SIZE_MAX     (1 << 30)
+#define SHM_ALIGN        16         //every record starts at a multiple of this (a record header always fits before the end)
+
+//reply flags (as project_print would print them)
+#define SHM_F_AUTHORITATIVE 0x01
+#define SHM_F_RECURSIVE     0x02
+#define SHM_F_TRUNCATED     0x04
+
+//record kinds
+#define SHM_REC_REPLY    1
+#define SHM_REC_PAD      2 //fills the end of the data area when the next record doesn't fit there, skipped by readers
+
+/**
+ * @struct: object header, followed by the data area at offset 'data_off'
+ *
+ * Positions are absolute byte counts since the ring was created (data offset = position & (size - 1)).
+ * The writer only ever appends: it publishes a record by moving 'head' past it, and before it overwrites
+ * the oldest records it moves 'oldest' past them. Readers keep their own position, read records in
+ * place, and check 'oldest' afterwards - if it went past the record they just read, the writer lapped
+ * them and the record may be torn. Nothing in the object is written by readers.
+*/
+struct shm_hdr{
+    char magic[8];       /* SHM_MAGIC */
+    uint32_t version;    /* SHM_VERSION */
+    uint32_t endian;     /* SHM_ENDIAN */
+    uint64_t size;       /* data area bytes, power of two */
+    uint64_t data_off;   /* data area start, from object start */
+    int32_t pid;         /* writer process (readers stop following once it's gone) */
+    uint32_t reserved;
+    _Alignas(64) _Atomic uint64_t head;   /* end of last published record */
+    _Atomic uint64_t oldest;              /* start of oldest record not (being) overwritten */
+    _Atomic uint64_t records;             /* replies published */
+    _Atomic uint32_t closed;              /* writer is done, nothing follows 'head' */
+};
+
+/**
+ * @struct: record header (every record starts with one, 'size' includes it and alignment padding)
+*/
+struct shm_rec_hdr{
+    uint32_t size;
+    uint32_t kind;       /* SHM_REC_* */
+    uint64_t seq;        /* reply number (from 0, readers count gaps as lost replies) */
+};
+
+/**
+ * @struct: reply (after record header), followed by the question name and its resource records
+ *
+ * Names are printable (no trailing dot) and NUL terminated. Rdata is the decoded form the formatters
+ * print, NUL terminated: wire bytes for address types (A, AAAA), presentation text otherwise
+ * (compressed names inside wire rdata would point into a message readers don't have).
+*/
+struct shm_reply{
+    uint16_t qtype;
+    uint16_t qclass;
+    uint8_t rcode;
+    uint8_t flags;       /* SHM_F_* */
+    uint16_t counts[3];  /* answer, authority and additional records */
+    uint16_t qname_len;  /* including the NUL */
+    uint32_t waiters;    /* input lines answered by reply (coalesced duplicates) */
+};
+
+/**
+ * @struct: resource record of reply (records are in reply order: answers, authority, additional),
+ *          followed by owner name and rdata, next record starts at the following multiple of 4
+*/
+struct shm_record{
+    uint16_t type;
+    uint16_t class;
+    uint32_t ttl;
+    uint8_t section;     /* 0 = answer, 1 = authority, 2 = additional */
+    uint8_t reserved;
+    uint16_t owner_len;  /* including the NUL */
+    uint16_t rdata_len;  /* excluding the NUL */
+    uint16_t reserved2;
+};
+
+/**
+ * @struct: ring writer
+*/
+struct shm_writer{
+    struct shm_hdr *hdr; /* NULL when no ring is open */
+    unsigned char *data;
+    size_t map_len;
+    uint64_t head;       /* local copies of the published positions */
+    uint64_t oldest;
+    unsigned long replies;
+    unsigned long dropped; /* replies larger than half of the ring */
+    unsigned long laps;    /* times the writer wrapped around the data area */
+};
+
+/**
+ * @struct: ring reader (one per reader process, the object is mapped read-only)
+*/
+struct shm_reader{
+    const struct shm_hdr *hdr;
+    const unsigned char *data;
+    size_t map_len;
+    uint64_t pos;        /* next record to read */
+    uint32_t size;       /* size of record returned by the last 'shm_reader_peek' (checked to lie within the ring) */
+    uint64_t next_seq;   /* reply number expected next */
+    unsigned long lost;      /* replies overwritten before they were read */
+    unsigned long overruns;  /* times the writer lapped the reader */
+};
+
+/**
+ * @function: shm_open_writer
+ * @brief creates (replaces) shared memory object '/name' holding an empty ring
+ *
+ * @param[in] w:    writer to initialize
+ * @param[in] name: object name (without the leading '/')
+ * @param[in] size: data area bytes (power of two)
+ * @return 0 if successful, 1 if not
+*/
+int shm_open_writer(struct shm_writer *w, const char *name, uint64_t size);
+
+/**
+ * @function: shm_add_reply
+ * @brief publishes decoded reply (overwriting the oldest replies if needed, never waits for readers)
+ *
+ * @param[in] w:       writer
+ * @param[in] dns:     reply header
+ * @param[in] qinfo:   question fields of reply
+ * @param[in] dns_rep: decoded records
+ * @param[in] qname:   question name (printable form)
+ * @param[in] waiters: amount of input lines the reply answers
+*/
+void shm_add_reply(struct shm_writer *w, struct dns_header_t *dns, struct dns_question_t *qinfo,
+                   struct dns_replies *dns_rep, unsigned char *qname, uint32_t waiters);
+
+/**
+ * @function: shm_close_writer
+ * @brief marks ring closed and unmaps it (the object stays for readers, 'rm /dev/shm/name' removes it)
+ *
+ * @param[in] w: writer
+*/
+void shm_close_writer(struct shm_writer *w);
+
+/**
+ * @function: shm_open_reader
+ * @brief maps shared memory object '/name' read-only, reading starts at the oldest reply still in the ring
+ *
+ * @param[in] r:    reader to initialize
+ * @param[in] name: object name (without the leading '/')
+ * @return 0 if successful, 1 if not
+*/
+int shm_open_reader(struct shm_reader *r, const char *name);
+
+/**
+ * @function: shm_reader_peek
+ * @brief next published reply, in place (valid until 'shm_reader_advance'); its size is read once into
+ *        @param r size and checked to cover its header and stay before the end of the data area, anything
+ *        read beyond that may still be torn until 'shm_reader_advance' says otherwise
+ *
+ * @param[in] r: reader
+ * @return reply record, NULL if there's nothing new yet
+*/
+const struct shm_rec_hdr *shm_reader_peek(struct shm_reader *r);
+
+/**
+ * @function: shm_reader_advance
+ * @brief moves past reply returned by 'shm_reader_peek', checking the writer didn't overwrite it meanwhile
+ *
+ * @param[in] r: reader
+ * @return 'true' if the reply was intact while it was read, 'false' if the reader was lapped
+ *         (the reader then continues at the oldest reply still in the ring)
+*/
+bool shm_reader_advance(struct shm_reader *r);
+
+/**
+ * @function: shm_reader_done
+ * @brief writer closed the ring (or exited) and everything it published was read
+ *
+ * @param[in] r: reader
+ * @return 'true' if nothing more will come
+*/
+bool shm_reader_done(struct shm_reader *r);
+
+/**
+ * @function: shm_close_reader
+ * @brief unmaps ring
+ *
+ * @param[in] r: reader
+*/
+void shm_close_reader(struct shm_reader *r);
+
+#endif
@@ -0,0 +1,91 @@
+/** @file:   spsc.c
+ *  @brief:  Bounded lock-free single-producer/single-consumer ring of preallocated slots
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "spsc.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SPSC_YIELDS       64      //yields before a waiting side starts sleeping
+#define SPSC_SLEEP_NS     20000   //first sleep, doubles with every round after that
+#define SPSC_SLEEP_MAX_NS 1000000 //longest sleep (how late a waiting side notices the other one at most)
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static uint64_t spsc_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//one backoff step of a waiting side (short waits stay on the CPU, long ones don't burn it)
+static void spsc_backoff(unsigned int round){
+    if (round < SPSC_YIELDS){
+        sched_yield();
+        return;
+    }
+    unsigned int shift = round - SPSC_YIELDS;
+    long ns = (shift >= 6) ? SPSC_SLEEP_MAX_NS : (long)SPSC_SLEEP_NS << shift;
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = (ns > SPSC_SLEEP_MAX_NS) ? SPSC_SLEEP_MAX_NS : ns};
+    nanosleep(&ts, NULL);
+}
+
+/*************************************************
+ *                     RING                      *
+*************************************************/
+int spsc_init(struct spsc_ring *r, uint32_t size, size_t elem_size){
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->tail_cache = 0;
+    r->head_cache = 0;
+    r->empty_waits = 0;
+    r->empty_ns = 0;
+    r->commits = 0;
+    r->occupancy_sum = 0;
+    r->occupancy_max = 0;
+    r->full_waits = 0;
+    r->full_ns = 0;
+    r->size = size;
+    r->mask = size - 1;
+    r->elem_size = elem_size;
+    r->elems = calloc(size, elem_size);
+    return (r->elems == NULL) ? 1 : 0;
+}
+
+void spsc_free(struct spsc_ring *r){
+    free(r->elems);
+    r->elems = NULL;
+}
+
+void *spsc_reserve_wait(struct spsc_ring *r){
+    void *slot = spsc_reserve(r);
+    if (slot != NULL){
+        return slot;
+    }
+    r->full_waits++;
+    uint64_t start = spsc_now_ns();
+    for (unsigned int round = 0; (slot = spsc_reserve(r)) == NULL; round++){
+        spsc_backoff(round);
+    }
+    r->full_ns += spsc_now_ns() - start;
+    return slot;
+}
+
+void *spsc_peek_wait(struct spsc_ring *r){
+    void *slot = spsc_peek(r);
+    if (slot != NULL){
+        return slot;
+    }
+    r->empty_waits++;
+    uint64_t start = spsc_now_ns();
+    for (unsigned int round = 0; (slot = spsc_peek(r)) == NULL; round++){
+        spsc_backoff(round);
+    }
+    r->empty_ns += spsc_now_ns() - start;
+    return slot;
+}
@@ -0,0 +1,146 @@
+/** @file:   spsc.h
+ *  @brief:  Bounded lock-free single-producer/single-consumer ring of preallocated slots
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPSC_CACHE_LINE 64 //producer and consumer indexes live on separate lines (no false sharing)
+
+/**
+ * @struct: ring of 'size' fixed-size slots between exactly one producer and one consumer thread
+ *
+ * The producer fills the slot 'spsc_reserve' hands it in place and publishes it with 'spsc_commit';
+ * the consumer reads the slot 'spsc_peek' hands it in place and gives it back with 'spsc_release'.
+ * Nothing is copied or allocated after 'spsc_init'. Each side keeps a cached copy of the other
+ * side's index, so the shared line is only read when the ring looks full (or empty).
+*/
+struct spsc_ring{
+    /* consumer side */
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t head; /* next slot to consume */
+    uint32_t tail_cache;     /* last 'tail' seen by consumer */
+    uint64_t empty_waits;    /* times consumer found ring empty in 'spsc_peek_wait' */
+    uint64_t empty_ns;       /* time consumer spent waiting for a slot to be published */
+    /* producer side */
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t tail; /* next slot to fill */
+    uint32_t head_cache;     /* last 'head' seen by producer */
+    uint64_t commits;
+    uint64_t occupancy_sum;  /* slots in use right after every commit (average occupancy) */
+    uint32_t occupancy_max;
+    uint64_t full_waits;     /* times producer found ring full in 'spsc_reserve_wait' */
+    uint64_t full_ns;        /* time producer spent waiting for a free slot */
+    /* read-only after 'spsc_init' */
+    _Alignas(SPSC_CACHE_LINE) uint32_t size; /* power of two */
+    uint32_t mask;
+    size_t elem_size;
+    unsigned char *elems;
+};
+
+/**
+ * @function: spsc_init
+ * @brief allocates ring slots
+ *
+ * @param[in] r:         ring
+ * @param[in] size:      amount of slots (power of two)
+ * @param[in] elem_size: size of one slot
+ * @return 0 if successful, 1 on allocation failure
+*/
+int spsc_init(struct spsc_ring *r, uint32_t size, size_t elem_size);
+
+/**
+ * @function: spsc_free
+ * @brief frees ring slots
+ *
+ * @param[in] r: ring
+*/
+void spsc_free(struct spsc_ring *r);
+
+/**
+ * @function: spsc_reserve
+ * @brief (producer) free slot to fill, the same one until it's committed
+ *
+ * @param[in] r: ring
+ * @return slot, NULL if ring is full
+*/
+static inline void *spsc_reserve(struct spsc_ring *r){
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (t - r->head_cache == r->size){
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (t - r->head_cache == r->size){
+            return NULL;
+        }
+    }
+    return r->elems + (size_t)(t & r->mask) * r->elem_size;
+}
+
+/**
+ * @function: spsc_commit
+ * @brief (producer) publishes slot returned by 'spsc_reserve' to consumer
+ *
+ * @param[in] r: ring
+*/
+static inline void spsc_commit(struct spsc_ring *r){
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed) + 1;
+    uint32_t used = t - atomic_load_explicit(&r->head, memory_order_relaxed);
+    r->commits++;
+    r->occupancy_sum += used;
+    if (used > r->occupancy_max){
+        r->occupancy_max = used;
+    }
+    atomic_store_explicit(&r->tail, t, memory_order_release);
+}
+
+/**
+ * @function: spsc_peek
+ * @brief (consumer) oldest published slot, the same one until it's released
+ *
+ * @param[in] r: ring
+ * @return slot, NULL if ring is empty
+*/
+static inline void *spsc_peek(struct spsc_ring *r){
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (h == r->tail_cache){
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (h == r->tail_cache){
+            return NULL;
+        }
+    }
+    return r->elems + (size_t)(h & r->mask) * r->elem_size;
+}
+
+/**
+ * @function: spsc_release
+ * @brief (consumer) hands slot returned by 'spsc_peek' back to producer
+ *
+ * @param[in] r: ring
+*/
+static inline void spsc_release(struct spsc_ring *r){
+    atomic_store_explicit(&r->head, atomic_load_explicit(&r->head, memory_order_relaxed) + 1, memory_order_release);
+}
+
+/**
+ * @function: spsc_reserve_wait
+ * @brief (producer) like 'spsc_reserve', but waits (yielding, then sleeping) until a slot is free
+ *
+ * @param[in] r: ring
+ * @return slot
+*/
+void *spsc_reserve_wait(struct spsc_ring *r);
+
+/**
+ * @function: spsc_peek_wait
+ * @brief (consumer) like 'spsc_peek', but waits (yielding, then sleeping) until a slot is published
+ *
+ * @param[in] r: ring
+ * @return slot
+*/
+void *spsc_peek_wait(struct spsc_ring *r);
+
+#endif
@@ -7,6 +7,14 @@
 
 import ctypes
 import subprocess
+import socket
+import struct
+import threading
+import tempfile
+import os
+import time
+import gzip
+import sys
 
 #test cases with successful outcomes
 tests_succ = {
@@ -29,6 +37,18 @@ tests_fails = {
     "testing hostname passed to 'server' but reverse DNS lookup demanded as well": [b'-x', b'-s', b'kazi.fit.vutbr.cz', b'www.fit.vut.cz'],
     "testing nonexistent or unreachable 'address' address/hostname": [b'-r', b'-s', b'kazi.fit.vutbr.cz', b'idont.exist'],
     "testing nonexistent or unreachable 'server' address/hostname": [b'-r', b'-s', b'idont.exist', b'www.fit.vut.cz'],
+    "testing IXFR without '--serial'": [b'-t', b'IXFR', b'-s', b'127.0.0.1', b'example.com'],
+    "testing '--qps' without '--load'": [b'-s', b'127.0.0.1', b'--qps', b'100', b'example.com'],
+    "testing '--monitor' with '-s'": [b'--monitor', b'servers.txt', b'-s', b'127.0.0.1'],
+    "testing '--shm' without '-f'": [b'-s', b'127.0.0.1', b'--shm', b'results', b'example.com'],
+    "testing server pool without '-f'": [b'-s', b'127.0.0.1,127.0.0.2', b'example.com'],
+    "testing '--journal' with stdin": [b'-s', b'127.0.0.1', b'-f', b'-', b'--journal', b'batch.jrn'],
+    "testing '--addresses-only' with '-t MX'": [b'-s', b'127.0.0.1', b'-t', b'MX', b'--addresses-only', b'example.com'],
+    "testing '--compress' without '-f'": [b'-s', b'127.0.0.1', b'--compress', b'gzip', b'example.com'],
+    "testing '--metrics' without '-f'": [b'-s', b'127.0.0.1', b'--metrics', b'/tmp/dns.prom', b'example.com'],
+    "testing trailing junk in '-w'": [b'-s', b'127.0.0.1', b'-f', b'-', b'-w', b'10abc'],
+    "testing trailing junk in '--sockets'": [b'-s', b'127.0.0.1', b'-f', b'-', b'--sockets', b'4x'],
+    "testing unit suffix in '--rcvbuf'": [b'-s', b'127.0.0.1', b'-f', b'-', b'--rcvbuf', b'64k'],
     #add test cases here
 }
 
@@ -48,6 +68,33 @@ dns_tests.hostname_to_DNSname.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
 dns_tests.hostname_to_DNSname.restype = None
 dns_tests.DNSname_to_hostname.argtypes = [ctypes.c_char_p]
 dns_tests.DNSname_to_hostname.restype = None
+dns_tests.name_normalize.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_char_p]
+dns_tests.name_normalize.restype = ctypes.c_size_t
+dns_tests.name_normalize_scalar.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_char_p]
+dns_tests.name_normalize_scalar.restype = ctypes.c_size_t
+dns_tests.name_norm_impl.restype = ctypes.c_char_p
+dns_tests.dns_query_build.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_uint16, ctypes.c_bool]
+dns_tests.dns_query_build.restype = None
+dns_tests.dns_query_patch.argtypes = [ctypes.c_char_p, ctypes.c_uint16, ctypes.c_bool]
+dns_tests.dns_query_patch.restype = None
+dns_tests.addr_format_ipv4.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+dns_tests.addr_format_ipv4.restype = ctypes.c_size_t
+dns_tests.addr_format_ipv6.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+dns_tests.addr_format_ipv6.restype = ctypes.c_size_t
+
+#struct batch_pacer
+class BatchPacer(ctypes.Structure):
+    _fields_ = [('cwnd', ctypes.c_double), ('ssthresh', ctypes.c_double), ('cwnd_max', ctypes.c_double),
+                ('tokens', ctypes.c_double), ('refilled', ctypes.c_uint64), ('srtt_ns', ctypes.c_uint64),
+                ('rttvar_ns', ctypes.c_uint64), ('recovery', ctypes.c_uint64), ('cuts', ctypes.c_ulong)]
+dns_tests.batch_pacer_init.argtypes = [ctypes.POINTER(BatchPacer), ctypes.c_uint64]
+dns_tests.batch_pacer_init.restype = None
+dns_tests.batch_pacer_window.argtypes = [ctypes.POINTER(BatchPacer)]
+dns_tests.batch_pacer_window.restype = ctypes.c_uint
+dns_tests.batch_pacer_ack.argtypes = [ctypes.POINTER(BatchPacer), ctypes.c_uint64, ctypes.c_uint]
+dns_tests.batch_pacer_ack.restype = None
+dns_tests.batch_pacer_loss.argtypes = [ctypes.POINTER(BatchPacer), ctypes.c_uint64, ctypes.c_uint64]
+dns_tests.batch_pacer_loss.restype = None
 
 ### 
 # IPv4/IPv6/hostname validation functions tests
@@ -149,6 +196,1133 @@ class host_dns_nameconversions:
         else:
             print("\t[FAIL]")
 
+###
+# bulk hostname normalization tests (dispatched SIMD kernel against scalar one)
+###
+class name_normalization:
+    def __init__(self):
+        self.total_tests = 6
+        self.successful_tests = 0
+        self.cases = [
+            (b"WWW.Google.com", dns_name("www.google.com")), #not a literal, DNSname_to_hostname test rewrites that one in place
+            (b"Static-Content42.EU-central-1.CDN.Example.net.", dns_name("static-content42.eu-central-1.cdn.example.net")),
+            (b"bad_name!.example.com", b""),
+            (b"a" * 64 + b".com", b""),
+            (b"_sip._TCP.Example.com", dns_name("_sip._tcp.example.com")),
+            (b"_Service-Name._tcp.Mailserver-Cluster.example.org", dns_name("_service-name._tcp.mailserver-cluster.example.org")),
+        ]
+
+    #every case through the dispatched kernel, result has to match the scalar kernel as well
+    def test_name_normalize(self):
+        impl = dns_tests.name_norm_impl().decode()
+        for host, expected in self.cases:
+            print(f"name_normalize ({impl}): \t{host[:24]}", end="")
+            wire = ctypes.create_string_buffer(len(host) + 2)
+            ref = ctypes.create_string_buffer(len(host) + 2)
+            n = dns_tests.name_normalize(host, len(host), wire)
+            m = dns_tests.name_normalize_scalar(host, len(host), ref)
+            if wire.raw[:n] == expected and n == m and ref.raw[:m] == expected:
+                self.successful_tests += 1
+                print("\t[OK]")
+            else:
+                print(f"\t[FAIL] ({wire.raw[:n]})")
+
+###
+# pre-serialized query template tests
+###
+class query_templates:
+    def __init__(self):
+        self.total_tests = 2
+        self.successful_tests = 0
+        self.qname = dns_name("www.google.com")
+        self.query = ctypes.create_string_buffer(272 + 4) #struct dns_query_t
+
+    #header (rd set), qname and question fields serialized at once, length stored after packet
+    def test_query_build(self):
+        print("dns_query_build: www.google.com AAAA:  ", end="")
+        dns_tests.dns_query_build(self.query, self.qname, len(self.qname), 28, True)
+        length = struct.unpack('=H', self.query.raw[272:274])[0]
+        expected = struct.pack('!HHHHH', 0x0100, 1, 0, 0, 0) + self.qname + struct.pack('!HH', 28, 1)
+        if length == len(expected) + 2 and self.query.raw[2:length] == expected:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print("\t[FAIL]")
+
+    #patching only touches ID and RD bit
+    def test_query_patch(self):
+        print("dns_query_patch: ID 0xbeef, no recursion:  ", end="")
+        before = self.query.raw
+        dns_tests.dns_query_patch(self.query, 0xbeef, False)
+        after = self.query.raw
+        if after[0:2] == b'\xbe\xef' and after[2] == before[2] & 0xfe and after[3:] == before[3:]:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print("\t[FAIL]")
+
+###
+# loopback stand-in DNS server (answers every A/AAAA query, counts queries received)
+###
+#hostname --> DNSname (www.google.com --> 3www6google3com0)
+def dns_name(name):
+    return b''.join(bytes([len(l)]) + l.encode() for l in name.split('.') if l) + b'\x00'
+
+#reply to query 'data', records are (name, type, rdata) tuples
+def dns_reply(data, flags = 0x8180, answers = [], authority = [], additional = []):
+    qend = data.index(b'\x00', 12) + 5
+    header = data[:2] + struct.pack('!HHHHH', flags, 1, len(answers), len(authority), len(additional))
+    records = b''
+    for name, rtype, rdata in answers + authority + additional:
+        records += dns_name(name) + struct.pack('!HHIH', rtype, 1, 300, len(rdata)) + rdata
+    return header + data[12:qend] + records
+
+#(qname, qtype) of query 'data'
+def dns_question(data):
+    qend = data.index(b'\x00', 12)
+    labels, i = [], 12
+    while data[i] != 0:
+        labels.append(data[i + 1:i + 1 + data[i]].decode())
+        i += data[i] + 1
+    return '.'.join(labels), struct.unpack('!H', data[qend + 1:qend + 3])[0]
+
+class StandInServer:
+    def __init__(self, delay = 0.0, address = '127.0.0.1', port = 0, answer = None):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind((address, port))
+        self.port = self.sock.getsockname()[1]
+        self.delay = delay
+        self.queries = 0
+        if answer is not None:
+            self.answer = answer
+        self.running = True
+        self.thread = threading.Thread(target = self.serve, daemon = True)
+        self.thread.start()
+
+    #answer for query 'data' (one A record 10.0.0.1 or AAAA record 2001:db8::1)
+    def answer(self, data):
+        qname, qtype = dns_question(data)
+        if qtype == 28:
+            rdata = socket.inet_pton(socket.AF_INET6, '2001:db8::1')
+        else:
+            rdata = socket.inet_aton('10.0.0.1')
+        return dns_reply(data, answers = [(qname, qtype, rdata)])
+
+    def serve(self):
+        self.sock.settimeout(0.1)
+        while self.running:
+            try:
+                data, addr = self.sock.recvfrom(65536)
+            except socket.timeout:
+                continue
+            self.queries += 1
+            reply = self.answer(data)
+            if reply is None:
+                continue
+            if self.delay > 0:
+                threading.Timer(self.delay, self.sock.sendto, (reply, addr)).start()
+            else:
+                self.sock.sendto(reply, addr)
+
+    def close(self):
+        self.running = False
+        self.thread.join()
+        self.sock.close()
+
+#loopback TCP stand-in server, 'stream' turns query into list of messages sent back (length prefixed, in odd sized chunks)
+class StandInTcpServer:
+    def __init__(self, stream):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.sock.bind(('127.0.0.1', 0))
+        self.sock.listen(1)
+        self.port = self.sock.getsockname()[1]
+        self.stream = stream
+        self.query = None
+        self.thread = threading.Thread(target = self.serve, daemon = True)
+        self.thread.start()
+
+    def serve(self):
+        conn, _ = self.sock.accept()
+        length = struct.unpack('!H', conn.recv(2, socket.MSG_WAITALL))[0]
+        self.query = conn.recv(length, socket.MSG_WAITALL)
+        data = b''.join(struct.pack('!H', len(msg)) + msg for msg in self.stream(self.query))
+        for i in range(0, len(data), 7777):
+            conn.sendall(data[i:i + 7777])
+        conn.close()
+
+    def close(self):
+        self.thread.join()
+        self.sock.close()
+
+###
+# batch mode tests (run against loopback stand-in server)
+###
+class batch_mode:
+    def __init__(self):
+        self.total_tests = 5
+        self.successful_tests = 0
+
+    #run ./dns in batch mode over 'names', return (returncode, stdout, stderr)
+    def run_batch(self, server, names, extra_args = []):
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write('\n'.join(names) + '\n')
+            path = f.name
+        process = subprocess.Popen(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '-f', path] + extra_args,
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        os.unlink(path)
+        return process.returncode, stdout.decode(), stderr.decode()
+
+    #replies claiming records they don't carry (none at all, one of three, five of six past the inline
+    #result slot) are rejected, not printed
+    def test_malformed_replies(self):
+        print("batch: truncated replies rejected:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            reply = dns_reply(data, answers = [(qname, 16, bytes([255]) + b'x' * 255) for i in range(5)])
+            if qname.startswith("empty"):
+                return reply[:2] + struct.pack('!HHHHH', 0x8180, 1, 5, 0, 0) + reply[12:data.index(b'\x00', 12) + 5]
+            if qname.startswith("cut"):
+                return reply[:6] + struct.pack('!H', 3) + reply[8:data.index(b'\x00', 12) + 5 + len(dns_name(qname)) + 10 + 256]
+            if qname.startswith("big"):
+                return reply[:6] + struct.pack('!H', 6) + reply[8:]
+            return dns_reply(data, answers = [(qname, 1, socket.inet_aton('10.0.0.1'))])
+        server = StandInServer(answer = answer)
+        code, out, err = self.run_batch(server, ["empty.example.com", "cut.example.com", "big.example.com", "good.example.com"])
+        server.close()
+        if (out.count("Answer Section(1)") == 1 and "good.example.com" in out and "empty" not in out and "cut" not in out and
+            "big" not in out and err.count("is malformed") == 3):
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({out!r} {err[-300:]!r})")
+
+    #200 lines of 5 distinct names: every duplicate has to attach to the in-flight query
+    def test_coalescing(self):
+        print("batch: coalescing duplicate names:  ", end="")
+        server = StandInServer(delay = 0.3)
+        names = [f"host{i % 5}.example.com" for i in range(200)]
+        code, out, err = self.run_batch(server, names)
+        server.close()
+        if code == 0 and out.count("Answer Section(1)") == 200 and server.queries == 5:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] (sent {server.queries} queries)")
+
+    #names streamed through stdin: CRLF endings, comments, blank lines, a line longer than the
+    #read buffer (rejected as invalid) and a last line without newline
+    def test_stdin_stream(self):
+        print("batch: streamed stdin input:  ", end="")
+        server = StandInServer()
+        names = [f"host{i}.example.com" for i in range(3000)]
+        data = b'# comment\r\n\n' + b'x' * (3 << 20) + b'\n' + '\r\n'.join(names).encode()
+        process = subprocess.Popen(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '-f', '-'],
+                                   stdin = subprocess.PIPE, stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(data, timeout = 60)
+        server.close()
+        out, err = stdout.decode(), stderr.decode()
+        if out.count("Answer Section(1)") == 3000 and "host2999.example.com" in out and \
+           "3000 names" in err and "1 invalid names" in err:
+            self.successful_tests += 1
+            print("\t\t[OK]")
+        else:
+            print("\t\t[FAIL]")
+
+    #queries spread over a pool of sockets, each bound to its own source port
+    def test_socket_pool(self):
+        print("batch: source port socket pool:  ", end="")
+        server = StandInServer()
+        names = [f"host{i}.example.com" for i in range(500)]
+        code, out, err = self.run_batch(server, names, ['--sockets', '4', '--rcvbuf', '1048576'])
+        server.close()
+        line = next((l for l in err.splitlines() if l.startswith("Sockets:")), "")
+        ports = line.split(" on ports ")[1].split(",")[0].split() if " on ports " in line else []
+        if code == 0 and out.count("Answer Section(1)") == 500 and len(set(ports)) == 4 and "dropped by kernel" in line:
+            self.successful_tests += 1
+            print("\t\t[OK]")
+        else:
+            print(f"\t\t[FAIL] ({line})")
+
+    #stdout not read for a while: replies wait in socket buffers (no retransmits), nothing is lost once it drains
+    def test_stalled_output(self):
+        print("batch: stalled stdout consumer:  ", end="")
+        server = StandInServer()
+        names = [f"host{i}.example.com" for i in range(3000)]
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write('\n'.join(names) + '\n')
+            path = f.name
+        process = subprocess.Popen(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '-f', path],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        time.sleep(1.5) #pipe fills up, output thread blocks in write
+        stdout, stderr = process.communicate(timeout = 60)
+        os.unlink(path)
+        server.close()
+        out, err = stdout.decode(), stderr.decode()
+        line = next((l for l in err.splitlines() if l.startswith("Pipeline:")), "")
+        paused = float(line.split("I/O paused ")[1].split(" s")[0]) if "I/O paused " in line else 0.0
+        if process.returncode == 0 and out.count("Answer Section(1)") == 3000 and server.queries == 3000 and paused > 0.5:
+            self.successful_tests += 1
+            print("\t\t[OK]")
+        else:
+            print(f"\t\t[FAIL] (sent {server.queries} queries, {line})")
+
+###
+# loss-aware pacing tests (AIMD window)
+###
+class batch_pacing:
+    def __init__(self):
+        self.total_tests = 2
+        self.successful_tests = 0
+
+    #window doubles per round trip until first loss, is halved once per round trip, then grows by one per round trip
+    def test_aimd(self):
+        print("batch_pacer: slow start, cut, additive increase:  ", end="")
+        p = BatchPacer()
+        ms = 1000000
+        dns_tests.batch_pacer_init(ctypes.byref(p), 0)
+        start = dns_tests.batch_pacer_window(ctypes.byref(p))
+        for i in range(start):
+            dns_tests.batch_pacer_ack(ctypes.byref(p), 1 * ms, 1024)
+        doubled = dns_tests.batch_pacer_window(ctypes.byref(p))
+        dns_tests.batch_pacer_loss(ctypes.byref(p), 2 * ms, 5 * ms)
+        halved = dns_tests.batch_pacer_window(ctypes.byref(p))
+        dns_tests.batch_pacer_loss(ctypes.byref(p), 3 * ms, 6 * ms) #sent before the cut, ignored
+        for i in range(halved + 1): #1/cwnd per reply, slightly more than one window of replies adds one
+            dns_tests.batch_pacer_ack(ctypes.byref(p), 1 * ms, 1024)
+        grown = dns_tests.batch_pacer_window(ctypes.byref(p))
+        if doubled == 2 * start and halved == start and p.cuts == 1 and grown == start + 1:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({start} {doubled} {halved} {grown})")
+
+    #server refusing queries at first: window gets cut, every name still gets its reply printed
+    def test_refused_backoff(self):
+        print("batch: window cut on REFUSED replies:  ", end="")
+        server = StandInServer()
+        plain = server.answer
+        def answer(data):
+            if server.queries <= 40:
+                return dns_reply(data, flags = 0x8185) #REFUSED
+            return plain(data)
+        server.answer = answer
+        names = [f"host{i}.example.com" for i in range(400)]
+        code, out, err = batch_mode().run_batch(server, names)
+        server.close()
+        if code == 0 and out.count("Question Section(1)") == 400 and "40 SERVFAIL/REFUSED" in err and " 0 cuts" not in err:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({err.strip()})")
+
+###
+# io_uring backend tests (-u, plain sockets are used where the kernel lacks io_uring)
+###
+class uring_backend:
+    def __init__(self):
+        self.total_tests = 2
+        self.successful_tests = 0
+
+    #batch through io_uring: every name answered, same output as over plain sockets
+    def test_batch(self):
+        print("io_uring: batch send/receive:  ", end="")
+        server = StandInServer()
+        names = [f"host{i}.example.com" for i in range(2000)]
+        code, out, err = batch_mode().run_batch(server, names, ['-u'])
+        _, plain_out, _ = batch_mode().run_batch(server, names)
+        server.close()
+        if code == 0 and out.count("Answer Section(1)") == 2000 and sorted(out.splitlines()) == sorted(plain_out.splitlines()) and \
+           ("receives in" in err or "WARNING: io_uring isn't available" in err):
+            self.successful_tests += 1
+            print("\t\t[OK]")
+        else:
+            print(f"\t\t[FAIL] ({err.strip()})")
+
+    #single query through io_uring
+    def test_single(self):
+        print("io_uring: single query:  ", end="")
+        server = StandInServer()
+        process = subprocess.Popen(['./dns', '-u', '-s', '127.0.0.1', '-p', str(server.port), 'localhost'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        server.close()
+        if process.returncode == 0 and "localhost., A, IN, 300, 10.0.0.1" in stdout.decode():
+            self.successful_tests += 1
+            print("\t\t[OK]")
+        else:
+            print("\t\t[FAIL]")
+
+###
+# phase tracing tests (--trace-phases)
+###
+class phase_tracing:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #every phase of a single lookup gets exactly one sample, output isn't affected
+    def test_single_phases(self):
+        print("trace: phases of a single lookup:  ", end="")
+        server = StandInServer()
+        process = subprocess.Popen(['./dns', '--trace-phases', '-s', '127.0.0.1', '-p', str(server.port), 'localhost'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        server.close()
+        rows = [line.split() for line in stderr.decode().splitlines()]
+        counts = {row[0]: row[1] for row in rows if len(row) == 8}
+        if process.returncode == 0 and "10.0.0.1" in stdout.decode() and \
+           all(counts.get(phase) == "1" for phase in ("validate", "qname", "socket", "wire", "decode", "print")):
+            self.successful_tests += 1
+            print("\t\t[OK]")
+        else:
+            print(f"\t\t[FAIL] ({stderr.decode().strip()})")
+
+###
+# columnar output tests (-o, read back with dnscol)
+###
+class columnar_output:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #binary output converted back has to match text output (address and text rdata, coalesced duplicates)
+    def test_roundtrip(self):
+        print("columnar: -o output read back by dnscol:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            return dns_reply(data, answers = [(qname, 1, socket.inet_aton('10.0.0.1')),
+                                              (qname, 28, socket.inet_pton(socket.AF_INET6, '2001:db8::1')),
+                                              (qname, 15, struct.pack('!H', 10) + dns_name('mail.example.com'))])
+        server = StandInServer(delay = 0.1, answer = answer)
+        names = [f"host{i % 300}.example.com" for i in range(1000)]
+        _, text, _ = batch_mode().run_batch(server, names)
+        path = tempfile.mktemp(suffix = '.col')
+        code, out, err = batch_mode().run_batch(server, names, ['-o', path])
+        server.close()
+        process = subprocess.Popen(['./dnscol', path], stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        size = os.path.getsize(path)
+        os.unlink(path)
+        back = stdout.decode()
+        if code == 0 and out == "" and process.returncode == 0 and back.count("Answer Section(3)") == 1000 and \
+           sorted(back.splitlines()) == sorted(text.splitlines()) and size < len(text) / 2:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({size} bytes vs. {len(text)} of text, {stderr.decode().strip()})")
+
+###
+# shared-memory result ring tests (--shm, read back with dnsshm)
+###
+class shared_memory_ring:
+    def __init__(self):
+        self.total_tests = 2
+        self.successful_tests = 0
+
+    def read_ring(self, name):
+        process = subprocess.Popen(['./dnsshm', name], stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        err = stderr.decode()
+        field = lambda label: int(err.split(label)[0].split()[-1]) if label in err else -1
+        return process.returncode, stdout.decode(), field(" replies read"), field(" lost to overruns"), err
+
+    #replies read from the ring have to match text output (address and text rdata, coalesced duplicates)
+    def test_roundtrip(self):
+        print("shm: --shm ring read back by dnsshm:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            return dns_reply(data, answers = [(qname, 1, socket.inet_aton('10.0.0.1')),
+                                              (qname, 15, struct.pack('!H', 10) + dns_name('mail.example.com'))])
+        server = StandInServer(delay = 0.1, answer = answer)
+        names = [f"host{i % 300}.example.com" for i in range(1000)]
+        _, text, _ = batch_mode().run_batch(server, names)
+        name = f"dns_tests_{os.getpid()}"
+        code, out, err = batch_mode().run_batch(server, names, ['--shm', name])
+        server.close()
+        rcode, back, read, lost, rerr = self.read_ring(name)
+        os.unlink(f"/dev/shm/{name}")
+        published = int(err.split(" replies published")[0].split()[-1]) if " replies published" in err else -1
+        if code == 0 and out == "" and rcode == 0 and read == published and lost == 0 and back.count("Answer Section(2)") == 1000 and \
+           sorted(back.splitlines()) == sorted(text.splitlines()):
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({err.strip()} {rerr.strip()})")
+
+    #writer never waits: a small ring keeps only the newest replies, the reader counts the rest as lost
+    def test_overrun(self):
+        print("shm: overrun ring counted as lost:  ", end="")
+        server = StandInServer()
+        names = [f"host{i}.example.com" for i in range(3000)]
+        name = f"dns_tests_{os.getpid()}"
+        code, _, err = batch_mode().run_batch(server, names, ['--shm', name, '--shm-size', '65536'])
+        server.close()
+        rcode, back, read, lost, rerr = self.read_ring(name)
+        os.unlink(f"/dev/shm/{name}")
+        if code == 0 and rcode == 0 and 0 < read < 3000 and read + lost == 3000 and back.count("Answer Section") == read and \
+           "wrapped 0 times" not in err:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({err.strip()} {rerr.strip()})")
+
+###
+# server pool tests (-s a,b,c with -f)
+###
+class server_pool:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #stand-in server remembering which names it was asked for
+    def logging_server(self):
+        server = StandInServer()
+        server.names = set()
+        plain = server.answer
+        def answer(data):
+            server.names.add(dns_question(data)[0])
+            return plain(data)
+        server.answer = answer
+        return server
+
+    def run_pool(self, servers, names):
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write('\n'.join(names) + '\n')
+            path = f.name
+        pool = ','.join(f"127.0.0.1#{s.port}" for s in servers)
+        process = subprocess.Popen(['./dns', '-s', pool, '-f', path], stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        os.unlink(path)
+        return process.returncode, stdout.decode(), stderr.decode()
+
+    #names of one domain stay on one server, a dead server's domains (and only those) move to the others
+    def test_spread_and_failover(self):
+        print("pool: consistent hashing and failover:  ", end="")
+        servers = [self.logging_server() for _ in range(3)]
+        names = [f"host{i}.domain{i % 60}.com" for i in range(300)]
+        domain = lambda name: name.split('.', 1)[1]
+        code, out, err = self.run_pool(servers, names)
+        before = [set(domain(n) for n in s.names) for s in servers]
+        spread = all(before) and sum(len(d) for d in before) == 60
+
+        servers[2].close()
+        for s in servers[:2]:
+            s.names = set()
+        code2, out2, err2 = self.run_pool(servers, names)
+        after = [set(domain(n) for n in s.names) for s in servers[:2]]
+        for s in servers[:2]:
+            s.names.clear()
+            s.close()
+        stayed = before[0] <= after[0] and before[1] <= after[1] and not (after[0] & before[1]) and not (after[1] & before[0])
+        if code == 0 and out.count("Answer Section(1)") == 300 and spread and code2 == 0 and \
+           out2.count("Answer Section(1)") == 300 and stayed and (after[0] | after[1]) == before[0] | before[1] | before[2] and \
+           "out of the ring 1 times (still out)" in err2:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({[len(d) for d in before]} {err2.strip()})")
+
+###
+# checkpoint journal tests (--journal)
+###
+class checkpoint_journal:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #stand-in server logging the names asked, 'stuck' ones are never answered
+    def logging_server(self, stuck):
+        server = StandInServer()
+        server.names = []
+        plain = server.answer
+        def answer(data):
+            qname = dns_question(data)[0]
+            server.names.append(qname)
+            return None if qname in stuck else plain(data)
+        server.answer = answer
+        return server
+
+    #run killed with a query in flight, rerun sends only that one, output of both covers every name once
+    def test_kill_and_resume(self):
+        print("journal: resume after kill:  ", end="")
+        directory = tempfile.mkdtemp()
+        path, journal, out = (os.path.join(directory, f) for f in ("names.txt", "batch.jrn", "out.txt"))
+        names = [f"host{i}.example.com" for i in range(200)]
+        names[50] = "stuck.example.com"
+        with open(path, 'w') as f:
+            f.write('\n'.join(names) + '\n')
+        size = lambda: os.path.getsize(journal) if os.path.exists(journal) else 0
+
+        #kill right after the second checkpoint (the first one is written with the first reply),
+        #while 'stuck' is still being retransmitted
+        server = self.logging_server({"stuck.example.com"})
+        with open(out, 'wb') as f:
+            process = subprocess.Popen(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '-f', path, '--journal', journal],
+                                       stdout = f, stderr = subprocess.DEVNULL)
+            deadline = time.time() + 10
+            while size() <= 32 and time.time() < deadline: #header only
+                time.sleep(0.005)
+            first = size()
+            while size() <= first and time.time() < deadline:
+                time.sleep(0.005)
+            process.kill()
+            process.wait()
+        server.close()
+
+        server = self.logging_server(set())
+        with open(out, 'ab') as f:
+            process = subprocess.run(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '-f', path, '--journal', journal],
+                                     stdout = f, stderr = subprocess.PIPE, timeout = 60)
+        resumed = server.names
+        again = subprocess.run(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '-f', path, '--journal', journal],
+                               stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+        server.close()
+        with open(out) as f:
+            text = f.read()
+        if process.returncode == 0 and resumed == ["stuck.example.com"] and \
+           all(text.count(f"{n}., A, IN, 300") == 1 for n in names) and \
+           "199 queries done by an earlier run skipped" in process.stderr.decode() and \
+           again.returncode == 0 and again.stdout == b'' and "200 queries done by an earlier run skipped" in again.stderr.decode():
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({resumed[:5]} {process.stderr.decode().strip()})")
+        for f in (path, journal, out):
+            os.unlink(f)
+        os.rmdir(directory)
+
+###
+# zone transfer tests (-t AXFR, -t IXFR over TCP)
+###
+class zone_transfer:
+    def __init__(self):
+        self.total_tests = 2
+        self.successful_tests = 0
+
+    def soa(self, serial):
+        return ('example.com', 6, dns_name('ns.example.com') + dns_name('admin.example.com') + struct.pack('!IIIII', serial, 7200, 3600, 1209600, 300))
+
+    def run_xfr(self, server, args):
+        process = subprocess.Popen(['./dns', '-s', '127.0.0.1', '-p', str(server.port)] + args + ['example.com'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        server.close()
+        return process.returncode, stdout.decode(), stderr.decode()
+
+    #20000 records over many messages (split across reads), closing SOA ends transfer
+    def test_axfr(self):
+        print("xfr: streamed AXFR:  ", end="")
+        def stream(query):
+            records = [self.soa(7)] + [(f'host{i}.example.com', 1, socket.inet_aton(f'10.0.{i // 256 % 256}.{i % 256}')) for i in range(20000)] + [self.soa(7)]
+            return [dns_reply(query, flags = 0x8400, answers = records[i:i + 300]) for i in range(0, len(records), 300)]
+        server = StandInTcpServer(stream)
+        code, out, err = self.run_xfr(server, ['-t', 'AXFR'])
+        if code == 0 and out.count(", A, IN, 300, 10.0.") == 20000 and out.count(", SOA, IN,") == 1 and \
+           "host19999.example.com., A, IN, 300, 10.0.78.31" in out and "20002 records in 67 messages" in err and \
+           struct.unpack('!H', server.query[2:4])[0] & 0x0100 == 0:
+            self.successful_tests += 1
+            print("\t\t\t[OK]")
+        else:
+            print(f"\t\t\t[FAIL] ({err.strip()})")
+
+    #request carries our serial in authority SOA, reply holds two difference sequences (1 --> 2 --> 3)
+    def test_ixfr(self):
+        print("xfr: IXFR difference sequences:  ", end="")
+        def stream(query):
+            records = [self.soa(3), self.soa(1), ('old.example.com', 1, socket.inet_aton('10.0.0.1')),
+                       self.soa(2), ('mid.example.com', 1, socket.inet_aton('10.0.0.2')),
+                       self.soa(2), ('mid.example.com', 1, socket.inet_aton('10.0.0.2')),
+                       self.soa(3), ('new.example.com', 1, socket.inet_aton('10.0.0.3')), ('new.example.com', 1, socket.inet_aton('10.0.0.4')),
+                       self.soa(3)]
+            return [dns_reply(query, flags = 0x8400, answers = records[:4]), dns_reply(query, flags = 0x8400, answers = records[4:])]
+        server = StandInTcpServer(stream)
+        code, out, err = self.run_xfr(server, ['-t', 'IXFR', '--serial', '1'])
+        nscount = struct.unpack('!H', server.query[8:10])[0]
+        if code == 0 and nscount == 1 and struct.unpack('!I', server.query[-20:-16])[0] == 1 and \
+           out.count("Deleted Records") == 2 and "Added Records(serial 3)" in out and "10.0.0.4" in out and \
+           "4 deleted, 5 added" in err:
+            self.successful_tests += 1
+            print("\t\t[OK]")
+        else:
+            print(f"\t\t[FAIL] ({err.strip()})")
+
+###
+# load generation tests (--load, against loopback stand-in server)
+###
+class load_generation:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #paced replay of a query file: rate held, dropped queries reported lost, rcodes counted
+    def test_rate_and_loss(self):
+        print("load: target rate, loss and rcodes:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            if qname.startswith('drop'):
+                return None
+            if qname.startswith('nx'):
+                return dns_reply(data, flags = 0x8183)
+            return dns_reply(data, answers = [(qname, 1, socket.inet_aton('10.0.0.1'))])
+        server = StandInServer(answer = answer)
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write('# name type\n' + ''.join(f'host{i}.example.com A\n' for i in range(5)) +
+                    ''.join(f'nx{i}.example.com AAAA\n' for i in range(3)) + 'drop0.example.com\ndrop1.example.com MX\n')
+            path = f.name
+        process = subprocess.Popen(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '--load', path, '--qps', '500',
+                                    '--duration', '1', '--timeout', '0.3', '--interval', '0.5'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        os.unlink(path)
+        server.close()
+        out = stdout.decode()
+        field = lambda name: int(out.split(name)[1].split()[0]) if name in out else -1
+        sent, completed, lost = field("Queries sent:"), field("Queries completed:"), field("Queries lost:")
+        noerror, nxdomain = field(" NOERROR "), field(" NXDOMAIN ")
+        cycles, rest = sent // 10, sent % 10 #file is replayed in order: 5 answered, 3 NXDOMAIN, 2 dropped
+        if process.returncode == 0 and abs(sent - 500) <= 25 and completed + lost == sent and lost == cycles * 2 + max(0, rest - 8) and \
+           noerror == cycles * 5 + min(rest, 5) and nxdomain == cycles * 3 + min(max(0, rest - 5), 3) and \
+           out.count(" s] sent ") >= 2 and "p99.9" in out:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({out.strip()} {stderr.decode().strip()})")
+
+###
+# probe mode tests (--monitor)
+###
+class monitor_mode:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #rounds staggered per server: answering server healthy, dropping one lost, SERVFAIL counted as error
+    def test_rounds(self):
+        print("monitor: rounds and rolling windows: ", end="")
+        healthy = StandInServer()
+        dropping = StandInServer(answer = lambda data: None)
+        failing = StandInServer(answer = lambda data: dns_reply(data, flags = 0x8182))
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write(f'# servers\nserver 127.0.0.1 {healthy.port}\nserver 127.0.0.1 {dropping.port}\n'
+                    f'server 127.0.0.1 {failing.port}\nquery example.com\nquery example.com AAAA\n')
+            path = f.name
+        process = subprocess.Popen(['./dns', '--monitor', path, '--interval', '0.25', '--timeout', '0.1', '--duration', '1'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        os.unlink(path)
+        for server in (healthy, dropping, failing):
+            server.close()
+        lines = {}
+        for line in stdout.decode().splitlines():
+            fields = line.split()
+            lines.setdefault(fields[1], []).append(dict(f.split('=') for f in fields[2:]))
+        rounds = lambda port: lines.get(f'127.0.0.1#{port}', [])
+        if process.returncode == 0 and len(lines) == 3 and all(len(rounds(s.port)) == 4 for s in (healthy, dropping, failing)) and \
+           all(r['ok'] == '2/2' and r['win'] == '100.00%' for r in rounds(healthy.port)) and \
+           all(r['lost'] == '2' and r['win'] == '0.00%' and r['p50'] == '-' for r in rounds(dropping.port)) and \
+           all(r['err'] == '2' and r['lost'] == '0' for r in rounds(failing.port)) and \
+           dropping.queries == 8 and "12 rounds" in stderr.decode():
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({stdout.decode().strip()} {stderr.decode().strip()})")
+
+###
+# USDT probe tests (stapsdt notes in the binary, read with readelf)
+###
+class usdt_probes:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+        self.probes = {"query_build": 4, "query_send": 6, "reply_receive": 3, "reply_match": 5, "reply_mismatch": 3,
+                       "query_timeout": 5, "decode_start": 4, "decode_end": 4, "print": 4}
+
+    #every probe is in the binary with its argument count, its semaphore points to dns_<probe>_semaphore
+    def test_probe_notes(self):
+        print("usdt: probe notes and semaphores:  ", end="")
+        try:
+            notes = subprocess.run(['readelf', '-n', './dns'], capture_output = True, timeout = 60).stdout.decode()
+            symbols = subprocess.run(['readelf', '-sW', './dns'], capture_output = True, timeout = 60).stdout.decode()
+        except FileNotFoundError:
+            print("\t[SKIP] (no readelf)")
+            self.successful_tests += 1
+            return
+        if "Provider: dns" not in notes: #built with 'make PROBES=0'
+            print("\t[SKIP] (probes compiled out)")
+            self.successful_tests += 1
+            return
+        semaphores = {f[7]: int(f[1], 16) for f in (l.split() for l in symbols.splitlines()) if len(f) == 8 and f[7].endswith("_semaphore")}
+        found, bad = {}, []
+        for block in notes.split("stapsdt")[1:]:
+            fields = dict(l.strip().split(": ", 1) for l in block.splitlines() if ": " in l)
+            if fields.get("Provider") != "dns":
+                continue
+            name = fields["Name"]
+            found[name] = found.get(name, 0) + 1
+            semaphore = int(fields["Location"].split("Semaphore: ")[1], 16)
+            if len(fields["Arguments"].split()) != self.probes.get(name) or semaphores.get(f"dns_{name}_semaphore") != semaphore:
+                bad.append(name)
+        if set(found) == set(self.probes) and not bad:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] (missing {set(self.probes) - set(found)}, wrong {bad})")
+
+###
+# typed rdata decoding tests (-t TYPE)
+###
+class rr_types:
+    def __init__(self):
+        self.total_tests = 6
+        self.successful_tests = 0
+        self.records = {
+            15: (struct.pack('!H', 10) + dns_name('mail.example.com'), "MX, IN, 300, 10 mail.example.com"),
+            6:  (dns_name('ns.example.com') + dns_name('admin.example.com') + struct.pack('!IIIII', 2023111901, 7200, 3600, 1209600, 300),
+                 "SOA, IN, 300, ns.example.com admin.example.com 2023111901 7200 3600 1209600 300"),
+            16: (b'\x05hello\x07"world"', 'TXT, IN, 300, "hello" "\\"world\\""'),
+            33: (struct.pack('!HHH', 10, 5, 5060) + dns_name('sip.example.com'), "SRV, IN, 300, 10 5 5060 sip.example.com"),
+        }
+
+    #query every type, check its rdata is printed in presentation format
+    def test_types(self):
+        server = StandInServer(answer = lambda data: dns_reply(data, answers = [(dns_question(data)[0], dns_question(data)[1],
+                                                                                 self.records[dns_question(data)[1]][0])]))
+        #service owner names (underscore labels) have no address, they must not need one
+        for name, code, host in (("MX", 15, 'localhost'), ("SOA", 6, 'localhost'), ("TXT", 16, 'localhost'),
+                                 ("SRV", 33, '_sip._tcp.example.com')):
+            print(f"rrtypes: -t {name} rdata decoding:  ", end="")
+            process = subprocess.Popen(['./dns', '-t', name, '-s', '127.0.0.1', '-p', str(server.port), host],
+                                       stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+            stdout, stderr = process.communicate(timeout = 60)
+            if process.returncode == 0 and f"{host}., {self.records[code][1]}" in stdout.decode():
+                self.successful_tests += 1
+                print("\t[OK]")
+            else:
+                print("\t[FAIL]")
+        server.close()
+
+    #unregistered types are printed as TYPE<n> next to their RFC 3597 generic rdata
+    def test_unknown_type(self):
+        print("rrtypes: unregistered type name:  ", end="")
+        server = StandInServer(answer = lambda data: dns_reply(data, answers = [('localhost', 1, b'\x7f\x00\x00\x01'),
+                                                                                ('localhost', 65280, b'\xab\xcd')]))
+        process = subprocess.Popen(['./dns', '-s', '127.0.0.1', '-p', str(server.port), 'localhost'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        server.close()
+        if process.returncode == 0 and "localhost., TYPE65280, IN, 300, \\# 2 abcd" in stdout.decode():
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({stdout.decode()})")
+
+    #A/AAAA formatters have to print exactly what inet_ntop prints (RFC 5952 compression, mapped IPv4)
+    def test_address_formatting(self):
+        print("rrtypes: A/AAAA formatters vs. inet_ntop:  ", end="")
+        addresses = ['::', '::1', '1::', '2001:db8::1', '2001:db8:0:1:0:0:0:1', '2001:0:0:1::1', 'fe80::1:0:0:1',
+                     '::ffff:10.0.0.1', '::10.0.0.1', '1:0:2:0:3:0:4:0', '2001:db8:85a3::8a2e:370:7334']
+        packed = [socket.inet_pton(socket.AF_INET6, a) for a in addresses]
+        for i in range(2000):
+            packed.append(bytes(b if (i >> (j // 2)) & 1 else 0 for j, b in enumerate(os.urandom(16))))
+        out = ctypes.create_string_buffer(46)
+        bad = [p for p in packed if dns_tests.addr_format_ipv6(p, out) != len(socket.inet_ntop(socket.AF_INET6, p)) or
+               out.value.decode() != socket.inet_ntop(socket.AF_INET6, p)]
+        bad += [p for p in (b'\x00\x00\x00\x00', b'\xff\xff\xff\xff', b'\x0a\x00\x64\x09')
+                if dns_tests.addr_format_ipv4(p, out) == 0 or out.value.decode() != socket.inet_ntoa(p)]
+        if not bad:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({bad[0].hex()})")
+
+###
+# dual-stack tests (A and AAAA in one round trip)
+###
+class dual_stack:
+    def __init__(self):
+        self.total_tests = 2
+        self.successful_tests = 0
+
+    #both replies share a CNAME, which has to be printed once, and both arrive within one delay
+    def test_dual_stack(self):
+        print("dual-stack: A + AAAA in one round trip:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            if qtype == 28:
+                address = (28, socket.inet_pton(socket.AF_INET6, '2001:db8::1'))
+            else:
+                address = (1, socket.inet_aton('10.0.0.1'))
+            return dns_reply(data, answers = [(qname, 5, dns_name('real.example.com')), ('real.example.com',) + address])
+        server = StandInServer(delay = 0.5, answer = answer)
+        start = time.monotonic()
+        process = subprocess.Popen(['./dns', '-d', '-s', '127.0.0.1', '-p', str(server.port), 'localhost'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        elapsed = time.monotonic() - start
+        server.close()
+        out = stdout.decode()
+        if process.returncode == 0 and "Question Section(2)" in out and "Answer Section(3)" in out and \
+           out.count("CNAME") == 1 and "10.0.0.1" in out and "2001:db8::1" in out and elapsed < 0.9:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({elapsed:.2f} s)")
+
+    #AAAA reply cut inside its CNAME (the shared chain walk must stop at the received length)
+    def test_truncated_aaaa(self):
+        print("dual-stack: truncated AAAA reply:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            reply = dns_reply(data, answers = [(qname, 5, dns_name('real.example.com')),
+                                               ('real.example.com', 1, socket.inet_aton('10.0.0.1'))])
+            if qtype == 28: #ends 3 bytes into the CNAME rdata
+                return reply[:data.index(b'\x00', 12) + 5 + len(dns_name(qname)) + 10 + 3]
+            return reply
+        server = StandInServer(answer = answer)
+        process = subprocess.Popen(['./dns', '-d', '-s', '127.0.0.1', '-p', str(server.port), 'localhost'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        server.close()
+        if process.returncode == 1 and "ERROR: malformed reply" in stderr.decode() and "10.0.0.1" not in stdout.decode():
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({process.returncode}, {stderr.decode()})")
+
+###
+# addresses-only fast path tests (--addresses-only)
+###
+class addresses_only:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #CNAME chain (owners written in full, in other case), a record off the chain, authority and NXDOMAIN
+    def test_batch(self):
+        print("addresses only: CNAME chains, NXDOMAIN:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            if qname.startswith("missing"):
+                return dns_reply(data, flags = 0x8183, authority = [('example.com', 6, b'\x00' * 22)])
+            if qtype == 28:
+                address = lambda i: socket.inet_pton(socket.AF_INET6, f'2001:db8::{i}')
+            else:
+                address = lambda i: socket.inet_aton(f'10.0.0.{i}')
+            return dns_reply(data, answers = [(qname, 5, dns_name('Edge.CDN.example.net')), ('other.example.com', qtype, address(9)),
+                                              ('edge.cdn.EXAMPLE.net', qtype, address(1)), ('edge.cdn.example.net', qtype, address(2))],
+                             authority = [('example.net', 2, dns_name('ns.example.net'))])
+        server = StandInServer(answer = answer)
+        code, out, err = batch_mode().run_batch(server, ["www.example.com", "missing.example.com"], ['-d', '--addresses-only'])
+        server.close()
+        expected = ["www.example.com. 10.0.0.1", "www.example.com. 10.0.0.2", "www.example.com. 2001:db8::1",
+                    "www.example.com. 2001:db8::2", "missing.example.com. NXDOMAIN", "missing.example.com. NXDOMAIN"]
+        if code == 0 and sorted(out.replace('\r', '').split('\n')[:-1]) == sorted(expected):
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({out!r})")
+
+###
+# compressed output tests (gzip stream of a batch has to decompress to the text an uncompressed run prints)
+###
+class compressed_output:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #enough names for several chunks of text, records sorted as output order isn't fixed
+    def test_gzip(self):
+        print("compressed output: gzip round trip:  ", end="")
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write(''.join(f"host{i}.example.com\n" for i in range(3000)))
+            path = f.name
+        server = StandInServer()
+        runs = []
+        for extra in ([], ['--compress', 'gzip:6']):
+            process = subprocess.run(['./dns', '-s', '127.0.0.1', '-p', str(server.port), '-f', path] + extra,
+                                     capture_output = True, timeout = 60)
+            runs.append(process)
+        server.close()
+        os.unlink(path)
+        try:
+            text = gzip.decompress(runs[1].stdout)
+        except OSError:
+            text = None
+        if (runs[0].returncode == 0 and runs[1].returncode == 0 and text is not None and
+            sorted(text.split(b'\n')) == sorted(runs[0].stdout.split(b'\n')) and b"Compression: gzip level 6" in runs[1].stderr):
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({runs[1].stderr[-300:]!r})")
+
+###
+# metrics export tests (counters of a batch run written to a textfile in Prometheus format)
+###
+class metrics_export:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #every name answered once (NOERROR or NXDOMAIN), one truncated reply, one claiming records it doesn't carry,
+    #file holds the final counts
+    def test_textfile(self):
+        print("metrics: textfile counters:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            if qname.startswith("missing"):
+                return dns_reply(data, flags = 0x8183)
+            if qname.startswith("broken"):
+                return data[:2] + struct.pack('!HHHHH', 0x8180, 1, 2, 0, 0) + data[12:]
+            return dns_reply(data, flags = 0x8380 if qname.startswith("big") else 0x8180,
+                             answers = [(qname, 1, socket.inet_aton('10.0.0.1'))])
+        server = StandInServer(answer = answer)
+        names = [f"host{i}.example.com" for i in range(20)] + ["missing.example.com", "big.example.com", "broken.example.com"]
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, 'dns.prom')
+            code, out, err = batch_mode().run_batch(server, names, ['--metrics', path])
+            server.close()
+            metrics = {}
+            if os.path.exists(path):
+                for line in open(path).read().split('\n'):
+                    if line and not line.startswith('#'):
+                        name, value = line.rsplit(' ', 1)
+                        metrics[name] = int(value)
+            leftover = os.listdir(tmp)
+        if (code == 0 and metrics.get('dns_queries_sent_total', 0) >= 23 and
+            metrics.get('dns_responses_total{rcode="NOERROR"}') == 22 and metrics.get('dns_responses_total{rcode="NXDOMAIN"}') == 1 and
+            metrics.get('dns_truncated_responses_total') == 1 and metrics.get('dns_decode_errors_total') == 1 and
+            metrics.get('dns_received_bytes_total', 0) > 0 and
+            leftover == ['dns.prom']):
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({metrics!r})")
+
+###
+# preload shim tests (python child with libdnspreload.so preloaded, pointed at a stand-in server)
+###
+class preload_shim:
+    def __init__(self):
+        self.total_tests = 1
+        self.successful_tests = 0
+
+    #A and AAAA asked once (repeated lookups come from the cache), PTR through 'gethostbyaddr', NXDOMAIN as an error
+    def test_lookups(self):
+        print("preload shim: cache, PTR, NXDOMAIN:  ", end="")
+        def answer(data):
+            qname, qtype = dns_question(data)
+            if qname.startswith("missing"):
+                return dns_reply(data, flags = 0x8183)
+            if qtype == 12:
+                return dns_reply(data, answers = [(qname, 12, dns_name('host.example.com'))])
+            return StandInServer.answer(None, data)
+        server = StandInServer(answer = answer)
+        child = """if True:
+            import ctypes, socket
+            class hostent(ctypes.Structure):
+                _fields_ = [('h_name', ctypes.c_char_p), ('h_aliases', ctypes.c_void_p), ('h_addrtype', ctypes.c_int),
+                            ('h_length', ctypes.c_int), ('h_addr_list', ctypes.c_void_p)]
+            libc = ctypes.CDLL(None)
+            libc.gethostbyaddr.restype = ctypes.POINTER(hostent)
+            for i in range(2):
+                print(sorted({a[4][0] for a in socket.getaddrinfo('www.example.com', 80, proto = socket.IPPROTO_TCP)}))
+            print(socket.gethostbyname_ex('www.example.com')[2])
+            print(libc.gethostbyaddr(socket.inet_aton('10.0.0.1'), 4, socket.AF_INET).contents.h_name.decode())
+            try:
+                socket.getaddrinfo('missing.example.com', 80)
+                print('resolved')
+            except socket.gaierror:
+                print('gaierror')
+        """
+        env = dict(os.environ, LD_PRELOAD = os.path.abspath('libdnspreload.so'), DNS_PRELOAD_SERVER = f"127.0.0.1#{server.port}",
+                   DNS_PRELOAD_STATS = '1')
+        process = subprocess.run([sys.executable, '-c', child], capture_output = True, text = True, timeout = 30, env = env)
+        server.close()
+        expected = ["['10.0.0.1', '2001:db8::1']", "['10.0.0.1', '2001:db8::1']", "['10.0.0.1']", "host.example.com", "gaierror"]
+        if (process.returncode == 0 and process.stdout.split('\n')[:-1] == expected and server.queries == 5 and
+            "5 queries sent, 0 left to libc" in process.stderr):
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({process.stdout!r} {process.stderr[-300:]!r} {server.queries} queries)")
+
+###
+# iterative resolution tests (stand-in root on 127.0.0.1 delegating example.com to 127.0.0.2)
+###
+class iterative_mode:
+    def __init__(self):
+        self.total_tests = 3
+        self.successful_tests = 0
+
+    #second lookup under example.com has to skip root thanks to delegation cache
+    def test_delegation_cache(self):
+        print("iterative: referral + delegation cache:  ", end="")
+        root = StandInServer(answer = lambda data: dns_reply(data, flags = 0x8000,
+                             authority = [('example.com', 2, dns_name('ns1.example.com'))],
+                             additional = [('ns1.example.com', 1, socket.inet_aton('127.0.0.2'))]))
+        auth = StandInServer(address = '127.0.0.2', port = root.port, answer = lambda data: dns_reply(data, flags = 0x8400,
+                             answers = [(dns_question(data)[0], 1, socket.inet_aton('10.0.0.7'))]))
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write('www.example.com\nmail.example.com\n')
+            path = f.name
+        process = subprocess.Popen(['./dns', '-i', '-s', '127.0.0.1', '-p', str(root.port), '-f', path],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        os.unlink(path)
+        root.close()
+        auth.close()
+        out = stdout.decode()
+        if process.returncode == 0 and out.count("Authoritative: Yes") == 2 and out.count("10.0.0.7") == 2 \
+           and root.queries == 1 and auth.queries == 2:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] (root got {root.queries} queries, authority {auth.queries})")
+
+    #glue of the wrong length for its type is ignored, the well-formed glue next to it is used
+    def test_bad_glue(self):
+        print("iterative: glue of wrong length:  ", end="")
+        root = StandInServer(answer = lambda data: dns_reply(data, flags = 0x8000,
+                             authority = [('example.com', 2, dns_name('ns1.example.com'))],
+                             additional = [('ns1.example.com', 28, socket.inet_aton('127.0.0.2')),
+                                           ('ns1.example.com', 1, b'\x7f\x00'),
+                                           ('ns1.example.com', 1, socket.inet_aton('127.0.0.2'))]))
+        auth = StandInServer(address = '127.0.0.2', port = root.port, answer = lambda data: dns_reply(data, flags = 0x8400,
+                             answers = [(dns_question(data)[0], 1, socket.inet_aton('10.0.0.7'))]))
+        process = subprocess.Popen(['./dns', '-i', '-s', '127.0.0.1', '-p', str(root.port), 'www.example.com'],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        root.close()
+        auth.close()
+        if process.returncode == 0 and "10.0.0.7" in stdout.decode() and auth.queries == 1 and "timeouts" in stderr.decode() \
+           and " 0 timeouts" in stderr.decode():
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({stderr.decode()})")
+
+    #'-f' lines are validated like in batch mode, invalid ones are reported and skipped
+    def test_invalid_names(self):
+        print("iterative: invalid names in input file:  ", end="")
+        root = StandInServer(answer = lambda data: dns_reply(data, flags = 0x8400,
+                             answers = [(dns_question(data)[0], 1, socket.inet_aton('10.0.0.7'))]))
+        with tempfile.NamedTemporaryFile('w', suffix = '.txt', delete = False) as f:
+            f.write('bad_name!.example.com\n' + 'a' * 64 + '.com\nWWW.Example.COM\n')
+            path = f.name
+        process = subprocess.Popen(['./dns', '-i', '-s', '127.0.0.1', '-p', str(root.port), '-f', path],
+                                   stderr = subprocess.PIPE, stdout = subprocess.PIPE)
+        stdout, stderr = process.communicate(timeout = 60)
+        os.unlink(path)
+        root.close()
+        out, err = stdout.decode(), stderr.decode()
+        if process.returncode == 1 and err.count("skipping invalid name") == 2 and "2 invalid names" in err \
+           and "www.example.com., A, IN" in out and root.queries == 1:
+            self.successful_tests += 1
+            print("\t[OK]")
+        else:
+            print(f"\t[FAIL] ({err})")
+
 #########################################
 #                 MAIN                  #
 #########################################
@@ -215,4 +1389,165 @@ if __name__ == '__main__':
     t3 = host_dns_nameconversions()
     t3.test_hostname_to_DNSname()
     t3.test_DNSname_to_hostname()
-    print(f"\n\r SUCCESS RATE:  [{t3.successful_tests}/{t3.total_tests}]\n\r")
\ No newline at end of file
+    print(f"\n\r SUCCESS RATE:  [{t3.successful_tests}/{t3.total_tests}]\n\r")
+
+    ### 
+    # BATCH MODE TESTING
+    print("\n\r------------------------- batch mode testing -------------------------")
+    t4 = batch_mode()
+    t4.test_coalescing()
+    t4.test_stdin_stream()
+    t4.test_socket_pool()
+    t4.test_stalled_output()
+    t4.test_malformed_replies()
+    print(f"\n\r SUCCESS RATE:  [{t4.successful_tests}/{t4.total_tests}]\n\r")
+
+    ### 
+    # ITERATIVE MODE TESTING
+    print("\n\r----------------------- iterative mode testing -----------------------")
+    t5 = iterative_mode()
+    t5.test_delegation_cache()
+    t5.test_invalid_names()
+    t5.test_bad_glue()
+    print(f"\n\r SUCCESS RATE:  [{t5.successful_tests}/{t5.total_tests}]\n\r")
+
+    ### 
+    # DUAL-STACK TESTING
+    print("\n\r------------------------- dual-stack testing -------------------------")
+    t6 = dual_stack()
+    t6.test_dual_stack()
+    t6.test_truncated_aaaa()
+    print(f"\n\r SUCCESS RATE:  [{t6.successful_tests}/{t6.total_tests}]\n\r")
+
+    ### 
+    # RR TYPES TESTING
+    print("\n\r------------------------- rr types testing ---------------------------")
+    t7 = rr_types()
+    t7.test_types()
+    t7.test_unknown_type()
+    t7.test_address_formatting()
+    print(f"\n\r SUCCESS RATE:  [{t7.successful_tests}/{t7.total_tests}]\n\r")
+
+    ### 
+    # NAME NORMALIZATION TESTING
+    print("\n\r--------------------- name normalization testing ---------------------")
+    t8 = name_normalization()
+    t8.test_name_normalize()
+    print(f"\n\r SUCCESS RATE:  [{t8.successful_tests}/{t8.total_tests}]\n\r")
+
+    ### 
+    # QUERY TEMPLATES TESTING
+    print("\n\r----------------------- query templates testing ----------------------")
+    t9 = query_templates()
+    t9.test_query_build()
+    t9.test_query_patch()
+    print(f"\n\r SUCCESS RATE:  [{t9.successful_tests}/{t9.total_tests}]\n\r")
+
+    ### 
+    # PACING TESTING
+    print("\n\r--------------------------- pacing testing ---------------------------")
+    t10 = batch_pacing()
+    t10.test_aimd()
+    t10.test_refused_backoff()
+    print(f"\n\r SUCCESS RATE:  [{t10.successful_tests}/{t10.total_tests}]\n\r")
+
+    ### 
+    # IO_URING TESTING
+    print("\n\r-------------------------- io_uring testing --------------------------")
+    t11 = uring_backend()
+    t11.test_batch()
+    t11.test_single()
+    print(f"\n\r SUCCESS RATE:  [{t11.successful_tests}/{t11.total_tests}]\n\r")
+
+    ### 
+    # PHASE TRACING TESTING
+    print("\n\r------------------------ phase tracing testing -----------------------")
+    t12 = phase_tracing()
+    t12.test_single_phases()
+    print(f"\n\r SUCCESS RATE:  [{t12.successful_tests}/{t12.total_tests}]\n\r")
+
+    ### 
+    # COLUMNAR OUTPUT TESTING
+    print("\n\r----------------------- columnar output testing ----------------------")
+    t13 = columnar_output()
+    t13.test_roundtrip()
+    print(f"\n\r SUCCESS RATE:  [{t13.successful_tests}/{t13.total_tests}]\n\r")
+
+    ### 
+    # ZONE TRANSFER TESTING
+    print("\n\r------------------------ zone transfer testing -----------------------")
+    t14 = zone_transfer()
+    t14.test_axfr()
+    t14.test_ixfr()
+    print(f"\n\r SUCCESS RATE:  [{t14.successful_tests}/{t14.total_tests}]\n\r")
+
+    ### 
+    # LOAD GENERATION TESTING
+    print("\n\r----------------------- load generation testing ----------------------")
+    t15 = load_generation()
+    t15.test_rate_and_loss()
+    print(f"\n\r SUCCESS RATE:  [{t15.successful_tests}/{t15.total_tests}]\n\r")
+
+    ### 
+    # USDT PROBES TESTING
+    print("\n\r-------------------------- usdt probes testing -----------------------")
+    t16 = usdt_probes()
+    t16.test_probe_notes()
+    print(f"\n\r SUCCESS RATE:  [{t16.successful_tests}/{t16.total_tests}]\n\r")
+
+    ### 
+    # PROBE MODE TESTING
+    print("\n\r------------------------- probe mode testing -------------------------")
+    t17 = monitor_mode()
+    t17.test_rounds()
+    print(f"\n\r SUCCESS RATE:  [{t17.successful_tests}/{t17.total_tests}]\n\r")
+
+    ### 
+    # SHARED-MEMORY RING TESTING
+    print("\n\r---------------------- shared-memory ring testing --------------------")
+    t18 = shared_memory_ring()
+    t18.test_roundtrip()
+    t18.test_overrun()
+    print(f"\n\r SUCCESS RATE:  [{t18.successful_tests}/{t18.total_tests}]\n\r")
+
+    ### 
+    # SERVER POOL TESTING
+    print("\n\r------------------------- server pool testing ------------------------")
+    t19 = server_pool()
+    t19.test_spread_and_failover()
+    print(f"\n\r SUCCESS RATE:  [{t19.successful_tests}/{t19.total_tests}]\n\r")
+
+    ### 
+    # CHECKPOINT JOURNAL TESTING
+    print("\n\r---------------------- checkpoint journal testing --------------------")
+    t20 = checkpoint_journal()
+    t20.test_kill_and_resume()
+    print(f"\n\r SUCCESS RATE:  [{t20.successful_tests}/{t20.total_tests}]\n\r")
+
+    ### 
+    # ADDRESSES-ONLY TESTING
+    print("\n\r------------------------ addresses-only testing ----------------------")
+    t21 = addresses_only()
+    t21.test_batch()
+    print(f"\n\r SUCCESS RATE:  [{t21.successful_tests}/{t21.total_tests}]\n\r")
+
+    ### 
+    # COMPRESSED OUTPUT TESTING
+    print("\n\r----------------------- compressed output testing --------------------")
+    t22 = compressed_output()
+    t22.test_gzip()
+    print(f"\n\r SUCCESS RATE:  [{t22.successful_tests}/{t22.total_tests}]\n\r")
+
+    ### 
+    # METRICS EXPORT TESTING
+    print("\n\r------------------------ metrics export testing ----------------------")
+    t23 = metrics_export()
+    t23.test_textfile()
+    print(f"\n\r SUCCESS RATE:  [{t23.successful_tests}/{t23.total_tests}]\n\r")
+
+    ### 
+    # PRELOAD SHIM TESTING
+    print("\n\r------------------------- preload shim testing -----------------------")
+    t24 = preload_shim()
+    t24.test_lookups()
+    print(f"\n\r SUCCESS RATE:  [{t24.successful_tests}/{t24.total_tests}]\n\r")
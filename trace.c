@@ -0,0 +1,82 @@
+/** @file:   trace.c
+ *  @brief:  Per-phase hot-path tracing (--trace-phases), compiled out unless built with DNS_TRACE
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "trace.h"
+
+#ifdef DNS_TRACE
+struct trace_stat trace_stats[TRACE_PHASES];
+
+static const char *trace_names[TRACE_PHASES] = {"validate", "qname", "socket", "wire", "decode", "print"};
+static uint64_t calib_ticks; //first calibration point
+static uint64_t calib_ns;
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static uint64_t trace_mono_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//upper bound of samples below given fraction of phase samples (from histogram, in ticks)
+static uint64_t trace_quantile(struct trace_stat *t, double q){
+    uint64_t want = (uint64_t)(q * (double)t->count + 0.5), seen = 0;
+    for (int b = 0; b < TRACE_BUCKETS; b++){
+        seen += t->hist[b];
+        if (seen >= want && seen > 0){
+            uint64_t bound = (1ULL << b) - 1; //bucket 'b' holds samples of 'b' bits
+            return (bound < t->max) ? bound : t->max;
+        }
+    }
+    return t->max;
+}
+
+/*************************************************
+ *                    TRACING                    *
+*************************************************/
+void trace_init(){
+    calib_ticks = trace_now();
+    calib_ns = trace_mono_ns();
+}
+
+void trace_add(enum trace_phase phase, uint64_t ticks){
+    struct trace_stat *t = &trace_stats[phase];
+    if (t->count == 0 || ticks < t->min){
+        t->min = ticks;
+    }
+    if (ticks > t->max){
+        t->max = ticks;
+    }
+    t->count++;
+    t->total += ticks;
+    int bits = (ticks == 0) ? 0 : 64 - __builtin_clzll(ticks);
+    t->hist[(bits < TRACE_BUCKETS) ? bits : TRACE_BUCKETS - 1]++;
+}
+
+void trace_report(){
+  //ticks --> nanoseconds over the whole run (TSC frequency isn't known up front)
+    uint64_t ticks = trace_now() - calib_ticks, ns = trace_mono_ns() - calib_ns;
+    double ns_per_tick = (ticks > 0) ? (double)ns / (double)ticks : 1.0;
+#if defined(__x86_64__) || defined(__i386__)
+    fprintf(stderr, "Trace: clock TSC, %.3f GHz measured over %.3f ms\r\n", 1.0 / ns_per_tick, (double)ns / 1e6);
+#else
+    fprintf(stderr, "Trace: clock CLOCK_MONOTONIC\r\n");
+#endif
+    fprintf(stderr, "       %-9s %9s %12s %10s %10s %10s %10s %10s\r\n",
+            "phase", "count", "total us", "avg us", "min us", "p50<= us", "p99<= us", "max us");
+    for (int i = 0; i < TRACE_PHASES; i++){
+        struct trace_stat *t = &trace_stats[i];
+        if (t->count == 0){
+            continue;
+        }
+        double us = ns_per_tick / 1000.0;
+        fprintf(stderr, "       %-9s %9lu %12.1f %10.2f %10.2f %10.2f %10.2f %10.2f\r\n", trace_names[i], t->count,
+                (double)t->total * us, (double)t->total / (double)t->count * us, (double)t->min * us,
+                (double)trace_quantile(t, 0.5) * us, (double)trace_quantile(t, 0.99) * us, (double)t->max * us);
+    }
+}
+#endif
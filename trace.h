@@ -0,0 +1,91 @@
+/** @file:   trace.h
+ *  @brief:  Per-phase hot-path tracing (--trace-phases), compiled out unless built with DNS_TRACE
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "dns.h"
+
+#define TRACE_BUCKETS 48 //log2 histogram buckets (ticks)
+
+/**
+ * @enum: traced phases of one lookup
+*/
+enum trace_phase{
+    TRACE_VALIDATE, /* argument validation (regcomp/regexec of addresses) */
+    TRACE_QNAME,    /* qname preparation (libc pre-lookups in 'dns_qname_insert', name normalization in batch mode) */
+    TRACE_SOCKET,   /* socket setup in 'sock_prep' */
+    TRACE_WIRE,     /* query sent --> reply received */
+    TRACE_DECODE,   /* 'dns_reply_load' */
+    TRACE_PRINT,    /* 'project_print' */
+    TRACE_PHASES
+};
+
+/**
+ * @struct: aggregated samples of one phase (in clock ticks, TSC cycles where available)
+*/
+struct trace_stat{
+    uint64_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    uint64_t hist[TRACE_BUCKETS]; /* samples by bit length of their tick count */
+};
+
+#ifdef DNS_TRACE
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <time.h>
+
+extern struct trace_stat trace_stats[TRACE_PHASES];
+
+//tick counter: TSC on x86 (no syscall, no vDSO call), monotonic clock in nanoseconds elsewhere
+static inline uint64_t trace_now(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @function: trace_init
+ * @brief takes first clock calibration point (ticks against monotonic clock), call at program start
+*/
+void trace_init();
+
+/**
+ * @function: trace_add
+ * @brief adds one sample to phase aggregates
+ *
+ * @param[in] phase: phase sample belongs to
+ * @param[in] ticks: duration of phase
+*/
+void trace_add(enum trace_phase phase, uint64_t ticks);
+
+/**
+ * @function: trace_report
+ * @brief prints per-phase totals and distributions to stderr (converted to time with second calibration point)
+*/
+void trace_report();
+
+#define TRACE_INIT()                trace_init()
+#define TRACE_START(var)            uint64_t var = trace_now()
+#define TRACE_STAMP(lvalue)         ((lvalue) = trace_now())
+#define TRACE_END(phase, var)       do { if (par.trace_phases) trace_add((phase), trace_now() - (var)); } while (0)
+#define TRACE_REPORT()              do { if (par.trace_phases) trace_report(); } while (0)
+#else
+#define TRACE_INIT()                ((void)0)
+#define TRACE_START(var)            ((void)0)
+#define TRACE_STAMP(lvalue)         ((void)0)
+#define TRACE_END(phase, var)       ((void)0)
+#define TRACE_REPORT()              ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,290 @@
+/** @file:   uring.c
+ *  @brief:  io_uring backend for the UDP send/receive path (raw syscalls, no liburing)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "uring.h"
+
+#ifdef URING_SUPPORTED
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+
+#define URING_DATA_RECV 1 //user_data of the multishot receive
+#define URING_DATA_SEND 2 //user_data of sends
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static int uring_enter(struct uring *u, unsigned submit, unsigned min_complete, unsigned flags, void *arg, size_t argsz){
+    int ret;
+    do {
+        ret = (int)syscall(__NR_io_uring_enter, u->fd, submit, min_complete, flags, arg, argsz);
+    } while (ret < 0 && errno == EINTR);
+    u->enters++;
+    return ret;
+}
+
+//next free submission queue entry (submits queued ones first if the ring is full)
+static struct io_uring_sqe *uring_sqe(struct uring *u){
+    unsigned tail = *u->sq_tail;
+    if (tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) >= u->sq_entries){
+        uring_enter(u, u->sq_queued, 0, 0, NULL, 0);
+        u->sq_queued = 0;
+    }
+    unsigned idx = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    u->sq_array[idx] = idx;
+    return sqe;
+}
+
+//publish entry taken with 'uring_sqe'
+static void uring_sqe_commit(struct uring *u){
+    __atomic_store_n(u->sq_tail, *u->sq_tail + 1, __ATOMIC_RELEASE);
+    u->sq_queued++;
+}
+
+//(re)arm multishot receive into provided buffers
+static void uring_recv_arm(struct uring *u){
+    struct io_uring_sqe *sqe = uring_sqe(u);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = u->sockfd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BGID;
+    sqe->user_data = URING_DATA_RECV;
+    uring_sqe_commit(u);
+    u->recv_armed = true;
+}
+
+/*************************************************
+ *                    BACKEND                    *
+*************************************************/
+int uring_open(struct uring *u, int sockfd){
+    memset(u, 0, sizeof(*u));
+    u->sockfd = sockfd;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    if ((u->fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &p)) < 0){
+        return 1; //no io_uring at all (old kernel, disabled by sysctl or seccomp)
+    }
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_EXT_ARG)){
+        close(u->fd);
+        u->fd = -1;
+        return 1;
+    }
+
+  //map rings (submission and completion rings share one mapping)
+    size_t sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    u->ring_len = (sq_len > cq_len) ? sq_len : cq_len;
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->ring_mem = mmap(NULL, u->ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    size_t bufs_len = (size_t)URING_BUFS * URING_BUF_SIZE;
+    size_t br_len = URING_BUFS * sizeof(struct io_uring_buf);
+    u->br = mmap(NULL, br_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    u->bufs = malloc(bufs_len);
+    if (u->ring_mem == MAP_FAILED || u->sqes == MAP_FAILED || u->br == MAP_FAILED || u->bufs == NULL){
+        uring_close(u);
+        return 1;
+    }
+    unsigned char *ring = u->ring_mem;
+    u->sq_head = (unsigned *)(ring + p.sq_off.head);
+    u->sq_tail = (unsigned *)(ring + p.sq_off.tail);
+    u->sq_mask = (unsigned *)(ring + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(ring + p.sq_off.array);
+    u->sq_entries = p.sq_entries;
+    u->cq_head = (unsigned *)(ring + p.cq_off.head);
+    u->cq_tail = (unsigned *)(ring + p.cq_off.tail);
+    u->cq_mask = (unsigned *)(ring + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(ring + p.cq_off.cqes);
+
+  //register provided-buffer ring (kernel 5.19+) and fill it
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)u->br;
+    reg.ring_entries = URING_BUFS;
+    reg.bgid = URING_BGID;
+    if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0){
+        uring_close(u);
+        return 1;
+    }
+    for (unsigned short i = 0; i < URING_BUFS; i++){
+        uring_recv_done(u, i);
+    }
+
+  //arm multishot receive (kernel 6.0+), older kernels reject it right away
+    uring_recv_arm(u);
+    uring_wait(u, 0);
+    if (__atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE) != *u->cq_head){
+        struct io_uring_cqe *cqe = &u->cqes[*u->cq_head & *u->cq_mask];
+        if (cqe->user_data == URING_DATA_RECV && cqe->res < 0 && cqe->res != -ENOBUFS){
+            uring_close(u);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void uring_send(struct uring *u, const void *pkt, size_t len){
+    struct io_uring_sqe *sqe = uring_sqe(u);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = u->sockfd;
+    sqe->addr = (uint64_t)(uintptr_t)pkt;
+    sqe->len = (uint32_t)len;
+    sqe->user_data = URING_DATA_SEND;
+    uring_sqe_commit(u);
+    u->sends++;
+}
+
+int uring_wait(struct uring *u, int timeout_ms){
+    if (!u->recv_armed){ //multishot ended (buffers ran out), start it again
+        uring_recv_arm(u);
+    }
+    unsigned submit = u->sq_queued;
+    u->sq_queued = 0;
+    if (timeout_ms == 0){
+        return (submit == 0 || uring_enter(u, submit, 0, 0, NULL, 0) >= 0) ? 0 : 1;
+    }
+    if (__atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE) != *u->cq_head){ //completions already waiting
+        return (submit == 0 || uring_enter(u, submit, 0, 0, NULL, 0) >= 0) ? 0 : 1;
+    }
+
+    struct __kernel_timespec ts = {.tv_sec = timeout_ms / 1000, .tv_nsec = (long long)(timeout_ms % 1000) * 1000000};
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = (timeout_ms < 0) ? 0 : (uint64_t)(uintptr_t)&ts;
+    if (uring_enter(u, submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0 && errno != ETIME){
+        return 1;
+    }
+    return 0;
+}
+
+bool uring_recv_next(struct uring *u, unsigned char **data, size_t *len, unsigned short *bid){
+    unsigned head = *u->cq_head;
+    while (head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)){
+        struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+        uint64_t user_data = cqe->user_data;
+        int32_t res = cqe->res;
+        uint32_t flags = cqe->flags;
+        head++;
+        __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+
+        if (user_data == URING_DATA_SEND){
+            if (res < 0){
+                u->send_errors++; //like a lost datagram, retransmit timeout handles it
+            }
+            continue;
+        }
+        if (!(flags & IORING_CQE_F_MORE)){ //multishot receive ended, rearmed with next wait
+            u->recv_armed = false;
+        }
+        if (res < 0 || !(flags & IORING_CQE_F_BUFFER)){
+            continue;
+        }
+        *bid = (unsigned short)(flags >> IORING_CQE_BUFFER_SHIFT);
+        *data = &u->bufs[(size_t)*bid * URING_BUF_SIZE];
+        *len = (size_t)res;
+        u->recvs++;
+        return true;
+    }
+    return false;
+}
+
+void uring_recv_done(struct uring *u, unsigned short bid){
+    struct io_uring_buf *buf = &u->br->bufs[u->br_tail & (URING_BUFS - 1)];
+    buf->addr = (uint64_t)(uintptr_t)&u->bufs[(size_t)bid * URING_BUF_SIZE];
+    buf->len = URING_BUF_SIZE;
+    buf->bid = bid;
+    u->br_tail++;
+    __atomic_store_n(&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+}
+
+ssize_t uring_exchange(struct uring *u, const void *pkt, size_t len, unsigned char *buf, size_t cap, int timeout_ms){
+    unsigned char *data;
+    size_t got;
+    unsigned short bid;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t deadline = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000 + timeout_ms;
+
+    uring_send(u, pkt, len);
+    while (true){
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t left = deadline - ((int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+        if (left <= 0){
+            errno = EAGAIN; //same as 'recvfrom' past SO_RCVTIMEO
+            return -1;
+        }
+        if (uring_wait(u, (int)left) != 0){
+            return -1;
+        }
+        if (uring_recv_next(u, &data, &got, &bid)){
+            got = (got > cap) ? cap : got;
+            memcpy(buf, data, got);
+            uring_recv_done(u, bid);
+            return (ssize_t)got;
+        }
+    }
+}
+
+void uring_close(struct uring *u){
+    if (u->ring_mem != NULL && u->ring_mem != MAP_FAILED){
+        munmap(u->ring_mem, u->ring_len);
+    }
+    if (u->sqes != NULL && u->sqes != MAP_FAILED){
+        munmap(u->sqes, u->sqes_len);
+    }
+    if (u->br != NULL && u->br != MAP_FAILED){
+        munmap(u->br, URING_BUFS * sizeof(struct io_uring_buf));
+    }
+    free(u->bufs);
+    if (u->fd >= 0){
+        close(u->fd);
+    }
+    memset(u, 0, sizeof(*u));
+    u->fd = -1;
+}
+
+#else
+//no io_uring headers at build time, callers always get the classic socket path
+int uring_open(struct uring *u, int sockfd){
+    memset(u, 0, sizeof(*u));
+    u->fd = -1;
+    u->sockfd = sockfd;
+    return 1;
+}
+
+void uring_send(struct uring *u, const void *pkt, size_t len){
+    (void)u; (void)pkt; (void)len;
+}
+
+int uring_wait(struct uring *u, int timeout_ms){
+    (void)u; (void)timeout_ms;
+    return 1;
+}
+
+bool uring_recv_next(struct uring *u, unsigned char **data, size_t *len, unsigned short *bid){
+    (void)u; (void)data; (void)len; (void)bid;
+    return false;
+}
+
+void uring_recv_done(struct uring *u, unsigned short bid){
+    (void)u; (void)bid;
+}
+
+ssize_t uring_exchange(struct uring *u, const void *pkt, size_t len, unsigned char *buf, size_t cap, int timeout_ms){
+    (void)u; (void)pkt; (void)len; (void)buf; (void)cap; (void)timeout_ms;
+    return -1;
+}
+
+void uring_close(struct uring *u){
+    u->fd = -1;
+}
+#endif
@@ -0,0 +1,129 @@
+/** @file:   uring.h
+ *  @brief:  io_uring backend for the UDP send/receive path (raw syscalls, no liburing)
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef URING_H
+#define URING_H
+
+#include "dns.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define URING_SUPPORTED 1
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#define URING_ENTRIES  256  //submission queue size (sends queued before a forced submit)
+#define URING_BUFS     256  //provided receive buffers (power of two)
+#define URING_BUF_SIZE 2048 //size of one receive buffer (UDP replies without EDNS are at most 512 bytes)
+#define URING_BGID     1    //provided buffer group ID
+
+/**
+ * @struct: io_uring instance bound to one (connected) UDP socket
+ *
+ * Sends are queued into the submission ring and go to the kernel together with the next wait,
+ * one io_uring_enter per loop iteration instead of one syscall per datagram. Replies arrive
+ * through a single multishot receive into kernel-picked buffers of a provided-buffer ring.
+*/
+struct uring{
+    int fd;                  /* io_uring instance (-1 = not open) */
+    int sockfd;              /* socket all operations work on */
+#ifdef URING_SUPPORTED
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned sq_entries;
+    unsigned sq_queued;      /* SQEs not submitted yet */
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    struct io_uring_buf_ring *br;
+    unsigned char *bufs;     /* URING_BUFS * URING_BUF_SIZE receive buffers */
+    unsigned short br_tail;
+    void *ring_mem;          /* mapped rings */
+    size_t ring_len;
+    size_t sqes_len;
+#endif
+    bool recv_armed;         /* multishot receive is active */
+    unsigned long enters;    /* io_uring_enter calls */
+    unsigned long sends;     /* datagrams sent */
+    unsigned long send_errors;
+    unsigned long recvs;     /* datagrams received */
+};
+
+/**
+ * @function: uring_open
+ * @brief sets up io_uring instance for socket (the socket has to be connected to the server),
+ *        checks kernel supports everything needed (provided-buffer rings, multishot receive)
+ *
+ * @param[in] u:      instance to set up
+ * @param[in] sockfd: connected UDP socket
+ * @return 0 if successful, 1 if io_uring isn't available (nothing is left allocated then)
+*/
+int uring_open(struct uring *u, int sockfd);
+
+/**
+ * @function: uring_send
+ * @brief queues datagram to be sent with the next 'uring_wait' (or sooner, when the queue is full)
+ *
+ * @param[in] u:   instance
+ * @param[in] pkt: datagram, has to stay unchanged until it's submitted
+ * @param[in] len: length of @param pkt
+*/
+void uring_send(struct uring *u, const void *pkt, size_t len);
+
+/**
+ * @function: uring_wait
+ * @brief submits queued sends and waits for completions (all in one syscall)
+ *
+ * @param[in] u:          instance
+ * @param[in] timeout_ms: how long to wait at most (-1 = no limit, 0 = just submit)
+ * @return 0 if successful (also on timeout), 1 on failure
+*/
+int uring_wait(struct uring *u, int timeout_ms);
+
+/**
+ * @function: uring_recv_next
+ * @brief next received datagram (send completions are consumed on the way)
+ *
+ * @param[in] u:    instance
+ * @param[in] data: pointer to set to datagram
+ * @param[in] len:  length of datagram
+ * @param[in] bid:  buffer ID, to be handed back with 'uring_recv_done' once datagram is processed
+ * @return 'true' if datagram was returned, 'false' if there's nothing more completed
+*/
+bool uring_recv_next(struct uring *u, unsigned char **data, size_t *len, unsigned short *bid);
+
+/**
+ * @function: uring_recv_done
+ * @brief hands receive buffer back to the kernel
+ *
+ * @param[in] u:   instance
+ * @param[in] bid: buffer ID from 'uring_recv_next'
+*/
+void uring_recv_done(struct uring *u, unsigned short bid);
+
+/**
+ * @function: uring_exchange
+ * @brief sends one datagram and waits for one datagram back (single query path)
+ *
+ * @param[in] u:   instance
+ * @param[in] pkt: datagram to send
+ * @param[in] len: length of @param pkt
+ * @param[in] buf: buffer to copy received datagram into
+ * @param[in] cap: size of @param buf
+ * @param[in] timeout_ms: how long to wait for reply at most
+ * @return length of received datagram, -1 on failure or timeout (errno set to EAGAIN then)
+*/
+ssize_t uring_exchange(struct uring *u, const void *pkt, size_t len, unsigned char *buf, size_t cap, int timeout_ms);
+
+/**
+ * @function: uring_close
+ * @brief releases everything instance holds (the socket is left open)
+ *
+ * @param[in] u: instance
+*/
+void uring_close(struct uring *u);
+
+#endif
@@ -0,0 +1,289 @@
+/** @file:   xfr.c
+ *  @brief:  Streaming zone transfer client (AXFR, IXFR over TCP) with constant memory use
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#include "xfr.h"
+#include "namenorm.h"
+#include "rrtypes.h"
+
+#include <time.h>
+
+//messages are parsed in place, one buffer for the whole transfer regardless of zone size
+static unsigned char xfr_buf[XFR_BUF + XFR_SLACK];
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+//bounded name reader
+size_t xfr_name(const unsigned char *msg, size_t len, size_t pos, char *out){
+    size_t end = 0;   //position after name in the record itself (set at first jump)
+    size_t olen = 0;
+    int jumps = 0;
+
+    while (pos < len){
+        unsigned char l = msg[pos];
+        if (l == 0){
+            if (out != NULL){
+                out[olen] = '\0';
+            }
+            return (end != 0) ? end : pos + 1;
+        }
+        if (l >= 192){ //compression pointer
+            if (pos + 1 >= len || ++jumps > 64){
+                return 0;
+            }
+            if (end == 0){
+                end = pos + 2;
+            }
+            pos = ((size_t)(l & 0x3f) << 8) | msg[pos + 1];
+            continue;
+        }
+        if (l > 63 || pos + 1 + l > len || olen + l + 1 > 255){
+            return 0;
+        }
+        if (out != NULL){
+            if (olen > 0){
+                out[olen++] = '.';
+            }
+            memcpy(out + olen, msg + pos + 1, l);
+            olen += l;
+        }
+        pos += 1 + (size_t)l;
+    }
+    return 0;
+}
+
+//serial out of SOA rdata (follows mname and rname)
+static bool xfr_soa_serial(const unsigned char *msg, size_t len, size_t rdata, uint16_t rdlen, uint32_t *serial){
+    size_t pos = xfr_name(msg, len, rdata, NULL);
+    if (pos != 0){
+        pos = xfr_name(msg, len, pos, NULL);
+    }
+    if (pos == 0 || pos + 20 > rdata + rdlen){
+        return false;
+    }
+    *serial = ((uint32_t)msg[pos] << 24) | ((uint32_t)msg[pos + 1] << 16) | ((uint32_t)msg[pos + 2] << 8) | msg[pos + 3];
+    return true;
+}
+
+//prints one record (rdata decoded by its type's decoder, freed right after)
+static int xfr_print(unsigned char *msg, size_t len, char *owner, struct record_data *res, unsigned char *rdata){
+    struct dns_record_a_t rec;
+    rec.name = (unsigned char *)owner;
+    rec.resource = res;
+    rec.rdata = rr_type_get(ntohs(res->type))->decode(msg, len, rdata, ntohs(res->data_len));
+    if (rec.rdata == NULL){
+        fprintf(stderr, "ERROR: malformed %s record in zone transfer: %s\r\n", DNS_Qtype_tostr(ntohs(res->type)), owner);
+        return 1;
+    }
+    project_print_record(&rec);
+    free(rec.rdata);
+    return 0;
+}
+
+//one answer record of the stream, SOA records drive where the transfer is (RFC 5936, RFC 1995)
+static int xfr_record(struct xfr_state *st, unsigned char *msg, size_t len, char *owner, struct record_data *res, size_t rdata){
+    uint16_t type = ntohs(res->type);
+    uint32_t serial = 0;
+    if (type == DNS_QTYPE_SOA && !xfr_soa_serial(msg, len, rdata, ntohs(res->data_len), &serial)){
+        fprintf(stderr, "ERROR: malformed SOA record in zone transfer: %s\r\n", owner);
+        return 1;
+    }
+
+    if (st->records++ == 0){ //first SOA: version of the zone the server sends
+        if (type != DNS_QTYPE_SOA){
+            fprintf(stderr, "ERROR: zone transfer doesn't start with SOA record\r\n");
+            return 1;
+        }
+        st->serial = serial;
+        fprintf(stdout, "Zone Transfer Section(%s, serial %u)\n\r", DNS_Qtype_tostr(st->qtype), serial);
+        if (st->qtype == DNS_QTYPE_IXFR && (int32_t)(serial - par.serial) <= 0){ //we are up to date (RFC 1982 comparison)
+            st->done = true;
+        }
+        return xfr_print(msg, len, owner, res, msg + rdata);
+    }
+
+    if (st->records == 2 && st->qtype == DNS_QTYPE_IXFR && type == DNS_QTYPE_SOA && serial != st->serial){
+        st->section = XFR_DELETED; //older SOA opens first difference sequence
+        fprintf(stdout, "Deleted Records(serial %u)\n\r", serial);
+    } else if (type == DNS_QTYPE_SOA){
+        switch (st->section){
+            case XFR_FULL: //closing SOA repeats the first one
+                st->done = true;
+                return 0;
+            case XFR_DELETED:
+                st->section = XFR_ADDED;
+                fprintf(stdout, "Added Records(serial %u)\n\r", serial);
+                break;
+            case XFR_ADDED:
+                if (serial == st->serial){ //closing SOA
+                    st->done = true;
+                    return 0;
+                }
+                st->section = XFR_DELETED;
+                fprintf(stdout, "Deleted Records(serial %u)\n\r", serial);
+                break;
+        }
+    }
+
+    if (st->section == XFR_DELETED){
+        st->deleted++;
+    } else if (st->section == XFR_ADDED){
+        st->added++;
+    }
+    return xfr_print(msg, len, owner, res, msg + rdata);
+}
+
+//one message of the stream
+int xfr_message(struct xfr_state *st, unsigned char *msg, size_t len){
+    struct dns_header_t *dns = (struct dns_header_t *)msg;
+    if (len < sizeof(*dns) || ntohs(dns->id) != st->id || dns->qr != 1){
+        fprintf(stderr, "ERROR: malformed zone transfer message received\r\n");
+        return 1;
+    }
+    if (dns->rcode != 0){
+        fprintf(stderr, "ERROR: zone transfer refused by server (rcode %u)\r\n", dns->rcode);
+        return 1;
+    }
+    st->messages++;
+
+    size_t pos = sizeof(*dns);
+    for (uint16_t i = 0; i < ntohs(dns->qdcount); i++){ //question (first message only, usually)
+        if ((pos = xfr_name(msg, len, pos, NULL)) == 0 || (pos += sizeof(struct dns_question_t)) > len){
+            fprintf(stderr, "ERROR: malformed zone transfer message received\r\n");
+            return 1;
+        }
+    }
+    for (uint16_t i = 0; i < ntohs(dns->ancount) && !st->done; i++){
+        char owner[256];
+        if ((pos = xfr_name(msg, len, pos, owner)) == 0 || pos + sizeof(struct record_data) > len){
+            fprintf(stderr, "ERROR: malformed zone transfer message received\r\n");
+            return 1;
+        }
+        struct record_data *res = (struct record_data *)(msg + pos);
+        pos += sizeof(struct record_data);
+        if (pos + ntohs(res->data_len) > len){
+            fprintf(stderr, "ERROR: malformed zone transfer message received\r\n");
+            return 1;
+        }
+        if (xfr_record(st, msg, len, owner, res, pos) != 0){
+            return 1;
+        }
+        pos += ntohs(res->data_len);
+    }
+    return 0;
+}
+
+/*************************************************
+ *                  TRANSFER                     *
+*************************************************/
+int xfr_run(){
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+  //zone name (taken as is, no pre-lookup)
+    unsigned char qname[258];
+    size_t qlen = name_normalize(par.address, strlen(par.address), qname);
+    if (qlen == 0){
+        fprintf(stderr, "ERROR: invalid zone name: %s\r\n", par.address);
+        return 1;
+    }
+
+  //server address is resolved the same way as for UDP queries, the transfer itself runs over TCP
+    int fd;
+    struct sockaddr_in dest;
+    struct sockaddr_in6 dest6;
+    sock_prep(&fd, &dest, &dest6);
+    close(fd);
+    bool v6 = is_it_IPv6(par.server);
+    struct timeval timeout = {.tv_sec = 10, .tv_usec = 0};
+    fd = socket(v6 ? AF_INET6 : AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0){
+        perror("ERROR: socket failure");
+        return 1;
+    }
+    if (connect(fd, v6 ? (struct sockaddr *)&dest6 : (struct sockaddr *)&dest, v6 ? sizeof(dest6) : sizeof(dest)) != 0){
+        perror("ERROR: couldn't connect to 'server'");
+        close(fd);
+        return 1;
+    }
+
+  //query (no recursion), IXFR carries SOA of our version in authority section (RFC 1995)
+    struct xfr_state st;
+    memset(&st, 0, sizeof(st));
+    srandom((unsigned int)(time(NULL) ^ getpid()));
+    st.id = (uint16_t)random();
+    st.qtype = (uint16_t)par.Qtype;
+    st.section = XFR_FULL;
+
+    struct dns_query_t query;
+    dns_query_build(&query, qname, qlen, st.qtype, false);
+    dns_query_patch(&query, st.id, false);
+    unsigned char out[2 + DNS_QUERY_MAX + XFR_SOA_AUTH];
+    size_t olen = query.len;
+    memcpy(out + 2, query.pkt, query.len);
+    if (st.qtype == DNS_QTYPE_IXFR){
+        unsigned char auth[XFR_SOA_AUTH] = {0xc0, 0x0c, 0, DNS_QTYPE_SOA, 0, DNS_QCLASS_IN, 0, 0, 0, 0, 0, 22, 0, 0,
+                                            par.serial >> 24, par.serial >> 16, par.serial >> 8, par.serial};
+        memcpy(out + 2 + olen, auth, sizeof(auth));
+        olen += sizeof(auth);
+        out[2 + 9] = 1; //NSCOUNT = 1
+    }
+    out[0] = (unsigned char)(olen >> 8);
+    out[1] = (unsigned char)olen;
+    if (send(fd, out, olen + 2, 0) != (ssize_t)(olen + 2)){
+        perror("ERROR: couldn't send zone transfer request");
+        close(fd);
+        return 1;
+    }
+
+  //receive stream, every complete message is parsed and printed before more is read
+    static char outbuf[1 << 20];
+    setvbuf(stdout, outbuf, _IOFBF, sizeof(outbuf));
+    size_t have = 0;
+    int ret = 0;
+    while (!st.done && ret == 0){
+        ssize_t n = recv(fd, xfr_buf + have, XFR_BUF - have, 0);
+        if (n < 0 && errno == EINTR){
+            continue;
+        }
+        if (n <= 0){
+            fprintf(stderr, (n == 0) ? "ERROR: connection closed before zone transfer was complete\r\n"
+                                     : "ERROR: zone transfer timed out\r\n");
+            ret = 1;
+            break;
+        }
+        have += (size_t)n;
+        st.bytes += (uint64_t)n;
+
+        size_t pos = 0;
+        while (!st.done && have - pos >= 2){
+            size_t mlen = ((size_t)xfr_buf[pos] << 8) | xfr_buf[pos + 1];
+            if (have - pos - 2 < mlen){
+                break;
+            }
+            if (xfr_message(&st, xfr_buf + pos + 2, mlen) != 0){
+                ret = 1;
+                break;
+            }
+            pos += 2 + mlen;
+        }
+        memmove(xfr_buf, xfr_buf + pos, have - pos); //partial message to front
+        have -= pos;
+    }
+    close(fd);
+    fflush(stdout);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double secs = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "Transfer: %lu records in %lu messages (%llu bytes) in %.3f s, %.0f records/s",
+            st.records, st.messages, (unsigned long long)st.bytes, secs, secs > 0 ? (double)st.records / secs : 0.0);
+    if (st.qtype == DNS_QTYPE_IXFR && st.records > 1 && st.section != XFR_FULL){
+        fprintf(stderr, ", %lu deleted, %lu added", st.deleted, st.added);
+    }
+    fprintf(stderr, "\r\n");
+    return ret;
+}
@@ -0,0 +1,73 @@
+/** @file:   xfr.h
+ *  @brief:  Streaming zone transfer client (AXFR, IXFR over TCP) with constant memory use
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef XFR_H
+#define XFR_H
+
+#include "dns.h"
+
+#define XFR_BUF      (256 << 10) //receive buffer, holds at least one whole message (2 byte length + 65535)
+#define XFR_SLACK    (16 << 10)  //zeroed space after buffer, compression pointers (14 bits) can't reach past it
+#define XFR_SOA_AUTH 34          //IXFR authority SOA: pointer, fixed fields, two root names, 5 counters
+
+/**
+ * @enum: where in the transfer stream the next record belongs
+*/
+enum xfr_section{
+    XFR_FULL,    /* whole zone (AXFR, or IXFR answered with the whole zone) */
+    XFR_DELETED, /* IXFR: records deleted from the older serial */
+    XFR_ADDED    /* IXFR: records added in the newer serial */
+};
+
+/**
+ * @struct: state of one zone transfer (everything else is reused per message)
+*/
+struct xfr_state{
+    uint16_t id;            /* transaction ID of the query (every message repeats it) */
+    uint16_t qtype;         /* DNS_QTYPE_AXFR or DNS_QTYPE_IXFR */
+    uint32_t serial;        /* serial of the first SOA (the zone version being transferred) */
+    enum xfr_section section;
+    bool done;              /* terminating SOA seen (or zone already up to date) */
+    unsigned long records;  /* records received */
+    unsigned long deleted;  /* IXFR: records printed under deleted sections */
+    unsigned long added;    /* IXFR: records printed under added sections */
+    unsigned long messages; /* DNS messages received */
+    uint64_t bytes;         /* bytes received (including length prefixes) */
+};
+
+/**
+ * @function: xfr_name
+ * @brief reads (possibly compressed) name out of message, never past its end
+ *
+ * @param[in] msg: whole DNS message
+ * @param[in] len: length of @param msg
+ * @param[in] pos: where name starts in @param msg
+ * @param[in] out: buffer (at least 256 chars) to save printable name into (no trailing dot), NULL to only skip it
+ * @return position right after name, 0 if name is malformed
+*/
+size_t xfr_name(const unsigned char *msg, size_t len, size_t pos, char *out);
+
+/**
+ * @function: xfr_message
+ * @brief processes one transfer message, prints its records as they are parsed
+ *
+ * @param[in] st:  transfer state
+ * @param[in] msg: DNS message (without TCP length prefix), followed by at least XFR_SLACK readable bytes
+ * @param[in] len: length of @param msg
+ * @return 0 if successful, 1 if message is malformed or carries an error
+*/
+int xfr_message(struct xfr_state *st, unsigned char *msg, size_t len);
+
+/**
+ * @function: xfr_run
+ * @brief transfers zone 'par.address' from 'par.server' over TCP (AXFR, or IXFR from 'par.serial')
+ *        and prints records while messages are still arriving
+ *
+ * @return exit code of the program (0 if successful, 1 otherwise)
+*/
+int xfr_run();
+
+#endif
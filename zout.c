@@ -0,0 +1,257 @@
+/** @file:   zout.c
+ *  @brief:  Compressed output stream ('--compress'): stdout text compressed and written by a writer thread
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#define _GNU_SOURCE //fopencookie (stdout replaced by a stream feeding the writer thread)
+#include "zout.h"
+
+#include <time.h>
+#include <zlib.h>
+#ifdef DNS_ZSTD
+#include <zstd.h>
+#endif
+
+/*************************************************
+ *           AUXILIARY TASK FUNCTIONS            *
+*************************************************/
+static uint64_t zout_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//writes all of 'len' bytes to the original standard output
+static int zout_write_all(struct zout *z, const unsigned char *data, size_t len){
+    while (len > 0){
+        ssize_t n = write(z->fd, data, len);
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            z->error = errno;
+            return 1;
+        }
+        data += n;
+        len -= (size_t)n;
+        z->out_bytes += (uint64_t)n;
+    }
+    return 0;
+}
+
+//stream write (printing thread): text is copied into the chunk being filled, full chunks go to the writer thread
+static ssize_t zout_cookie_write(void *cookie, const char *buf, size_t size){
+    struct zout *z = cookie;
+    size_t left = size;
+    while (left > 0){
+        if (z->cur == NULL){
+            z->cur = spsc_reserve_wait(&z->chunks);
+            z->cur->end = false;
+            z->cur->len = 0;
+        }
+        size_t n = ZOUT_CHUNK - z->cur->len;
+        n = (left < n) ? left : n;
+        memcpy(&z->cur->data[z->cur->len], buf, n);
+        z->cur->len += n;
+        buf += n;
+        left -= n;
+        if (z->cur->len == ZOUT_CHUNK){
+            spsc_commit(&z->chunks);
+            z->cur = NULL;
+        }
+    }
+    return (ssize_t)size;
+}
+
+/*************************************************
+ *                 WRITER THREAD                 *
+*************************************************/
+//gzip stream (deflate with gzip wrapper) of every chunk, one member for the whole run,
+//'false' if it couldn't start
+static bool zout_gzip(struct zout *z, unsigned char *out){
+    z_stream s;
+    memset(&s, 0, sizeof(s));
+    if (deflateInit2(&s, z->level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+        z->error = ENOMEM;
+        return false;
+    }
+    while (true){
+        struct zout_chunk *c = spsc_peek_wait(&z->chunks);
+        uint64_t start = zout_now_ns();
+        bool end = c->end;
+        s.next_in = c->data;
+        s.avail_in = (uInt)c->len;
+        z->in_bytes += c->len;
+        int ret;
+        do {
+            s.next_out = out;
+            s.avail_out = ZOUT_CHUNK;
+            ret = deflate(&s, end ? Z_FINISH : Z_NO_FLUSH);
+            if (z->error == 0 && zout_write_all(z, out, ZOUT_CHUNK - s.avail_out) != 0){
+                break; //error is reported at close, the rest is still consumed so printing never blocks
+            }
+        } while (s.avail_out == 0 || (end && ret != Z_STREAM_END));
+        spsc_release(&z->chunks);
+        z->busy_ns += zout_now_ns() - start;
+        if (end){
+            break;
+        }
+    }
+    deflateEnd(&s);
+    return true;
+}
+
+#ifdef DNS_ZSTD
+//zstd frame of every chunk, 'false' if it couldn't start
+static bool zout_zstd(struct zout *z, unsigned char *out){
+    ZSTD_CCtx *cctx = ZSTD_createCCtx();
+    if (cctx == NULL || ZSTD_isError(ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, z->level))){
+        z->error = ENOMEM;
+        ZSTD_freeCCtx(cctx);
+        return false;
+    }
+    while (true){
+        struct zout_chunk *c = spsc_peek_wait(&z->chunks);
+        uint64_t start = zout_now_ns();
+        bool end = c->end;
+        ZSTD_inBuffer in = {c->data, c->len, 0};
+        z->in_bytes += c->len;
+        size_t remaining;
+        do {
+            ZSTD_outBuffer o = {out, ZOUT_CHUNK, 0};
+            remaining = ZSTD_compressStream2(cctx, &o, &in, end ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining)){
+                z->error = EIO;
+                break;
+            }
+            if (z->error == 0 && zout_write_all(z, out, o.pos) != 0){
+                break;
+            }
+        } while (in.pos < in.size || (end && remaining != 0));
+        spsc_release(&z->chunks);
+        z->busy_ns += zout_now_ns() - start;
+        if (end){
+            break;
+        }
+    }
+    ZSTD_freeCCtx(cctx);
+    return true;
+}
+#endif
+
+static void *zout_writer(void *arg){
+    struct zout *z = arg;
+    unsigned char *out = malloc(ZOUT_CHUNK);
+    if (out == NULL){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        exit(1);
+    }
+    bool done;
+#ifdef DNS_ZSTD
+    if (z->method == ZOUT_ZSTD){
+        done = zout_zstd(z, out);
+    } else
+#endif
+    done = zout_gzip(z, out);
+    free(out);
+
+  //a failed setup still has to let printing finish
+    while (!done){
+        struct zout_chunk *c = spsc_peek_wait(&z->chunks);
+        done = c->end;
+        spsc_release(&z->chunks);
+    }
+    return NULL;
+}
+
+/*************************************************
+ *               COMPRESSED OUTPUT               *
+*************************************************/
+int zout_method(const char *text, unsigned int *method, int *level){
+    const char *colon = strchr(text, ':');
+    size_t len = colon ? (size_t)(colon - text) : strlen(text);
+    int max;
+    if (len == 4 && strncmp(text, "gzip", 4) == 0){
+        *method = ZOUT_GZIP;
+        *level = ZOUT_GZIP_LEVEL;
+        max = 9;
+    } else if (len == 4 && strncmp(text, "zstd", 4) == 0){
+#ifdef DNS_ZSTD
+        *method = ZOUT_ZSTD;
+        *level = ZOUT_ZSTD_LEVEL;
+        max = 19;
+#else
+        return 1;
+#endif
+    } else {
+        return 1;
+    }
+    if (colon != NULL){
+        char *end;
+        long l = strtol(colon + 1, &end, 10);
+        if (*end != '\0' || l < 1 || l > max){
+            return 1;
+        }
+        *level = (int)l;
+    }
+    return 0;
+}
+
+int zout_open(struct zout *z, unsigned int method, int level){
+    memset(z, 0, sizeof(*z));
+    z->method = method;
+    z->level = level;
+    z->fd = STDOUT_FILENO;
+    z->start = zout_now_ns();
+    if (spsc_init(&z->chunks, ZOUT_CHUNKS, sizeof(struct zout_chunk)) != 0){
+        fprintf(stderr, "ERROR: memory allocation failure\r\n");
+        return 1;
+    }
+    cookie_io_functions_t io = {.read = NULL, .write = zout_cookie_write, .seek = NULL, .close = NULL};
+    if ((z->text = fopencookie(z, "w", io)) == NULL || setvbuf(z->text, NULL, _IOFBF, ZOUT_STDIO_BUF) != 0){
+        fprintf(stderr, "ERROR: couldn't create output stream\r\n");
+        spsc_free(&z->chunks);
+        return 1;
+    }
+    if (pthread_create(&z->thread, NULL, zout_writer, z) != 0){
+        fprintf(stderr, "ERROR: couldn't create thread\r\n");
+        fclose(z->text);
+        spsc_free(&z->chunks);
+        return 1;
+    }
+    fflush(stdout);
+    z->orig = stdout;
+    stdout = z->text;
+    return 0;
+}
+
+int zout_close(struct zout *z){
+    fflush(z->text);
+    stdout = z->orig;
+    if (z->cur != NULL){ //partly filled chunk
+        spsc_commit(&z->chunks);
+    }
+    struct zout_chunk *c = spsc_reserve_wait(&z->chunks);
+    c->end = true;
+    c->len = 0;
+    spsc_commit(&z->chunks);
+    pthread_join(z->thread, NULL);
+    fclose(z->text);
+    spsc_free(&z->chunks);
+    if (z->error != 0){
+        errno = z->error;
+        perror("ERROR: compressed output write failure");
+        return 1;
+    }
+    return 0;
+}
+
+void zout_print(struct zout *z){
+    double secs = (double)(zout_now_ns() - z->start) / 1e9, busy = (double)z->busy_ns / 1e9;
+    fprintf(stderr, "Compression: %s level %d, %lu bytes of text --> %lu bytes (%.2fx) in %lu chunks, writer busy %.3f s "
+                    "of %.3f s (%.1f MB/s of text), printing waited %.3f s for it\r\n",
+            (z->method == ZOUT_ZSTD) ? "zstd" : "gzip", z->level, (unsigned long)z->in_bytes, (unsigned long)z->out_bytes,
+            z->out_bytes ? (double)z->in_bytes / (double)z->out_bytes : 0.0, (unsigned long)(z->chunks.commits - 1), busy, secs,
+            busy > 0 ? (double)z->in_bytes / busy / 1e6 : 0.0, (double)z->chunks.full_ns / 1e9);
+}
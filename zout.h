@@ -0,0 +1,94 @@
+/** @file:   zout.h
+ *  @brief:  Compressed output stream ('--compress'): stdout text compressed and written by a writer thread
+ *  @author: Vojtěch Kališ (xkalis03)
+ *  @last_edit: 18th October 2026
+**/
+
+#ifndef ZOUT_H
+#define ZOUT_H
+
+#include "dns.h"
+#include "spsc.h"
+
+#define ZOUT_CHUNK        (1 << 20) //text bytes handed to the writer thread at once
+#define ZOUT_CHUNKS       8         //chunks queued for the writer thread (power of two), printing waits when all are full
+#define ZOUT_STDIO_BUF    65536     //stdio buffer of the text stream (printing copies into a chunk once it fills)
+#define ZOUT_GZIP_LEVEL   3         //default levels: fast ones, text of replies compresses well anyway
+#define ZOUT_ZSTD_LEVEL   3
+
+//compression methods ('par.compress')
+#define ZOUT_NONE         0
+#define ZOUT_GZIP         1
+#define ZOUT_ZSTD         2         //only when built with zstd (DNS_ZSTD)
+
+/**
+ * @struct: chunk of text queued for the writer thread
+*/
+struct zout_chunk{
+    bool end;             /* stream is over (no text in this chunk) */
+    size_t len;
+    unsigned char data[ZOUT_CHUNK];
+};
+
+/**
+ * @struct: compressed output stream
+ *
+ * While it's open, 'stdout' is a stream whose writes go into chunks reserved in place in a ring,
+ * a full chunk is handed to the writer thread, which compresses it and writes the result to the
+ * original standard output. The printing thread only ever copies, and waits just when the writer
+ * is a whole ring of chunks behind.
+*/
+struct zout{
+    unsigned int method;   /* ZOUT_* */
+    int level;
+    int fd;                /* original standard output (compressed stream goes there) */
+    FILE *orig;            /* original 'stdout' */
+    FILE *text;            /* stream printing goes to while open */
+    struct zout_chunk *cur; /* chunk being filled (reserved in the ring), NULL between chunks */
+    struct spsc_ring chunks;
+    pthread_t thread;
+    int error;             /* errno of a failed write of the writer thread (0 = none) */
+    uint64_t start;        /* monotonic ns the stream was opened */
+    uint64_t in_bytes, out_bytes, busy_ns;
+};
+
+/**
+ * @function: zout_method
+ * @brief parses "gzip", "zstd" and their "method:level" forms
+ *
+ * @param[in] text:   option operand
+ * @param[in] method: set to ZOUT_*
+ * @param[in] level:  set to the level given (method's default if none)
+ * @return 0 if successful, 1 if unknown (or zstd without build support) or level out of range
+*/
+int zout_method(const char *text, unsigned int *method, int *level);
+
+/**
+ * @function: zout_open
+ * @brief starts writer thread and points 'stdout' to the compressing stream
+ *
+ * @param[in] z:      stream to initialize
+ * @param[in] method: ZOUT_GZIP or ZOUT_ZSTD
+ * @param[in] level:  compression level
+ * @return 0 if successful, 1 if not
+*/
+int zout_open(struct zout *z, unsigned int method, int level);
+
+/**
+ * @function: zout_close
+ * @brief flushes text printed so far, ends compressed stream, stops writer thread, restores 'stdout'
+ *
+ * @param[in] z: stream
+ * @return 0 if successful, 1 if writing failed
+*/
+int zout_close(struct zout *z);
+
+/**
+ * @function: zout_print
+ * @brief summary to stderr (text and compressed bytes, ratio, writer throughput, time printing waited)
+ *
+ * @param[in] z: closed stream
+*/
+void zout_print(struct zout *z);
+
+#endif